@@ -18,12 +18,11 @@ import org.kde.mobile.angelfish 1.0
 WebView {
     id: webEngineView
 
-    profile: AngelfishWebProfile {
-        httpUserAgent: userAgent.userAgent
-        questionLoader: questionLoader
-        offTheRecord: false
-        storageName: "angelfish-webapp"
-    }
+    // the url the web app has been created for
+    property url appUrl
+    property string storageName: "angelfish-webapp"
+
+    profile: profileManager.profile(storageName, false, profileUserAgent)
 
     // Custom context menu
     contextMenu: Controls.Menu {
@@ -62,7 +61,7 @@ WebView {
     }
 
     onNewViewRequested: {
-        if (UrlUtils.urlHost(request.requestedUrl) === UrlUtils.urlHost( BrowserManager.initialUrl)) {
+        if (UrlUtils.urlHost(request.requestedUrl) === UrlUtils.urlHost(appUrl)) {
             url = request.requestedUrl;
         } else {
             Qt.openUrlExternally(request.requestedUrl);
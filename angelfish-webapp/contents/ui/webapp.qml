@@ -26,6 +26,20 @@ Kirigami.ApplicationWindow {
 
     pageStack.globalToolBar.showNavigationButtons: false
 
+    // set by the host when opening the web app
+    property url initialUrl
+    property string storageName
+
+    Connections {
+        target: Downloads
+        function onDownloadFinished(fileName, state) {
+            if (state === Downloads.Completed)
+                showPassiveNotification(i18n("Download finished"))
+            else
+                showPassiveNotification(i18n("Download failed"))
+        }
+    }
+
     // Main Page
     pageStack.initialPage: Kirigami.Page {
         id: rootPage
@@ -42,7 +56,9 @@ Kirigami.ApplicationWindow {
             // ID for compatibility with angelfish components
             id: currentWebView
             anchors.fill: parent
-            url: BrowserManager.initialUrl
+            appUrl: webBrowser.initialUrl
+            storageName: webBrowser.storageName
+            url: webBrowser.initialUrl
         }
         ErrorHandler {
             id: errorHandler
@@ -93,6 +109,18 @@ Kirigami.ApplicationWindow {
 
         Loader {
             id: sheetLoader
+            asynchronous: true
+            onLoaded: item.open()
+        }
+
+        ProfileManager {
+            id: profileManager
+            urlRequestInterceptor: Adblock.interceptor
+            profileComponent: Component {
+                AngelfishWebProfile {
+                    questionLoader: questionLoader
+                }
+            }
         }
     }
 }
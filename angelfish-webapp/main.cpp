@@ -7,23 +7,37 @@
 #include <QApplication>
 #include <QCommandLineOption>
 #include <QCommandLineParser>
+#include <QDBusConnection>
 #include <QQmlApplicationEngine>
+#include <QQuickWindow>
 #include <QUrl>
 #include <QtQml>
 #include <QtWebEngine>
 
 #include <KLocalizedContext>
 #include <KLocalizedString>
-#include <KDesktopFile>
 #include <KAboutData>
+#include <KDBusService>
 
+#include "adblockmanager.h"
 #include "bookmarkshistorymodel.h"
+#include "datasaver.h"
+#include "downloadmanager.h"
 #include "browsermanager.h"
 #include "iconimageprovider.h"
+#include "metrics.h"
+#include "pagetextindex.h"
+#include "profilemanager.h"
+#include "requestinterceptor.h"
+#include "snapshotstore.h"
+#include "startupmonitor.h"
 #include "tabsmodel.h"
+#include "tracer.h"
 #include "urlutils.h"
 #include "useragent.h"
+#include "useragentrules.h"
 #include "angelfishsettings.h"
+#include "webapphost.h"
 
 Q_DECL_EXPORT int main(int argc, char *argv[])
 {
@@ -48,64 +62,107 @@ Q_DECL_EXPORT int main(int argc, char *argv[])
     // Command line parser
     QCommandLineParser parser;
     parser.addPositionalArgument(QStringLiteral("desktopfile"), i18n("desktop file to open"), QStringLiteral("[file]"));
+    const QCommandLineOption startupTraceOption(QStringLiteral("startup-trace"), i18n("Print the duration of the startup phases"));
+    parser.addOption(startupTraceOption);
     parser.addHelpOption();
     parser.process(app);
 
-    // QML loading
-    QQmlApplicationEngine engine;
-    engine.rootContext()->setContextObject(new KLocalizedContext(&engine));
-
-    engine.addImageProvider(IconImageProvider::providerId(), new IconImageProvider(&engine));
-
     if (parser.positionalArguments().isEmpty()) {
         return 1;
     }
 
-    const QString fileName = parser.positionalArguments().constFirst();
-    const KDesktopFile desktopFile(fileName);
-    if (desktopFile.readUrl().isEmpty()) {
-        return 2;
-    }
-    const QString initialUrl = QUrl::fromUserInput(desktopFile.readUrl()).toString();
-
-    const QString appName = desktopFile.readName().toLower().replace(QLatin1Char(' '), QLatin1Char('-')) + QStringLiteral("-angelfish-webapp");
-    KAboutData aboutData(appName.toLower(), desktopFile.readName(),
+    // All web apps share one process, see WebAppHost
+    KAboutData aboutData(QStringLiteral("angelfish-webapp"), i18n("Angelfish Web Apps"),
                           QStringLiteral("0.1"),
                           i18n("Angelfish Web App runtime"),
                           KAboutLicense::GPL,
                           i18n("Copyright 2020 Angelfish developers"));
-    QApplication::setWindowIcon(QIcon::fromTheme(desktopFile.readIcon()));
     aboutData.addAuthor(i18n("Marco Martin"), QString(), QStringLiteral("mart@kde.org"));
 
     KAboutData::setApplicationData(aboutData);
 
+    // A web app launched while the host is running is opened by the running host,
+    // this process exits here in that case.
+    KDBusService service(KDBusService::Unique, &app);
+    if (qEnvironmentVariableIsSet("ANGELFISH_TRACE"))
+        Tracer::instance()->start(qEnvironmentVariable("ANGELFISH_TRACE"));
+    // polled by monitoring on the name of the service
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/Metrics"), BrowserManager::instance()->metrics(), QDBusConnection::ExportScriptableSlots);
+
+    // QML loading
+    QQmlApplicationEngine engine;
+    engine.rootContext()->setContextObject(new KLocalizedContext(&engine));
+
+    engine.addImageProvider(IconImageProvider::providerId(), new IconImageProvider(&engine));
+
     // Exported types
     qmlRegisterType<BookmarksHistoryModel>("org.kde.mobile.angelfish", 1, 0, "BookmarksHistoryModel");
     qmlRegisterType<UserAgent>("org.kde.mobile.angelfish", 1, 0, "UserAgentGenerator");
     qmlRegisterType<TabsModel>("org.kde.mobile.angelfish", 1, 0, "TabsModel");
+    qmlRegisterType<ProfileManager>("org.kde.mobile.angelfish", 1, 0, "ProfileManager");
+    qmlRegisterUncreatableType<UserAgentRules>("org.kde.mobile.angelfish", 1, 0, "UserAgentRules", QStringLiteral("Only provides the rule modes"));
 
     // URL utils
     qmlRegisterSingletonType<UrlUtils>("org.kde.mobile.angelfish", 1, 0, "UrlUtils", [](QQmlEngine *, QJSEngine *) -> QObject * {
         return static_cast<QObject *>(new UrlUtils());
     });
 
-    BrowserManager::instance()->setInitialUrl(initialUrl);
-
     // Browser Manager
     qmlRegisterSingletonType<BrowserManager>("org.kde.mobile.angelfish", 1, 0, "BrowserManager", [](QQmlEngine *, QJSEngine *) -> QObject * {
         return static_cast<QObject *>(BrowserManager::instance());
     });
 
     // Settings are read from WebView which we use as super class for WebAppView
+    // Content blocker
+    qmlRegisterSingletonType<AdblockManager>("org.kde.mobile.angelfish", 1, 0, "Adblock", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(AdblockManager::instance());
+    });
+
+    // Data saver, applied by the same interceptor as the content blocker
+    static_cast<RequestInterceptor *>(AdblockManager::instance()->interceptor())->setDataSaver(DataSaver::instance());
+    qmlRegisterSingletonType<DataSaver>("org.kde.mobile.angelfish", 1, 0, "DataSaver", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(DataSaver::instance());
+    });
+    qmlRegisterSingletonType<SnapshotStore>("org.kde.mobile.angelfish", 1, 0, "Snapshots", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(SnapshotStore::instance());
+    });
+    qmlRegisterSingletonType<PageTextIndex>("org.kde.mobile.angelfish", 1, 0, "PageText", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(PageTextIndex::instance());
+    });
+    qmlRegisterSingletonType<DownloadManager>("org.kde.mobile.angelfish", 1, 0, "Downloads", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(DownloadManager::instance());
+    });
+
+    qmlRegisterSingletonInstance<Metrics>("org.kde.mobile.angelfish", 1, 0, "Metrics", BrowserManager::instance()->metrics());
+
+    auto *startupMonitor = StartupMonitor::instance();
+    startupMonitor->setTraceEnabled(parser.isSet(startupTraceOption));
+    qmlRegisterSingletonInstance<StartupMonitor>("org.kde.mobile.angelfish", 1, 0, "Startup", startupMonitor);
+
     qmlRegisterSingletonInstance<AngelfishSettings>("org.kde.mobile.angelfish", 1, 0, "Settings", AngelfishSettings::self());
 
     // Load QML
-    engine.load(QUrl(QStringLiteral("qrc:///webapp.qml")));
+    WebAppHost host(&engine);
+    QQuickWindow *window = host.open(parser.positionalArguments().constFirst());
+    startupMonitor->mark(StartupMonitor::QmlLoaded);
 
     // Error handling
-    if (engine.rootObjects().isEmpty()) {
-        return -1;
+    if (!window) {
+        return 2;
     }
 
-    return app.exec();
+    QObject::connect(&service, &KDBusService::activateRequested, &host, [&parser, &host](const QStringList &arguments, const QString &workingDirectory) {
+        parser.parse(arguments);
+        if (!parser.positionalArguments().isEmpty())
+            host.open(parser.positionalArguments().constFirst(), workingDirectory);
+    });
+
+    startupMonitor->watchWindow(window);
+    startupMonitor->deferToIdle(BrowserManager::instance(), [] {
+        BrowserManager::instance()->runMaintenance();
+    });
+
+    const int ret = app.exec();
+    Tracer::instance()->stop();
+    return ret;
 }
@@ -0,0 +1,109 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "webapphost.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QIcon>
+#include <QQuickWindow>
+#include <QStandardPaths>
+#include <QUrl>
+
+#include <KDesktopFile>
+#include <KWindowSystem>
+
+WebAppHost::WebAppHost(QQmlEngine *engine, QObject *parent)
+    : QObject(parent)
+    , m_component(engine, QUrl(QStringLiteral("qrc:///webapp.qml")))
+{
+    if (m_component.isError())
+        qWarning() << Q_FUNC_INFO << m_component.errors();
+}
+
+QQuickWindow *WebAppHost::open(const QString &desktopFile, const QString &workingDirectory)
+{
+    const QString path = resolve(desktopFile, workingDirectory);
+    if (QQuickWindow *window = m_windows.value(path)) {
+        window->show();
+        KWindowSystem::raiseWindow(window->winId());
+        return window;
+    }
+
+    const KDesktopFile file(path);
+    if (file.readUrl().isEmpty()) {
+        qWarning() << Q_FUNC_INFO << "Not a web app:" << desktopFile;
+        return nullptr;
+    }
+
+    // The shell matches a window to its launcher by the desktop file name
+    // that is set when the window is created. Each web app gets its own, so
+    // they don't all show up as the runtime.
+    const QString hostDesktopFileName = QGuiApplication::desktopFileName();
+    QGuiApplication::setDesktopFileName(desktopFileName(path));
+
+    QObject *object = m_component.createWithInitialProperties({
+        {QStringLiteral("initialUrl"), QUrl::fromUserInput(file.readUrl())},
+        {QStringLiteral("storageName"), storageName(path)},
+    });
+    auto *window = qobject_cast<QQuickWindow *>(object);
+    if (!window) {
+        qWarning() << Q_FUNC_INFO << "Failed to create the window for" << desktopFile << m_component.errors();
+        QGuiApplication::setDesktopFileName(hostDesktopFileName);
+        delete object;
+        return nullptr;
+    }
+
+    window->setIcon(QIcon::fromTheme(file.readIcon()));
+    window->show();
+    QGuiApplication::setDesktopFileName(hostDesktopFileName);
+    m_windows.insert(path, window);
+    emit windowCountChanged();
+
+    // closing a window hides it, drop it together with its views
+    connect(window, &QWindow::visibleChanged, this, [this, path, window] {
+        if (window->isVisible())
+            return;
+
+        m_windows.remove(path);
+        window->deleteLater();
+        emit windowCountChanged();
+    });
+
+    return window;
+}
+
+int WebAppHost::windowCount() const
+{
+    return m_windows.size();
+}
+
+QString WebAppHost::storageName(const QString &desktopFile)
+{
+    return QStringLiteral("angelfish-webapp-") + QFileInfo(desktopFile).completeBaseName();
+}
+
+QString WebAppHost::desktopFileName(const QString &desktopFile)
+{
+    return QFileInfo(desktopFile).completeBaseName();
+}
+
+QString WebAppHost::resolve(const QString &desktopFile, const QString &workingDirectory)
+{
+    if (QFileInfo(desktopFile).isAbsolute())
+        return desktopFile;
+
+    const QString installed = QStandardPaths::locate(QStandardPaths::ApplicationsLocation, desktopFile);
+    if (!installed.isEmpty())
+        return installed;
+
+    const QDir directory(workingDirectory.isEmpty() ? QDir::currentPath() : workingDirectory);
+    return directory.absoluteFilePath(desktopFile);
+}
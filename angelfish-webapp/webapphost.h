@@ -0,0 +1,59 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef WEBAPPHOST_H
+#define WEBAPPHOST_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QQmlComponent>
+
+class QQmlEngine;
+class QQuickWindow;
+
+/**
+ * @class WebAppHost
+ * @short Shows all web apps in windows of a single process.
+ *
+ * Launching a web app while the host is running only opens another window,
+ * so the web engine, the QML engine and the database are shared by all web
+ * apps. Each web app has its own profile, so they don't share cookies and
+ * storage.
+ */
+class WebAppHost : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WebAppHost(QQmlEngine *engine, QObject *parent = nullptr);
+
+    // Opens the web app described by the desktop file, or raises its window
+    // if it is already open. Relative file names are looked up in the
+    // applications directories first, and then in the working directory.
+    // Returns nullptr if the desktop file doesn't describe a web app.
+    QQuickWindow *open(const QString &desktopFile, const QString &workingDirectory = QString());
+
+    int windowCount() const;
+
+    // name of the profile storage of a web app
+    static QString storageName(const QString &desktopFile);
+    // desktop file name, used as the application id of the web app's window
+    static QString desktopFileName(const QString &desktopFile);
+
+signals:
+    void windowCountChanged();
+
+private:
+    static QString resolve(const QString &desktopFile, const QString &workingDirectory);
+
+    QQmlComponent m_component;
+    QHash<QString, QPointer<QQuickWindow>> m_windows;
+};
+
+#endif // WEBAPPHOST_H
@@ -0,0 +1,272 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QUrl>
+
+#include <vector>
+
+#include "adblockfilter.h"
+#include "adblockmanager.h"
+#include "requestinterceptor.h"
+
+class AdblockTest : public QObject
+{
+    Q_OBJECT
+
+    static bool blocked(const AdblockFilter &filter,
+                        const QString &url,
+                        const QString &page = QStringLiteral("https://page.example/"),
+                        AdblockFilter::ResourceType type = AdblockFilter::Script)
+    {
+        return filter.shouldBlock(AdblockFilter::Request(QUrl(url), QUrl(page), type));
+    }
+
+    // a list resembling the common ones: mostly host rules, and path rules
+    // with and without wildcards
+    static QString syntheticList(int size)
+    {
+        QRandomGenerator random(42);
+        QString list;
+        list.reserve(size * 32);
+        list += QStringLiteral("[Adblock Plus 2.0]\n! Synthetic list\n");
+        for (int i = 0; i < size; i++) {
+            switch (i % 10) {
+            case 0:
+                list += QStringLiteral("/banner%1/*\n").arg(i);
+                break;
+            case 1:
+                list += QStringLiteral("&ad_slot%1=\n").arg(i);
+                break;
+            case 2:
+                list += QStringLiteral("||cdn%1.example^*/track.js$script,third-party\n").arg(i);
+                break;
+            case 3:
+                list += QStringLiteral("@@||allowed%1.example^$image\n").arg(i);
+                break;
+            case 4:
+                list += QStringLiteral("example.org##.ad%1\n").arg(i);
+                break;
+            default:
+                list += QStringLiteral("||tracker%1-%2.example^\n").arg(i).arg(random.bounded(1000));
+                break;
+            }
+        }
+        return list;
+    }
+
+    static std::vector<AdblockFilter::Request> syntheticRequests(int count)
+    {
+        QRandomGenerator random(23);
+        std::vector<AdblockFilter::Request> requests;
+        requests.reserve(count);
+        for (int i = 0; i < count; i++) {
+            const int site = random.bounded(100000);
+            QString url;
+            switch (i % 4) {
+            case 0:
+                url = QStringLiteral("https://tracker%1-%2.example/pixel.gif").arg(site).arg(random.bounded(1000));
+                break;
+            case 1:
+                url = QStringLiteral("https://static.site%1.example/assets/app.%2.js?v=%3").arg(site).arg(random.bounded(100)).arg(i);
+                break;
+            case 2:
+                url = QStringLiteral("https://cdn%1.example/lib/1.2/track.js").arg(site);
+                break;
+            default:
+                url = QStringLiteral("https://news%1.example/article/%2/images/photo-%3.jpg?w=640&h=480").arg(site).arg(i).arg(random.bounded(50));
+                break;
+            }
+            requests.push_back(AdblockFilter::Request(QUrl(url), QUrl(QStringLiteral("https://news%1.example/").arg(site)), AdblockFilter::Script));
+        }
+        return requests;
+    }
+
+private Q_SLOTS:
+    void testHostRules()
+    {
+        AdblockFilter filter;
+        QCOMPARE(filter.addList(QStringLiteral("||ads.example.com^\n||Tracker.Example.org^\n")), 2);
+
+        QVERIFY(blocked(filter, QStringLiteral("https://ads.example.com/banner.png")));
+        QVERIFY(blocked(filter, QStringLiteral("https://eu.ads.example.com/")));
+        QVERIFY(blocked(filter, QStringLiteral("http://tracker.example.org:8080/t")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://example.com/ads.example.com")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://notads.example.com/")));
+
+        // pages are not blocked by rules without "$document"
+        QVERIFY(!blocked(filter, QStringLiteral("https://ads.example.com/"), QString(), AdblockFilter::Document));
+    }
+
+    void testPatterns()
+    {
+        AdblockFilter filter;
+        filter.addList(QStringLiteral("/banner/*/img^\n"
+                                      "|https://start.example/script.js|\n"
+                                      "||cdn.example^*/ads/\n"
+                                      "&adslot=\n"));
+
+        QVERIFY(blocked(filter, QStringLiteral("https://a.example/banner/foo/img")));
+        QVERIFY(blocked(filter, QStringLiteral("https://a.example/banner/foo/bar/img?x=1")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://a.example/banner/foo/imgs")));
+
+        QVERIFY(blocked(filter, QStringLiteral("https://start.example/script.js")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://start.example/script.js?v=2")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://other.example/?u=https://start.example/script.js")));
+
+        QVERIFY(blocked(filter, QStringLiteral("https://img.cdn.example/x/ads/1.png")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://cdn.example.org/x/ads/1.png")));
+
+        QVERIFY(blocked(filter, QStringLiteral("https://site.example/page?id=1&adslot=top")));
+        QVERIFY(blocked(filter, QStringLiteral("https://site.example/page?id=1&ADSLOT=top")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://site.example/page?adslot=top")));
+    }
+
+    void testExceptions()
+    {
+        AdblockFilter filter;
+        filter.addList(QStringLiteral("||ads.example^\n"
+                                      "/ad.js\n"
+                                      "@@||ads.example/allowed/*\n"
+                                      "@@||goodsite.example^$document\n"
+                                      "@@||cdn.example^\n"));
+
+        QVERIFY(blocked(filter, QStringLiteral("https://ads.example/banner.js")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://ads.example/allowed/banner.js")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://cdn.example/ad.js")));
+
+        // everything is allowed on whitelisted pages
+        QVERIFY(!blocked(filter, QStringLiteral("https://ads.example/banner.js"), QStringLiteral("https://www.goodsite.example/")));
+    }
+
+    void testOptions()
+    {
+        AdblockFilter filter;
+        filter.addList(QStringLiteral("||images.example^$image\n"
+                                      "||scripts.example^$~script\n"
+                                      "||social.com^$third-party\n"
+                                      "/widget.js$domain=news.example|~sport.news.example\n"));
+
+        QVERIFY(blocked(filter, QStringLiteral("https://images.example/a.png"), QStringLiteral("https://page.example/"), AdblockFilter::Image));
+        QVERIFY(!blocked(filter, QStringLiteral("https://images.example/a.js"), QStringLiteral("https://page.example/"), AdblockFilter::Script));
+
+        QVERIFY(!blocked(filter, QStringLiteral("https://scripts.example/a.js"), QStringLiteral("https://page.example/"), AdblockFilter::Script));
+        QVERIFY(blocked(filter, QStringLiteral("https://scripts.example/a.png"), QStringLiteral("https://page.example/"), AdblockFilter::Image));
+
+        // third-party compares the registrable domains
+        QVERIFY(blocked(filter, QStringLiteral("https://social.com/like"), QStringLiteral("https://page.org/")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://api.social.com/like"), QStringLiteral("https://www.social.com/")));
+
+        QVERIFY(blocked(filter, QStringLiteral("https://cdn.example/widget.js"), QStringLiteral("https://news.example/")));
+        QVERIFY(blocked(filter, QStringLiteral("https://cdn.example/widget.js"), QStringLiteral("https://world.news.example/")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://cdn.example/widget.js"), QStringLiteral("https://sport.news.example/")));
+        QVERIFY(!blocked(filter, QStringLiteral("https://cdn.example/widget.js"), QStringLiteral("https://page.example/")));
+    }
+
+    void testUnsupportedRules()
+    {
+        AdblockFilter filter;
+        QCOMPARE(filter.addList(QStringLiteral("[Adblock Plus 2.0]\n"
+                                               "! Title: comment\n"
+                                               "example.org##.ad\n"
+                                               "example.org#@#.ad\n"
+                                               "/banner[0-9]+/\n"
+                                               "||popup.example^$popup\n"
+                                               "||csp.example^$csp=script-src 'none'\n"
+                                               "*\n"
+                                               "\n")),
+                 0);
+        QCOMPARE(filter.ruleCount(), 0);
+        QVERIFY(!blocked(filter, QStringLiteral("https://popup.example/")));
+    }
+
+    void testCache()
+    {
+        AdblockFilter filter;
+        filter.addList(syntheticList(1000));
+
+        QByteArray data;
+        {
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::WriteOnly);
+            QDataStream stream(&buffer);
+            filter.save(stream);
+        }
+
+        AdblockFilter loaded;
+        {
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::ReadOnly);
+            QDataStream stream(&buffer);
+            QVERIFY(loaded.load(stream));
+        }
+        QCOMPARE(loaded.ruleCount(), filter.ruleCount());
+
+        const auto requests = syntheticRequests(2000);
+        for (const auto &request : requests)
+            QCOMPARE(loaded.shouldBlock(request), filter.shouldBlock(request));
+
+        // truncated data must not produce a half loaded filter
+        data.chop(data.size() / 2);
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        QDataStream stream(&buffer);
+        QVERIFY(!loaded.load(stream));
+        QCOMPARE(loaded.ruleCount(), 0);
+    }
+
+    void testBlockedCountsPerView()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        AdblockManager *manager = AdblockManager::instance();
+        auto *interceptor = static_cast<RequestInterceptor *>(manager->interceptor());
+        const QUrl page(QStringLiteral("https://page.example/"));
+        const QUrl ad(QStringLiteral("https://ads.example/ad.js"));
+        QSignalSpy spy(manager, &AdblockManager::blockedCountChanged);
+
+        // a page no view shows is not counted
+        emit interceptor->requestBlocked(page, ad);
+        QCOMPARE(spy.count(), 0);
+
+        // two tabs showing the same page keep their own count
+        QScopedPointer<QObject> first(new QObject);
+        QScopedPointer<QObject> second(new QObject);
+        manager->startPage(first.data(), page);
+        emit interceptor->requestBlocked(page, ad);
+        manager->startPage(second.data(), page);
+        emit interceptor->requestBlocked(page, ad);
+        emit interceptor->requestBlocked(page, ad);
+        QCOMPARE(manager->blockedCount(first.data()), 1);
+        QCOMPARE(manager->blockedCount(second.data()), 2);
+        QCOMPARE(spy.last().at(0).value<QObject *>(), second.data());
+
+        // a redirect keeps the count, loading a page starts over
+        const QUrl redirected(QStringLiteral("https://www.page.example/"));
+        manager->setPageUrl(second.data(), redirected);
+        emit interceptor->requestBlocked(redirected, ad);
+        QCOMPARE(manager->blockedCount(second.data()), 3);
+        manager->startPage(second.data(), page);
+        QCOMPARE(manager->blockedCount(second.data()), 0);
+
+        // counts are dropped with their view
+        QObject *view = first.data();
+        first.reset();
+        QCOMPARE(manager->blockedCount(view), 0);
+
+        // instance() creates a new manager afterwards
+        delete manager;
+    }
+};
+
+QTEST_GUILESS_MAIN(AdblockTest);
+
+#include "adblocktest.moc"
@@ -0,0 +1,97 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSignalSpy>
+
+#include <memory>
+
+#include "benchmarkdriver.h"
+#include "benchmarkserver.h"
+
+class BenchmarkDriverTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    QNetworkReply *get(const QUrl &url)
+    {
+        QNetworkReply *reply = m_network.get(QNetworkRequest(url));
+        QSignalSpy finished(reply, &QNetworkReply::finished);
+        finished.wait(5000);
+        return reply;
+    }
+
+    QNetworkAccessManager m_network;
+
+private Q_SLOTS:
+    void testScript()
+    {
+        auto *driver = BenchmarkDriver::instance();
+        QVERIFY(driver->setScript(R"({
+            "pageSize": 1000,
+            "latency": 5,
+            "steps": [
+                {"action": "openTabs", "count": 3},
+                {"action": "typeUrl", "text": "page"},
+                {"action": "wait", "ms": 10}
+            ]
+        })"));
+        QCOMPARE(driver->steps().size(), 3);
+        QCOMPARE(driver->steps().at(0).action, QStringLiteral("openTabs"));
+        QCOMPARE(driver->steps().at(0).arguments.value(QStringLiteral("count")).toInt(), 3);
+        QCOMPARE(driver->server()->pageSize(), 1000);
+        QCOMPARE(driver->server()->latency(), 5);
+
+        QVERIFY(!driver->setScript("{"));
+        QVERIFY(!driver->setScript(R"({"steps": [{"action": "fly"}]})"));
+        QVERIFY(driver->errorString().contains(QStringLiteral("fly")));
+        QVERIFY(!driver->setScript(R"({"steps": []})"));
+        // the last valid script is kept
+        QCOMPARE(driver->steps().size(), 3);
+    }
+
+    void testPage()
+    {
+        const QByteArray page = BenchmarkServer::page(QStringLiteral("/page/<1>"), 10000);
+        QVERIFY(page.size() >= 10000);
+        QVERIFY(page.size() < 10500);
+        QVERIFY(page.contains("<title>Page /page/&lt;1&gt;</title>"));
+        QCOMPARE(BenchmarkServer::page(QStringLiteral("/page/<1>"), 10000), page);
+    }
+
+    void testServer()
+    {
+        BenchmarkServer server;
+        server.setPageSize(2000);
+        server.setLatency(50);
+        QVERIFY(server.start());
+
+        QElapsedTimer timer;
+        timer.start();
+        std::unique_ptr<QNetworkReply> reply(get(server.url(QStringLiteral("/page/1"))));
+        QCOMPARE(reply->error(), QNetworkReply::NoError);
+        QVERIFY(timer.elapsed() >= 50);
+        QCOMPARE(reply->readAll(), BenchmarkServer::page(QStringLiteral("/page/1"), 2000));
+
+        // overridden per request
+        reply.reset(get(server.url(QStringLiteral("/big?size=100000&latency=0"))));
+        QCOMPARE(reply->error(), QNetworkReply::NoError);
+        QVERIFY(reply->readAll().size() >= 100000);
+
+        reply.reset(get(server.url(QStringLiteral("/favicon.ico"))));
+        QCOMPARE(reply->error(), QNetworkReply::ContentNotFoundError);
+        QCOMPARE(server.requestCount(), 3);
+    }
+};
+
+QTEST_GUILESS_MAIN(BenchmarkDriverTest)
+
+#include "benchmarkdrivertest.moc"
@@ -11,7 +11,9 @@
 #include <QStandardPaths>
 
 #include "browsermanager.h"
+#include "hostmatcher.h"
 #include "urlutils.h"
+#include "useragentrules.h"
 #include "angelfishsettings.h"
 
 class UserAgentTest : public QObject
@@ -42,6 +44,65 @@ private Q_SLOTS:
 
         QCOMPARE(UrlUtils::urlFromUserInput(incompleteUrl), completeUrl);
     }
+
+    void urlPrecomputedColumns()
+    {
+        QCOMPARE(UrlUtils::urlNormalizedHost(QStringLiteral("https://m.Example.org/foo")), QStringLiteral("example.org"));
+        QCOMPARE(UrlUtils::urlRegistrableDomain(QStringLiteral("https://news.bbc.co.uk/")), QStringLiteral("bbc.co.uk"));
+        QCOMPARE(UrlUtils::urlRegistrableDomain(QStringLiteral("https://kde.org")), QStringLiteral("kde.org"));
+        QCOMPARE(UrlUtils::urlRegistrableDomain(QStringLiteral("http://localhost:8080/")), QStringLiteral("localhost"));
+        QCOMPARE(UrlUtils::urlDisplayPath(QStringLiteral("https://kde.org/")), QString());
+        QCOMPARE(UrlUtils::urlDisplayPath(QStringLiteral("https://kde.org/community/")), QStringLiteral("/community/"));
+    }
+
+    void hostMatcher()
+    {
+        HostMatcher<int> matcher;
+        matcher.insert(QStringLiteral("example.org"), 1);
+        matcher.insert(QStringLiteral("*.mail.example.org"), 2);
+
+        QCOMPARE(*matcher.find(QStringLiteral("example.org")), 1);
+        QCOMPARE(*matcher.find(QStringLiteral("www.Example.org")), 1);
+        QCOMPARE(*matcher.find(QStringLiteral("mail.example.org")), 2);
+        QCOMPARE(*matcher.find(QStringLiteral("a.mail.example.org")), 2);
+        QVERIFY(!matcher.find(QStringLiteral("notexample.org")));
+        QVERIFY(!matcher.find(QStringLiteral("org")));
+
+        QVERIFY(matcher.remove(QStringLiteral("mail.example.org")));
+        QCOMPARE(*matcher.find(QStringLiteral("mail.example.org")), 1);
+    }
+
+    void hostMatcherManyRules()
+    {
+        HostMatcher<int> matcher;
+        for (int i = 0; i < 10000; i++)
+            matcher.insert(QStringLiteral("site%1.example").arg(i), i);
+        QCOMPARE(matcher.count(), 10000);
+
+        QCOMPARE(*matcher.find(QStringLiteral("www.site4242.example")), 4242);
+        QVERIFY(!matcher.find(QStringLiteral("www.site10000.example")));
+    }
+
+    void userAgentRules()
+    {
+        const QString url = QStringLiteral("https://m.rules.example.org/page");
+        QVERIFY(m_browserManager->userAgentRuleForUrl(url).isEmpty());
+
+        m_browserManager->setUserAgentRule(QStringLiteral("rules.example.org"), UserAgentRules::Desktop);
+        QVariantMap rule = m_browserManager->userAgentRuleForUrl(url);
+        QCOMPARE(rule.value(QStringLiteral("pattern")).toString(), QStringLiteral("rules.example.org"));
+        QCOMPARE(rule.value(QStringLiteral("mode")).toInt(), int(UserAgentRules::Desktop));
+
+        // replacing a rule
+        m_browserManager->setUserAgentRule(QStringLiteral("rules.example.org"), UserAgentRules::Custom, QStringLiteral("Agent/1.0"));
+        rule = m_browserManager->userAgentRuleForUrl(url);
+        QCOMPARE(rule.value(QStringLiteral("mode")).toInt(), int(UserAgentRules::Custom));
+        QCOMPARE(rule.value(QStringLiteral("userAgent")).toString(), QStringLiteral("Agent/1.0"));
+
+        m_browserManager->removeUserAgentRule(QStringLiteral("rules.example.org"));
+        QVERIFY(m_browserManager->userAgentRuleForUrl(url).isEmpty());
+    }
+
 private:
     BrowserManager *m_browserManager;
 };
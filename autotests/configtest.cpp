@@ -18,6 +18,14 @@ private Q_SLOTS:
         QCOMPARE(AngelfishSettings::defaultSearchBaseUrlValue(), "https://start.duckduckgo.com/?q=");
         QCOMPARE(AngelfishSettings::defaultWebAutoLoadImagesValue(), true);
         QCOMPARE(AngelfishSettings::defaultWebJavaScriptEnabledValue(), true);
+        QCOMPARE(AngelfishSettings::defaultAdblockEnabledValue(), true);
+        QCOMPARE(AngelfishSettings::defaultDataSaverEnabledValue(), false);
+        QCOMPARE(AngelfishSettings::defaultDataSaverMaxImagesValue(), 10);
+        QCOMPARE(AngelfishSettings::defaultSpeculationEnabledValue(), true);
+        QCOMPARE(AngelfishSettings::defaultSnapshotsCaptureBookmarksValue(), true);
+        QCOMPARE(AngelfishSettings::defaultSnapshotsMaxSizeValue(), 200);
+        QCOMPARE(AngelfishSettings::defaultDownloadsMaximumActiveValue(), 2);
+        QCOMPARE(AngelfishSettings::defaultBackgroundMemoryLimitValue(), 300);
         QCOMPARE(AngelfishSettings::defaultNavBarMainMenuValue(), true);
         QCOMPARE(AngelfishSettings::defaultNavBarTabsValue(), true);
     }
@@ -0,0 +1,17 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+import QtQuick 2.7
+import QtQuick.Window 2.2
+
+// Stands in for the web app window, which needs a web engine
+Window {
+    property url initialUrl
+    property string storageName
+
+    width: 100
+    height: 100
+}
@@ -0,0 +1,333 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QGuiApplication>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtWebEngine>
+#include <QtWebEngine/QQuickWebEngineProfile>
+
+#include <algorithm>
+
+#include "datasaver.h"
+#include "requestinterceptor.h"
+
+constexpr int IMAGE_COUNT = 8;
+
+// Serves a synthetic page with images, media, a font and scripts from two
+// origins, and records the paths that have been requested.
+class PageServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    bool start()
+    {
+        connect(&m_server, &QTcpServer::newConnection, this, [this] {
+            while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+                connect(socket, &QTcpSocket::readyRead, this, [this, socket] {
+                    handle(socket);
+                });
+                connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            }
+        });
+        return m_server.listen(QHostAddress::LocalHost);
+    }
+
+    // the page uses 127.0.0.1, scripts from localhost are third-party
+    QUrl pageUrl() const
+    {
+        return QUrl(QStringLiteral("http://127.0.0.1:%1/").arg(m_server.serverPort()));
+    }
+
+    QStringList requests() const
+    {
+        return m_requests;
+    }
+
+    int requestCount(const QString &prefix) const
+    {
+        return int(std::count_if(m_requests.cbegin(), m_requests.cend(), [&prefix](const QString &path) {
+            return path.startsWith(prefix);
+        }));
+    }
+
+    void clear()
+    {
+        m_requests.clear();
+    }
+
+private:
+    void handle(QTcpSocket *socket)
+    {
+        QByteArray &buffer = m_buffers[socket];
+        buffer += socket->readAll();
+        if (!buffer.contains("\r\n\r\n"))
+            return;
+
+        const QList<QByteArray> requestLine = buffer.left(buffer.indexOf("\r\n")).split(' ');
+        m_buffers.remove(socket);
+        const QString path = requestLine.size() > 1 ? QString::fromLatin1(requestLine.at(1)) : QString();
+        m_requests.append(path);
+
+        QByteArray contentType = "text/plain";
+        QByteArray body;
+        if (path == QLatin1String("/")) {
+            contentType = "text/html";
+            body = "<html><head><link rel=\"icon\" href=\"data:,\">"
+                   "<link rel=\"stylesheet\" href=\"/style.css\">"
+                   "<script src=\"/own.js\"></script>"
+                   "<script src=\"http://localhost:"
+                + QByteArray::number(m_server.serverPort())
+                + "/third.js\"></script></head><body><p>text</p>";
+            for (int i = 0; i < IMAGE_COUNT; i++)
+                body += "<img src=\"/img/" + QByteArray::number(i) + ".png\">";
+            body += "<video src=\"/video.mp4\" autoplay muted></video></body></html>";
+        } else if (path == QLatin1String("/style.css")) {
+            contentType = "text/css";
+            body = "@font-face { font-family: test; src: url(/font.woff); } body { font-family: test; }";
+        } else if (path.endsWith(QLatin1String(".js"))) {
+            contentType = "application/javascript";
+            body = "var loaded = true;";
+        }
+
+        socket->write("HTTP/1.1 200 OK\r\nContent-Type: " + contentType + "\r\nContent-Length: " + QByteArray::number(body.size())
+                      + "\r\nConnection: close\r\n\r\n" + body);
+        socket->disconnectFromHost();
+    }
+
+    QTcpServer m_server;
+    QHash<QTcpSocket *, QByteArray> m_buffers;
+    QStringList m_requests;
+};
+
+class DataSaverTest : public QObject
+{
+    Q_OBJECT
+
+    static DataSaver::Budget testBudget()
+    {
+        DataSaver::Budget budget;
+        budget.maxImages = 3;
+        budget.maxRequests = 5;
+        return budget;
+    }
+
+private Q_SLOTS:
+    void testDisabled()
+    {
+        DataSaver saver;
+        const QUrl page(QStringLiteral("https://page.org/"));
+        saver.startPage(page);
+        QVERIFY(saver.allowRequest(page, QUrl(QStringLiteral("https://page.org/a.mp4")), AdblockFilter::Media));
+        QCOMPARE(saver.pageStatistics(page).value(QStringLiteral("blocked")).toInt(), 0);
+    }
+
+    void testBudget()
+    {
+        DataSaver saver;
+        saver.setBudget(testBudget());
+        saver.setEnabled(true);
+        QSignalSpy spy(&saver, &DataSaver::pageStatisticsChanged);
+
+        const QUrl page(QStringLiteral("https://page.org/"));
+        saver.startPage(page);
+        const auto allow = [&](const QString &url, AdblockFilter::ResourceType type) {
+            return saver.allowRequest(page, QUrl(url), type);
+        };
+
+        QVERIFY(!allow(QStringLiteral("https://page.org/a.mp4"), AdblockFilter::Media));
+        QVERIFY(!allow(QStringLiteral("https://page.org/a.woff"), AdblockFilter::Font));
+        QVERIFY(!allow(QStringLiteral("https://cdn.com/a.js"), AdblockFilter::Script));
+        QVERIFY(allow(QStringLiteral("https://static.page.org/a.js"), AdblockFilter::Script));
+
+        for (int i = 0; i < 3; i++)
+            QVERIFY(allow(QStringLiteral("https://page.org/%1.png").arg(i), AdblockFilter::Image));
+        QVERIFY(!allow(QStringLiteral("https://page.org/3.png"), AdblockFilter::Image));
+
+        // the request budget is used up by the next request, stylesheets are always loaded
+        QVERIFY(allow(QStringLiteral("https://page.org/data.json"), AdblockFilter::XmlHttpRequest));
+        QVERIFY(!allow(QStringLiteral("https://page.org/more.json"), AdblockFilter::XmlHttpRequest));
+        QVERIFY(allow(QStringLiteral("https://page.org/style.css"), AdblockFilter::Stylesheet));
+
+        const QVariantMap statistics = saver.pageStatistics(page);
+        QCOMPARE(statistics.value(QStringLiteral("requests")).toInt(), 5);
+        QCOMPARE(statistics.value(QStringLiteral("blocked")).toInt(), 5);
+        QCOMPARE(statistics.value(QStringLiteral("blockedMedia")).toInt(), 1);
+        QCOMPARE(statistics.value(QStringLiteral("blockedFonts")).toInt(), 1);
+        QCOMPARE(statistics.value(QStringLiteral("blockedScripts")).toInt(), 1);
+        QCOMPARE(statistics.value(QStringLiteral("blockedImages")).toInt(), 1);
+        // one for starting the page, one per blocked request
+        QCOMPARE(spy.count(), 6);
+
+        // loading the page again starts with a new budget
+        saver.startPage(page);
+        QCOMPARE(saver.pageStatistics(page).value(QStringLiteral("requests")).toInt(), 0);
+        QVERIFY(allow(QStringLiteral("https://page.org/0.png"), AdblockFilter::Image));
+    }
+
+    void testAllowPage()
+    {
+        DataSaver saver;
+        saver.setBudget(testBudget());
+        saver.setEnabled(true);
+
+        const QUrl page(QStringLiteral("https://page.org/"));
+        saver.allowPage(page);
+
+        // only the next load is exempt
+        saver.startPage(page);
+        QVERIFY(saver.allowRequest(page, QUrl(QStringLiteral("https://page.org/a.mp4")), AdblockFilter::Media));
+        saver.startPage(page);
+        QVERIFY(!saver.allowRequest(page, QUrl(QStringLiteral("https://page.org/a.mp4")), AdblockFilter::Media));
+    }
+
+    void testPagesReleased()
+    {
+        DataSaver saver;
+        saver.setBudget(testBudget());
+        saver.setEnabled(true);
+
+        const QUrl page(QStringLiteral("https://page.org/"));
+        const QUrl image(QStringLiteral("https://page.org/0.png"));
+        QObject first;
+        QScopedPointer<QObject> second(new QObject);
+        saver.startPage(page);
+        saver.showPage(&first, page);
+        saver.showPage(second.data(), page);
+        QVERIFY(saver.allowRequest(page, image, AdblockFilter::Image));
+
+        // kept while a view shows the page
+        saver.showPage(&first, QUrl(QStringLiteral("https://other.org/")));
+        QCOMPARE(saver.pageStatistics(page).value(QStringLiteral("requests")).toInt(), 1);
+
+        second.reset();
+        QCOMPARE(saver.pageStatistics(page).value(QStringLiteral("requests")).toInt(), 0);
+
+        // requests of pages no view shows are not counted
+        QVERIFY(saver.allowRequest(page, image, AdblockFilter::Image));
+        QVERIFY(!saver.allowRequest(page, QUrl(QStringLiteral("https://page.org/a.mp4")), AdblockFilter::Media));
+        QCOMPARE(saver.pageStatistics(page).value(QStringLiteral("requests")).toInt(), 0);
+
+        // a page started before the data saver was enabled is counted once it is shown
+        saver.showPage(&first, page);
+        QVERIFY(saver.allowRequest(page, image, AdblockFilter::Image));
+        QCOMPARE(saver.pageStatistics(page).value(QStringLiteral("requests")).toInt(), 1);
+    }
+
+    void testRedirectsReleased()
+    {
+        DataSaver saver;
+        saver.setBudget(testBudget());
+        saver.setEnabled(true);
+
+        // redirects and downloads are started, but never shown
+        const QUrl image(QStringLiteral("https://page.org/0.png"));
+        const auto hop = [](int i) {
+            return QUrl(QStringLiteral("https://redirect.org/%1").arg(i));
+        };
+        for (int i = 0; i < 20; i++)
+            saver.startPage(hop(i));
+
+        QVERIFY(saver.allowRequest(hop(0), image, AdblockFilter::Image));
+        QCOMPARE(saver.pageStatistics(hop(0)).value(QStringLiteral("requests")).toInt(), 0);
+
+        // the latest one is still counted until a view shows it
+        QVERIFY(saver.allowRequest(hop(19), image, AdblockFilter::Image));
+        QCOMPARE(saver.pageStatistics(hop(19)).value(QStringLiteral("requests")).toInt(), 1);
+        QObject view;
+        saver.showPage(&view, hop(19));
+        for (int i = 20; i < 40; i++)
+            saver.startPage(hop(i));
+        QCOMPARE(saver.pageStatistics(hop(19)).value(QStringLiteral("requests")).toInt(), 1);
+    }
+
+    void testPageLoad()
+    {
+        PageServer server;
+        QVERIFY(server.start());
+
+        DataSaver saver;
+        DataSaver::Budget budget;
+        budget.maxImages = 3;
+        saver.setBudget(budget);
+        saver.setEnabled(true);
+
+        RequestInterceptor interceptor;
+        interceptor.setAdblockEnabled(false);
+        interceptor.setDataSaver(&saver);
+
+        QQuickWebEngineProfile profile;
+        profile.setOffTheRecord(true);
+        profile.setUrlRequestInterceptor(&interceptor);
+
+        QQmlEngine engine;
+        QQmlComponent component(&engine);
+        component.setData(QByteArrayLiteral(R"(
+            import QtQuick 2.7
+            import QtQuick.Window 2.2
+            import QtWebEngine 1.10
+
+            Window {
+                property alias view: view
+                width: 400
+                height: 400
+                visible: true
+
+                WebEngineView {
+                    id: view
+                    anchors.fill: parent
+                }
+            })"),
+                          QUrl());
+        QScopedPointer<QObject> window(component.create());
+        QVERIFY2(window, qPrintable(component.errorString()));
+        auto *view = window->property("view").value<QObject *>();
+        QVERIFY(view);
+        view->setProperty("profile", QVariant::fromValue(&profile));
+
+        view->setProperty("url", server.pageUrl());
+        QTRY_VERIFY(server.requests().contains(QStringLiteral("/style.css")));
+        QTRY_VERIFY(!view->property("loading").toBool());
+        QTest::qWait(500);
+
+        QVERIFY(server.requests().contains(QStringLiteral("/own.js")));
+        QCOMPARE(server.requestCount(QStringLiteral("/third.js")), 0);
+        QCOMPARE(server.requestCount(QStringLiteral("/font.woff")), 0);
+        QCOMPARE(server.requestCount(QStringLiteral("/video.mp4")), 0);
+        const int images = server.requestCount(QStringLiteral("/img/"));
+        QVERIFY(images > 0);
+        QVERIFY(images <= 3);
+
+        const QVariantMap statistics = saver.pageStatistics(server.pageUrl());
+        QCOMPARE(statistics.value(QStringLiteral("blockedImages")).toInt(), IMAGE_COUNT - images);
+        QCOMPARE(statistics.value(QStringLiteral("blockedScripts")).toInt(), 1);
+
+        // everything is loaded once the page is allowed
+        server.clear();
+        saver.allowPage(server.pageUrl());
+        QMetaObject::invokeMethod(view, "reload");
+        QTRY_COMPARE(server.requestCount(QStringLiteral("/img/")), IMAGE_COUNT);
+        QTRY_COMPARE(server.requestCount(QStringLiteral("/third.js")), 1);
+        QCOMPARE(saver.pageStatistics(server.pageUrl()).value(QStringLiteral("blocked")).toInt(), 0);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+    QtWebEngine::initialize();
+    QGuiApplication app(argc, argv);
+    DataSaverTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "datasavertest.moc"
@@ -0,0 +1,246 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "dbmanager.h"
+#include "datatransfer.h"
+
+class DataTransferTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    int count(const QString &table, const QString &condition = QStringLiteral("1"))
+    {
+        QSqlQuery query(QStringLiteral("SELECT COUNT(*) FROM %1 WHERE %2").arg(table, condition));
+        return query.next() ? query.value(0).toInt() : -1;
+    }
+
+    qint64 lastVisited(const QString &table, const QString &url)
+    {
+        QSqlQuery query;
+        query.prepare(QStringLiteral("SELECT lastVisited FROM %1 WHERE url = :url").arg(table));
+        query.bindValue(QStringLiteral(":url"), url);
+        return query.exec() && query.next() ? query.value(0).toLongLong() : -1;
+    }
+
+    void clearTables()
+    {
+        QSqlQuery query;
+        QVERIFY(query.exec(QStringLiteral("DELETE FROM history")));
+        QVERIFY(query.exec(QStringLiteral("DELETE FROM bookmarks")));
+    }
+
+    // creates a history database of another browser
+    void createDatabase(const QString &path, const QStringList &statements)
+    {
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("source"));
+            database.setDatabaseName(path);
+            QVERIFY(database.open());
+            for (const QString &statement : statements) {
+                QSqlQuery query(database);
+                QVERIFY2(query.exec(statement), qPrintable(statement));
+            }
+        }
+        QSqlDatabase::removeDatabase(QStringLiteral("source"));
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QCoreApplication::setOrganizationName(QStringLiteral("autotests"));
+        QCoreApplication::setApplicationName(QStringLiteral("angelfish_datatransfertest"));
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.removeRecursively();
+        dir.mkpath(QStringLiteral("."));
+
+        m_dbmanager = new DBManager();
+        QVERIFY(m_directory.isValid());
+    }
+
+    void init()
+    {
+        clearTables();
+    }
+
+    void testJsonLinesRoundTrip()
+    {
+        m_dbmanager->addBookmark({{QStringLiteral("url"), QStringLiteral("https://kde.org/")}, {QStringLiteral("title"), QStringLiteral("KDE")}});
+        m_dbmanager->addToHistory({{QStringLiteral("url"), QStringLiteral("https://kde.org/")}, {QStringLiteral("title"), QStringLiteral("KDE")}});
+        m_dbmanager->addToHistory({{QStringLiteral("url"), QStringLiteral("https://planet.kde.org/")}, {QStringLiteral("title"), QStringLiteral("\"Planet\"\n")}});
+
+        const QString path = m_directory.filePath(QStringLiteral("export.jsonl"));
+        QList<qreal> progress;
+        auto result = DataTransfer::exportToFile(m_dbmanager->databaseFile(), path, DataTransfer::JsonLines, [&progress](qreal value) {
+            progress.append(value);
+        });
+        QVERIFY2(result.error.isEmpty(), qPrintable(result.error));
+        QCOMPARE(result.count, 3);
+        QCOMPARE(progress.constLast(), 1.0);
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QList<QByteArray> lines = file.readAll().trimmed().split('\n');
+        QCOMPARE(lines.size(), 3);
+        QCOMPARE(QJsonDocument::fromJson(lines.constFirst()).object().value(QStringLiteral("type")).toString(), QStringLiteral("bookmark"));
+
+        clearTables();
+        result = DataTransfer::importFromFile(m_dbmanager->databaseFile(), path, DataTransfer::JsonLines);
+        QVERIFY2(result.error.isEmpty(), qPrintable(result.error));
+        QCOMPARE(result.count, 3);
+        QVERIFY(result.historyChanged);
+        QVERIFY(result.bookmarksChanged);
+        QCOMPARE(count(QStringLiteral("bookmarks")), 1);
+        QCOMPARE(count(QStringLiteral("history")), 2);
+        QCOMPARE(count(QStringLiteral("history"), QStringLiteral("title = '\"Planet\"\n' AND host = 'planet.kde.org'")), 1);
+    }
+
+    void testInvalidJsonLines()
+    {
+        const QString path = m_directory.filePath(QStringLiteral("invalid.jsonl"));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("{\"url\": \"https://kde.org/\", \"lastVisited\": 10}\n{\"url\": \n");
+        file.close();
+
+        const auto result = DataTransfer::importFromFile(m_dbmanager->databaseFile(), path, DataTransfer::JsonLines);
+        QVERIFY(result.error.startsWith(QStringLiteral("Line 2")));
+        // the entries before are kept
+        QCOMPARE(result.count, 1);
+    }
+
+    void testNetscapeBookmarks()
+    {
+        const QString path = m_directory.filePath(QStringLiteral("bookmarks.html"));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("<!DOCTYPE NETSCAPE-Bookmark-file-1>\n"
+                   "<DL><p>\n"
+                   "    <DT><H3>Folder</H3>\n"
+                   "    <DL><p>\n"
+                   "        <DT><A HREF=\"https://kde.org/?a=1&amp;b=2\" ADD_DATE=\"100\" LAST_VISIT=\"200\">KDE &amp; Plasma</A>\n"
+                   "    </DL><p>\n"
+                   "    <DT><a href=\"https://planet.kde.org/\" add_date=\"300\">Planet</a>\n"
+                   "    <DT><A HREF=\"place:sort=8\">Recent</A>\n"
+                   "</DL><p>\n");
+        file.close();
+
+        auto result = DataTransfer::importFromFile(m_dbmanager->databaseFile(), path, DataTransfer::NetscapeBookmarks);
+        QVERIFY2(result.error.isEmpty(), qPrintable(result.error));
+        QCOMPARE(result.count, 2);
+        QVERIFY(!result.historyChanged);
+        QCOMPARE(count(QStringLiteral("bookmarks"), QStringLiteral("title = 'KDE & Plasma'")), 1);
+        QCOMPARE(lastVisited(QStringLiteral("bookmarks"), QStringLiteral("https://kde.org/?a=1&b=2")), qint64(200));
+        QCOMPARE(lastVisited(QStringLiteral("bookmarks"), QStringLiteral("https://planet.kde.org/")), qint64(300));
+
+        // written back the same way
+        const QString exported = m_directory.filePath(QStringLiteral("exported.html"));
+        result = DataTransfer::exportToFile(m_dbmanager->databaseFile(), exported, DataTransfer::NetscapeBookmarks);
+        QCOMPARE(result.count, 2);
+        clearTables();
+        result = DataTransfer::importFromFile(m_dbmanager->databaseFile(), exported, DataTransfer::NetscapeBookmarks);
+        QCOMPARE(result.count, 2);
+        QCOMPARE(count(QStringLiteral("bookmarks"), QStringLiteral("title = 'KDE & Plasma'")), 1);
+    }
+
+    void testFirefoxHistory()
+    {
+        const QString path = m_directory.filePath(QStringLiteral("places.sqlite"));
+        createDatabase(path,
+                       {
+                           QStringLiteral("CREATE TABLE moz_places (id INTEGER PRIMARY KEY, url TEXT, title TEXT, last_visit_date INT)"),
+                           QStringLiteral("INSERT INTO moz_places (url, title, last_visit_date) VALUES ('https://kde.org/', 'KDE', 1600000000000000)"),
+                           QStringLiteral("INSERT INTO moz_places (url, title, last_visit_date) VALUES ('https://never.visited/', 'Never', NULL)"),
+                           QStringLiteral("INSERT INTO moz_places (url, title, last_visit_date) VALUES ('place:type=6', 'Tags', 1)"),
+                       });
+
+        const auto result = DataTransfer::importFromFile(m_dbmanager->databaseFile(), path, DataTransfer::FirefoxHistory);
+        QVERIFY2(result.error.isEmpty(), qPrintable(result.error));
+        QCOMPARE(result.count, 1);
+        QCOMPARE(lastVisited(QStringLiteral("history"), QStringLiteral("https://kde.org/")), qint64(1600000000));
+    }
+
+    void testChromiumHistory()
+    {
+        const QString path = m_directory.filePath(QStringLiteral("History"));
+        createDatabase(path,
+                       {
+                           QStringLiteral("CREATE TABLE urls (id INTEGER PRIMARY KEY, url TEXT, title TEXT, last_visit_time INT, hidden INT)"),
+                           QStringLiteral("INSERT INTO urls (url, title, last_visit_time, hidden) VALUES ('https://kde.org/', 'KDE', 13244473600000000, 0)"),
+                           QStringLiteral("INSERT INTO urls (url, title, last_visit_time, hidden) VALUES ('https://hidden.example/', '', 13244473600000000, 1)"),
+                           QStringLiteral("INSERT INTO urls (url, title, last_visit_time, hidden) VALUES ('chrome://settings/', 'Settings', 1, 0)"),
+                       });
+
+        // an entry visited more recently keeps its visit
+        m_dbmanager->addToHistory({{QStringLiteral("url"), QStringLiteral("https://kde.org/")}, {QStringLiteral("title"), QStringLiteral("KDE")}});
+        const qint64 visited = lastVisited(QStringLiteral("history"), QStringLiteral("https://kde.org/"));
+
+        const auto result = DataTransfer::importFromFile(m_dbmanager->databaseFile(), path, DataTransfer::ChromiumHistory);
+        QVERIFY2(result.error.isEmpty(), qPrintable(result.error));
+        QCOMPARE(result.count, 1);
+        QCOMPARE(count(QStringLiteral("history")), 1);
+        QCOMPARE(lastVisited(QStringLiteral("history"), QStringLiteral("https://kde.org/")), visited);
+
+        clearTables();
+        DataTransfer::importFromFile(m_dbmanager->databaseFile(), path, DataTransfer::ChromiumHistory);
+        QCOMPARE(lastVisited(QStringLiteral("history"), QStringLiteral("https://kde.org/")), qint64(1600000000));
+    }
+
+    void testMissingFile()
+    {
+        const auto result = DataTransfer::importFromFile(m_dbmanager->databaseFile(), m_directory.filePath(QStringLiteral("missing")), DataTransfer::FirefoxHistory);
+        QVERIFY(!result.error.isEmpty());
+        QCOMPARE(result.count, 0);
+    }
+
+    void testImportedEntriesKept()
+    {
+        // more entries than the history keeps of the pages visited here
+        const int rows = 3500;
+        const QString path = m_directory.filePath(QStringLiteral("kept.jsonl"));
+        {
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            for (int i = 0; i < rows; i++) {
+                file.write(QStringLiteral("{\"type\":\"history\",\"url\":\"https://imported.example/%1\",\"lastVisited\":%2}\n")
+                               .arg(i)
+                               .arg(1500000000 + i)
+                               .toUtf8());
+            }
+        }
+        QCOMPARE(DataTransfer::importFromFile(m_dbmanager->databaseFile(), path, DataTransfer::JsonLines).count, rows);
+        m_dbmanager->addToHistory({{QStringLiteral("url"), QStringLiteral("https://kde.org/")}, {QStringLiteral("title"), QStringLiteral("KDE")}});
+
+        // the next start doesn't undo the import
+        QCOMPARE(DBManager::runMaintenance(m_dbmanager->databaseFile()), 0);
+        QCOMPARE(count(QStringLiteral("history")), rows + 1);
+        QCOMPARE(count(QStringLiteral("history"), QStringLiteral("imported = 1")), rows);
+    }
+
+    void cleanupTestCase()
+    {
+        delete m_dbmanager;
+    }
+
+private:
+    DBManager *m_dbmanager = nullptr;
+    QTemporaryDir m_directory;
+};
+
+QTEST_GUILESS_MAIN(DataTransferTest)
+
+#include "datatransfertest.moc"
@@ -0,0 +1,123 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+#include <QCoreApplication>
+#include <QDir>
+#include <QProcess>
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QStandardPaths>
+
+#include <memory>
+#include <vector>
+
+#include "dbmanager.h"
+
+constexpr int WRITERS = 4;
+constexpr int WRITES = 250;
+
+static void setupApplication()
+{
+    QCoreApplication::setOrganizationName(QStringLiteral("autotests"));
+    QCoreApplication::setApplicationName(QStringLiteral("angelfish_dbconcurrencytest"));
+}
+
+// run in a child process, adds WRITES history entries
+static int runWriter(const QString &id)
+{
+    DBManager dbmanager;
+    for (int i = 0; i < WRITES; i++) {
+        dbmanager.addToHistory({
+            {QStringLiteral("url"), QStringLiteral("https://writer-%1-%2/").arg(id).arg(i)},
+            {QStringLiteral("title"), QStringLiteral("Writer %1").arg(id)},
+        });
+    }
+    return 0;
+}
+
+class DBConcurrencyTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.removeRecursively();
+        dir.mkpath(QStringLiteral("."));
+
+        m_dbmanager = new DBManager();
+    }
+
+    void testWriteAheadLog()
+    {
+        QSqlQuery query(QStringLiteral("PRAGMA journal_mode"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toString(), QStringLiteral("wal"));
+    }
+
+    void testConcurrentWriters()
+    {
+        QSignalSpy spy(m_dbmanager, &DBManager::databaseTableChanged);
+
+        std::vector<std::unique_ptr<QProcess>> writers;
+        for (int i = 0; i < WRITERS; i++) {
+            auto writer = std::make_unique<QProcess>();
+            writer->setProcessChannelMode(QProcess::ForwardedChannels);
+            writer->start(QCoreApplication::applicationFilePath(), {QStringLiteral("--writer"), QString::number(i)});
+            QVERIFY(writer->waitForStarted());
+            writers.push_back(std::move(writer));
+        }
+
+        // the parent keeps writing meanwhile
+        for (int i = 0; i < WRITES; i++)
+            m_dbmanager->addToHistory({{QStringLiteral("url"), QStringLiteral("https://parent-%1/").arg(i)}});
+
+        for (const auto &writer : writers) {
+            QVERIFY(writer->waitForFinished(60000));
+            QCOMPARE(writer->exitStatus(), QProcess::NormalExit);
+            QCOMPARE(writer->exitCode(), 0);
+        }
+
+        QSqlQuery query(QStringLiteral("SELECT COUNT(*) FROM history WHERE url LIKE 'https://writer-%'"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), WRITERS * WRITES);
+
+        // the writes of the other processes are announced once the event
+        // loop runs, the parent's own writes were announced right away
+        QCOMPARE(spy.count(), WRITES);
+        spy.clear();
+        QTRY_VERIFY(!spy.isEmpty());
+        bool historyChanged = false;
+        for (const QList<QVariant> &arguments : qAsConst(spy))
+            historyChanged |= arguments.constFirst().toString() == QStringLiteral("history");
+        QVERIFY(historyChanged);
+    }
+
+    void cleanupTestCase()
+    {
+        delete m_dbmanager;
+    }
+
+private:
+    DBManager *m_dbmanager = nullptr;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    setupApplication();
+
+    const QStringList arguments = app.arguments();
+    if (arguments.size() == 3 && arguments.at(1) == QStringLiteral("--writer"))
+        return runWriter(arguments.at(2));
+
+    DBConcurrencyTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "dbconcurrencytest.moc"
@@ -7,7 +7,9 @@
 #include <QtTest/QTest>
 #include <QSignalSpy>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QStandardPaths>
+#include <QSqlQuery>
 
 #include "dbmanager.h"
 #include "sqlquerymodel.h"
@@ -43,6 +45,22 @@ private Q_SLOTS:
         QCOMPARE(spy.count(), 1);
     }
 
+    void testPrecomputedUrlColumns()
+    {
+        m_dbmanager->addToHistory({{"url", "https://www.news.bbc.co.uk/sport/"}, {"title", "Sport"}, {"icon", "TESTDATA"}});
+
+        QSqlQuery query;
+        query.prepare("SELECT host, domain, displayPath FROM history WHERE url = :url");
+        query.bindValue(":url", "https://www.news.bbc.co.uk/sport/");
+        QVERIFY(query.exec());
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toString(), "news.bbc.co.uk");
+        QCOMPARE(query.value(1).toString(), "bbc.co.uk");
+        QCOMPARE(query.value(2).toString(), "/sport/");
+
+        m_dbmanager->removeFromHistory("https://www.news.bbc.co.uk/sport/");
+    }
+
     void testLastVisited()
     {
         QSignalSpy spy(m_dbmanager, &DBManager::databaseTableChanged);
@@ -68,6 +86,53 @@ private Q_SLOTS:
         QCOMPARE(spy.count(), 1);
     }
 
+    void testRemoveHistoryRange()
+    {
+        // independent of the other tests and of earlier runs
+        QSqlQuery query;
+        QVERIFY(query.exec("DELETE FROM history"));
+        QVERIFY(query.exec("DELETE FROM icons WHERE url IN ('old-icon', 'recent-icon')"));
+
+        const qint64 now = QDateTime::currentSecsSinceEpoch();
+        m_dbmanager->addToHistory({{"url", "https://old.example/"}, {"title", "Old"}, {"icon", "old-icon"}});
+        m_dbmanager->addToHistory({{"url", "https://recent.example/"}, {"title", "Recent"}, {"icon", "recent-icon"}});
+
+        QVERIFY(query.exec("INSERT INTO icons (url, icon) VALUES ('old-icon', x'00'), ('recent-icon', x'00')"));
+        query.prepare("UPDATE history SET lastVisited = :lastVisited WHERE url = :url");
+        query.bindValue(":lastVisited", now - 2 * 60 * 60);
+        query.bindValue(":url", "https://old.example/");
+        QVERIFY(query.exec());
+
+        QSignalSpy spy(m_dbmanager, &DBManager::databaseTableChanged);
+        QList<qreal> progress;
+        const int removed = DBManager::removeHistoryRange(m_dbmanager->databaseFile(), now - 60 * 60, now, [&progress](qreal value) {
+            progress.append(value);
+        });
+        QCOMPARE(removed, 1);
+        QVERIFY(!progress.isEmpty());
+        QCOMPARE(progress.constLast(), 1.0);
+
+        // announced by the caller, once for all entries
+        QCOMPARE(spy.count(), 0);
+        m_dbmanager->announceChanges("history");
+        QCOMPARE(spy.count(), 1);
+
+        QVERIFY(query.exec("SELECT url FROM history"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toString(), "https://old.example/");
+        QVERIFY(!query.next());
+
+        // the unused icon is removed with its entries
+        QVERIFY(query.exec("SELECT url FROM icons WHERE url IN ('old-icon', 'recent-icon')"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toString(), "old-icon");
+        QVERIFY(!query.next());
+
+        // nothing left in the range
+        QCOMPARE(DBManager::removeHistoryRange(m_dbmanager->databaseFile(), now - 60 * 60, now), 0);
+        m_dbmanager->removeFromHistory("https://old.example/");
+    }
+
     void testSqlQueryModelRoleNames()
     {
         auto model = new SqlQueryModel();
@@ -77,7 +142,11 @@ private Q_SLOTS:
             { Qt::UserRole + 1, "url"},
             { Qt::UserRole + 2, "title"},
             { Qt::UserRole + 3, "icon"},
-            { Qt::UserRole + 4, "lastVisited"}
+            { Qt::UserRole + 4, "lastVisited"},
+            { Qt::UserRole + 5, "host"},
+            { Qt::UserRole + 6, "domain"},
+            { Qt::UserRole + 7, "displayPath"},
+            { Qt::UserRole + 8, "imported"}
         };
         QCOMPARE(model->roleNames(), expectedRoleNames);
     }
@@ -0,0 +1,300 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+
+#include <algorithm>
+
+#include "browsermanager.h"
+#include "downloadmanager.h"
+
+constexpr int FILE_SIZE = 100000;
+// of the file served
+const QByteArray ETAG = QByteArrayLiteral("\"v1\"");
+
+// Serves FILE_SIZE bytes on every path. Ranges are honoured unless the path
+// starts with /norange or If-Range doesn't match ETAG, /login serves a page.
+class RangeServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    bool start()
+    {
+        for (int i = 0; i < FILE_SIZE; i++)
+            m_content.append(char('a' + i % 26));
+
+        connect(&m_server, &QTcpServer::newConnection, this, [this] {
+            while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+                connect(socket, &QTcpSocket::readyRead, this, [this, socket] {
+                    handle(socket);
+                });
+                connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            }
+        });
+        return m_server.listen(QHostAddress::LocalHost);
+    }
+
+    QUrl url(const QString &path) const
+    {
+        return QUrl(QStringLiteral("http://127.0.0.1:%1%2").arg(m_server.serverPort()).arg(path));
+    }
+
+    QByteArray content() const
+    {
+        return m_content;
+    }
+
+    QList<QByteArray> ranges() const
+    {
+        return m_ranges;
+    }
+
+private:
+    void handle(QTcpSocket *socket)
+    {
+        QByteArray &buffer = m_buffers[socket];
+        buffer += socket->readAll();
+        if (!buffer.contains("\r\n\r\n"))
+            return;
+
+        const QList<QByteArray> lines = buffer.left(buffer.indexOf("\r\n\r\n")).split('\n');
+        m_buffers.remove(socket);
+        const QList<QByteArray> requestLine = lines.at(0).split(' ');
+        const bool rangeSupported = !requestLine.value(1).startsWith("/norange");
+
+        qint64 offset = 0;
+        QByteArray ifRange;
+        for (const QByteArray &line : lines) {
+            if (line.toLower().startsWith("range: bytes=")) {
+                m_ranges.append(line.trimmed());
+                offset = line.mid(line.indexOf('=') + 1).split('-').at(0).toLongLong();
+            } else if (line.toLower().startsWith("if-range:")) {
+                ifRange = line.mid(line.indexOf(':') + 1).trimmed();
+            }
+        }
+
+        if (requestLine.value(1).startsWith("/login")) {
+            const QByteArray page = QByteArrayLiteral("<html>Please log in</html>");
+            socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nContent-Length: " + QByteArray::number(page.size())
+                          + "\r\nConnection: close\r\n\r\n" + page);
+        } else if (offset > 0 && rangeSupported && (ifRange.isEmpty() || ifRange == ETAG)) {
+            const QByteArray body = m_content.mid(int(offset));
+            socket->write("HTTP/1.1 206 Partial Content\r\nContent-Type: application/octet-stream\r\nContent-Length: "
+                          + QByteArray::number(body.size()) + "\r\nContent-Range: bytes " + QByteArray::number(offset) + '-'
+                          + QByteArray::number(FILE_SIZE - 1) + '/' + QByteArray::number(FILE_SIZE) + "\r\nETag: " + ETAG
+                          + "\r\nConnection: close\r\n\r\n" + body);
+        } else {
+            socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: " + QByteArray::number(FILE_SIZE)
+                          + "\r\nETag: " + ETAG + "\r\nConnection: close\r\n\r\n" + m_content);
+        }
+        socket->disconnectFromHost();
+    }
+
+    QTcpServer m_server;
+    QHash<QTcpSocket *, QByteArray> m_buffers;
+    QByteArray m_content;
+    QList<QByteArray> m_ranges;
+};
+
+class DownloadManagerTest : public QObject
+{
+    Q_OBJECT
+
+    // stores a download of an earlier session with the first bytes already on disk
+    int addDownload(const QString &path, DownloadManager::State state, const QByteArray &partial = QByteArray(), const QByteArray &validator = ETAG)
+    {
+        const QString fileName = m_directory.filePath(path.mid(1));
+        QFile file(fileName);
+        file.open(QIODevice::WriteOnly);
+        file.write(partial);
+        file.close();
+
+        return BrowserManager::instance()->addDownload({
+            {QStringLiteral("url"), m_server.url(path)},
+            {QStringLiteral("path"), fileName},
+            {QStringLiteral("receivedBytes"), partial.size()},
+            {QStringLiteral("totalBytes"), FILE_SIZE},
+            {QStringLiteral("state"), state},
+            {QStringLiteral("mimeType"), QStringLiteral("application/octet-stream")},
+            {QStringLiteral("validator"), QString::fromLatin1(validator)},
+        });
+    }
+
+    static QVariant value(const DownloadManager &manager, int row, DownloadManager::Role role)
+    {
+        return manager.data(manager.index(row), role);
+    }
+
+    static DownloadManager::State state(const DownloadManager &manager, int row)
+    {
+        return DownloadManager::State(value(manager, row, DownloadManager::StateRole).toInt());
+    }
+
+    static QByteArray fileContent(const DownloadManager &manager, int row)
+    {
+        QFile file(value(manager, row, DownloadManager::PathRole).toString());
+        file.open(QIODevice::ReadOnly);
+        return file.readAll();
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QCoreApplication::setOrganizationName(QStringLiteral("autotests"));
+        QCoreApplication::setApplicationName(QStringLiteral("angelfish_downloadmanagertest"));
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.mkpath(QStringLiteral("."));
+
+        BrowserManager::instance();
+        QVERIFY(m_directory.isValid());
+        QVERIFY(m_server.start());
+    }
+
+    void cleanupTestCase()
+    {
+        delete BrowserManager::instance();
+    }
+
+    void init()
+    {
+        QSqlQuery query;
+        QVERIFY(query.exec(QStringLiteral("DELETE FROM downloads")));
+    }
+
+    void testResume()
+    {
+        const QByteArray partial = m_server.content().left(40000);
+        addDownload(QStringLiteral("/resume"), DownloadManager::Downloading, partial);
+
+        DownloadManager manager;
+        QCOMPARE(manager.rowCount(), 1);
+        QCOMPARE(state(manager, 0), DownloadManager::Queued);
+        QCOMPARE(value(manager, 0, DownloadManager::FileNameRole).toString(), QStringLiteral("resume"));
+
+        QTRY_COMPARE(state(manager, 0), DownloadManager::Completed);
+        QVERIFY(m_server.ranges().contains("Range: bytes=40000-"));
+        QCOMPARE(fileContent(manager, 0), m_server.content());
+        QCOMPARE(value(manager, 0, DownloadManager::ReceivedBytesRole).toLongLong(), qint64(FILE_SIZE));
+        QCOMPARE(value(manager, 0, DownloadManager::RemainingTimeRole).toLongLong(), qint64(-1));
+    }
+
+    void testRangeNotSupported()
+    {
+        addDownload(QStringLiteral("/norange"), DownloadManager::Downloading, QByteArray(500, 'x'));
+
+        DownloadManager manager;
+        QTRY_COMPARE(state(manager, 0), DownloadManager::Completed);
+        // the whole file has been downloaded again
+        QCOMPARE(fileContent(manager, 0), m_server.content());
+    }
+
+    void testFileChanged()
+    {
+        // If-Range doesn't match, the new file is downloaded from the start
+        addDownload(QStringLiteral("/changed"), DownloadManager::Downloading, QByteArray(500, 'x'), QByteArrayLiteral("\"v0\""));
+
+        DownloadManager manager;
+        QTRY_COMPARE(state(manager, 0), DownloadManager::Completed);
+        QCOMPARE(fileContent(manager, 0), m_server.content());
+        QCOMPARE(BrowserManager::instance()->downloads().constFirst().toMap().value(QStringLiteral("validator")).toByteArray(), ETAG);
+    }
+
+    void testWithoutValidator()
+    {
+        // the partial file can't be identified, no range is requested
+        const int ranges = m_server.ranges().size();
+        addDownload(QStringLiteral("/unknown"), DownloadManager::Downloading, QByteArray(500, 'x'), QByteArray());
+
+        DownloadManager manager;
+        QTRY_COMPARE(state(manager, 0), DownloadManager::Completed);
+        QCOMPARE(fileContent(manager, 0), m_server.content());
+        QCOMPARE(m_server.ranges().size(), ranges);
+    }
+
+    void testUnexpectedPage()
+    {
+        // a login page instead of the file doesn't replace the partial file
+        const QByteArray partial = m_server.content().left(500);
+        addDownload(QStringLiteral("/login"), DownloadManager::Downloading, partial);
+
+        DownloadManager manager;
+        QTRY_COMPARE(state(manager, 0), DownloadManager::Failed);
+        QCOMPARE(fileContent(manager, 0), partial);
+    }
+
+    void testQueue()
+    {
+        for (int i = 0; i < 4; i++)
+            addDownload(QStringLiteral("/queued-%1").arg(i), DownloadManager::Queued);
+
+        DownloadManager manager;
+        manager.setMaximumActive(1);
+        int maximum = 0;
+        connect(&manager, &DownloadManager::activeCountChanged, this, [&] {
+            maximum = std::max(maximum, manager.activeCount());
+        });
+        QSignalSpy finishedSpy(&manager, &DownloadManager::downloadFinished);
+
+        QTRY_COMPARE(finishedSpy.count(), 4);
+        QCOMPARE(maximum, 1);
+        QCOMPARE(manager.activeCount(), 0);
+        // in the order they were added
+        for (int i = 0; i < 4; i++)
+            QCOMPARE(finishedSpy.at(i).at(0).toString(), QStringLiteral("queued-%1").arg(i));
+    }
+
+    void testPausedStayPaused()
+    {
+        const int id = addDownload(QStringLiteral("/paused"), DownloadManager::Paused, m_server.content().left(100));
+        // downloads that were never confirmed are dropped
+        addDownload(QStringLiteral("/requested"), DownloadManager::Requested);
+
+        {
+            DownloadManager manager;
+            QCOMPARE(manager.rowCount(), 1);
+            QTest::qWait(100);
+            QCOMPARE(state(manager, 0), DownloadManager::Paused);
+
+            manager.resume(id);
+            QTRY_COMPARE(state(manager, 0), DownloadManager::Completed);
+            QCOMPARE(fileContent(manager, 0), m_server.content());
+        }
+
+        // the state has been stored
+        DownloadManager manager;
+        QCOMPARE(state(manager, 0), DownloadManager::Completed);
+        manager.clearFinished();
+        QCOMPARE(manager.rowCount(), 0);
+        QVERIFY(QFile::exists(m_directory.filePath(QStringLiteral("paused"))));
+    }
+
+    void testCancel()
+    {
+        const int id = addDownload(QStringLiteral("/cancelled"), DownloadManager::Paused, m_server.content().left(100));
+
+        DownloadManager manager;
+        manager.cancel(id);
+        QCOMPARE(manager.rowCount(), 0);
+        QVERIFY(!QFile::exists(m_directory.filePath(QStringLiteral("cancelled"))));
+        QVERIFY(BrowserManager::instance()->downloads().isEmpty());
+    }
+
+private:
+    QTemporaryDir m_directory;
+    RangeServer m_server;
+};
+
+QTEST_GUILESS_MAIN(DownloadManagerTest)
+
+#include "downloadmanagertest.moc"
@@ -0,0 +1,107 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QJsonArray>
+
+#include "framemonitor.h"
+#include "metrics.h"
+#include "tracer.h"
+
+class FrameMonitorTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init()
+    {
+        Metrics::instance()->reset();
+    }
+
+    void testTracerHistory()
+    {
+        auto *tracer = Tracer::instance();
+        QVERIFY(!Tracer::enabled());
+
+        tracer->setHistorySize(3);
+        QVERIFY(Tracer::enabled());
+        tracer->complete("First", "test", 100, 10);
+        tracer->complete("Second", "test", 200, 10);
+        tracer->complete("Third", "test", 300, 10, QStringLiteral("detail"));
+        tracer->complete("Fourth", "test", 400, 10);
+
+        // the first one has been overwritten
+        const QVector<Tracer::Event> events = tracer->events(0, 1000);
+        QCOMPARE(events.size(), 3);
+        QCOMPARE(QByteArray(events.at(0).name), QByteArrayLiteral("Second"));
+        QCOMPARE(QByteArray(events.at(2).name), QByteArrayLiteral("Fourth"));
+        QCOMPARE(events.at(1).argument, QStringLiteral("detail"));
+        QCOMPARE(events.at(1).thread, Tracer::currentThread());
+
+        // only the ones overlapping the interval
+        const QVector<Tracer::Event> overlapping = tracer->events(305, 401);
+        QCOMPARE(overlapping.size(), 2);
+        QCOMPARE(QByteArray(overlapping.at(0).name), QByteArrayLiteral("Third"));
+
+        tracer->setHistorySize(0);
+        QVERIFY(!Tracer::enabled());
+        QVERIFY(tracer->events(0, 1000).isEmpty());
+    }
+
+    void testJankyFrames()
+    {
+        FrameMonitor monitor;
+        monitor.setBudget(10);
+        monitor.setEnabled(true);
+        QVERIFY(Tracer::enabled());
+
+        const qint64 start = Tracer::now();
+        monitor.addWakeUp(start - 5000);
+        monitor.addFrame(start);
+        monitor.addFrame(start + 10000);
+        monitor.addFrame(start + 20000);
+        // a handler blocks the GUI thread between two frames
+        Tracer::instance()->complete("SQL", "sql", start + 22000, 30000, QStringLiteral("SELECT 1"));
+        Tracer::instance()->complete("Before", "test", start + 1000, 2000);
+        monitor.addFrame(start + 60000);
+        // idle until the GUI thread wakes up for the next frame
+        monitor.addWakeUp(start + 2050000);
+        monitor.addFrame(start + 2060000);
+
+        QCOMPARE(monitor.frameCount(), 4);
+        QCOMPARE(monitor.jankCount(), 1);
+        QCOMPARE(monitor.worstFrame(), 40.0);
+        QCOMPARE(Metrics::instance()->value(QStringLiteral("frames.total")), qint64(4));
+        QCOMPARE(Metrics::instance()->value(QStringLiteral("frames.janky")), qint64(1));
+
+        const QVector<FrameMonitor::JankyFrame> frames = monitor.jankyFrames();
+        QCOMPARE(frames.size(), 1);
+        QCOMPARE(frames.first().start, start + 20000);
+        QCOMPARE(frames.first().interval, qint64(40000));
+        QCOMPARE(frames.first().operations.size(), 1);
+        QCOMPARE(QByteArray(frames.first().operations.first().name), QByteArrayLiteral("SQL"));
+
+        const QJsonObject report = monitor.report();
+        QCOMPARE(report.value(QStringLiteral("janky")).toInt(), 1);
+        QCOMPARE(report.value(QStringLiteral("interval_ms")).toObject().value(QStringLiteral("max")).toDouble(), 40.0);
+        const QJsonObject attribution = report.value(QStringLiteral("attribution")).toArray().first().toObject();
+        QCOMPARE(attribution.value(QStringLiteral("name")).toString(), QStringLiteral("SQL"));
+        QCOMPARE(attribution.value(QStringLiteral("overlap_ms")).toDouble(), 30.0);
+        QVERIFY(attribution.value(QStringLiteral("guiThread")).toBool());
+
+        monitor.reset();
+        QCOMPARE(monitor.jankCount(), 0);
+        QVERIFY(monitor.jankyFrames().isEmpty());
+
+        monitor.setEnabled(false);
+        QVERIFY(!Tracer::enabled());
+    }
+};
+
+QTEST_GUILESS_MAIN(FrameMonitorTest)
+
+#include "framemonitortest.moc"
@@ -0,0 +1,140 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QDateTime>
+#include <QSqlQuery>
+#include <QStandardPaths>
+
+#include "bookmarkshistorymodel.h"
+#include "browsermanager.h"
+#include "historysections.h"
+#include "topsitesmodel.h"
+
+class HistoryAggregatesTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static void visit(const QString &url)
+    {
+        BrowserManager::instance()->addToHistory({{QStringLiteral("url"), url}, {QStringLiteral("title"), url}});
+    }
+
+    // sets the last visit of url, as if it had been visited then
+    static void setLastVisited(const QString &url, qint64 lastVisited)
+    {
+        QSqlQuery query;
+        query.prepare(QStringLiteral("UPDATE history SET lastVisited = :lastVisited WHERE url = :url"));
+        query.bindValue(QStringLiteral(":lastVisited"), lastVisited);
+        query.bindValue(QStringLiteral(":url"), url);
+        QVERIFY(query.exec());
+    }
+
+    static QStringList hosts(const TopSitesModel &model)
+    {
+        QStringList hosts;
+        for (int i = 0; i < model.rowCount(); i++)
+            hosts.append(model.data(model.index(i), TopSitesModel::HostRole).toString());
+        return hosts;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QCoreApplication::setOrganizationName(QStringLiteral("autotests"));
+        QCoreApplication::setApplicationName(QStringLiteral("angelfish_historyaggregatestest"));
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.removeRecursively();
+        dir.mkpath(QStringLiteral("."));
+
+        BrowserManager::instance();
+    }
+
+    void cleanupTestCase()
+    {
+        delete BrowserManager::instance();
+    }
+
+    void testTopSites()
+    {
+        TopSitesModel model;
+        QCOMPARE(model.rowCount(), 0);
+
+        visit(QStringLiteral("https://kde.org/a"));
+        visit(QStringLiteral("https://kde.org/b"));
+        visit(QStringLiteral("https://plasma-mobile.org/"));
+        // pages without host are left out
+        visit(QStringLiteral("file:///home/user/page.html"));
+        QCOMPARE(hosts(model), (QStringList{QStringLiteral("kde.org"), QStringLiteral("plasma-mobile.org")}));
+        QCOMPARE(model.data(model.index(0), TopSitesModel::VisitsRole).toLongLong(), qint64(2));
+        QCOMPARE(model.data(model.index(0), TopSitesModel::UrlRole).toString(), QStringLiteral("https://kde.org/b"));
+
+        // every later visit is counted
+        const qint64 now = QDateTime::currentSecsSinceEpoch();
+        setLastVisited(QStringLiteral("https://plasma-mobile.org/"), now + 10);
+        setLastVisited(QStringLiteral("https://plasma-mobile.org/"), now + 20);
+        model.reload();
+        QCOMPARE(hosts(model), (QStringList{QStringLiteral("plasma-mobile.org"), QStringLiteral("kde.org")}));
+        QCOMPARE(model.data(model.index(0), TopSitesModel::VisitsRole).toLongLong(), qint64(3));
+
+        // the latest remaining page stands in for a removed one
+        BrowserManager::instance()->removeFromHistory(QStringLiteral("https://kde.org/b"));
+        QCOMPARE(model.data(model.index(1), TopSitesModel::UrlRole).toString(), QStringLiteral("https://kde.org/a"));
+        BrowserManager::instance()->removeFromHistory(QStringLiteral("https://kde.org/a"));
+        QCOMPARE(hosts(model), QStringList{QStringLiteral("plasma-mobile.org")});
+
+        model.setLimit(0);
+        QCOMPARE(model.rowCount(), 0);
+    }
+
+    void testSections()
+    {
+        HistorySections sections;
+        const qint64 entries = sections.today();
+        QVERIFY(entries > 0);
+        QCOMPARE(sections.yesterday(), qint64(0));
+        QCOMPARE(sections.older(), qint64(0));
+
+        const QDate today = QDate::currentDate();
+        visit(QStringLiteral("https://yesterday.example/"));
+        setLastVisited(QStringLiteral("https://yesterday.example/"), today.addDays(-1).startOfDay().toSecsSinceEpoch() + 60);
+        visit(QStringLiteral("https://older.example/"));
+        setLastVisited(QStringLiteral("https://older.example/"), today.addDays(-3).startOfDay().toSecsSinceEpoch() + 60);
+        visit(QStringLiteral("https://oldest.example/"));
+        setLastVisited(QStringLiteral("https://oldest.example/"), today.addDays(-30).startOfDay().toSecsSinceEpoch() + 60);
+
+        // the entries moved to their days, which is not announced
+        sections.reload();
+        QCOMPARE(sections.today(), entries);
+        QCOMPARE(sections.yesterday(), qint64(1));
+        QCOMPARE(sections.older(), qint64(2));
+
+        BrowserManager::instance()->removeFromHistory(QStringLiteral("https://oldest.example/"));
+        QCOMPARE(sections.older(), qint64(1));
+    }
+
+    void testSectionRole()
+    {
+        BookmarksHistoryModel model;
+        model.setHistory(true);
+        QVERIFY(model.rowCount() > 0);
+
+        const int role = model.roleNames().key("section");
+        const int urlRole = model.roleNames().key("url");
+        QHash<QString, int> sections;
+        for (int i = 0; i < model.rowCount(); i++)
+            sections.insert(model.data(model.index(i, 0), urlRole).toString(), model.data(model.index(i, 0), role).toInt());
+        QCOMPARE(sections.value(QStringLiteral("https://plasma-mobile.org/")), int(HistorySections::Today));
+        QCOMPARE(sections.value(QStringLiteral("https://yesterday.example/")), int(HistorySections::Yesterday));
+        QCOMPARE(sections.value(QStringLiteral("https://older.example/")), int(HistorySections::Older));
+    }
+};
+
+QTEST_GUILESS_MAIN(HistoryAggregatesTest)
+
+#include "historyaggregatestest.moc"
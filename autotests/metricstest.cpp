@@ -0,0 +1,109 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QThread>
+
+#include <memory>
+#include <vector>
+
+#include "metrics.h"
+
+class MetricsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init()
+    {
+        Metrics::instance()->reset();
+    }
+
+    void testValues()
+    {
+        auto *metrics = Metrics::instance();
+        metrics->add(QStringLiteral("sql.statements"));
+        metrics->add(QStringLiteral("sql.statements"), 2);
+        metrics->add(QStringLiteral("tabs.open"), 3);
+        metrics->add(QStringLiteral("tabs.open"), -1);
+        metrics->set(QStringLiteral("webengine.views"), 4);
+
+        QCOMPARE(metrics->value(QStringLiteral("sql.statements")), qint64(3));
+        QCOMPARE(metrics->value(QStringLiteral("tabs.open")), qint64(2));
+        QCOMPARE(metrics->value(QStringLiteral("webengine.views")), qint64(4));
+        QCOMPARE(metrics->value(QStringLiteral("unknown")), qint64(0));
+
+        const QVariantMap values = metrics->values();
+        QCOMPARE(values.size(), 3);
+        QCOMPARE(values.value(QStringLiteral("sql.statements")).toLongLong(), qint64(3));
+    }
+
+    void testProvider()
+    {
+        auto *metrics = Metrics::instance();
+        qint64 rows = 10;
+        metrics->setProvider(QStringLiteral("history.rows"), [&rows] {
+            return rows;
+        });
+
+        QCOMPARE(metrics->value(QStringLiteral("history.rows")), qint64(10));
+        rows = 20;
+        QCOMPARE(metrics->values().value(QStringLiteral("history.rows")).toLongLong(), qint64(20));
+
+        metrics->setProvider(QStringLiteral("history.rows"), {});
+        QVERIFY(!metrics->values().contains(QStringLiteral("history.rows")));
+    }
+
+    void testHistogram()
+    {
+        auto *metrics = Metrics::instance();
+        for (qint64 sample : {1, 3, 3, 40, 1000000})
+            metrics->record(QStringLiteral("page.load_ms"), sample);
+
+        const QVariantMap histogram = metrics->histograms().value(QStringLiteral("page.load_ms")).toMap();
+        QCOMPARE(histogram.value(QStringLiteral("count")).toLongLong(), qint64(5));
+        QCOMPARE(histogram.value(QStringLiteral("sum")).toLongLong(), qint64(1000047));
+        QCOMPARE(histogram.value(QStringLiteral("min")).toLongLong(), qint64(1));
+        QCOMPARE(histogram.value(QStringLiteral("max")).toLongLong(), qint64(1000000));
+
+        const QVariantList bounds = histogram.value(QStringLiteral("bounds")).toList();
+        const QVariantList buckets = histogram.value(QStringLiteral("buckets")).toList();
+        QCOMPARE(buckets.size(), bounds.size() + 1);
+        // 1 <= 1, 3 <= 5, 40 <= 50, the last one is larger than all bounds
+        QCOMPARE(buckets.at(bounds.indexOf(qint64(1))).toLongLong(), qint64(1));
+        QCOMPARE(buckets.at(bounds.indexOf(qint64(5))).toLongLong(), qint64(2));
+        QCOMPARE(buckets.at(bounds.indexOf(qint64(50))).toLongLong(), qint64(1));
+        QCOMPARE(buckets.last().toLongLong(), qint64(1));
+    }
+
+    void testThreads()
+    {
+        constexpr int threadCount = 4;
+        constexpr int iterations = 10000;
+
+        std::vector<std::unique_ptr<QThread>> threads;
+        for (int i = 0; i < threadCount; i++) {
+            threads.emplace_back(QThread::create([] {
+                for (int j = 0; j < iterations; j++) {
+                    Metrics::instance()->add(QStringLiteral("sql.statements"));
+                    Metrics::instance()->record(QStringLiteral("sql.latency_us"), j % 100);
+                }
+            }));
+            threads.back()->start();
+        }
+        for (const auto &thread : threads)
+            QVERIFY(thread->wait());
+
+        QCOMPARE(Metrics::instance()->value(QStringLiteral("sql.statements")), qint64(threadCount * iterations));
+        const QVariantMap histogram = Metrics::instance()->histograms().value(QStringLiteral("sql.latency_us")).toMap();
+        QCOMPARE(histogram.value(QStringLiteral("count")).toLongLong(), qint64(threadCount * iterations));
+    }
+};
+
+QTEST_GUILESS_MAIN(MetricsTest)
+
+#include "metricstest.moc"
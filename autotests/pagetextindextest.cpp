@@ -0,0 +1,150 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QStandardPaths>
+
+#include "bookmarkshistorymodel.h"
+#include "browsermanager.h"
+#include "dbmanager.h"
+#include "pagetextindex.h"
+
+class PageTextIndexTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static qint64 count(const QString &table)
+    {
+        QSqlQuery query;
+        if (!query.exec(QStringLiteral("SELECT COUNT(*) FROM %1").arg(table)) || !query.next())
+            return -1;
+        return query.value(0).toLongLong();
+    }
+
+    // adds the page to the history and indexes its text
+    bool index(PageTextIndex &index, const QString &url, const QString &text)
+    {
+        BrowserManager::instance()->addToHistory({{QStringLiteral("url"), url}, {QStringLiteral("title"), url}});
+        QSignalSpy spy(&index, &PageTextIndex::pageIndexed);
+        index.addPage(url, url, text);
+        if (!spy.wait())
+            return false;
+        return spy.first().at(1).toBool();
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QCoreApplication::setOrganizationName(QStringLiteral("autotests"));
+        QCoreApplication::setApplicationName(QStringLiteral("angelfish_pagetextindextest"));
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.mkpath(QStringLiteral("."));
+
+        if (!BrowserManager::instance()->hasPageText())
+            QSKIP("SQLite lacks FTS5");
+    }
+
+    void cleanupTestCase()
+    {
+        delete BrowserManager::instance();
+    }
+
+    void testMatch()
+    {
+        QCOMPARE(DBManager::pageTextMatch(QStringLiteral("plasma mo\"bile")), QStringLiteral("\"plasma\" \"mo\" \"bile\"*"));
+        QCOMPARE(DBManager::pageTextMatch(QStringLiteral("Grüße")), QStringLiteral("\"Grüße\"*"));
+        QVERIFY(DBManager::pageTextMatch(QStringLiteral(" ,. ")).isEmpty());
+    }
+
+    void testSearch()
+    {
+        PageTextIndex index;
+        index.setEnabled(true);
+        QVERIFY(this->index(index, QStringLiteral("https://plasma-mobile.org/"), QStringLiteral("Plasma Mobile runs on phones")));
+
+        BookmarksHistoryModel model;
+        model.setHistory(true);
+        model.setFilter(QStringLiteral("phon"));
+        QCOMPARE(model.rowCount(), 0);
+
+        model.setPageText(true);
+        QCOMPARE(model.rowCount(), 1);
+        QCOMPARE(model.data(model.index(0, 0), model.roleNames().key("url")).toString(), QStringLiteral("https://plasma-mobile.org/"));
+        QVERIFY(model.data(model.index(0, 0), model.roleNames().key("snippet")).toString().contains(QStringLiteral("phones")));
+
+        // still found by its url
+        model.setFilter(QStringLiteral("plasma-mobile"));
+        QCOMPARE(model.rowCount(), 1);
+    }
+
+    void testPrivate()
+    {
+        // pages of private tabs are never added to the history
+        PageTextIndex index;
+        index.setEnabled(true);
+        QSignalSpy spy(&index, &PageTextIndex::pageIndexed);
+        index.addPage(QStringLiteral("https://private.example/"), QStringLiteral("Private"), QStringLiteral("secret"));
+        QVERIFY(spy.wait());
+        QVERIFY(!spy.first().at(1).toBool());
+
+        // only web pages are indexed
+        QVERIFY(!index.shouldIndex(QUrl(QStringLiteral("file:///home/user/page.html"))));
+        index.setEnabled(false);
+        QVERIFY(!index.shouldIndex(QUrl(QStringLiteral("https://kde.org/"))));
+    }
+
+    void testRemovedWithHistory()
+    {
+        PageTextIndex index;
+        index.setEnabled(true);
+        QVERIFY(this->index(index, QStringLiteral("https://kde.org/"), QStringLiteral("Community")));
+        const qint64 pages = count(QStringLiteral("pagetextinfo"));
+
+        BrowserManager::instance()->removeFromHistory(QStringLiteral("https://kde.org/"));
+        QCOMPARE(count(QStringLiteral("pagetextinfo")), pages - 1);
+        QCOMPARE(count(QStringLiteral("pagetext")), pages - 1);
+    }
+
+    void testMaximumSize()
+    {
+        BrowserManager::instance()->clearPageText();
+        PageTextIndex index;
+        index.setEnabled(true);
+        // a little more than two of the pages
+        index.setMaximumSize(120);
+        QVERIFY(this->index(index, QStringLiteral("https://a.example/"), QString(40, QLatin1Char('a'))));
+        QVERIFY(this->index(index, QStringLiteral("https://b.example/"), QString(40, QLatin1Char('b'))));
+
+        // the oldest text is removed
+        QVERIFY(this->index(index, QStringLiteral("https://c.example/"), QString(40, QLatin1Char('c'))));
+        QSqlQuery query;
+        QVERIFY(query.exec(QStringLiteral("SELECT url FROM pagetextinfo ORDER BY url")));
+        QStringList urls;
+        while (query.next())
+            urls.append(query.value(0).toString());
+        QCOMPARE(urls, (QStringList{QStringLiteral("https://b.example/"), QStringLiteral("https://c.example/")}));
+    }
+
+    void testDisable()
+    {
+        PageTextIndex index;
+        index.setEnabled(true);
+        QVERIFY(this->index(index, QStringLiteral("https://kde.org/"), QStringLiteral("Community")));
+        QVERIFY(count(QStringLiteral("pagetext")) > 0);
+
+        index.setEnabled(false);
+        QCOMPARE(count(QStringLiteral("pagetext")), qint64(0));
+        QCOMPARE(count(QStringLiteral("pagetextinfo")), qint64(0));
+    }
+};
+
+QTEST_GUILESS_MAIN(PageTextIndexTest)
+
+#include "pagetextindextest.moc"
@@ -0,0 +1,47 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "processmemory.h"
+
+class ProcessMemoryTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testReadKilobytes()
+    {
+        QTemporaryDir dir;
+        const QString path = dir.filePath(QStringLiteral("status"));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("Name:\tangelfish\nVmHWM:\t  204800 kB\nVmRSS:\t  102400 kB\n");
+        file.close();
+
+        QCOMPARE(ProcessMemory::readKilobytes(path, QByteArrayLiteral("VmRSS:")), qint64(102400));
+        QCOMPARE(ProcessMemory::readKilobytes(path, QByteArrayLiteral("VmSwap:")), qint64(-1));
+        QCOMPARE(ProcessMemory::readKilobytes(dir.filePath(QStringLiteral("missing")), QByteArrayLiteral("VmRSS:")), qint64(-1));
+    }
+
+    void testResident()
+    {
+#ifdef Q_OS_LINUX
+        QVERIFY(ProcessMemory::resident() > 0);
+        QVERIFY(ProcessMemory::resident(QCoreApplication::applicationPid()) > 0);
+#else
+        QSKIP("Needs procfs");
+#endif
+    }
+};
+
+QTEST_GUILESS_MAIN(ProcessMemoryTest)
+
+#include "processmemorytest.moc"
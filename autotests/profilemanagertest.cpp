@@ -0,0 +1,363 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QDebug>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJSEngine>
+#include <QPointer>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtWebEngine>
+#include <QtWebEngine/QQuickWebEngineProfile>
+
+#include "profilemanager.h"
+#include "useragent.h"
+#include "useragentrules.h"
+
+// The browser window provides these to WebView.qml, only what is used while
+// loading a private page is stubbed.
+static QJSValue stub(QJSEngine *engine, const char *object)
+{
+    return engine->evaluate(QString::fromLatin1(object));
+}
+
+static void registerStubs()
+{
+    const char *uri = "org.kde.mobile.angelfish";
+    qmlRegisterType<UserAgent>(uri, 1, 0, "UserAgentGenerator");
+    qmlRegisterType<ProfileManager>(uri, 1, 0, "ProfileManager");
+    qmlRegisterSingletonType(uri, 1, 0, "Settings", [](QQmlEngine *, QJSEngine *engine) -> QJSValue {
+        return stub(engine, "({webAutoLoadImages: true, webJavaScriptEnabled: true, searchBaseUrl: ''})");
+    });
+    qmlRegisterSingletonType(uri, 1, 0, "BrowserManager", [](QQmlEngine *, QJSEngine *engine) -> QJSValue {
+        // pages mentioning the desktop ask for the desktop agent
+        return stub(engine,
+                    "({userAgentRuleForUrl: function(url) {"
+                    "    return String(url).indexOf('desktop') >= 0 ? {pattern: 'desktop', mode: 1} : {};"
+                    "}})");
+    });
+    qmlRegisterSingletonType(uri, 1, 0, "Adblock", [](QQmlEngine *, QJSEngine *engine) -> QJSValue {
+        return stub(engine,
+                    "({startPage: function(view, url) {}, setPageUrl: function(view, url) {},"
+                    "  blockedCount: function(view) { return 0; }})");
+    });
+    qmlRegisterSingletonType(uri, 1, 0, "DataSaver", [](QQmlEngine *, QJSEngine *engine) -> QJSValue {
+        return stub(engine, "({showPage: function(view, url) {}, pageStatistics: function(url) { return {}; }})");
+    });
+    qmlRegisterSingletonType(uri, 1, 0, "Snapshots", [](QQmlEngine *, QJSEngine *engine) -> QJSValue {
+        return stub(engine, "({isSnapshot: function(url) { return false; }, hasSnapshot: function(url) { return false; }})");
+    });
+    qmlRegisterSingletonType(uri, 1, 0, "Metrics", [](QQmlEngine *, QJSEngine *engine) -> QJSValue {
+        return stub(engine, "({add: function(name, delta) {}, record: function(name, value) {}})");
+    });
+    qmlRegisterSingletonType(uri, 1, 0, "Startup", [](QQmlEngine *, QJSEngine *engine) -> QJSValue {
+        return stub(engine, "({pageLoaded: function() {}})");
+    });
+}
+
+class ProfileManagerTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QUrl page(const QString &text)
+    {
+        return QUrl(QStringLiteral("data:text/html,<p>%1</p>").arg(text));
+    }
+
+    // a private tab of the browser, using the WebView.qml of the application
+    static QObject *createWindow(QQmlEngine &engine)
+    {
+        QQmlComponent component(&engine);
+        component.setData(QByteArrayLiteral(R"(
+            import QtQuick 2.7
+            import QtQuick.Window 2.2
+            import QtWebEngine 1.10
+            import org.kde.mobile.angelfish 1.0
+
+            Window {
+                property alias view: view
+                width: 200
+                height: 200
+                visible: true
+
+                function i18n(text) { return text; }
+
+                ProfileManager {
+                    id: profileManager
+                }
+
+                WebView {
+                    id: view
+                    anchors.fill: parent
+                    privateMode: true
+                    profile: profileManager.profile("Private", true, view.profileUserAgent)
+                    property int loadsStarted: 0
+                    property var loadedUrls: []
+                    onLoadingChanged: {
+                        if (loadRequest.status === WebEngineView.LoadStartedStatus)
+                            loadsStarted++;
+                        if (loadRequest.status === WebEngineView.LoadSucceededStatus)
+                            loadedUrls = loadedUrls.concat([String(loadRequest.url)]);
+                    }
+                }
+            })"),
+                          // next to WebView.qml, which makes it available as a type
+                          QUrl::fromLocalFile(QStringLiteral(ANGELFISH_QML_DIR "/profilemanagertest.qml")));
+        QObject *window = component.create();
+        if (!window)
+            qWarning() << component.errorString();
+        return window;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        registerStubs();
+        m_mobileAgent = UserAgent().userAgent();
+        UserAgent desktop;
+        desktop.setIsMobile(false);
+        m_desktopAgent = desktop.userAgent();
+    }
+
+    void testProfilePerAgent()
+    {
+        ProfileManager manager;
+
+        auto *mobile = manager.profile(QStringLiteral("Test"), false, m_mobileAgent);
+        auto *desktop = manager.profile(QStringLiteral("Test"), false, m_desktopAgent);
+        QVERIFY(mobile != desktop);
+
+        // profiles are reused
+        QCOMPARE(manager.profile(QStringLiteral("Test"), false, m_mobileAgent), mobile);
+        QCOMPARE(manager.profiles().count(), 2);
+
+        QCOMPARE(mobile->httpUserAgent(), m_mobileAgent);
+        QCOMPARE(desktop->httpUserAgent(), m_desktopAgent);
+
+        // on disk storage can't be shared between two profiles
+        QCOMPARE(mobile->storageName(), QStringLiteral("Test"));
+        QCOMPARE(desktop->storageName(), QStringLiteral("Test-desktop"));
+    }
+
+    void testOffTheRecordProfiles()
+    {
+        ProfileManager manager;
+
+        auto *mobile = manager.profile(QStringLiteral("Private"), true, m_mobileAgent);
+        auto *desktop = manager.profile(QStringLiteral("Private"), true, m_desktopAgent);
+        QVERIFY(mobile != desktop);
+        QVERIFY(mobile->isOffTheRecord());
+        QVERIFY(desktop->isOffTheRecord());
+        QCOMPARE(mobile->storageName(), desktop->storageName());
+    }
+
+    void testReleaseOffTheRecordProfiles()
+    {
+        ProfileManager manager;
+
+        auto *regular = manager.profile(QStringLiteral("Test"), false, m_mobileAgent);
+        QPointer<QQuickWebEngineProfile> mobile = manager.profile(QStringLiteral("Private"), true, m_mobileAgent);
+        QPointer<QQuickWebEngineProfile> desktop = manager.profile(QStringLiteral("Private"), true, m_desktopAgent);
+
+        manager.releaseOffTheRecordProfiles();
+        QCOMPARE(manager.profiles(), QVector<QQuickWebEngineProfile *>{regular});
+        QTRY_VERIFY(!mobile && !desktop);
+
+        // created again when needed
+        auto *recreated = manager.profile(QStringLiteral("Private"), true, m_mobileAgent);
+        QVERIFY(recreated->isOffTheRecord());
+        QCOMPARE(manager.profile(QStringLiteral("Test"), false, m_mobileAgent), regular);
+    }
+
+    void testSingleLoadPerNavigation()
+    {
+        QQmlEngine engine;
+        QScopedPointer<QObject> window(createWindow(engine));
+        QVERIFY(window);
+        auto *view = window->property("view").value<QObject *>();
+        QVERIFY(view);
+
+        const auto loadsStarted = [view] {
+            return view->property("loadsStarted").toInt();
+        };
+
+        // every navigation must start exactly one load
+        view->setProperty("url", page(QStringLiteral("first")));
+        QTRY_COMPARE(loadsStarted(), 1);
+        QTRY_VERIFY(view->property("loading").toBool() == false);
+
+        view->setProperty("url", page(QStringLiteral("second")));
+        QTRY_COMPARE(loadsStarted(), 2);
+        QTRY_VERIFY(view->property("loading").toBool() == false);
+
+        // switching the agent loads the page once again with the new agent
+        auto *userAgent = view->property("userAgent").value<QObject *>();
+        userAgent->setProperty("isMobile", false);
+        QTRY_COMPARE(loadsStarted(), 3);
+        QTRY_VERIFY(view->property("loading").toBool() == false);
+        QCOMPARE(view->property("profileUserAgent").toString(), m_desktopAgent);
+        QCOMPARE(view->property("url").toUrl(), page(QStringLiteral("second")));
+
+        // give stray reloads a chance to show up
+        QTest::qWait(500);
+        QCOMPARE(loadsStarted(), 3);
+    }
+
+    void testApplyRule()
+    {
+        UserAgent agent;
+        QSignalSpy spy(&agent, &UserAgent::userAgentChanged);
+
+        // a rule for the agent in use changes nothing
+        QVERIFY(!agent.applyRule({{QStringLiteral("mode"), int(UserAgentRules::Mobile)}}));
+        QCOMPARE(agent.userAgent(), m_mobileAgent);
+
+        QVERIFY(agent.applyRule({{QStringLiteral("mode"), int(UserAgentRules::Desktop)}}));
+        QCOMPARE(agent.userAgent(), m_desktopAgent);
+        QVERIFY(!agent.isMobile());
+
+        const QString custom = QStringLiteral("Agent/1.0");
+        QVERIFY(agent.applyRule({{QStringLiteral("mode"), int(UserAgentRules::Custom)}, {QStringLiteral("userAgent"), custom}}));
+        QCOMPARE(agent.userAgent(), custom);
+
+        // leaving the sites with rules restores the agent chosen for the tab
+        QVERIFY(agent.applyRule({}));
+        QCOMPARE(agent.userAgent(), m_mobileAgent);
+        QVERIFY(agent.isMobile());
+        QVERIFY(agent.customUserAgent().isEmpty());
+        QVERIFY(!agent.applyRule({}));
+
+        // also if it has been the desktop agent
+        agent.setIsMobile(false);
+        QVERIFY(agent.applyRule({{QStringLiteral("mode"), int(UserAgentRules::Mobile)}}));
+        QVERIFY(agent.isMobile());
+        QVERIFY(agent.applyRule({}));
+        QCOMPARE(agent.userAgent(), m_desktopAgent);
+        QVERIFY(spy.count() > 0);
+    }
+
+    void testRuleSwitchLoadsOnce()
+    {
+        QQmlEngine engine;
+        QScopedPointer<QObject> window(createWindow(engine));
+        QVERIFY(window);
+        auto *view = window->property("view").value<QObject *>();
+        QVERIFY(view);
+
+        const auto loadedUrls = [view] {
+            return view->property("loadedUrls").toStringList();
+        };
+
+        view->setProperty("url", page(QStringLiteral("first")));
+        QTRY_COMPARE(loadedUrls().count(), 1);
+
+        // the page of the rule is loaded once, with the agent of the rule
+        view->setProperty("url", page(QStringLiteral("desktop")));
+        QTRY_COMPARE(loadedUrls().count(), 2);
+        QCOMPARE(loadedUrls().last(), page(QStringLiteral("desktop")).toString());
+        QCOMPARE(view->property("profileUserAgent").toString(), m_desktopAgent);
+
+        // the previous page is not reloaded
+        QTest::qWait(500);
+        QCOMPARE(loadedUrls().count(), 2);
+        QCOMPARE(view->property("droppedReloadUrl").toString(), QString());
+
+        // but loading it again later is not dropped
+        view->setProperty("url", page(QStringLiteral("first")));
+        QTRY_COMPARE(loadedUrls().count(), 3);
+        QCOMPARE(loadedUrls().last(), page(QStringLiteral("first")).toString());
+    }
+
+    void testAgentSwitchKeepsCurrentPage()
+    {
+        QQmlEngine engine;
+        QScopedPointer<QObject> window(createWindow(engine));
+        QVERIFY(window);
+        auto *view = window->property("view").value<QObject *>();
+        QVERIFY(view);
+
+        view->setProperty("url", page(QStringLiteral("first")));
+        QTRY_VERIFY(view->property("url").toUrl() == page(QStringLiteral("first")) && !view->property("loading").toBool());
+        view->setProperty("url", page(QStringLiteral("second")));
+        QTRY_VERIFY(view->property("url").toUrl() == page(QStringLiteral("second")) && !view->property("loading").toBool());
+        QVERIFY(view->property("canGoBack").toBool());
+
+        // only the current page is carried over to the new profile
+        view->property("userAgent").value<QObject *>()->setProperty("isMobile", false);
+        QTRY_COMPARE(view->property("profileUserAgent").toString(), m_desktopAgent);
+        QTRY_VERIFY(!view->property("loading").toBool());
+        QCOMPARE(view->property("url").toUrl(), page(QStringLiteral("second")));
+        QVERIFY(!view->property("canGoBack").toBool());
+        QVERIFY(!view->property("canGoForward").toBool());
+    }
+
+    void testRedirectingCarriedPage()
+    {
+        // a site sending other agents to a page of their own
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto writePage = [&dir](const QString &name, const QByteArray &html) {
+            QFile file(dir.filePath(name));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(html);
+        };
+        writePage(QStringLiteral("start.html"),
+                  "<script>if (navigator.userAgent.indexOf('Mobile') < 0) location.replace('large.html');</script><p>start</p>");
+        writePage(QStringLiteral("large.html"), "<p>large</p>");
+        const QUrl start = QUrl::fromLocalFile(dir.filePath(QStringLiteral("start.html")));
+        const QUrl large = QUrl::fromLocalFile(dir.filePath(QStringLiteral("large.html")));
+
+        QQmlEngine engine;
+        QScopedPointer<QObject> window(createWindow(engine));
+        QVERIFY(window);
+        auto *view = window->property("view").value<QObject *>();
+        QVERIFY(view);
+
+        view->setProperty("url", start);
+        QTRY_VERIFY(!view->property("loading").toBool() && view->property("loadedUrls").toStringList().count() == 1);
+        QCOMPARE(view->property("url").toUrl(), start);
+
+        // the carried page is loaded with the new agent and follows its redirect
+        view->property("userAgent").value<QObject *>()->setProperty("isMobile", false);
+        QTRY_COMPARE(view->property("url").toUrl(), large);
+        QTRY_VERIFY(!view->property("loading").toBool());
+        QCOMPARE(view->property("profileUserAgent").toString(), m_desktopAgent);
+        QVERIFY(!view->property("canGoBack").toBool());
+
+        // nothing is loaded again afterwards
+        const int loads = view->property("loadsStarted").toInt();
+        QTest::qWait(500);
+        QCOMPARE(view->property("loadsStarted").toInt(), loads);
+        QCOMPARE(view->property("url").toUrl(), large);
+
+        // and the history of the new profile works as usual
+        view->setProperty("url", page(QStringLiteral("next")));
+        QTRY_VERIFY(view->property("url").toUrl() == page(QStringLiteral("next")) && !view->property("loading").toBool());
+        QMetaObject::invokeMethod(view, "goBack");
+        QTRY_COMPARE(view->property("url").toUrl(), large);
+    }
+
+private:
+    QString m_mobileAgent;
+    QString m_desktopAgent;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+    QtWebEngine::initialize();
+    QGuiApplication app(argc, argv);
+    ProfileManagerTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "profilemanagertest.moc"
@@ -0,0 +1,322 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QRegularExpression>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+
+#include <functional>
+
+#include "bookmarkshistorymodel.h"
+#include "browsermanager.h"
+#include "datagenerator.h"
+#include "dbmanager.h"
+#include "iconimageprovider.h"
+
+// Checks how SQLite runs the statements of the browser. Every statement run
+// by an operation is explained, and the tables it reads completely are
+// compared with the scans expected for the operation. A scan ordered by an
+// index is listed with the index, as it stops at the LIMIT. Lookups by a key
+// never scan, so a statement losing its index fails here long before the
+// history is large enough for anyone to notice.
+
+constexpr int HISTORY_ROWS = 5000;
+constexpr int BOOKMARK_ROWS = 200;
+
+// tables of the browser, scans of subqueries and constant rows are fine
+static const QStringList TABLES = {
+    QStringLiteral("bookmarks"),
+    QStringLiteral("history"),
+    QStringLiteral("icons"),
+    QStringLiteral("useragentrules"),
+    QStringLiteral("snapshots"),
+    QStringLiteral("downloads"),
+    QStringLiteral("pagetimings"),
+    QStringLiteral("pagetextinfo"),
+    QStringLiteral("historydays"),
+    QStringLiteral("historyhosts"),
+};
+
+// statements without a query plan
+static const QStringList UNPLANNED = {
+    QStringLiteral("PRAGMA"),
+    QStringLiteral("BEGIN"),
+    QStringLiteral("COMMIT"),
+    QStringLiteral("ROLLBACK"),
+    QStringLiteral("CREATE"),
+    QStringLiteral("ALTER"),
+    QStringLiteral("DROP"),
+    QStringLiteral("ATTACH"),
+    QStringLiteral("DETACH"),
+};
+
+class QueryPlanTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    // detail lines of the query plan, placeholders are bound to NULL
+    static QStringList queryPlan(const QString &sql)
+    {
+        static const QRegularExpression placeholder(QStringLiteral(":\\w+"));
+
+        QSqlQuery query;
+        if (!query.prepare(QStringLiteral("EXPLAIN QUERY PLAN ") + sql)) {
+            qWarning() << sql << query.lastError();
+            return {QStringLiteral("INVALID")};
+        }
+        auto it = placeholder.globalMatch(sql);
+        while (it.hasNext())
+            query.bindValue(it.next().captured(), QVariant());
+        if (!query.exec()) {
+            qWarning() << sql << query.lastError();
+            return {QStringLiteral("INVALID")};
+        }
+
+        QStringList plan;
+        while (query.next())
+            plan.append(query.value(QStringLiteral("detail")).toString());
+        return plan;
+    }
+
+    // the scans of tables by the statements run by operation
+    QStringList scans(const std::function<void()> &operation)
+    {
+        // older versions of SQLite write SCAN TABLE
+        static const QRegularExpression scan(QStringLiteral("^SCAN (?:TABLE )?(\\w+)(.*)$"));
+
+        m_statements.clear();
+        operation();
+
+        QStringList scans;
+        for (const QString &sql : qAsConst(m_statements)) {
+            const QString command = sql.section(QLatin1Char(' '), 0, 0, QString::SectionSkipEmpty).toUpper();
+            if (UNPLANNED.contains(command))
+                continue;
+
+            for (const QString &detail : queryPlan(sql)) {
+                const auto match = scan.match(detail);
+                if (detail == QLatin1String("INVALID")) {
+                    scans.append(detail);
+                } else if (match.hasMatch() && TABLES.contains(match.captured(1))) {
+                    const QString line = QStringLiteral("SCAN ") + match.captured(1) + match.captured(2);
+                    if (!scans.contains(line)) {
+                        qDebug() << line << "by" << sql.simplified();
+                        scans.append(line);
+                    }
+                }
+            }
+        }
+        scans.sort();
+        return scans;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QCoreApplication::setOrganizationName(QStringLiteral("autotests"));
+        QCoreApplication::setApplicationName(QStringLiteral("angelfish_queryplantest"));
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.removeRecursively();
+        dir.mkpath(QStringLiteral("."));
+
+        m_manager = BrowserManager::instance();
+        DataGenerator generator;
+        QSqlDatabase database = QSqlDatabase::database();
+        QVERIFY(generator.populate(database, HISTORY_ROWS, BOOKMARK_ROWS));
+
+        QSqlQuery sample;
+        QVERIFY(sample.exec(QStringLiteral("SELECT url, icon, domain FROM history ORDER BY lastVisited DESC LIMIT 1")));
+        QVERIFY(sample.next());
+        m_url = sample.value(0).toString();
+        m_icon = sample.value(1).toString();
+        m_domain = sample.value(2).toString();
+        sample.finish();
+
+        DBManager::setStatementObserver([this](const QString &sql) {
+            m_statements.append(sql);
+        });
+    }
+
+    void cleanupTestCase()
+    {
+        DBManager::setStatementObserver({});
+    }
+
+    void testBookmarksAndHistory()
+    {
+        const QVariantMap page = {{QStringLiteral("url"), QStringLiteral("https://kde.org/")}, {QStringLiteral("title"), QStringLiteral("KDE")}};
+        const QString favicon = QStringLiteral("image://favicon/") + m_icon.mid(QStringLiteral("image://%1/").arg(IconImageProvider::providerId()).size());
+
+        QCOMPARE(scans([&] { m_manager->addBookmark(page); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->addToHistory(page); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->isBookmarked(m_url); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->updateLastVisited(m_url); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->updateIcon(m_url, favicon); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->removeBookmark(QStringLiteral("https://kde.org/")); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->removeFromHistory(QStringLiteral("https://kde.org/")); }), QStringList());
+    }
+
+    void testIcons()
+    {
+        IconImageProvider provider(nullptr);
+        const QString id = m_icon.mid(QStringLiteral("image://%1/").arg(IconImageProvider::providerId()).size());
+
+        QCOMPARE(scans([&] { QVERIFY(!provider.requestImage(id, nullptr, QSize()).isNull()); }), QStringList());
+        // the icon is stored already, so no image provider is needed
+        QCOMPARE(scans([&] { QCOMPARE(IconImageProvider::storeImage(QStringLiteral("image://favicon/") + id), m_icon); }), QStringList());
+    }
+
+    void testUserAgentRules()
+    {
+        // the rules are loaded all at once after every change
+        const QStringList reload = {QStringLiteral("SCAN useragentrules")};
+        QCOMPARE(scans([&] { m_manager->setUserAgentRule(QStringLiteral("kde.org"), 1); }), reload);
+        QCOMPARE(scans([&] { m_manager->removeUserAgentRule(QStringLiteral("kde.org")); }), reload);
+    }
+
+    void testSnapshots()
+    {
+        QCOMPARE(scans([&] { m_manager->addSnapshot(m_url, QStringLiteral("a"), QStringLiteral("A"), 100); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->addSnapshot(QStringLiteral("https://kde.org/"), QStringLiteral("b"), QStringLiteral("B"), 100); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->snapshot(m_url); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->touchSnapshot(m_url); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->removeSnapshot(m_url); }), QStringList());
+
+        // sums up all files, the least recently used ones are removed
+        const QStringList size = {QStringLiteral("SCAN snapshots USING INDEX idx_snapshots_hash")};
+        QCOMPARE(scans([&] { m_manager->snapshotsSize(); }), size);
+        QCOMPARE(scans([&] { m_manager->trimSnapshots(0); }),
+                 size + QStringList{QStringLiteral("SCAN snapshots USING INDEX idx_snapshots_lastAccessed")});
+    }
+
+    void testDownloads()
+    {
+        int id = -1;
+        QCOMPARE(scans([&] {
+                     id = m_manager->addDownload({{QStringLiteral("url"), QStringLiteral("https://kde.org/file.iso")}});
+                 }),
+                 QStringList());
+        QCOMPARE(scans([&] { m_manager->updateDownload(id, 10, 100, 1); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->setDownloadValidator(id, QStringLiteral("\"etag\"")); }), QStringList());
+        // the downloads are loaded all at once on startup
+        QCOMPARE(scans([&] { m_manager->downloads(); }), QStringList{QStringLiteral("SCAN downloads")});
+        QCOMPARE(scans([&] { m_manager->removeDownload(id); }), QStringList());
+    }
+
+    void testPageTimings()
+    {
+        const QVariantMap timing = {{QStringLiteral("ttfb"), 100}, {QStringLiteral("transferSize"), 20000}};
+        QCOMPARE(scans([&] { m_manager->addPageTiming(m_url, timing); }), QStringList());
+        QCOMPARE(scans([&] { m_manager->addPageTiming(m_url, timing); }), QStringList());
+        // read all at once by the site performance page
+        QCOMPARE(scans([&] { m_manager->pageTimings(); }), QStringList{QStringLiteral("SCAN pagetimings")});
+    }
+
+    void testHistoryAggregates()
+    {
+        // read in the order of the index, up to the limit
+        QCOMPARE(scans([&] { m_manager->topSites(8); }), QStringList{QStringLiteral("SCAN historyhosts USING INDEX idx_historyhosts_visits")});
+        // a row per day with history, read at once
+        QCOMPARE(scans([&] { m_manager->historyDays(); }), QStringList{QStringLiteral("SCAN historydays")});
+    }
+
+    void testPageText()
+    {
+        if (!m_manager->hasPageText())
+            QSKIP("SQLite lacks FTS5");
+
+        const QString text = QStringLiteral("Plasma Mobile");
+        const QString databaseFile = m_manager->databaseFile();
+        // the size of all texts is summed up after every page
+        const QStringList size = {QStringLiteral("SCAN pagetextinfo")};
+        QCOMPARE(scans([&] { QVERIFY(DBManager::addPageText(databaseFile, m_url, text, text, 1000)); }), size);
+        QCOMPARE(scans([&] { QVERIFY(DBManager::addPageText(databaseFile, m_url, text, text, 1000)); }), size);
+        QCOMPARE(scans([&] { QVERIFY(DBManager::addPageText(databaseFile, m_url, text, text, 0)); }),
+                 size + QStringList{QStringLiteral("SCAN pagetextinfo USING INDEX idx_pagetextinfo_indexed")});
+        QCOMPARE(scans([&] { QVERIFY(!DBManager::addPageText(databaseFile, QStringLiteral("https://unvisited.example/"), text, text, 1000)); }),
+                 QStringList());
+        QCOMPARE(scans([&] { m_manager->clearPageText(); }), QStringList());
+    }
+
+    void testMaintenance()
+    {
+        // every icon is looked up in history and bookmarks
+        const QStringList icons = {QStringLiteral("SCAN icons")};
+        QCOMPARE(scans([&] { QVERIFY(DBManager::runMaintenance(m_manager->databaseFile()) >= 0); }),
+                 QStringList{QStringLiteral("SCAN history USING INDEX idx_history_visited")} + icons);
+
+        const qint64 now = QDateTime::currentSecsSinceEpoch();
+        QCOMPARE(scans([&] { QVERIFY(DBManager::removeHistoryRange(m_manager->databaseFile(), now - 60 * 60, now) >= 0); }), icons);
+    }
+
+    void testModel_data()
+    {
+        QTest::addColumn<bool>("bookmarks");
+        QTest::addColumn<bool>("history");
+        QTest::addColumn<QString>("filter");
+        QTest::addColumn<bool>("domain");
+        QTest::addColumn<bool>("pageText");
+        QTest::addColumn<QStringList>("expected");
+
+        // substrings can't be looked up in an index
+        const QStringList search = {QStringLiteral("SCAN bookmarks"), QStringLiteral("SCAN history")};
+        const QStringList recent = {QStringLiteral("SCAN history USING INDEX idx_history_lastVisited")};
+
+        QTest::newRow("history") << false << true << QString() << false << false << recent;
+        QTest::newRow("bookmarks") << true << false << QString() << false << false << QStringList{QStringLiteral("SCAN bookmarks")};
+        QTest::newRow("both") << true << true << QString() << false << false << QStringList{QStringLiteral("SCAN bookmarks")};
+        QTest::newRow("domain") << false << true << QString() << true << false << QStringList();
+        QTest::newRow("both domain") << true << true << QString() << true << false << QStringList();
+        QTest::newRow("history filter") << false << true << QStringLiteral("plasma") << false << false << recent;
+        // the matching texts are looked up once, the history is still read by recency
+        QTest::newRow("history page text") << false << true << QStringLiteral("plasma") << false << true << recent;
+        QTest::newRow("both filter") << true << true << QStringLiteral("plasma") << false << false << search;
+    }
+
+    void testModel()
+    {
+        QFETCH(bool, bookmarks);
+        QFETCH(bool, history);
+        QFETCH(QString, filter);
+        QFETCH(bool, domain);
+        QFETCH(bool, pageText);
+        QFETCH(QStringList, expected);
+
+        if (pageText && !m_manager->hasPageText())
+            QSKIP("SQLite lacks FTS5");
+
+        BookmarksHistoryModel model;
+        model.setActive(false);
+        model.setBookmarks(bookmarks);
+        model.setHistory(history);
+        model.setFilter(filter);
+        if (domain)
+            model.setDomain(m_domain);
+        model.setPageText(pageText);
+
+        QCOMPARE(scans([&] { model.setActive(true); }), expected);
+        QVERIFY(model.rowCount() > 0);
+    }
+
+private:
+    BrowserManager *m_manager = nullptr;
+    QStringList m_statements;
+    // most recently visited entry of the generated history
+    QString m_url;
+    QString m_icon;
+    QString m_domain;
+};
+
+QTEST_GUILESS_MAIN(QueryPlanTest)
+
+#include "queryplantest.moc"
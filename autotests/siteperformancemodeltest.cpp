@@ -0,0 +1,118 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QSqlQuery>
+#include <QStandardPaths>
+
+#include "browsermanager.h"
+#include "pagetimings.h"
+#include "siteperformancemodel.h"
+
+class SitePerformanceModelTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    QVariantMap timing(qint64 ttfb, qint64 firstContentfulPaint = -1)
+    {
+        return {
+            {QStringLiteral("ttfb"), ttfb},
+            {QStringLiteral("domContentLoaded"), ttfb * 3},
+            {QStringLiteral("firstContentfulPaint"), firstContentfulPaint},
+            {QStringLiteral("transferSize"), 20000},
+        };
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QCoreApplication::setOrganizationName(QStringLiteral("autotests"));
+        QCoreApplication::setApplicationName(QStringLiteral("angelfish_siteperformancemodeltest"));
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.mkpath(QStringLiteral("."));
+
+        BrowserManager::instance();
+        QSqlQuery query;
+        QVERIFY(query.exec(QStringLiteral("DELETE FROM pagetimings")));
+    }
+
+    void cleanupTestCase()
+    {
+        delete BrowserManager::instance();
+    }
+
+    void testBuckets()
+    {
+        QCOMPARE(PageTimings::bucket(0), 0);
+        QVERIFY(PageTimings::bucket(1) > PageTimings::bucket(0));
+        for (qint64 value : {10, 100, 1000, 50000, 3000000}) {
+            const qint64 approximated = PageTimings::bucketValue(PageTimings::bucket(value));
+            QVERIFY2(qAbs(approximated - value) <= value / 10 + 1, qPrintable(QString::number(value)));
+        }
+
+        const QHash<int, int> buckets = PageTimings::buckets(timing(100));
+        QCOMPARE(buckets.size(), 3);
+        QCOMPARE(buckets.value(PageTimings::TimeToFirstByte), PageTimings::bucket(100));
+        QCOMPARE(buckets.value(PageTimings::DomContentLoaded), PageTimings::bucket(300));
+        QVERIFY(!buckets.contains(PageTimings::FirstContentfulPaint));
+        QVERIFY(PageTimings::buckets({}).isEmpty());
+    }
+
+    void testPercentile()
+    {
+        QMap<int, qint64> buckets;
+        QCOMPARE(PageTimings::percentile(buckets, 0.5), qint64(-1));
+
+        buckets[PageTimings::bucket(100)] = 9;
+        buckets[PageTimings::bucket(1000)] = 1;
+        const qint64 fast = PageTimings::bucketValue(PageTimings::bucket(100));
+        const qint64 slow = PageTimings::bucketValue(PageTimings::bucket(1000));
+        QCOMPARE(PageTimings::percentile(buckets, 0), fast);
+        QCOMPARE(PageTimings::percentile(buckets, 0.5), fast);
+        QCOMPARE(PageTimings::percentile(buckets, 0.9), fast);
+        QCOMPARE(PageTimings::percentile(buckets, 0.99), slow);
+        QCOMPARE(PageTimings::percentile(buckets, 1), slow);
+    }
+
+    void testModel()
+    {
+        auto *manager = BrowserManager::instance();
+        for (int i = 0; i < 9; i++)
+            manager->addPageTiming(QStringLiteral("https://example.org/page%1").arg(i), timing(100, 400));
+        manager->addPageTiming(QStringLiteral("https://example.org/"), timing(1000, 2000));
+        manager->addPageTiming(QStringLiteral("http://www.kde.org/"), timing(50));
+        // not loaded from the network
+        manager->addPageTiming(QStringLiteral("file:///home/user/page.html"), timing(1));
+        manager->addPageTiming(QStringLiteral("https://kde.org/"), {});
+
+        SitePerformanceModel model;
+        QCOMPARE(model.rowCount(), 2);
+
+        // most loaded first
+        const QModelIndex example = model.index(0);
+        QCOMPARE(example.data(SitePerformanceModel::HostRole).toString(), QStringLiteral("example.org"));
+        QCOMPARE(example.data(SitePerformanceModel::LoadsRole).toLongLong(), qint64(10));
+        QCOMPARE(example.data(SitePerformanceModel::TimeToFirstByteMedianRole).toLongLong(), PageTimings::bucketValue(PageTimings::bucket(100)));
+        QCOMPARE(example.data(SitePerformanceModel::TimeToFirstByteP90Role).toLongLong(), PageTimings::bucketValue(PageTimings::bucket(100)));
+        QCOMPARE(example.data(SitePerformanceModel::FirstContentfulPaintMedianRole).toLongLong(), PageTimings::bucketValue(PageTimings::bucket(400)));
+        QCOMPARE(example.data(SitePerformanceModel::TransferSizeMedianRole).toLongLong(), PageTimings::bucketValue(PageTimings::bucket(20000)));
+
+        const QModelIndex kde = model.index(1);
+        QCOMPARE(kde.data(SitePerformanceModel::HostRole).toString(), QStringLiteral("kde.org"));
+        QCOMPARE(kde.data(SitePerformanceModel::LoadsRole).toLongLong(), qint64(1));
+        QCOMPARE(kde.data(SitePerformanceModel::FirstContentfulPaintMedianRole).toLongLong(), qint64(-1));
+
+        // updated on changes of the table
+        manager->addPageTiming(QStringLiteral("https://kde.org/"), timing(50));
+        QTRY_COMPARE(model.index(1).data(SitePerformanceModel::LoadsRole).toLongLong(), qint64(2));
+    }
+};
+
+QTEST_GUILESS_MAIN(SitePerformanceModelTest)
+
+#include "siteperformancemodeltest.moc"
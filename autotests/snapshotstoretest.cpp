@@ -0,0 +1,250 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QGuiApplication>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtWebEngine>
+#include <QtWebEngine/QQuickWebEngineDownloadItem>
+#include <QtWebEngine/QQuickWebEngineProfile>
+
+#include "browsermanager.h"
+#include "snapshotstore.h"
+
+class SnapshotStoreTest : public QObject
+{
+    Q_OBJECT
+
+    // writes a file with the content to be added as snapshot
+    QString page(const QByteArray &content)
+    {
+        const QString fileName = m_pages.filePath(QStringLiteral("page-%1").arg(m_pageCount++));
+        QFile file(fileName);
+        file.open(QIODevice::WriteOnly);
+        file.write(content);
+        return fileName;
+    }
+
+    // the file is stored in a worker thread
+    static bool addSnapshot(SnapshotStore &store, const QString &url, const QString &title, const QString &fileName)
+    {
+        QSignalSpy added(&store, &SnapshotStore::snapshotAdded);
+        QSignalSpy failed(&store, &SnapshotStore::snapshotFailed);
+        store.addSnapshot(url, title, fileName);
+        return QTest::qWaitFor([&] {
+                   return !added.isEmpty() || !failed.isEmpty();
+               })
+            && failed.isEmpty();
+    }
+
+    static int fileCount(const SnapshotStore &store)
+    {
+        return QDir(store.directory()).entryList({QStringLiteral("*.mht")}, QDir::Files).count();
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QCoreApplication::setOrganizationName(QStringLiteral("autotests"));
+        QCoreApplication::setApplicationName(QStringLiteral("angelfish_snapshotstoretest"));
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.mkpath(QStringLiteral("."));
+
+        BrowserManager::instance();
+        QSqlQuery query;
+        QVERIFY(query.exec(QStringLiteral("DELETE FROM snapshots")));
+        QVERIFY(m_pages.isValid());
+    }
+
+    void cleanupTestCase()
+    {
+        delete BrowserManager::instance();
+    }
+
+    void init()
+    {
+        QSqlQuery query;
+        QVERIFY(query.exec(QStringLiteral("DELETE FROM snapshots")));
+    }
+
+    void testAddSnapshot()
+    {
+        QTemporaryDir directory;
+        SnapshotStore store(directory.path());
+        const QString url = QStringLiteral("https://kde.org/");
+
+        QVERIFY(!store.hasSnapshot(url));
+        QVERIFY(store.snapshotUrl(url).isEmpty());
+
+        const QString fileName = page("<html>KDE</html>");
+        QVERIFY(addSnapshot(store, url, QStringLiteral("KDE"), fileName));
+        QVERIFY(!QFile::exists(fileName));
+        QVERIFY(store.hasSnapshot(url));
+        QCOMPARE(store.size(), qint64(16));
+
+        const QUrl snapshotUrl = store.snapshotUrl(url);
+        QVERIFY(store.isSnapshot(snapshotUrl));
+        QVERIFY(!store.isSnapshot(QUrl(url)));
+        QFile file(snapshotUrl.toLocalFile());
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), QByteArray("<html>KDE</html>"));
+
+        store.removeSnapshot(url);
+        QVERIFY(!store.hasSnapshot(url));
+        QVERIFY(!file.exists());
+
+        // nothing is recorded for a missing file
+        QVERIFY(!addSnapshot(store, url, QStringLiteral("KDE"), m_pages.filePath(QStringLiteral("missing"))));
+        QVERIFY(!store.hasSnapshot(url));
+    }
+
+    void testContentAddressed()
+    {
+        QTemporaryDir directory;
+        SnapshotStore store(directory.path());
+        const QString kde = QStringLiteral("https://kde.org/");
+        const QString www = QStringLiteral("https://www.kde.org/");
+
+        // identical content shares a file
+        QVERIFY(addSnapshot(store, kde, QString(), page("same")));
+        QVERIFY(addSnapshot(store, www, QString(), page("same")));
+        QCOMPARE(fileCount(store), 1);
+        QCOMPARE(store.snapshotUrl(kde), store.snapshotUrl(www));
+        QCOMPARE(store.size(), qint64(4));
+
+        // the file stays as long as it is used
+        QVERIFY(addSnapshot(store, kde, QString(), page("changed")));
+        QCOMPARE(fileCount(store), 2);
+        store.removeSnapshot(www);
+        QCOMPARE(fileCount(store), 1);
+        QCOMPARE(store.size(), qint64(7));
+    }
+
+    void testEviction()
+    {
+        QTemporaryDir directory;
+        SnapshotStore store(directory.path());
+        store.setMaximumSize(25);
+
+        const QString first = QStringLiteral("https://first.org/");
+        const QString second = QStringLiteral("https://second.org/");
+        const QString third = QStringLiteral("https://third.org/");
+        QVERIFY(addSnapshot(store, first, QString(), page("0123456789")));
+        QVERIFY(addSnapshot(store, second, QString(), page("abcdefghij")));
+
+        // opening the first snapshot makes the second one the least recently used
+        QTest::qWait(1100);
+        QVERIFY(!store.snapshotUrl(first).isEmpty());
+
+        QVERIFY(addSnapshot(store, third, QString(), page("ABCDEFGHIJ")));
+        QVERIFY(store.hasSnapshot(first));
+        QVERIFY(!store.hasSnapshot(second));
+        QVERIFY(store.hasSnapshot(third));
+        QCOMPARE(fileCount(store), 2);
+        QCOMPARE(store.size(), qint64(20));
+
+        store.setMaximumSize(0);
+        QCOMPARE(fileCount(store), 0);
+        QCOMPARE(store.size(), qint64(0));
+    }
+
+    void testShouldCapture()
+    {
+        QTemporaryDir directory;
+        SnapshotStore store(directory.path());
+        const QString url = QStringLiteral("https://bookmarked.org/");
+
+        QVERIFY(!store.shouldCapture(url));
+        BrowserManager::instance()->addBookmark({{QStringLiteral("url"), url}});
+        QVERIFY(store.shouldCapture(url));
+        QVERIFY(!store.shouldCapture(QStringLiteral("file:///home/user/page.html")));
+
+        // a recent snapshot doesn't need to be captured again
+        QVERIFY(addSnapshot(store, url, QString(), page("bookmarked")));
+        QVERIFY(!store.shouldCapture(url));
+
+        store.removeSnapshot(url);
+        store.setCaptureBookmarks(false);
+        QVERIFY(!store.shouldCapture(url));
+        BrowserManager::instance()->removeBookmark(url);
+    }
+
+    void testCapture()
+    {
+        QTemporaryDir directory;
+        SnapshotStore store(directory.path());
+        QSignalSpy spy(&store, &SnapshotStore::snapshotAdded);
+
+        QQuickWebEngineProfile profile;
+        profile.setOffTheRecord(true);
+        connect(&profile, &QQuickWebEngineProfile::downloadRequested, &store, &SnapshotStore::capture);
+
+        QQmlEngine engine;
+        QQmlComponent component(&engine);
+        component.setData(QByteArrayLiteral(R"(
+            import QtQuick 2.7
+            import QtQuick.Window 2.2
+            import QtWebEngine 1.10
+
+            Window {
+                property alias view: view
+                width: 400
+                height: 400
+                visible: true
+
+                function save() {
+                    view.triggerWebAction(WebEngineView.SavePage);
+                }
+
+                WebEngineView {
+                    id: view
+                    anchors.fill: parent
+                }
+            })"),
+                          QUrl());
+        QScopedPointer<QObject> window(component.create());
+        QVERIFY2(window, qPrintable(component.errorString()));
+        auto *view = window->property("view").value<QObject *>();
+        QVERIFY(view);
+        view->setProperty("profile", QVariant::fromValue(&profile));
+
+        QMetaObject::invokeMethod(view, "loadHtml", Q_ARG(QString, QStringLiteral("<html><body><p>Offline</p></body></html>")), Q_ARG(QUrl, QUrl(QStringLiteral("https://example.org/"))));
+        QTRY_VERIFY(!view->property("loading").toBool());
+        QTRY_COMPARE(view->property("loadProgress").toInt(), 100);
+
+        QMetaObject::invokeMethod(window.data(), "save");
+        QVERIFY(spy.wait(10000));
+
+        const QString url = spy.at(0).at(0).toString();
+        QFile file(store.snapshotUrl(url).toLocalFile());
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QByteArray content = file.readAll();
+        QVERIFY(content.contains("MIME-Version"));
+        QVERIFY(content.contains("Offline"));
+        QCOMPARE(QDir(store.directory()).entryList({QStringLiteral("*.partial")}, QDir::Files).count(), 0);
+    }
+
+private:
+    QTemporaryDir m_pages;
+    int m_pageCount = 0;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+    QtWebEngine::initialize();
+    QGuiApplication app(argc, argv);
+    SnapshotStoreTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "snapshotstoretest.moc"
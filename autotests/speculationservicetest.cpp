@@ -0,0 +1,109 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QSignalSpy>
+
+#include "speculationservice.h"
+
+class SpeculationServiceTest : public QObject
+{
+    Q_OBJECT
+
+    static int statistic(const SpeculationService &service, const char *name)
+    {
+        return service.statistics().value(QString::fromLatin1(name)).toInt();
+    }
+
+private Q_SLOTS:
+    void testDisabled()
+    {
+        SpeculationService service;
+        service.setStableDelay(0);
+        QSignalSpy spy(&service, &SpeculationService::preconnectRequested);
+
+        service.setCandidate(QUrl(QStringLiteral("https://kde.org/")));
+        QTest::qWait(50);
+        QCOMPARE(spy.count(), 0);
+        QCOMPARE(service.mode(), SpeculationService::Idle);
+    }
+
+    void testStableCandidate()
+    {
+        SpeculationService service;
+        service.setStableDelay(100);
+        service.setEnabled(true);
+        QSignalSpy spy(&service, &SpeculationService::preconnectRequested);
+
+        // only the candidate which stays unchanged is used
+        service.setCandidate(QUrl(QStringLiteral("https://planet.kde.org/")));
+        service.setCandidate(QUrl(QStringLiteral("https://kde.org/announcements/")));
+        QVERIFY(spy.wait());
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(spy.at(0).at(1).toUrl(), QUrl(QStringLiteral("https://kde.org")));
+        QVERIFY(spy.at(0).at(0).toString().contains(QStringLiteral("rel=\"preconnect\" href=\"https://kde.org\"")));
+        QCOMPARE(service.mode(), SpeculationService::Preconnect);
+
+        // another page of the same origin is already warmed
+        service.setCandidate(QUrl(QStringLiteral("https://kde.org/applications/")));
+        QTest::qWait(200);
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(statistic(service, "preconnects"), 1);
+    }
+
+    void testIgnoredSchemes()
+    {
+        SpeculationService service;
+        service.setStableDelay(0);
+        service.setEnabled(true);
+        QSignalSpy spy(&service, &SpeculationService::modeChanged);
+
+        service.setCandidate(QUrl(QStringLiteral("file:///home/user/page.html")));
+        QTest::qWait(50);
+        QCOMPARE(spy.count(), 0);
+    }
+
+    void testCommit()
+    {
+        SpeculationService service;
+        service.setStableDelay(0);
+        service.setEnabled(true);
+        QSignalSpy releasedSpy(&service, &SpeculationService::released);
+
+        // committing before the candidate was stable
+        service.setCandidate(QUrl(QStringLiteral("https://kde.org/")));
+        service.commit(QUrl(QStringLiteral("https://kde.org/")));
+        QCOMPARE(statistic(service, "unspeculatedCommits"), 1);
+
+        // any page of the origin benefits from the connection
+        service.setCandidate(QUrl(QStringLiteral("https://kde.org/applications/")));
+        QTRY_COMPARE(service.mode(), SpeculationService::Preconnect);
+        service.commit(QUrl(QStringLiteral("https://kde.org/community/#latest")));
+        QCOMPARE(statistic(service, "preconnectHits"), 1);
+        // the view is kept until its requests are done
+        QCOMPARE(releasedSpy.count(), 0);
+
+        service.setCandidate(QUrl(QStringLiteral("https://www.gnu.org/")));
+        QTRY_COMPARE(service.url(), QUrl(QStringLiteral("https://www.gnu.org")));
+        service.commit(QUrl(QStringLiteral("https://kde.org/")));
+        QCOMPARE(statistic(service, "misses"), 1);
+        QCOMPARE(service.mode(), SpeculationService::Idle);
+
+        // disabling releases the speculation
+        service.setCandidate(QUrl(QStringLiteral("https://www.gnu.org/software/")));
+        QTRY_COMPARE(service.mode(), SpeculationService::Preconnect);
+        const int released = releasedSpy.count();
+        service.setEnabled(false);
+        QCOMPARE(releasedSpy.count(), released + 1);
+        QCOMPARE(statistic(service, "misses"), 2);
+        QCOMPARE(statistic(service, "preconnects"), 3);
+    }
+};
+
+QTEST_GUILESS_MAIN(SpeculationServiceTest)
+
+#include "speculationservicetest.moc"
@@ -0,0 +1,99 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QSignalSpy>
+
+#include "metrics.h"
+#include "startupmonitor.h"
+
+class StartupMonitorTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testPhases()
+    {
+        StartupMonitor monitor;
+        QSignalSpy readySpy(&monitor, &StartupMonitor::readyChanged);
+
+        QCOMPARE(monitor.elapsed(StartupMonitor::ProcessStart), qint64(0));
+        QCOMPARE(monitor.elapsed(StartupMonitor::QmlLoaded), qint64(-1));
+        QVERIFY(!monitor.ready());
+
+        QTest::qWait(20);
+        monitor.mark(StartupMonitor::QmlLoaded);
+        const qint64 qmlLoaded = monitor.elapsed(StartupMonitor::QmlLoaded);
+        QVERIFY(qmlLoaded >= 20);
+
+        // only the first time counts
+        QTest::qWait(20);
+        monitor.mark(StartupMonitor::QmlLoaded);
+        QCOMPARE(monitor.elapsed(StartupMonitor::QmlLoaded), qmlLoaded);
+
+        // without a window, the page counts as painted right away
+        monitor.pageLoaded();
+        QVERIFY(monitor.elapsed(StartupMonitor::FirstPaint) >= qmlLoaded);
+        QVERIFY(!monitor.ready());
+        QVERIFY(readySpy.wait());
+        QVERIFY(monitor.ready());
+        QCOMPARE(readySpy.count(), 1);
+        QVERIFY(monitor.elapsed(StartupMonitor::Idle) >= monitor.elapsed(StartupMonitor::FirstPaint));
+        QCOMPARE(monitor.elapsed(StartupMonitor::FirstFrame), qint64(-1));
+
+        // exported for comparing builds with and without precompiled QML
+        QCOMPARE(Metrics::instance()->value(QStringLiteral("startup.qml_loaded_ms")), qmlLoaded);
+        QCOMPARE(Metrics::instance()->value(QStringLiteral("startup.idle_ms")), monitor.elapsed(StartupMonitor::Idle));
+
+        const QString report = monitor.report();
+        QVERIFY(report.contains(QStringLiteral("QmlLoaded")));
+        QVERIFY(report.contains(QString::number(qmlLoaded)));
+    }
+
+    void testIdleTimeout()
+    {
+        StartupMonitor monitor;
+        monitor.setIdleTimeout(50);
+        QSignalSpy readySpy(&monitor, &StartupMonitor::readyChanged);
+
+        // the timeout only starts with the QML
+        QTest::qWait(100);
+        QVERIFY(!monitor.ready());
+
+        monitor.mark(StartupMonitor::QmlLoaded);
+        QVERIFY(readySpy.wait());
+        QVERIFY(monitor.ready());
+        QCOMPARE(monitor.elapsed(StartupMonitor::FirstPaint), qint64(-1));
+    }
+
+    void testDeferToIdle()
+    {
+        StartupMonitor monitor;
+        int calls = 0;
+        monitor.deferToIdle(this, [&calls] {
+            calls++;
+        });
+        QCOMPARE(calls, 0);
+
+        monitor.mark(StartupMonitor::Idle);
+        QCOMPARE(calls, 1);
+
+        // runs only once
+        monitor.mark(StartupMonitor::Idle);
+        QCOMPARE(calls, 1);
+
+        // runs right away once idle
+        monitor.deferToIdle(this, [&calls] {
+            calls++;
+        });
+        QCOMPARE(calls, 2);
+    }
+};
+
+QTEST_GUILESS_MAIN(StartupMonitorTest)
+
+#include "startupmonitortest.moc"
@@ -0,0 +1,151 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QSignalSpy>
+
+#include <memory>
+
+#include <unistd.h>
+
+#include "metrics.h"
+#include "tabresourcemonitor.h"
+
+// the properties of a WebEngineView read by the monitor
+class FakeView : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QString title MEMBER m_title NOTIFY titleChanged)
+    Q_PROPERTY(bool visible MEMBER m_visible)
+    Q_PROPERTY(int lifecycleState MEMBER m_lifecycleState NOTIFY lifecycleStateChanged)
+    Q_PROPERTY(qint64 renderProcessPid MEMBER m_renderProcessPid NOTIFY renderProcessPidChanged)
+
+public:
+    explicit FakeView(qint64 pid, bool visible = false)
+        : m_visible(visible)
+        , m_renderProcessPid(pid)
+    {
+    }
+
+    QString m_title;
+    bool m_visible;
+    int m_lifecycleState = 0;
+    qint64 m_renderProcessPid;
+
+signals:
+    void titleChanged();
+    void lifecycleStateChanged();
+    void renderProcessPidChanged();
+};
+
+class TabResourceMonitorTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QVariant value(const TabResourceMonitor &monitor, int row, TabResourceMonitor::Role role)
+    {
+        return monitor.data(monitor.index(row), role);
+    }
+
+private Q_SLOTS:
+    void testSampleProcess()
+    {
+        const auto sample = TabResourceMonitor::sampleProcess(getpid());
+        QVERIFY(sample.rss > 0);
+        QVERIFY(sample.cpuTime >= 0);
+
+        const auto missing = TabResourceMonitor::sampleProcess(-1);
+        QCOMPARE(missing.rss, qint64(-1));
+        QCOMPARE(missing.cpuTime, qint64(-1));
+    }
+
+    void testViews()
+    {
+        TabResourceMonitor monitor;
+        FakeView first(getpid());
+        FakeView second(getpid(), true);
+        auto third = std::make_unique<FakeView>(0);
+
+        monitor.addView(&first, false);
+        monitor.addView(&second, false);
+        monitor.addView(&first, false);
+        monitor.addView(third.get(), true);
+        QCOMPARE(monitor.rowCount(), 3);
+
+        QCOMPARE(value(monitor, 0, TabResourceMonitor::PidRole).toLongLong(), qint64(getpid()));
+        QCOMPARE(value(monitor, 0, TabResourceMonitor::ProcessTabsRole).toInt(), 2);
+        // not started yet
+        QCOMPARE(value(monitor, 2, TabResourceMonitor::PidRole).toLongLong(), qint64(-1));
+        QCOMPARE(value(monitor, 2, TabResourceMonitor::ProcessTabsRole).toInt(), 1);
+        QVERIFY(value(monitor, 2, TabResourceMonitor::PrivateModeRole).toBool());
+
+        QSignalSpy changed(&monitor, &TabResourceMonitor::dataChanged);
+        first.setProperty("title", QStringLiteral("KDE"));
+        QCOMPARE(changed.count(), 1);
+        QCOMPARE(value(monitor, 0, TabResourceMonitor::TitleRole).toString(), QStringLiteral("KDE"));
+
+        third.reset();
+        QCOMPARE(monitor.rowCount(), 2);
+        monitor.removeView(&second);
+        QCOMPARE(monitor.rowCount(), 1);
+    }
+
+    void testLifecycleState()
+    {
+        TabResourceMonitor monitor;
+        FakeView background(getpid());
+        FakeView current(getpid(), true);
+        monitor.addView(&background, false);
+        monitor.addView(&current, false);
+
+        monitor.setLifecycleState(0, TabResourceMonitor::Frozen);
+        QCOMPARE(value(monitor, 0, TabResourceMonitor::LifecycleStateRole).toInt(), int(TabResourceMonitor::Frozen));
+        QCOMPARE(Metrics::instance()->value(QStringLiteral("tabs.frozen")), qint64(1));
+
+        // visible views are left alone
+        monitor.setLifecycleState(1, TabResourceMonitor::Discarded);
+        QCOMPARE(value(monitor, 1, TabResourceMonitor::LifecycleStateRole).toInt(), int(TabResourceMonitor::Active));
+        QCOMPARE(Metrics::instance()->value(QStringLiteral("tabs.discarded")), qint64(0));
+
+        monitor.setLifecycleState(0, TabResourceMonitor::Active);
+        QCOMPARE(Metrics::instance()->value(QStringLiteral("tabs.frozen")), qint64(0));
+    }
+
+    void testSampling()
+    {
+        TabResourceMonitor monitor;
+        FakeView view(getpid());
+        monitor.addView(&view, false);
+        QCOMPARE(value(monitor, 0, TabResourceMonitor::RssRole).toLongLong(), qint64(-1));
+
+        monitor.setActive(true);
+        QTRY_VERIFY(value(monitor, 0, TabResourceMonitor::RssRole).toLongLong() > 0);
+        QVERIFY(value(monitor, 0, TabResourceMonitor::CpuTimeRole).toLongLong() >= 0);
+
+        // the renderers counted once, however many tabs they have
+        QCOMPARE(Metrics::instance()->value(QStringLiteral("tabs.renderers")), qint64(1));
+        QVERIFY(Metrics::instance()->value(QStringLiteral("tabs.renderer_rss_kb")) > 0);
+        monitor.setActive(false);
+    }
+
+    void testMetricsSampling()
+    {
+        // reading the totals doesn't wait for /proc, the next read has them
+        TabResourceMonitor monitor;
+        FakeView view(getpid());
+        monitor.addView(&view, false);
+        QCOMPARE(Metrics::instance()->value(QStringLiteral("tabs.renderer_rss_kb")), qint64(0));
+        QTRY_VERIFY(Metrics::instance()->value(QStringLiteral("tabs.renderer_rss_kb")) > 0);
+        QVERIFY(!monitor.active());
+    }
+};
+
+QTEST_GUILESS_MAIN(TabResourceMonitorTest)
+
+#include "tabresourcemonitortest.moc"
@@ -0,0 +1,158 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include "tracer.h"
+
+class TracerTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    QJsonArray readTrace(const QString &path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return {};
+
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+        if (error.error != QJsonParseError::NoError)
+            qWarning() << error.errorString();
+        return document.array();
+    }
+
+    QJsonObject findEvent(const QJsonArray &events, const QString &name)
+    {
+        for (const auto &event : events) {
+            if (event.toObject().value(QStringLiteral("name")).toString() == name)
+                return event.toObject();
+        }
+        return {};
+    }
+
+private Q_SLOTS:
+    void testDisabled()
+    {
+        QVERIFY(!Tracer::enabled());
+        TraceScope trace("Disabled");
+        QVERIFY(!trace.active());
+    }
+
+    void testTrace()
+    {
+        QTemporaryDir dir;
+        const QString path = dir.filePath(QStringLiteral("trace.json"));
+        QVERIFY(Tracer::instance()->start(path));
+        QVERIFY(Tracer::enabled());
+
+        {
+            TraceScope outer("Outer", "test");
+            QVERIFY(outer.active());
+            outer.setArgument(QStringLiteral("SELECT \"quoted\"\n"));
+            TraceScope inner("Inner", "test");
+            QThread::msleep(5);
+        }
+        Tracer::instance()->instant("Instant", "test");
+
+        QThread *thread = QThread::create([] {
+            TraceScope trace("Worker", "test");
+        });
+        thread->start();
+        QVERIFY(thread->wait());
+        delete thread;
+
+        Tracer::instance()->stop();
+        QVERIFY(!Tracer::enabled());
+
+        // recorded after the trace has been stopped
+        {
+            TraceScope late("Late", "test");
+        }
+
+        const QJsonArray events = readTrace(path);
+        QVERIFY(!events.isEmpty());
+
+        const QJsonObject outer = findEvent(events, QStringLiteral("Outer"));
+        const QJsonObject inner = findEvent(events, QStringLiteral("Inner"));
+        QCOMPARE(outer.value(QStringLiteral("ph")).toString(), QStringLiteral("X"));
+        QCOMPARE(outer.value(QStringLiteral("cat")).toString(), QStringLiteral("test"));
+        QCOMPARE(outer.value(QStringLiteral("args")).toObject().value(QStringLiteral("detail")).toString(), QStringLiteral("SELECT \"quoted\"\n"));
+        QVERIFY(inner.value(QStringLiteral("dur")).toDouble() >= 5000);
+
+        // the inner scope lies within the outer one
+        const double outerStart = outer.value(QStringLiteral("ts")).toDouble();
+        const double innerStart = inner.value(QStringLiteral("ts")).toDouble();
+        QVERIFY(innerStart >= outerStart);
+        QVERIFY(innerStart + inner.value(QStringLiteral("dur")).toDouble() <= outerStart + outer.value(QStringLiteral("dur")).toDouble());
+
+        QCOMPARE(findEvent(events, QStringLiteral("Instant")).value(QStringLiteral("ph")).toString(), QStringLiteral("i"));
+
+        const QJsonObject worker = findEvent(events, QStringLiteral("Worker"));
+        QVERIFY(!worker.isEmpty());
+        QVERIFY(worker.value(QStringLiteral("tid")).toDouble() != outer.value(QStringLiteral("tid")).toDouble());
+        QCOMPARE(worker.value(QStringLiteral("pid")).toDouble(), outer.value(QStringLiteral("pid")).toDouble());
+
+        QVERIFY(findEvent(events, QStringLiteral("Late")).isEmpty());
+    }
+
+    void testUnfinishedTrace()
+    {
+        // a trace of a browser that crashed misses the closing bracket
+        QTemporaryDir dir;
+        const QString path = dir.filePath(QStringLiteral("trace.json"));
+        QVERIFY(Tracer::instance()->start(path));
+        {
+            TraceScope trace("Unfinished", "test");
+        }
+        // more than is buffered
+        for (int i = 0; i < 1000; i++)
+            Tracer::instance()->instant("Filler", "test");
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QByteArray written = file.readAll();
+        QVERIFY(written.startsWith("[\n"));
+        QVERIFY(written.contains("\"name\":\"Unfinished\""));
+        QVERIFY(!written.trimmed().endsWith(']'));
+
+        Tracer::instance()->stop();
+        QVERIFY(!readTrace(path).isEmpty());
+    }
+
+    void testPeriodicFlush()
+    {
+        // a few events are written once a second has passed
+        QTemporaryDir dir;
+        const QString path = dir.filePath(QStringLiteral("trace.json"));
+        QVERIFY(Tracer::instance()->start(path));
+        Tracer::instance()->instant("Early", "test");
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(!file.readAll().contains("\"name\":\"Early\""));
+
+        QThread::msleep(1100);
+        Tracer::instance()->instant("Late", "test");
+        const QByteArray written = file.readAll();
+        QVERIFY(written.contains("\"name\":\"Early\""));
+        QVERIFY(written.contains("\"name\":\"Late\""));
+
+        Tracer::instance()->stop();
+    }
+};
+
+QTEST_GUILESS_MAIN(TracerTest)
+
+#include "tracertest.moc"
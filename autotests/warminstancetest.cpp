@@ -0,0 +1,133 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QGuiApplication>
+#include <QQuickWindow>
+#include <QSignalSpy>
+
+#include "warminstance.h"
+
+class WarmInstanceTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testActivate()
+    {
+        WarmInstance instance;
+        QSignalSpy waitingSpy(&instance, &WarmInstance::waitingChanged);
+        QSignalSpy activatedSpy(&instance, &WarmInstance::activated);
+
+        // not started in the background
+        QVERIFY(!instance.waiting());
+        instance.activate();
+        QCOMPARE(activatedSpy.count(), 0);
+        QCOMPARE(instance.lastActivationLatency(), qint64(-1));
+
+        instance.setEnabled(true);
+        QVERIFY(instance.waiting());
+        QCOMPARE(waitingSpy.count(), 1);
+
+        instance.activate();
+        QVERIFY(!instance.waiting());
+        QCOMPARE(waitingSpy.count(), 2);
+        QCOMPARE(activatedSpy.count(), 1);
+        QVERIFY(instance.lastActivationLatency() >= 0);
+    }
+
+    void testWaitAfterClose()
+    {
+        WarmInstance instance;
+        QQuickWindow window;
+        instance.setWindow(&window);
+        instance.setEnabled(true);
+        QSignalSpy waitingSpy(&instance, &WarmInstance::waitingChanged);
+
+        instance.activate();
+        QVERIFY(window.isVisible());
+        QVERIFY(!instance.waiting());
+        QCOMPARE(waitingSpy.count(), 1);
+
+        // the tabs are unloaded until the next activation
+        window.close();
+        QVERIFY(instance.waiting());
+        QCOMPARE(waitingSpy.count(), 2);
+
+        instance.activate();
+        QVERIFY(!instance.waiting());
+        QCOMPARE(waitingSpy.count(), 3);
+
+        // without the background mode, closing just quits
+        instance.setEnabled(false);
+        waitingSpy.clear();
+        window.show();
+        window.close();
+        QVERIFY(!instance.waiting());
+        QCOMPARE(waitingSpy.count(), 0);
+    }
+
+    void testMemoryLimit()
+    {
+        WarmInstance instance;
+        qint64 memory = 500;
+        instance.setMemoryProbe([&memory] {
+            return memory;
+        });
+        instance.setMemoryLimit(300);
+        instance.setCheckInterval(10);
+        QSignalSpy droppedSpy(&instance, &WarmInstance::cachesDropped);
+
+        // only checked in the background
+        QTest::qWait(50);
+        QCOMPARE(droppedSpy.count(), 0);
+
+        instance.setEnabled(true);
+        QVERIFY(droppedSpy.wait());
+
+        // nothing has been allocated since
+        QTest::qWait(50);
+        QCOMPARE(droppedSpy.count(), 1);
+
+        memory = 600;
+        QVERIFY(droppedSpy.wait());
+        QCOMPARE(droppedSpy.count(), 2);
+
+        instance.setEnabled(false);
+        memory = 700;
+        QTest::qWait(50);
+        QCOMPARE(droppedSpy.count(), 2);
+    }
+
+    void testBelowLimit()
+    {
+        WarmInstance instance;
+        instance.setMemoryProbe([] {
+            return qint64(100);
+        });
+        instance.setMemoryLimit(300);
+        instance.setCheckInterval(10);
+        instance.setEnabled(true);
+
+        QSignalSpy droppedSpy(&instance, &WarmInstance::cachesDropped);
+        QTest::qWait(50);
+        QCOMPARE(droppedSpy.count(), 0);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    // the window is never looked at
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    QGuiApplication::setQuitOnLastWindowClosed(false);
+    WarmInstanceTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "warminstancetest.moc"
@@ -0,0 +1,121 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QGuiApplication>
+#include <QPlatformSurfaceEvent>
+#include <QQmlEngine>
+#include <QQuickWindow>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include "webapphost.h"
+
+class WebAppHostTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        // the desktop file name the platform window has been created with
+        if (event->type() == QEvent::PlatformSurface
+            && static_cast<QPlatformSurfaceEvent *>(event)->surfaceEventType() == QPlatformSurfaceEvent::SurfaceCreated)
+            m_createdDesktopFileNames.insert(watched, QGuiApplication::desktopFileName());
+        return QObject::eventFilter(watched, event);
+    }
+
+private:
+    QString writeDesktopFile(const QString &name, const QString &url)
+    {
+        const QString path = m_dir.filePath(name + QStringLiteral(".desktop"));
+        KConfig desktopFile(path, KConfig::SimpleConfig);
+        auto desktopEntry = desktopFile.group("Desktop Entry");
+        if (!url.isEmpty())
+            desktopEntry.writeEntry(QStringLiteral("URL"), url);
+        desktopEntry.writeEntry(QStringLiteral("Name"), name);
+        desktopFile.sync();
+        return path;
+    }
+
+    QTemporaryDir m_dir;
+    QHash<QObject *, QString> m_createdDesktopFileNames;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QVERIFY(m_dir.isValid());
+        QGuiApplication::setDesktopFileName(QStringLiteral("org.kde.angelfish-webapp"));
+        qApp->installEventFilter(this);
+    }
+
+    void testOpen()
+    {
+        QQmlEngine engine;
+        WebAppHost host(&engine);
+        QSignalSpy countSpy(&host, &WebAppHost::windowCountChanged);
+
+        const QString kde = writeDesktopFile(QStringLiteral("kde"), QStringLiteral("https://kde.org/"));
+        QQuickWindow *window = host.open(kde);
+        QVERIFY(window);
+        QVERIFY(window->isVisible());
+        QCOMPARE(window->property("initialUrl").toUrl(), QUrl(QStringLiteral("https://kde.org/")));
+        QCOMPARE(window->property("storageName").toString(), QStringLiteral("angelfish-webapp-kde"));
+        QCOMPARE(host.windowCount(), 1);
+        QCOMPARE(countSpy.count(), 1);
+
+        // the window belongs to the web app, the process keeps its own name
+        QCOMPARE(m_createdDesktopFileNames.value(window), QStringLiteral("kde"));
+        QCOMPARE(QGuiApplication::desktopFileName(), QStringLiteral("org.kde.angelfish-webapp"));
+
+        // launching it again raises the window
+        QCOMPARE(host.open(kde), window);
+        QCOMPARE(host.windowCount(), 1);
+
+        // relative names are looked up in the working directory
+        const QString plasma = writeDesktopFile(QStringLiteral("plasma"), QStringLiteral("https://plasma-mobile.org/"));
+        QQuickWindow *plasmaWindow = host.open(QStringLiteral("plasma.desktop"), m_dir.path());
+        QVERIFY(plasmaWindow);
+        QVERIFY(plasmaWindow != window);
+        QCOMPARE(plasmaWindow->property("storageName").toString(), QStringLiteral("angelfish-webapp-plasma"));
+        QCOMPARE(m_createdDesktopFileNames.value(plasmaWindow), QStringLiteral("plasma"));
+        QCOMPARE(host.open(plasma), plasmaWindow);
+        QCOMPARE(host.windowCount(), 2);
+
+        // closed windows are dropped
+        QPointer<QQuickWindow> closed(window);
+        window->close();
+        QTRY_COMPARE(host.windowCount(), 1);
+        QTRY_VERIFY(!closed);
+    }
+
+    void testNotAWebApp()
+    {
+        QQmlEngine engine;
+        WebAppHost host(&engine);
+
+        QVERIFY(!host.open(writeDesktopFile(QStringLiteral("nourl"), QString())));
+        QCOMPARE(host.windowCount(), 0);
+        QCOMPARE(QGuiApplication::desktopFileName(), QStringLiteral("org.kde.angelfish-webapp"));
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    // the windows are never looked at
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    QGuiApplication::setQuitOnLastWindowClosed(false);
+    WebAppHostTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "webapphosttest.moc"
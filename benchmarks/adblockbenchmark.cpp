@@ -0,0 +1,131 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include <QDataStream>
+#include <QRandomGenerator>
+#include <QUrl>
+
+#include <vector>
+
+#include "adblockfilter.h"
+
+// number of rules, about as many as EasyList and EasyPrivacy together
+constexpr int RULES = 60000;
+
+namespace {
+// a list resembling the common ones: mostly host rules, and path rules
+// with and without wildcards
+QString syntheticList(int size)
+{
+    QRandomGenerator random(42);
+    QString list;
+    list.reserve(size * 32);
+    list += QStringLiteral("[Adblock Plus 2.0]\n! Synthetic list\n");
+    for (int i = 0; i < size; i++) {
+        switch (i % 10) {
+        case 0:
+            list += QStringLiteral("/banner%1/*\n").arg(i);
+            break;
+        case 1:
+            list += QStringLiteral("&ad_slot%1=\n").arg(i);
+            break;
+        case 2:
+            list += QStringLiteral("||cdn%1.example^*/track.js$script,third-party\n").arg(i);
+            break;
+        case 3:
+            list += QStringLiteral("@@||allowed%1.example^$image\n").arg(i);
+            break;
+        case 4:
+            list += QStringLiteral("example.org##.ad%1\n").arg(i);
+            break;
+        default:
+            list += QStringLiteral("||tracker%1-%2.example^\n").arg(i).arg(random.bounded(1000));
+            break;
+        }
+    }
+    return list;
+}
+
+std::vector<AdblockFilter::Request> syntheticRequests(int count)
+{
+    QRandomGenerator random(23);
+    std::vector<AdblockFilter::Request> requests;
+    requests.reserve(count);
+    for (int i = 0; i < count; i++) {
+        const int site = random.bounded(100000);
+        QString url;
+        switch (i % 4) {
+        case 0:
+            url = QStringLiteral("https://tracker%1-%2.example/pixel.gif").arg(site).arg(random.bounded(1000));
+            break;
+        case 1:
+            url = QStringLiteral("https://static.site%1.example/assets/app.%2.js?v=%3").arg(site).arg(random.bounded(100)).arg(i);
+            break;
+        case 2:
+            url = QStringLiteral("https://cdn%1.example/lib/1.2/track.js").arg(site);
+            break;
+        default:
+            url = QStringLiteral("https://news%1.example/article/%2/images/photo-%3.jpg?w=640&h=480").arg(site).arg(i).arg(random.bounded(50));
+            break;
+        }
+        requests.push_back(AdblockFilter::Request(QUrl(url), QUrl(QStringLiteral("https://news%1.example/").arg(site)), AdblockFilter::Script));
+    }
+    return requests;
+}
+}
+
+class AdblockBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void compile()
+    {
+        const QString list = syntheticList(RULES);
+        QBENCHMARK {
+            AdblockFilter filter;
+            filter.addList(list);
+        }
+    }
+
+    void loadCache()
+    {
+        AdblockFilter filter;
+        filter.addList(syntheticList(RULES));
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        filter.save(out);
+
+        QBENCHMARK {
+            QDataStream in(data);
+            AdblockFilter loaded;
+            loaded.load(in);
+        }
+    }
+
+    // time for matching the whole corpus, divide by its size for the time per request
+    void match()
+    {
+        AdblockFilter filter;
+        filter.addList(syntheticList(RULES));
+        const auto requests = syntheticRequests(10000);
+
+        int blockedCount = 0;
+        QBENCHMARK {
+            blockedCount = 0;
+            for (const auto &request : requests)
+                blockedCount += filter.shouldBlock(request);
+        }
+        QVERIFY(blockedCount > 0);
+        QVERIFY(blockedCount < int(requests.size()));
+    }
+};
+
+QTEST_GUILESS_MAIN(AdblockBenchmark)
+
+#include "adblockbenchmark.moc"
@@ -0,0 +1,203 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "datagenerator.h"
+
+#include <QBuffer>
+#include <QColor>
+#include <QDateTime>
+#include <QDebug>
+#include <QImage>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QUrl>
+
+#include <algorithm>
+#include <cmath>
+
+#include "urlutils.h"
+
+// distinct sites, the most popular one is visited HOST_COUNT times as often
+// as the least popular one
+constexpr int HOST_COUNT = 5000;
+// mean age of a visit in days, visits older than a year are not generated
+constexpr double MEAN_VISIT_AGE = 30;
+constexpr qint64 MAX_VISIT_AGE = 365;
+
+namespace {
+const QStringList WORDS = {
+    QStringLiteral("news"),     QStringLiteral("linux"),   QStringLiteral("plasma"),  QStringLiteral("mobile"),  QStringLiteral("weather"),
+    QStringLiteral("recipe"),   QStringLiteral("football"), QStringLiteral("travel"), QStringLiteral("review"),  QStringLiteral("phone"),
+    QStringLiteral("music"),    QStringLiteral("video"),   QStringLiteral("garden"),  QStringLiteral("science"), QStringLiteral("history"),
+    QStringLiteral("market"),   QStringLiteral("energy"),  QStringLiteral("city"),    QStringLiteral("school"),  QStringLiteral("health"),
+    QStringLiteral("release"),  QStringLiteral("update"),  QStringLiteral("guide"),   QStringLiteral("forum"),   QStringLiteral("blog"),
+    QStringLiteral("open"),     QStringLiteral("source"),  QStringLiteral("free"),    QStringLiteral("best"),    QStringLiteral("new"),
+    QStringLiteral("how"),      QStringLiteral("to"),      QStringLiteral("the"),     QStringLiteral("and"),     QStringLiteral("with"),
+    QStringLiteral("community"), QStringLiteral("project"), QStringLiteral("browser"), QStringLiteral("desktop"), QStringLiteral("kernel"),
+};
+
+const QStringList SUFFIXES = {
+    QStringLiteral("com"), QStringLiteral("com"), QStringLiteral("com"), QStringLiteral("org"),   QStringLiteral("net"),
+    QStringLiteral("de"),  QStringLiteral("fr"),  QStringLiteral("io"),  QStringLiteral("co.uk"), QStringLiteral("com.br"),
+};
+
+bool execute(QSqlQuery &query)
+{
+    if (!query.exec()) {
+        qWarning() << Q_FUNC_INFO << "Failed to execute SQL statement";
+        qWarning() << query.lastQuery();
+        qWarning() << query.lastError();
+        return false;
+    }
+    return true;
+}
+}
+
+DataGenerator::DataGenerator(quint32 seed)
+    : m_random(seed)
+{
+    double total = 0;
+    for (int rank = 0; rank < HOST_COUNT; rank++) {
+        // www. and m. are stripped for the host column, like for real sites
+        const int prefix = m_random.bounded(10);
+        const QString subdomain = prefix < 3 ? QStringLiteral("www.") : prefix < 4 ? QStringLiteral("m.") : prefix < 5 ? word() + QLatin1Char('.') : QString();
+        m_hosts.append(QStringLiteral("%1%2%3.%4").arg(subdomain, word(), QString::number(rank), SUFFIXES.at(m_random.bounded(SUFFIXES.size()))));
+
+        total += 1.0 / (rank + 1);
+        m_weights.push_back(total);
+    }
+}
+
+QString DataGenerator::host()
+{
+    const double pick = m_random.generateDouble() * m_weights.back();
+    const auto it = std::upper_bound(m_weights.cbegin(), m_weights.cend(), pick);
+    return m_hosts.at(std::min<int>(it - m_weights.cbegin(), HOST_COUNT - 1));
+}
+
+QString DataGenerator::url()
+{
+    QString path;
+    const int depth = m_random.bounded(4);
+    for (int i = 0; i < depth; i++)
+        path += QLatin1Char('/') + word();
+
+    // the counter keeps the urls unique, like article ids do
+    path += QStringLiteral("/%1-%2-%3").arg(word(), word()).arg(m_counter++);
+    if (m_random.bounded(5) == 0)
+        path += QStringLiteral("?ref=%1").arg(m_random.bounded(1000));
+
+    return QStringLiteral("https://") + host() + path;
+}
+
+QString DataGenerator::title(const QString &url)
+{
+    QStringList words;
+    const int length = 2 + m_random.bounded(8);
+    for (int i = 0; i < length; i++)
+        words.append(word());
+    words.first()[0] = words.first().at(0).toUpper();
+
+    return words.join(QLatin1Char(' ')) + QStringLiteral(" - ") + UrlUtils::urlRegistrableDomain(url);
+}
+
+qint64 DataGenerator::lastVisited(qint64 now)
+{
+    const double days = -std::log(1 - m_random.generateDouble()) * MEAN_VISIT_AGE;
+    return now - qint64(std::min(days, double(MAX_VISIT_AGE)) * 24 * 60 * 60);
+}
+
+QString DataGenerator::iconUrl(const QString &url) const
+{
+    return QStringLiteral("image://angelfish-favicon/https://%1/favicon.ico").arg(QUrl(url).host());
+}
+
+QByteArray DataGenerator::favicon()
+{
+    // noise keeps the compression from making the images unrealistically small
+    QImage image(32, 32, QImage::Format_ARGB32);
+    image.fill(QColor::fromRgb(m_random.generate()));
+    for (int i = 0; i < 200; i++)
+        image.setPixel(m_random.bounded(32), m_random.bounded(32), m_random.generate());
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    return data;
+}
+
+bool DataGenerator::populate(QSqlDatabase &database, int historyRows, int bookmarkRows)
+{
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    if (!database.transaction())
+        return false;
+
+    QSqlQuery query(database);
+    if (!query.exec(QStringLiteral("DELETE FROM history")) || !query.exec(QStringLiteral("DELETE FROM bookmarks"))
+        || !query.exec(QStringLiteral("DELETE FROM icons"))) {
+        database.rollback();
+        return false;
+    }
+
+    const QString insert = QStringLiteral(
+        "INSERT INTO %1 (url, title, icon, lastVisited, host, domain, displayPath) "
+        "VALUES (:url, :title, :icon, :lastVisited, :host, :domain, :displayPath)");
+    QSqlQuery history(database);
+    history.prepare(insert.arg(QStringLiteral("history")));
+    QSqlQuery bookmarks(database);
+    bookmarks.prepare(insert.arg(QStringLiteral("bookmarks")));
+    QSqlQuery icons(database);
+    icons.prepare(QStringLiteral("INSERT OR IGNORE INTO icons (url, icon) VALUES (:url, :icon)"));
+
+    QSet<QString> iconUrls;
+    // every n-th entry is bookmarked as well
+    const int bookmarkInterval = std::max(1, historyRows / std::max(1, bookmarkRows));
+    int bookmarked = 0;
+    for (int i = 0; i < historyRows; i++) {
+        const QString url = this->url();
+        const QString icon = iconUrl(url);
+        if (!iconUrls.contains(icon)) {
+            iconUrls.insert(icon);
+            icons.bindValue(QStringLiteral(":url"), icon);
+            icons.bindValue(QStringLiteral(":icon"), favicon());
+            if (!execute(icons)) {
+                database.rollback();
+                return false;
+            }
+        }
+
+        const bool bookmark = bookmarked < bookmarkRows && i % bookmarkInterval == 0;
+        for (QSqlQuery *table : {&history, &bookmarks}) {
+            if (table == &bookmarks && !bookmark)
+                continue;
+            table->bindValue(QStringLiteral(":url"), url);
+            table->bindValue(QStringLiteral(":title"), title(url));
+            table->bindValue(QStringLiteral(":icon"), icon);
+            table->bindValue(QStringLiteral(":lastVisited"), lastVisited(now));
+            table->bindValue(QStringLiteral(":host"), UrlUtils::urlNormalizedHost(url));
+            table->bindValue(QStringLiteral(":domain"), UrlUtils::urlRegistrableDomain(url));
+            table->bindValue(QStringLiteral(":displayPath"), UrlUtils::urlDisplayPath(url));
+            if (!execute(*table)) {
+                database.rollback();
+                return false;
+            }
+        }
+        if (bookmark)
+            bookmarked++;
+    }
+
+    return database.commit();
+}
+
+QString DataGenerator::word()
+{
+    return WORDS.at(m_random.bounded(WORDS.size()));
+}
@@ -0,0 +1,60 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef DATAGENERATOR_H
+#define DATAGENERATOR_H
+
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+class QSqlDatabase;
+
+/**
+ * @class DataGenerator
+ * @short Generates history, bookmarks and favicons resembling real browsing.
+ *
+ * Visits follow a Zipf distribution over the hosts, so a few sites make up
+ * most of the history, like in real profiles. Paths, titles and the time
+ * since the last visit vary the way they do on the web, and every host has
+ * a PNG favicon of a few KiB. The same seed always generates the same data.
+ */
+class DataGenerator
+{
+public:
+    explicit DataGenerator(quint32 seed = 1);
+
+    // host picked by popularity
+    QString host();
+    // unique url on a host picked by popularity
+    QString url();
+    QString title(const QString &url);
+    // seconds since the epoch, more recent visits are more likely
+    qint64 lastVisited(qint64 now);
+    // url of the favicon of the host of url, as stored by IconImageProvider
+    QString iconUrl(const QString &url) const;
+    // PNG image data
+    QByteArray favicon();
+
+    // Replaces the history, bookmarks and icons in the database. Bookmarks
+    // are urls of the history.
+    bool populate(QSqlDatabase &database, int historyRows, int bookmarkRows);
+
+private:
+    QString word();
+
+    QRandomGenerator m_random;
+    QStringList m_hosts;
+    // cumulative popularity of m_hosts
+    std::vector<double> m_weights;
+    int m_counter = 0;
+};
+
+#endif // DATAGENERATOR_H
@@ -0,0 +1,46 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+
+#include "hostmatcher.h"
+
+// number of patterns, about as many as a large list of user agent rules
+constexpr int PATTERNS = 10000;
+
+class HostMatcherBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        for (int i = 0; i < PATTERNS; i++)
+            m_matcher.insert(QStringLiteral("site%1.example").arg(i), i);
+    }
+
+    // looked up for every navigation, see UserAgentRules
+    void find()
+    {
+        QBENCHMARK {
+            m_matcher.find(QStringLiteral("a.b.www.site9999.example"));
+        }
+    }
+
+    void findMissing()
+    {
+        QBENCHMARK {
+            m_matcher.find(QStringLiteral("a.b.www.site10000.example"));
+        }
+    }
+
+private:
+    HostMatcher<int> m_matcher;
+};
+
+QTEST_GUILESS_MAIN(HostMatcherBenchmark)
+
+#include "hostmatcherbenchmark.moc"
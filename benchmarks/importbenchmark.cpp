@@ -0,0 +1,115 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include "datatransfer.h"
+#include "dbmanager.h"
+#include "processmemory.h"
+
+// entries imported, override with ANGELFISH_IMPORT_ROWS=100000
+constexpr int DEFAULT_IMPORT_ROWS = 1000000;
+
+class ImportBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QCoreApplication::setOrganizationName(QStringLiteral("autotests"));
+        QCoreApplication::setApplicationName(QStringLiteral("angelfish_importbenchmark"));
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.removeRecursively();
+        dir.mkpath(QStringLiteral("."));
+
+        m_dbmanager = new DBManager();
+        QVERIFY(m_directory.isValid());
+    }
+
+    // Imports a large history in the background while measuring how long
+    // the event loop is blocked and how much memory is used
+    void benchmarkLargeImport()
+    {
+        const int rows = qEnvironmentVariableIsSet("ANGELFISH_IMPORT_ROWS") ? qEnvironmentVariableIntValue("ANGELFISH_IMPORT_ROWS") : DEFAULT_IMPORT_ROWS;
+
+        const QString path = m_directory.filePath(QStringLiteral("large.jsonl"));
+        {
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            for (int i = 0; i < rows; i++) {
+                file.write(QStringLiteral("{\"type\":\"history\",\"url\":\"https://site%1.example/page/%2\",\"title\":\"Page %2\",\"lastVisited\":%3}\n")
+                               .arg(i % 1000)
+                               .arg(i)
+                               .arg(1500000000 + i)
+                               .toUtf8());
+            }
+        }
+
+        DataTransfer transfer(m_dbmanager->databaseFile());
+        QSignalSpy finishedSpy(&transfer, &DataTransfer::finished);
+        QSignalSpy tableSpy(&transfer, &DataTransfer::tableChanged);
+
+        const qint64 memoryBefore = ProcessMemory::resident();
+        qint64 peakMemory = memoryBefore;
+        qint64 longestStall = 0;
+        QElapsedTimer sinceTick;
+        QTimer ticker;
+        ticker.setInterval(10);
+        connect(&ticker, &QTimer::timeout, this, [&] {
+            longestStall = qMax(longestStall, sinceTick.restart());
+            peakMemory = qMax(peakMemory, ProcessMemory::resident());
+        });
+
+        QBENCHMARK_ONCE {
+            sinceTick.start();
+            ticker.start();
+            transfer.importFile(QUrl::fromLocalFile(path), DataTransfer::JsonLines);
+            QVERIFY(transfer.running());
+            QVERIFY(finishedSpy.wait(600000));
+            ticker.stop();
+        }
+
+        QCOMPARE(finishedSpy.constFirst().at(0).toInt(), rows);
+        QCOMPARE(finishedSpy.constFirst().at(1).toString(), QString());
+        QCOMPARE(tableSpy.count(), 1);
+        QSqlQuery count(QStringLiteral("SELECT COUNT(*) FROM history"));
+        QVERIFY(count.next());
+        QCOMPARE(count.value(0).toInt(), rows);
+
+        const qint64 memoryGrowth = (peakMemory - memoryBefore) / 1024;
+        qInfo().noquote() << QStringLiteral("Imported %1 entries, longest event loop stall %2 ms, memory growth %3 MiB")
+                                 .arg(rows)
+                                 .arg(longestStall)
+                                 .arg(memoryGrowth);
+
+        // independent of the number of rows
+        QVERIFY(memoryGrowth < 64);
+        QVERIFY(longestStall < 250);
+    }
+
+    void cleanupTestCase()
+    {
+        delete m_dbmanager;
+    }
+
+private:
+    DBManager *m_dbmanager = nullptr;
+    QTemporaryDir m_directory;
+};
+
+QTEST_GUILESS_MAIN(ImportBenchmark)
+
+#include "importbenchmark.moc"
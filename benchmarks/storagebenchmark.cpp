@@ -0,0 +1,284 @@
+/*
+ *  SPDX-FileCopyrightText: 2020 Angelfish developers
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-only
+ */
+
+#include <QtTest/QTest>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "bookmarkshistorymodel.h"
+#include "browsermanager.h"
+#include "datagenerator.h"
+#include "iconimageprovider.h"
+
+// history sizes measured, override with ANGELFISH_BENCHMARK_ROWS=3000,100000
+static const QByteArray DEFAULT_SIZES = QByteArrayLiteral("3000,100000,1000000");
+// urls looked up by the benchmarks, picked from the generated history
+constexpr int SAMPLE_SIZE = 1000;
+
+class StorageBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    static bool execute(QSqlQuery &query)
+    {
+        if (!query.exec()) {
+            qWarning() << query.lastQuery() << query.lastError();
+            return false;
+        }
+        return true;
+    }
+
+    static bool execute(const QString &sql)
+    {
+        QSqlQuery query;
+        query.prepare(sql);
+        return execute(query);
+    }
+
+    void addSizes()
+    {
+        QTest::addColumn<int>("rows");
+        for (int rows : qAsConst(m_sizes))
+            QTest::newRow(QByteArray::number(rows).constData()) << rows;
+    }
+
+    // Fills the database with rows history entries. Generated once per size
+    // and copied from a template afterwards, which is a lot faster.
+    void useDatabase(int rows)
+    {
+        if (rows == m_rows && !m_modified)
+            return;
+
+        static const QStringList tables = {QStringLiteral("history"), QStringLiteral("bookmarks"), QStringLiteral("icons")};
+        const QString file = m_templates.filePath(QStringLiteral("template-%1.sqlite").arg(rows));
+        const bool generate = !QFile::exists(file);
+
+        if (generate) {
+            DataGenerator generator;
+            QSqlDatabase database = QSqlDatabase::database();
+            QVERIFY(generator.populate(database, rows, rows / 50));
+        }
+
+        QSqlQuery attach;
+        attach.prepare(QStringLiteral("ATTACH DATABASE :file AS template"));
+        attach.bindValue(QStringLiteral(":file"), file);
+        QVERIFY(execute(attach));
+
+        QVERIFY(execute(QStringLiteral("BEGIN")));
+        for (const QString &table : tables) {
+            if (generate) {
+                QVERIFY(execute(QStringLiteral("CREATE TABLE template.%1 AS SELECT * FROM main.%1").arg(table)));
+            } else {
+                QVERIFY(execute(QStringLiteral("DELETE FROM main.%1").arg(table)));
+                QVERIFY(execute(QStringLiteral("INSERT INTO main.%1 SELECT * FROM template.%1").arg(table)));
+            }
+        }
+        QVERIFY(execute(QStringLiteral("COMMIT")));
+        QVERIFY(execute(QStringLiteral("DETACH DATABASE template")));
+
+        m_urls.clear();
+        m_icons.clear();
+        QSqlQuery sample;
+        QVERIFY(sample.exec(QStringLiteral("SELECT url, icon FROM history ORDER BY random() LIMIT %1").arg(SAMPLE_SIZE)));
+        while (sample.next()) {
+            m_urls.append(sample.value(0).toString());
+            m_icons.append(sample.value(1).toString());
+        }
+
+        QSqlQuery domain;
+        QVERIFY(domain.exec(QStringLiteral("SELECT domain FROM history GROUP BY domain ORDER BY COUNT(*) DESC LIMIT 1")));
+        QVERIFY(domain.next());
+        m_topDomain = domain.value(0).toString();
+
+        m_rows = rows;
+        m_modified = false;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QCoreApplication::setOrganizationName(QStringLiteral("autotests"));
+        QCoreApplication::setApplicationName(QStringLiteral("angelfish_storagebenchmark"));
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.removeRecursively();
+        dir.mkpath(QStringLiteral("."));
+
+        const QByteArray sizes = qEnvironmentVariableIsSet("ANGELFISH_BENCHMARK_ROWS") ? qgetenv("ANGELFISH_BENCHMARK_ROWS") : DEFAULT_SIZES;
+        for (const QByteArray &size : sizes.split(','))
+            m_sizes.append(size.toInt());
+
+        QVERIFY(m_templates.isValid());
+        // creates the database
+        BrowserManager::instance();
+    }
+
+    void benchmarkAddToHistory_data()
+    {
+        addSizes();
+    }
+
+    void benchmarkAddToHistory()
+    {
+        QFETCH(int, rows);
+        useDatabase(rows);
+
+        int i = 0;
+        QBENCHMARK {
+            BrowserManager::instance()->addToHistory({
+                {QStringLiteral("url"), QStringLiteral("https://benchmark.example/%1").arg(i++)},
+                {QStringLiteral("title"), QStringLiteral("Benchmark")},
+            });
+        }
+        m_modified = true;
+    }
+
+    void benchmarkIsBookmarked_data()
+    {
+        addSizes();
+    }
+
+    void benchmarkIsBookmarked()
+    {
+        QFETCH(int, rows);
+        useDatabase(rows);
+
+        int i = 0;
+        QBENCHMARK {
+            BrowserManager::instance()->isBookmarked(m_urls.at(i++ % m_urls.size()));
+        }
+    }
+
+    void benchmarkUpdateIcon_data()
+    {
+        addSizes();
+    }
+
+    void benchmarkUpdateIcon()
+    {
+        QFETCH(int, rows);
+        useDatabase(rows);
+
+        // icons already stored, like on every visit after the first
+        const QString stored = QStringLiteral("image://%1/").arg(IconImageProvider::providerId());
+        int i = 0;
+        QBENCHMARK {
+            const int index = i++ % m_urls.size();
+            BrowserManager::instance()->updateIcon(m_urls.at(index), QStringLiteral("image://favicon/") + m_icons.at(index).mid(stored.size()));
+        }
+    }
+
+    void benchmarkUpdateLastVisited_data()
+    {
+        addSizes();
+    }
+
+    void benchmarkUpdateLastVisited()
+    {
+        QFETCH(int, rows);
+        useDatabase(rows);
+
+        int i = 0;
+        QBENCHMARK {
+            BrowserManager::instance()->updateLastVisited(m_urls.at(i++ % m_urls.size()));
+        }
+    }
+
+    void benchmarkRequestIcon_data()
+    {
+        addSizes();
+    }
+
+    void benchmarkRequestIcon()
+    {
+        QFETCH(int, rows);
+        useDatabase(rows);
+
+        IconImageProvider provider(nullptr);
+        const QString stored = QStringLiteral("image://%1/").arg(IconImageProvider::providerId());
+        int i = 0;
+        QBENCHMARK {
+            provider.requestImage(m_icons.at(i++ % m_icons.size()).mid(stored.size()), nullptr, QSize());
+        }
+    }
+
+    // trims the history and the icons
+    void benchmarkMaintenance_data()
+    {
+        addSizes();
+    }
+
+    void benchmarkMaintenance()
+    {
+        QFETCH(int, rows);
+        useDatabase(rows);
+
+        QBENCHMARK_ONCE {
+            DBManager::runMaintenance(BrowserManager::instance()->databaseFile());
+        }
+        m_modified = true;
+    }
+
+    void benchmarkModelQuery_data()
+    {
+        QTest::addColumn<int>("rows");
+        QTest::addColumn<bool>("bookmarks");
+        QTest::addColumn<bool>("history");
+        QTest::addColumn<QString>("filter");
+        QTest::addColumn<bool>("domain");
+
+        for (int rows : qAsConst(m_sizes)) {
+            const QByteArray size = QByteArray::number(rows);
+            QTest::newRow((size + " history").constData()) << rows << false << true << QString() << false;
+            QTest::newRow((size + " bookmarks").constData()) << rows << true << false << QString() << false;
+            QTest::newRow((size + " filter").constData()) << rows << true << true << QStringLiteral("plasma") << false;
+            QTest::newRow((size + " domain").constData()) << rows << false << true << QString() << true;
+        }
+    }
+
+    void benchmarkModelQuery()
+    {
+        QFETCH(int, rows);
+        QFETCH(bool, bookmarks);
+        QFETCH(bool, history);
+        QFETCH(QString, filter);
+        QFETCH(bool, domain);
+        useDatabase(rows);
+
+        BookmarksHistoryModel model;
+        model.setActive(false);
+        model.setBookmarks(bookmarks);
+        model.setHistory(history);
+        model.setFilter(filter);
+        if (domain)
+            model.setDomain(m_topDomain);
+
+        // every activation runs the query again
+        QBENCHMARK {
+            model.setActive(true);
+            model.setActive(false);
+        }
+    }
+
+private:
+    QVector<int> m_sizes;
+    QTemporaryDir m_templates;
+    int m_rows = -1;
+    // whether a benchmark changed the entries
+    bool m_modified = false;
+    QStringList m_urls;
+    QStringList m_icons;
+    QString m_topDomain;
+};
+
+QTEST_GUILESS_MAIN(StorageBenchmark)
+
+#include "storagebenchmark.moc"
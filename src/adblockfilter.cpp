@@ -0,0 +1,534 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "adblockfilter.h"
+#include "urlutils.h"
+
+#include <QDataStream>
+#include <QIODevice>
+#include <QUrl>
+
+constexpr quint32 FILTER_FORMAT_VERSION = 1;
+
+namespace {
+// letters and digits of a lower case url, the parts urls are split into for the index
+inline bool isTokenChar(QChar c)
+{
+    const ushort u = c.unicode();
+    return (u >= 'a' && u <= 'z') || (u >= '0' && u <= '9') || u == '%';
+}
+
+// "^" in a pattern stands for anything but a letter, a digit or one of "_-.%"
+inline bool isSeparator(QChar c)
+{
+    return !c.isLetterOrNumber() && c != QLatin1Char('_') && c != QLatin1Char('-') && c != QLatin1Char('.') && c != QLatin1Char('%');
+}
+
+inline uint tokenHash(QStringView token)
+{
+    return qHash(token);
+}
+
+// Whether the pattern matches the beginning of the text, or the whole text
+// if anchorEnd is set. "*" matches any sequence, "^" a separator or the end
+// of the text.
+bool globMatch(QStringView pattern, QStringView text, bool anchorEnd)
+{
+    int p = 0;
+    int t = 0;
+    int starP = -1;
+    int starT = 0;
+
+    while (true) {
+        if (p == pattern.size()) {
+            if (!anchorEnd || t == text.size())
+                return true;
+        } else if (pattern[p] == QLatin1Char('*')) {
+            starP = ++p;
+            starT = t;
+            continue;
+        } else if (t < text.size() && (pattern[p] == QLatin1Char('^') ? isSeparator(text[t]) : pattern[p] == text[t])) {
+            ++p;
+            ++t;
+            continue;
+        } else if (t == text.size() && pattern[p] == QLatin1Char('^')) {
+            ++p;
+            continue;
+        }
+
+        // let the last "*" consume one more character and try again
+        if (starP < 0 || starT >= text.size())
+            return false;
+        p = starP;
+        t = ++starT;
+    }
+}
+
+bool isSubdomainOf(const QString &host, const QString &domain)
+{
+    if (!host.endsWith(domain))
+        return false;
+    return host.size() == domain.size() || host.at(host.size() - domain.size() - 1) == QLatin1Char('.');
+}
+
+int hostStart(const QString &url, const QString &host)
+{
+    const int scheme = url.indexOf(QLatin1String("://"));
+    const int from = scheme < 0 ? 0 : scheme + 3;
+    const int index = url.indexOf(host, from);
+    return index < 0 ? from : index;
+}
+
+const QHash<QString, quint32> &typeOptions()
+{
+    static const QHash<QString, quint32> types = {
+        {QStringLiteral("document"), AdblockFilter::Document},
+        {QStringLiteral("subdocument"), AdblockFilter::SubDocument},
+        {QStringLiteral("stylesheet"), AdblockFilter::Stylesheet},
+        {QStringLiteral("script"), AdblockFilter::Script},
+        {QStringLiteral("image"), AdblockFilter::Image},
+        {QStringLiteral("font"), AdblockFilter::Font},
+        {QStringLiteral("object"), AdblockFilter::Object},
+        {QStringLiteral("object-subrequest"), AdblockFilter::Object},
+        {QStringLiteral("xmlhttprequest"), AdblockFilter::XmlHttpRequest},
+        {QStringLiteral("ping"), AdblockFilter::Ping},
+        {QStringLiteral("beacon"), AdblockFilter::Ping},
+        {QStringLiteral("media"), AdblockFilter::Media},
+        {QStringLiteral("websocket"), AdblockFilter::WebSocket},
+        {QStringLiteral("other"), AdblockFilter::Other},
+    };
+    return types;
+}
+
+// tokens found in almost every url, which make a bad index
+bool isCommonToken(QStringView token)
+{
+    static const QStringList common = {
+        QStringLiteral("http"),
+        QStringLiteral("https"),
+        QStringLiteral("www"),
+        QStringLiteral("com"),
+        QStringLiteral("net"),
+        QStringLiteral("org"),
+        QStringLiteral("js"),
+        QStringLiteral("html"),
+    };
+    for (const QString &c : common) {
+        if (token == c)
+            return true;
+    }
+    return false;
+}
+}
+
+AdblockFilter::Request::Request(const QUrl &url, const QUrl &firstPartyUrl, ResourceType type)
+    : m_url(url.toString(QUrl::FullyEncoded).toLower())
+    , m_host(url.host(QUrl::FullyEncoded).toLower())
+    , m_firstPartyUrl(firstPartyUrl.toString(QUrl::FullyEncoded).toLower())
+    , m_firstPartyHost(firstPartyUrl.host(QUrl::FullyEncoded).toLower())
+    , m_type(type)
+{
+    m_hostStart = hostStart(m_url, m_host);
+    m_firstPartyHostStart = hostStart(m_firstPartyUrl, m_firstPartyHost);
+}
+
+bool AdblockFilter::Request::isThirdParty() const
+{
+    // only computed for the few rules with a third-party option
+    if (m_thirdParty < 0) {
+        m_thirdParty = !m_firstPartyHost.isEmpty() && UrlUtils::urlRegistrableDomain(m_url) != UrlUtils::urlRegistrableDomain(m_firstPartyUrl);
+    }
+    return m_thirdParty;
+}
+
+int AdblockFilter::addList(QIODevice *device)
+{
+    int added = 0;
+    while (!device->atEnd()) {
+        if (addRule(QString::fromUtf8(device->readLine())))
+            added++;
+    }
+    return added;
+}
+
+int AdblockFilter::addList(const QString &text)
+{
+    int added = 0;
+    const auto lines = text.splitRef(QLatin1Char('\n'));
+    for (const QStringRef &line : lines) {
+        if (addRule(line.toString()))
+            added++;
+    }
+    return added;
+}
+
+bool AdblockFilter::addRule(const QString &text)
+{
+    QString line = text.trimmed();
+
+    // comments, the list header and element hiding rules
+    if (line.isEmpty() || line.startsWith(QLatin1Char('!')) || line.startsWith(QLatin1Char('[')))
+        return false;
+    if (line.contains(QLatin1String("##")) || line.contains(QLatin1String("#@#")) || line.contains(QLatin1String("#?#"))
+        || line.contains(QLatin1String("#$#")) || line.contains(QLatin1String("#%#")))
+        return false;
+
+    Rule rule;
+    if (line.startsWith(QLatin1String("@@"))) {
+        rule.flags |= Exception;
+        line.remove(0, 2);
+    }
+
+    const int dollar = line.lastIndexOf(QLatin1Char('$'));
+    if (dollar >= 0) {
+        if (!parseOptions(line.mid(dollar + 1), &rule))
+            return false;
+        line.truncate(dollar);
+    }
+
+    // regular expressions are not supported
+    if (line.size() > 1 && line.startsWith(QLatin1Char('/')) && line.endsWith(QLatin1Char('/')))
+        return false;
+
+    line = line.toLower();
+    if (line.startsWith(QLatin1String("||"))) {
+        rule.flags |= HostAnchor;
+        line.remove(0, 2);
+    } else if (line.startsWith(QLatin1Char('|'))) {
+        rule.flags |= StartAnchor;
+        line.remove(0, 1);
+    }
+    if (line.endsWith(QLatin1Char('|'))) {
+        rule.flags |= EndAnchor;
+        line.chop(1);
+    }
+
+    // wildcards at the ends don't change the meaning, but defeat the anchors
+    while (line.startsWith(QLatin1Char('*'))) {
+        rule.flags &= ~(HostAnchor | StartAnchor);
+        line.remove(0, 1);
+    }
+    while (line.endsWith(QLatin1Char('*'))) {
+        rule.flags &= ~EndAnchor;
+        line.chop(1);
+    }
+
+    // a rule that would match every request is most likely a mistake
+    if (line.isEmpty() && rule.domains.isEmpty() && rule.types == DefaultTypes)
+        return false;
+
+    rule.pattern = line;
+    insert(std::move(rule));
+    return true;
+}
+
+bool AdblockFilter::parseOptions(const QString &options, Rule *rule)
+{
+    quint32 included = 0;
+    quint32 excluded = 0;
+
+    const auto list = options.splitRef(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QStringRef &optionRef : list) {
+        const QString option = optionRef.trimmed().toString().toLower();
+        const bool inverse = option.startsWith(QLatin1Char('~'));
+        const QString name = inverse ? option.mid(1) : option;
+
+        const auto type = typeOptions().constFind(name);
+        if (type != typeOptions().cend()) {
+            (inverse ? excluded : included) |= type.value();
+        } else if (name == QLatin1String("third-party") || name == QLatin1String("3p")) {
+            rule->flags |= inverse ? FirstPartyOnly : ThirdPartyOnly;
+        } else if (name == QLatin1String("first-party") || name == QLatin1String("1p")) {
+            rule->flags |= inverse ? ThirdPartyOnly : FirstPartyOnly;
+        } else if (name.startsWith(QLatin1String("domain="))) {
+            const auto domains = name.midRef(7).split(QLatin1Char('|'), Qt::SkipEmptyParts);
+            for (const QStringRef &domain : domains) {
+                if (domain.startsWith(QLatin1Char('~')))
+                    rule->excludedDomains.append(domain.mid(1).toString());
+                else
+                    rule->domains.append(domain.toString());
+            }
+        } else if (name == QLatin1String("match-case") || name == QLatin1String("important")) {
+            // urls are always compared case-insensitively, and there is no
+            // precedence between the lists
+        } else {
+            // popup, csp, redirect and friends can't be applied to a request
+            return false;
+        }
+    }
+
+    if (included)
+        rule->types = included & ~excluded;
+    else if (excluded)
+        rule->types = DefaultTypes & ~excluded;
+
+    return rule->types != 0;
+}
+
+bool AdblockFilter::isHostRule(const Rule &rule)
+{
+    if ((rule.flags & ~Exception) != HostAnchor || rule.types != DefaultTypes || !rule.domains.isEmpty() || !rule.excludedDomains.isEmpty())
+        return false;
+
+    const QString &pattern = rule.pattern;
+    if (pattern.size() < 2 || !pattern.endsWith(QLatin1Char('^')))
+        return false;
+
+    for (int i = 0; i < pattern.size() - 1; i++) {
+        const QChar c = pattern.at(i);
+        if (!isTokenChar(c) && c != QLatin1Char('.') && c != QLatin1Char('-') && c != QLatin1Char('_'))
+            return false;
+    }
+    return true;
+}
+
+uint AdblockFilter::bestToken(const Rule &rule, bool *found)
+{
+    const QStringView pattern(rule.pattern);
+    const bool startAnchored = rule.flags & (HostAnchor | StartAnchor);
+    const bool endAnchored = rule.flags & EndAnchor;
+
+    // A token can only be used if it is a complete token of every url the
+    // rule matches, so it must not touch a wildcard or an unanchored end.
+    QStringView best;
+    int bestScore = -1;
+    int i = 0;
+    while (i < pattern.size()) {
+        if (!isTokenChar(pattern[i])) {
+            i++;
+            continue;
+        }
+        const int start = i;
+        while (i < pattern.size() && isTokenChar(pattern[i]))
+            i++;
+
+        const bool leftBounded = start > 0 ? pattern[start - 1] != QLatin1Char('*') : startAnchored;
+        const bool rightBounded = i < pattern.size() ? pattern[i] != QLatin1Char('*') : endAnchored;
+        if (!leftBounded || !rightBounded)
+            continue;
+
+        const QStringView token = pattern.mid(start, i - start);
+        const int score = isCommonToken(token) ? 0 : token.size();
+        if (score > bestScore) {
+            best = token;
+            bestScore = score;
+        }
+    }
+
+    *found = bestScore >= 0;
+    return *found ? tokenHash(best) : 0;
+}
+
+void AdblockFilter::insert(Rule &&rule)
+{
+    const bool exception = rule.flags & Exception;
+
+    if (isHostRule(rule)) {
+        const QString host = rule.pattern.left(rule.pattern.size() - 1);
+        (exception ? m_allowedHosts : m_blockedHosts).insert(host, true);
+        return;
+    }
+
+    if (exception && (rule.types & Document))
+        m_hasDocumentExceptions = true;
+
+    RuleSet &set = exception ? m_exceptions : m_blocking;
+    const int index = m_rules.size();
+    bool found = false;
+    const uint token = bestToken(rule, &found);
+    if (found)
+        set.byToken[token].append(index);
+    else
+        set.untokenized.append(index);
+
+    m_rules.append(std::move(rule));
+}
+
+bool AdblockFilter::shouldBlock(const Request &request) const
+{
+    // data:, blob: and similar urls never cause network traffic
+    if (request.m_host.isEmpty())
+        return false;
+
+    const bool defaultType = request.m_type & DefaultTypes;
+    if (defaultType && m_allowedHosts.find(request.m_host))
+        return false;
+
+    const Target target{request.m_url, request.m_hostStart, request.m_hostStart + request.m_host.size(), request.m_type};
+    const bool blocked = (defaultType && m_blockedHosts.find(request.m_host)) || matchesAny(m_blocking, request, target);
+    if (!blocked)
+        return false;
+
+    if (matchesAny(m_exceptions, request, target))
+        return false;
+
+    if (m_hasDocumentExceptions && !request.m_firstPartyHost.isEmpty()) {
+        const Target page{request.m_firstPartyUrl,
+                          request.m_firstPartyHostStart,
+                          request.m_firstPartyHostStart + request.m_firstPartyHost.size(),
+                          Document};
+        if (matchesAny(m_exceptions, request, page))
+            return false;
+    }
+
+    return true;
+}
+
+bool AdblockFilter::matchesAny(const RuleSet &set, const Request &request, const Target &target) const
+{
+    for (const int index : set.untokenized) {
+        if (matches(m_rules.at(index), request, target))
+            return true;
+    }
+
+    if (set.byToken.isEmpty())
+        return false;
+
+    const QStringView url(target.url);
+    int i = 0;
+    while (i < url.size()) {
+        if (!isTokenChar(url[i])) {
+            i++;
+            continue;
+        }
+        const int start = i;
+        while (i < url.size() && isTokenChar(url[i]))
+            i++;
+
+        const auto candidates = set.byToken.constFind(tokenHash(url.mid(start, i - start)));
+        if (candidates == set.byToken.cend())
+            continue;
+
+        for (const int index : *candidates) {
+            if (matches(m_rules.at(index), request, target))
+                return true;
+        }
+    }
+    return false;
+}
+
+bool AdblockFilter::matches(const Rule &rule, const Request &request, const Target &target) const
+{
+    if (!(rule.types & target.type))
+        return false;
+
+    if (rule.flags & (ThirdPartyOnly | FirstPartyOnly)) {
+        const bool thirdParty = request.isThirdParty();
+        if ((rule.flags & ThirdPartyOnly) && !thirdParty)
+            return false;
+        if ((rule.flags & FirstPartyOnly) && thirdParty)
+            return false;
+    }
+
+    return matchesDomain(rule, request.m_firstPartyHost) && matchesPattern(rule, target);
+}
+
+bool AdblockFilter::matchesDomain(const Rule &rule, const QString &host)
+{
+    for (const QString &domain : rule.excludedDomains) {
+        if (isSubdomainOf(host, domain))
+            return false;
+    }
+
+    if (rule.domains.isEmpty())
+        return true;
+
+    for (const QString &domain : rule.domains) {
+        if (isSubdomainOf(host, domain))
+            return true;
+    }
+    return false;
+}
+
+bool AdblockFilter::matchesPattern(const Rule &rule, const Target &target)
+{
+    const QStringView pattern(rule.pattern);
+    const QStringView url(target.url);
+    const bool anchorEnd = rule.flags & EndAnchor;
+
+    if (rule.flags & HostAnchor) {
+        // at the start of the host or of one of its labels
+        for (int i = target.hostStart; i < target.hostEnd; i++) {
+            if ((i == target.hostStart || url[i - 1] == QLatin1Char('.')) && globMatch(pattern, url.mid(i), anchorEnd))
+                return true;
+        }
+        return false;
+    }
+
+    if (rule.flags & StartAnchor)
+        return globMatch(pattern, url, anchorEnd);
+
+    // only try the positions where the literal beginning of the pattern occurs
+    int literal = 0;
+    while (literal < pattern.size() && pattern[literal] != QLatin1Char('*') && pattern[literal] != QLatin1Char('^'))
+        literal++;
+
+    if (literal == 0) {
+        for (int i = 0; i <= url.size(); i++) {
+            if (globMatch(pattern, url.mid(i), anchorEnd))
+                return true;
+        }
+        return false;
+    }
+
+    const QStringRef prefix = rule.pattern.leftRef(literal);
+    for (int i = target.url.indexOf(prefix); i >= 0; i = target.url.indexOf(prefix, i + 1)) {
+        if (globMatch(pattern, url.mid(i), anchorEnd))
+            return true;
+    }
+    return false;
+}
+
+int AdblockFilter::ruleCount() const
+{
+    return m_blockedHosts.count() + m_allowedHosts.count() + m_rules.size();
+}
+
+void AdblockFilter::save(QDataStream &stream) const
+{
+    stream << FILTER_FORMAT_VERSION;
+    stream << m_blockedHosts.patterns() << m_allowedHosts.patterns();
+
+    stream << quint32(m_rules.size());
+    for (const Rule &rule : m_rules)
+        stream << rule.pattern << rule.flags << rule.types << rule.domains << rule.excludedDomains;
+}
+
+bool AdblockFilter::load(QDataStream &stream)
+{
+    *this = AdblockFilter();
+
+    quint32 version = 0;
+    stream >> version;
+    if (version != FILTER_FORMAT_VERSION)
+        return false;
+
+    QStringList blockedHosts;
+    QStringList allowedHosts;
+    stream >> blockedHosts >> allowedHosts;
+    for (const QString &host : qAsConst(blockedHosts))
+        m_blockedHosts.insert(host, true);
+    for (const QString &host : qAsConst(allowedHosts))
+        m_allowedHosts.insert(host, true);
+
+    quint32 count = 0;
+    stream >> count;
+    m_rules.reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        Rule rule;
+        stream >> rule.pattern >> rule.flags >> rule.types >> rule.domains >> rule.excludedDomains;
+        // the token index is cheap to rebuild and not stored
+        insert(std::move(rule));
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        *this = AdblockFilter();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,152 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef ADBLOCKFILTER_H
+#define ADBLOCKFILTER_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "hostmatcher.h"
+
+class QDataStream;
+class QIODevice;
+class QUrl;
+
+/**
+ * @class AdblockFilter
+ * @short Compiled EasyList-style filter list.
+ *
+ * Supported are blocking and exception ("@@") rules with the "|", "||", "^"
+ * and "*" syntax and the resource type, third-party and domain options.
+ * Element hiding rules, regular expressions and options that would need to
+ * rewrite requests are skipped.
+ *
+ * Rules of the form "||host^" make up most of the common lists and are stored
+ * in a HostMatcher. All other rules are indexed by one token (a run of letters
+ * and digits) which appears in every url they can match. A url is split into
+ * its tokens, and only the rules stored under one of them are checked, so the
+ * matching cost depends on the length of the url and not on the size of the
+ * list.
+ *
+ * The class doesn't depend on WebEngine, so lists can be compiled on any
+ * thread. A compiled filter is immutable and can be shared between threads.
+ */
+class AdblockFilter
+{
+public:
+    enum ResourceType : quint32 {
+        Document = 1 << 0,
+        SubDocument = 1 << 1,
+        Stylesheet = 1 << 2,
+        Script = 1 << 3,
+        Image = 1 << 4,
+        Font = 1 << 5,
+        Object = 1 << 6,
+        XmlHttpRequest = 1 << 7,
+        Ping = 1 << 8,
+        Media = 1 << 9,
+        WebSocket = 1 << 10,
+        Other = 1 << 11,
+        // rules without type options don't apply to the page itself
+        DefaultTypes = (1 << 12) - 1 - Document,
+    };
+
+    class Request
+    {
+    public:
+        Request(const QUrl &url, const QUrl &firstPartyUrl, ResourceType type);
+
+    private:
+        friend class AdblockFilter;
+
+        bool isThirdParty() const;
+
+        QString m_url; // lower case
+        QString m_host;
+        int m_hostStart = 0;
+        QString m_firstPartyUrl; // lower case
+        QString m_firstPartyHost;
+        int m_firstPartyHostStart = 0;
+        ResourceType m_type;
+        mutable int m_thirdParty = -1;
+    };
+
+    // adds the rules of a list in the EasyList format, returns the number of rules added
+    int addList(QIODevice *device);
+    int addList(const QString &text);
+    // adds a single line of a list, returns whether it was a supported rule
+    bool addRule(const QString &line);
+
+    bool shouldBlock(const Request &request) const;
+
+    int ruleCount() const;
+
+    // compact binary form of the compiled rules, which can be loaded without
+    // parsing the lists again
+    void save(QDataStream &stream) const;
+    bool load(QDataStream &stream);
+
+private:
+    enum RuleFlag : quint8 {
+        Exception = 1 << 0,
+        HostAnchor = 1 << 1,
+        StartAnchor = 1 << 2,
+        EndAnchor = 1 << 3,
+        ThirdPartyOnly = 1 << 4,
+        FirstPartyOnly = 1 << 5,
+    };
+
+    struct Rule {
+        QString pattern;
+        quint8 flags = 0;
+        quint32 types = DefaultTypes;
+        QStringList domains;
+        QStringList excludedDomains;
+    };
+
+    struct RuleSet {
+        // rules by the hash of their token
+        QHash<uint, QVector<int>> byToken;
+        // rules without a usable token, checked for every request
+        QVector<int> untokenized;
+    };
+
+    // the url a rule is matched against, either the one of the request or
+    // the one of the page for "$document" exceptions
+    struct Target {
+        const QString &url;
+        int hostStart;
+        int hostEnd;
+        quint32 type;
+    };
+
+    static bool parseOptions(const QString &options, Rule *rule);
+    static bool isHostRule(const Rule &rule);
+    static uint bestToken(const Rule &rule, bool *found);
+
+    void insert(Rule &&rule);
+    bool matchesAny(const RuleSet &set, const Request &request, const Target &target) const;
+    bool matches(const Rule &rule, const Request &request, const Target &target) const;
+    static bool matchesDomain(const Rule &rule, const QString &host);
+    static bool matchesPattern(const Rule &rule, const Target &target);
+
+    // "||host^" rules without options
+    HostMatcher<bool> m_blockedHosts;
+    HostMatcher<bool> m_allowedHosts;
+
+    QVector<Rule> m_rules;
+    RuleSet m_blocking;
+    RuleSet m_exceptions;
+    // whether there are "$document" exceptions, which are checked against the page
+    bool m_hasDocumentExceptions = false;
+};
+
+#endif // ADBLOCKFILTER_H
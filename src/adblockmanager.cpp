@@ -0,0 +1,234 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "adblockmanager.h"
+#include "adblockfilter.h"
+#include "requestinterceptor.h"
+#include "tracer.h"
+
+#include "angelfishsettings.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+constexpr quint32 CACHE_MAGIC = 0x41464142; // "AFAB"
+
+AdblockManager *AdblockManager::s_instance = nullptr;
+
+namespace {
+QFileInfoList listFiles(const QString &location)
+{
+    return QDir(location).entryInfoList({QStringLiteral("*.txt")}, QDir::Files, QDir::Name);
+}
+
+// changes whenever a list is added, removed or modified
+QByteArray listsSignature(const QFileInfoList &lists)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const QFileInfo &list : lists) {
+        hash.addData(list.fileName().toUtf8());
+        hash.addData(QByteArray::number(list.size()));
+        hash.addData(QByteArray::number(list.lastModified().toMSecsSinceEpoch()));
+    }
+    return hash.result();
+}
+}
+
+AdblockManager::AdblockManager(QObject *parent)
+    : QObject(parent)
+    , m_interceptor(new RequestInterceptor(this))
+    , m_listsWatcher(new QFileSystemWatcher(this))
+{
+    connect(m_interceptor, &RequestInterceptor::requestBlocked, this, &AdblockManager::onRequestBlocked);
+
+    m_interceptor->setAdblockEnabled(AngelfishSettings::self()->adblockEnabled());
+    connect(AngelfishSettings::self(), &AngelfishSettings::adblockEnabledChanged, this, [this] {
+        m_interceptor->setAdblockEnabled(AngelfishSettings::self()->adblockEnabled());
+        emit enabledChanged();
+    });
+
+    connect(&m_loader, &QFutureWatcher<std::shared_ptr<const AdblockFilter>>::finished, this, [this] {
+        const auto filter = m_loader.result();
+        m_ruleCount = filter ? filter->ruleCount() : 0;
+        m_interceptor->setAdblockFilter(filter);
+        emit filterChanged();
+
+        if (m_reloadPending) {
+            m_reloadPending = false;
+            reload();
+        }
+    });
+
+    // create the directory, so that it is easy to find where lists belong
+    QDir().mkpath(listsLocation());
+    m_listsWatcher->addPath(listsLocation());
+    connect(m_listsWatcher, &QFileSystemWatcher::directoryChanged, this, &AdblockManager::reload);
+    connect(m_listsWatcher, &QFileSystemWatcher::fileChanged, this, &AdblockManager::reload);
+
+    reload();
+}
+
+AdblockManager::~AdblockManager()
+{
+    m_loader.waitForFinished();
+    if (s_instance == this)
+        s_instance = nullptr;
+}
+
+AdblockManager *AdblockManager::instance()
+{
+    if (!s_instance)
+        s_instance = new AdblockManager();
+
+    return s_instance;
+}
+
+bool AdblockManager::enabled() const
+{
+    return AngelfishSettings::self()->adblockEnabled();
+}
+
+int AdblockManager::ruleCount() const
+{
+    return m_ruleCount;
+}
+
+QWebEngineUrlRequestInterceptor *AdblockManager::interceptor() const
+{
+    return m_interceptor;
+}
+
+void AdblockManager::startPage(QObject *view, const QUrl &pageUrl)
+{
+    if (!view)
+        return;
+
+    auto page = m_pages.find(view);
+    if (page == m_pages.end()) {
+        page = m_pages.insert(view, {});
+        connect(view, &QObject::destroyed, this, [this, view] {
+            m_pages.remove(view);
+        });
+    }
+
+    page->url = pageUrl;
+    page->serial = ++m_pageSerial;
+    if (page->blockedCount != 0) {
+        page->blockedCount = 0;
+        emit blockedCountChanged(view, 0);
+    }
+}
+
+void AdblockManager::setPageUrl(QObject *view, const QUrl &pageUrl)
+{
+    const auto page = m_pages.find(view);
+    if (page != m_pages.end())
+        page->url = pageUrl;
+}
+
+int AdblockManager::blockedCount(QObject *view) const
+{
+    return m_pages.value(view).blockedCount;
+}
+
+QString AdblockManager::listsLocation()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/angelfish/adblock");
+}
+
+QString AdblockManager::cacheLocation()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/angelfish/adblock.cache");
+}
+
+void AdblockManager::reload()
+{
+    if (m_loader.isRunning()) {
+        m_reloadPending = true;
+        return;
+    }
+
+    // pick up lists which are modified in place
+    const QStringList watched = m_listsWatcher->files();
+    if (!watched.isEmpty())
+        m_listsWatcher->removePaths(watched);
+    for (const QFileInfo &list : listFiles(listsLocation()))
+        m_listsWatcher->addPath(list.filePath());
+
+    m_loader.setFuture(QtConcurrent::run(&AdblockManager::loadFilter, listsLocation(), cacheLocation()));
+}
+
+std::shared_ptr<const AdblockFilter> AdblockManager::loadFilter(const QString &listsLocation, const QString &cacheLocation)
+{
+    TraceScope trace("AdblockManager::loadFilter", "adblock");
+
+    const QFileInfoList lists = listFiles(listsLocation);
+    if (lists.isEmpty())
+        return nullptr;
+
+    const QByteArray signature = listsSignature(lists);
+    auto filter = std::make_shared<AdblockFilter>();
+
+    QFile cache(cacheLocation);
+    if (cache.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&cache);
+        quint32 magic = 0;
+        QByteArray cachedSignature;
+        stream >> magic >> cachedSignature;
+        if (magic == CACHE_MAGIC && cachedSignature == signature && filter->load(stream)) {
+            if (trace.active())
+                trace.setArgument(QStringLiteral("%1 rules from the cache").arg(filter->ruleCount()));
+            return filter;
+        }
+        filter = std::make_shared<AdblockFilter>();
+    }
+
+    for (const QFileInfo &list : lists) {
+        QFile file(list.filePath());
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qWarning() << Q_FUNC_INFO << "Failed to open filter list" << list.filePath();
+            continue;
+        }
+        filter->addList(&file);
+    }
+    if (trace.active())
+        trace.setArgument(QStringLiteral("%1 rules compiled").arg(filter->ruleCount()));
+
+    QDir().mkpath(QFileInfo(cacheLocation).path());
+    QSaveFile cacheFile(cacheLocation);
+    if (cacheFile.open(QIODevice::WriteOnly)) {
+        QDataStream stream(&cacheFile);
+        stream << CACHE_MAGIC << signature;
+        filter->save(stream);
+        if (!cacheFile.commit())
+            qWarning() << Q_FUNC_INFO << "Failed to write the filter cache" << cacheLocation;
+    }
+
+    return filter;
+}
+
+void AdblockManager::onRequestBlocked(const QUrl &firstPartyUrl)
+{
+    auto page = m_pages.end();
+    for (auto it = m_pages.begin(); it != m_pages.end(); ++it) {
+        if (it->url == firstPartyUrl && (page == m_pages.end() || it->serial > page->serial))
+            page = it;
+    }
+    if (page == m_pages.end())
+        return;
+
+    emit blockedCountChanged(page.key(), ++page->blockedCount);
+}
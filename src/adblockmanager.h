@@ -0,0 +1,98 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef ADBLOCKMANAGER_H
+#define ADBLOCKMANAGER_H
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QUrl>
+
+#include <memory>
+
+class AdblockFilter;
+class QFileSystemWatcher;
+class QWebEngineUrlRequestInterceptor;
+class RequestInterceptor;
+
+/**
+ * @class AdblockManager
+ * @short Loads the filter lists and counts the blocked requests of each page.
+ *
+ * Lists in the EasyList format are read from the "angelfish/adblock"
+ * directory in the generic data location, so that they are shared with the
+ * web apps. The compiled rules are cached, and the lists are only parsed
+ * again if one of them changed. Both happens on a worker thread.
+ *
+ * Blocked requests are counted per view, starting over with every page it
+ * loads. A request only knows the url of its page, so it is counted for the
+ * view showing that url, or the one which started loading it last if there
+ * are several.
+ */
+class AdblockManager : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool enabled READ enabled NOTIFY enabledChanged)
+    Q_PROPERTY(int ruleCount READ ruleCount NOTIFY filterChanged)
+    Q_PROPERTY(QWebEngineUrlRequestInterceptor *interceptor READ interceptor CONSTANT)
+
+public:
+    ~AdblockManager() override;
+
+    static AdblockManager *instance();
+
+    bool enabled() const;
+    int ruleCount() const;
+    QWebEngineUrlRequestInterceptor *interceptor() const;
+
+    // the view starts loading a page, which is counted from zero
+    Q_INVOKABLE void startPage(QObject *view, const QUrl &pageUrl);
+    // the url of the page changed, e.g. by a redirect, without a new page
+    Q_INVOKABLE void setPageUrl(QObject *view, const QUrl &pageUrl);
+    Q_INVOKABLE int blockedCount(QObject *view) const;
+
+    static QString listsLocation();
+    static QString cacheLocation();
+
+public slots:
+    // compile the lists again, or load them from the cache if nothing changed
+    void reload();
+
+signals:
+    void enabledChanged();
+    void filterChanged();
+    void blockedCountChanged(QObject *view, int count);
+
+private:
+    AdblockManager(QObject *parent = nullptr);
+
+    static std::shared_ptr<const AdblockFilter> loadFilter(const QString &listsLocation, const QString &cacheLocation);
+
+    void onRequestBlocked(const QUrl &firstPartyUrl);
+
+    RequestInterceptor *m_interceptor;
+    QFileSystemWatcher *m_listsWatcher;
+    QFutureWatcher<std::shared_ptr<const AdblockFilter>> m_loader;
+    bool m_reloadPending = false;
+    int m_ruleCount = 0;
+
+    struct Page {
+        QUrl url;
+        // order in which the pages have been started
+        quint64 serial = 0;
+        int blockedCount = 0;
+    };
+    QHash<QObject *, Page> m_pages;
+    quint64 m_pageSerial = 0;
+
+    static AdblockManager *s_instance;
+};
+
+#endif // ADBLOCKMANAGER_H
@@ -0,0 +1,11 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "angelfishlogging.h"
+
+Q_LOGGING_CATEGORY(ANGELFISH_TABS, "org.kde.mobile.angelfish.tabs", QtWarningMsg)
@@ -0,0 +1,18 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef ANGELFISHLOGGING_H
+#define ANGELFISHLOGGING_H
+
+#include <QLoggingCategory>
+
+// Only warnings are shown by default, enable the rest with e.g.
+//   QT_LOGGING_RULES="org.kde.mobile.angelfish.tabs.debug=true"
+Q_DECLARE_LOGGING_CATEGORY(ANGELFISH_TABS)
+
+#endif // ANGELFISHLOGGING_H
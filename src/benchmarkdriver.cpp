@@ -0,0 +1,336 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "benchmarkdriver.h"
+#include "metrics.h"
+#include "processmemory.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QQuickWindow>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// ms a step may take before the benchmark is aborted
+constexpr int STEP_TIMEOUT = 30000;
+
+static const QStringList ACTIONS = {
+    QStringLiteral("openTabs"),
+    QStringLiteral("navigate"),
+    QStringLiteral("switchTab"),
+    QStringLiteral("typeUrl"),
+    QStringLiteral("openHistory"),
+    QStringLiteral("wait"),
+};
+
+BenchmarkDriver *BenchmarkDriver::s_instance = nullptr;
+
+BenchmarkDriver::BenchmarkDriver(QObject *parent)
+    : QObject(parent)
+{
+    m_timeout.setSingleShot(true);
+    m_timeout.setInterval(STEP_TIMEOUT);
+    connect(&m_timeout, &QTimer::timeout, this, [this] {
+        fail(QStringLiteral("Timed out waiting for %1").arg(m_action));
+    });
+}
+
+BenchmarkDriver *BenchmarkDriver::instance()
+{
+    if (!s_instance)
+        s_instance = new BenchmarkDriver();
+
+    return s_instance;
+}
+
+bool BenchmarkDriver::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_error = QStringLiteral("Failed to open %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    return setScript(file.readAll());
+}
+
+bool BenchmarkDriver::setScript(const QByteArray &script)
+{
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(script, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        m_error = parseError.errorString();
+        return false;
+    }
+
+    const QJsonObject object = document.object();
+    QVector<Step> steps;
+    for (const auto &value : object.value(QStringLiteral("steps")).toArray()) {
+        const QVariantMap step = value.toObject().toVariantMap();
+        const QString action = step.value(QStringLiteral("action")).toString();
+        if (!ACTIONS.contains(action)) {
+            m_error = QStringLiteral("Unknown action \"%1\" in step %2").arg(action).arg(steps.size() + 1);
+            return false;
+        }
+        steps.append({action, step});
+    }
+    if (steps.isEmpty()) {
+        m_error = QStringLiteral("The script has no steps");
+        return false;
+    }
+
+    m_steps = steps;
+    m_server.setPageSize(object.value(QStringLiteral("pageSize")).toInt(m_server.pageSize()));
+    m_server.setLatency(object.value(QStringLiteral("latency")).toInt(m_server.latency()));
+    m_error.clear();
+    return true;
+}
+
+QVector<BenchmarkDriver::Step> BenchmarkDriver::steps() const
+{
+    return m_steps;
+}
+
+QString BenchmarkDriver::errorString() const
+{
+    return m_error;
+}
+
+BenchmarkServer *BenchmarkDriver::server()
+{
+    return &m_server;
+}
+
+void BenchmarkDriver::start(QQuickWindow *window)
+{
+    m_window = window;
+    m_running = true;
+    emit runningChanged();
+
+    m_timer.start();
+    m_startMemory = ProcessMemory::resident();
+    m_peakMemory = m_startMemory;
+    m_startStatements = Metrics::instance()->value(QStringLiteral("sql.statements"));
+    m_startErrors = Metrics::instance()->value(QStringLiteral("sql.errors"));
+    runNextStep();
+}
+
+bool BenchmarkDriver::running() const
+{
+    return m_running;
+}
+
+void BenchmarkDriver::pageLoaded(const QUrl &url, bool succeeded)
+{
+    // other loads, like the ones of tabs in the background, are ignored
+    if (!m_waiting || m_completion != PageLoad || url.adjusted(QUrl::StripTrailingSlash) != m_expectedUrl.adjusted(QUrl::StripTrailingSlash))
+        return;
+
+    if (!succeeded)
+        m_failedLoads++;
+    complete();
+}
+
+void BenchmarkDriver::stepFinished()
+{
+    if (m_waiting && m_completion == Finished)
+        complete();
+}
+
+void BenchmarkDriver::runNextStep()
+{
+    if (!m_running)
+        return;
+
+    if (!m_pending.isEmpty()) {
+        m_pending.takeFirst()();
+        return;
+    }
+
+    if (m_nextStep >= m_steps.size()) {
+        finish();
+        return;
+    }
+
+    const Step &step = m_steps.at(m_nextStep++);
+    const QVariantMap &arguments = step.arguments;
+    if (step.action == QLatin1String("openTabs")) {
+        const int count = arguments.value(QStringLiteral("count"), 1).toInt();
+        const QString path = arguments.value(QStringLiteral("path"), QStringLiteral("/page")).toString();
+        for (int i = 0; i < count; i++) {
+            // every tab shows a page of its own
+            QUrl url = m_server.url(path);
+            url.setPath(url.path() + QLatin1Char('/') + QString::number(m_openedTabs++));
+            m_pending.append([this, url] {
+                m_expectedUrl = url;
+                perform(QStringLiteral("openTab"), {{QStringLiteral("url"), url}}, PageLoad, QStringLiteral("openTab"));
+            });
+        }
+    } else if (step.action == QLatin1String("navigate")) {
+        const QUrl url = m_server.url(arguments.value(QStringLiteral("path"), QStringLiteral("/page")).toString());
+        m_pending.append([this, url] {
+            m_expectedUrl = url;
+            perform(QStringLiteral("navigate"), {{QStringLiteral("url"), url}}, PageLoad, QStringLiteral("navigate"));
+        });
+    } else if (step.action == QLatin1String("switchTab")) {
+        const int index = arguments.value(QStringLiteral("index")).toInt();
+        m_pending.append([this, index] {
+            perform(QStringLiteral("switchTab"), {{QStringLiteral("index"), index}}, Frame, QStringLiteral("switchTab"));
+        });
+    } else if (step.action == QLatin1String("typeUrl")) {
+        const QString text = arguments.value(QStringLiteral("text")).toString();
+        m_pending.append([this] {
+            perform(QStringLiteral("openUrlEntry"), {}, Finished, QStringLiteral("openUrlEntry"));
+        });
+        // one character at a time, each one filters the completions
+        for (int length = 1; length <= text.length(); length++) {
+            m_pending.append([this, text, length] {
+                perform(QStringLiteral("setUrlText"), {{QStringLiteral("text"), text.left(length)}}, Frame, QStringLiteral("keystroke"));
+            });
+        }
+        m_pending.append([this] {
+            perform(QStringLiteral("closeUrlEntry"), {}, Finished);
+        });
+    } else if (step.action == QLatin1String("openHistory")) {
+        m_pending.append([this] {
+            perform(QStringLiteral("openHistory"), {}, Frame, QStringLiteral("openHistory"));
+        });
+        m_pending.append([this] {
+            perform(QStringLiteral("closeSubPages"), {}, Frame);
+        });
+    } else if (step.action == QLatin1String("wait")) {
+        QTimer::singleShot(arguments.value(QStringLiteral("ms")).toInt(), this, &BenchmarkDriver::runNextStep);
+        return;
+    }
+
+    runNextStep();
+}
+
+void BenchmarkDriver::perform(const QString &action, const QVariantMap &arguments, Completion completion, const QString &sample)
+{
+    if (!m_window) {
+        fail(QStringLiteral("The window has been closed"));
+        return;
+    }
+
+    m_action = action;
+    m_completion = completion;
+    m_sample = sample;
+    m_waiting = true;
+    m_stepStatements = Metrics::instance()->value(QStringLiteral("sql.statements"));
+    m_timeout.start();
+
+    // the frame is swapped in the render thread
+    if (completion == Frame)
+        m_frameConnection = connect(m_window, &QQuickWindow::frameSwapped, this, &BenchmarkDriver::complete, Qt::QueuedConnection);
+
+    m_stepTimer.start();
+    emit stepRequested(action, arguments);
+    if (completion == Frame)
+        m_window->update();
+}
+
+void BenchmarkDriver::complete()
+{
+    if (!m_waiting)
+        return;
+
+    const double elapsed = m_stepTimer.nsecsElapsed() / 1000000.0;
+    m_waiting = false;
+    m_timeout.stop();
+    disconnect(m_frameConnection);
+
+    if (!m_sample.isEmpty()) {
+        m_latencies[m_sample].append(elapsed);
+        m_statements[m_sample] += Metrics::instance()->value(QStringLiteral("sql.statements")) - m_stepStatements;
+    }
+    m_peakMemory = std::max(m_peakMemory, ProcessMemory::resident());
+
+    // leave the event loop to whatever the step has triggered
+    QTimer::singleShot(0, this, &BenchmarkDriver::runNextStep);
+}
+
+void BenchmarkDriver::fail(const QString &error)
+{
+    qWarning() << Q_FUNC_INFO << error;
+    m_error = error;
+    m_waiting = false;
+    m_timeout.stop();
+    disconnect(m_frameConnection);
+    finish();
+}
+
+void BenchmarkDriver::finish()
+{
+    m_pending.clear();
+    m_running = false;
+    emit runningChanged();
+
+    // stdout only carries the report, everything else is logged to stderr
+    const QByteArray json = QJsonDocument(report()).toJson();
+    fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    fflush(stdout);
+
+    emit finished(m_error.isEmpty() ? 0 : 1);
+}
+
+QJsonObject BenchmarkDriver::report() const
+{
+    QJsonObject actions;
+    for (auto it = m_latencies.cbegin(); it != m_latencies.cend(); ++it) {
+        QVector<double> samples = it.value();
+        std::sort(samples.begin(), samples.end());
+        const auto percentile = [&samples](qreal fraction) {
+            const int rank = std::max(1, int(std::ceil(fraction * samples.size())));
+            return samples.at(rank - 1);
+        };
+        double sum = 0;
+        for (double sample : samples)
+            sum += sample;
+
+        actions.insert(it.key(),
+                       QJsonObject{
+                           {QStringLiteral("count"), samples.size()},
+                           {QStringLiteral("min_ms"), samples.first()},
+                           {QStringLiteral("median_ms"), percentile(0.5)},
+                           {QStringLiteral("p90_ms"), percentile(0.9)},
+                           {QStringLiteral("max_ms"), samples.last()},
+                           {QStringLiteral("mean_ms"), sum / samples.size()},
+                           {QStringLiteral("sqlStatements"), m_statements.value(it.key())},
+                       });
+    }
+
+    QJsonObject report{
+        {QStringLiteral("duration_ms"), m_timer.isValid() ? m_timer.elapsed() : 0},
+        {QStringLiteral("actions"), actions},
+        {QStringLiteral("failedLoads"), m_failedLoads},
+        {QStringLiteral("rss_kb"),
+         QJsonObject{
+             {QStringLiteral("start"), m_startMemory},
+             {QStringLiteral("peak"), m_peakMemory},
+             {QStringLiteral("end"), ProcessMemory::resident()},
+         }},
+        {QStringLiteral("sql"),
+         QJsonObject{
+             {QStringLiteral("statements"), Metrics::instance()->value(QStringLiteral("sql.statements")) - m_startStatements},
+             {QStringLiteral("errors"), Metrics::instance()->value(QStringLiteral("sql.errors")) - m_startErrors},
+         }},
+        {QStringLiteral("server"),
+         QJsonObject{
+             {QStringLiteral("pageSize"), m_server.pageSize()},
+             {QStringLiteral("latency"), m_server.latency()},
+             {QStringLiteral("requests"), m_server.requestCount()},
+         }},
+    };
+    if (!m_error.isEmpty())
+        report.insert(QStringLiteral("error"), m_error);
+    return report;
+}
@@ -0,0 +1,143 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BENCHMARKDRIVER_H
+#define BENCHMARKDRIVER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+#include <QVariantMap>
+#include <QVector>
+
+#include <functional>
+
+#include "benchmarkserver.h"
+
+class QQuickWindow;
+
+/**
+ * @class BenchmarkDriver
+ * @short Runs the scripted scenarios of angelfish --benchmark.
+ *
+ * The script is a JSON object. pageSize and latency configure the
+ * BenchmarkServer the pages are loaded from, steps is the list of actions:
+ *
+ *   {
+ *       "pageSize": 50000,
+ *       "latency": 20,
+ *       "steps": [
+ *           {"action": "openTabs", "count": 10},
+ *           {"action": "navigate", "path": "/article?size=500000"},
+ *           {"action": "switchTab", "index": 0},
+ *           {"action": "typeUrl", "text": "page"},
+ *           {"action": "openHistory"},
+ *           {"action": "wait", "ms": 1000}
+ *       ]
+ *   }
+ *
+ * The actions are performed by webbrowser.qml on stepRequested, like a
+ * user would. Each one is timed until the page is loaded, or the next frame
+ * has been shown for actions that don't load a page. Once done, the
+ * latencies per action, the resident memory and the SQL statements are
+ * written to stdout as JSON. benchmarks/browsing.json is a typical session:
+ *
+ *   angelfish --benchmark benchmarks/browsing.json
+ */
+class BenchmarkDriver : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+
+public:
+    struct Step {
+        QString action;
+        QVariantMap arguments;
+    };
+
+    static BenchmarkDriver *instance();
+
+    // false if the script is invalid, see errorString
+    bool load(const QString &path);
+    bool setScript(const QByteArray &script);
+    QVector<Step> steps() const;
+    QString errorString() const;
+
+    BenchmarkServer *server();
+
+    // runs the steps in window, finished is emitted once they are done
+    void start(QQuickWindow *window);
+    bool running() const;
+
+    QJsonObject report() const;
+
+    // called by webbrowser.qml
+    Q_INVOKABLE void pageLoaded(const QUrl &url, bool succeeded);
+    Q_INVOKABLE void stepFinished();
+
+signals:
+    void runningChanged();
+    void stepRequested(const QString &action, const QVariantMap &arguments);
+    void finished(int exitCode);
+
+private:
+    enum Completion {
+        PageLoad,
+        Frame,
+        Finished, // reported with stepFinished
+    };
+
+    explicit BenchmarkDriver(QObject *parent = nullptr);
+
+    void runNextStep();
+    // emits stepRequested and times it until completion, as sample if not empty
+    void perform(const QString &action, const QVariantMap &arguments, Completion completion, const QString &sample = {});
+    void complete();
+    void fail(const QString &error);
+    void finish();
+
+    QVector<Step> m_steps;
+    // actions a step has been split into, like the keystrokes of typeUrl
+    QVector<std::function<void()>> m_pending;
+    QString m_error;
+
+    BenchmarkServer m_server;
+    QPointer<QQuickWindow> m_window;
+    bool m_running = false;
+    int m_nextStep = 0;
+    int m_openedTabs = 0;
+
+    // the action waited for
+    bool m_waiting = false;
+    QString m_action;
+    Completion m_completion = Frame;
+    QUrl m_expectedUrl;
+    QString m_sample;
+    QElapsedTimer m_stepTimer;
+    qint64 m_stepStatements = 0;
+    QTimer m_timeout;
+    QMetaObject::Connection m_frameConnection;
+
+    QElapsedTimer m_timer;
+    QHash<QString, QVector<double>> m_latencies;
+    QHash<QString, qint64> m_statements;
+    int m_failedLoads = 0;
+    qint64 m_startMemory = 0;
+    qint64 m_peakMemory = 0;
+    qint64 m_startStatements = 0;
+    qint64 m_startErrors = 0;
+
+    static BenchmarkDriver *s_instance;
+};
+
+#endif // BENCHMARKDRIVER_H
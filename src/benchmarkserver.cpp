@@ -0,0 +1,135 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "benchmarkserver.h"
+
+#include <QDebug>
+#include <QPointer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrlQuery>
+
+// requests larger than this are not answered
+constexpr int MAX_REQUEST_SIZE = 64 * 1024;
+
+BenchmarkServer::BenchmarkServer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, [this] {
+        while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket] {
+                handle(socket);
+            });
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket] {
+                m_buffers.remove(socket);
+                socket->deleteLater();
+            });
+        }
+    });
+}
+
+bool BenchmarkServer::start()
+{
+    if (!m_server.listen(QHostAddress::LocalHost)) {
+        qWarning() << Q_FUNC_INFO << "Failed to start the benchmark server" << m_server.errorString();
+        return false;
+    }
+    return true;
+}
+
+QUrl BenchmarkServer::url(const QString &path) const
+{
+    return QUrl(QStringLiteral("http://127.0.0.1:%1%2").arg(m_server.serverPort()).arg(path));
+}
+
+int BenchmarkServer::pageSize() const
+{
+    return m_pageSize;
+}
+
+void BenchmarkServer::setPageSize(int size)
+{
+    m_pageSize = size;
+}
+
+int BenchmarkServer::latency() const
+{
+    return m_latency;
+}
+
+void BenchmarkServer::setLatency(int latency)
+{
+    m_latency = latency;
+}
+
+int BenchmarkServer::requestCount() const
+{
+    return m_requestCount;
+}
+
+QByteArray BenchmarkServer::page(const QString &path, int size)
+{
+    const QByteArray escapedPath = path.toHtmlEscaped().toUtf8();
+    QByteArray html = "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>Page " + escapedPath
+        + "</title></head>\n<body><h1>" + escapedPath + "</h1>\n";
+    const QByteArray end = "</body></html>\n";
+
+    // paragraphs with links to other pages, numbered so they differ a bit
+    for (int i = 0; html.size() + end.size() < size; i++) {
+        html += "<p><a href=\"/page/" + QByteArray::number(i) + "\">Page " + QByteArray::number(i)
+            + "</a> Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore "
+              "et dolore magna aliqua.</p>\n";
+    }
+    return html + end;
+}
+
+void BenchmarkServer::handle(QTcpSocket *socket)
+{
+    QByteArray &buffer = m_buffers[socket];
+    buffer += socket->readAll();
+    const int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (buffer.size() > MAX_REQUEST_SIZE) {
+            m_buffers.remove(socket);
+            socket->abort();
+        }
+        return;
+    }
+
+    const QList<QByteArray> requestLine = buffer.left(buffer.indexOf("\r\n")).split(' ');
+    m_buffers.remove(socket);
+    m_requestCount++;
+
+    const QUrl requested(QString::fromUtf8(requestLine.value(1)));
+    const QUrlQuery query(requested);
+    bool ok = false;
+    int size = query.queryItemValue(QStringLiteral("size")).toInt(&ok);
+    if (!ok)
+        size = m_pageSize;
+    int latency = query.queryItemValue(QStringLiteral("latency")).toInt(&ok);
+    if (!ok)
+        latency = m_latency;
+
+    QByteArray response;
+    if (requestLine.value(0) != "GET" || requested.path() == QLatin1String("/favicon.ico")) {
+        response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    } else {
+        const QByteArray body = page(requested.path(), size);
+        response = "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nCache-Control: no-store\r\nContent-Length: "
+            + QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    }
+
+    // the socket may be gone once the latency has passed
+    QPointer<QTcpSocket> guard(socket);
+    QTimer::singleShot(latency, this, [guard, response] {
+        if (!guard)
+            return;
+        guard->write(response);
+        guard->disconnectFromHost();
+    });
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BENCHMARKSERVER_H
+#define BENCHMARKSERVER_H
+
+#include <QHash>
+#include <QObject>
+#include <QTcpServer>
+#include <QUrl>
+
+class QTcpSocket;
+
+/**
+ * @class BenchmarkServer
+ * @short Serves synthetic pages on localhost for BenchmarkDriver.
+ *
+ * Every path is answered with a page of pageSize bytes after latency ms,
+ * so loads don't depend on the network. Both can be overridden per request
+ * with the size and latency query items, like /page/1?size=500000.
+ */
+class BenchmarkServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BenchmarkServer(QObject *parent = nullptr);
+
+    bool start();
+    QUrl url(const QString &path) const;
+
+    int pageSize() const;
+    void setPageSize(int size);
+
+    // ms until a request is answered
+    int latency() const;
+    void setLatency(int latency);
+
+    int requestCount() const;
+
+    // html of about size bytes, the same for the same path
+    static QByteArray page(const QString &path, int size);
+
+private:
+    void handle(QTcpSocket *socket);
+
+    QTcpServer m_server;
+    QHash<QTcpSocket *, QByteArray> m_buffers;
+    int m_pageSize = 50000;
+    int m_latency = 0;
+    int m_requestCount = 0;
+};
+
+#endif // BENCHMARKSERVER_H
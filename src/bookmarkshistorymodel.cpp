@@ -9,10 +9,13 @@
 
 #include "bookmarkshistorymodel.h"
 #include "browsermanager.h"
+#include "dbmanager.h"
+#include "tracer.h"
 
 #include <QDateTime>
 #include <QDebug>
 #include <QSqlError>
+#include <QSqlRecord>
 
 constexpr int QUERY_LIMIT = 1000;
 
@@ -30,6 +33,7 @@ void BookmarksHistoryModel::setActive(bool a)
         setQuery();
     else
         clear();
+    updateFirstUrl();
     emit activeChanged();
 }
 
@@ -60,9 +64,28 @@ void BookmarksHistoryModel::setFilter(const QString &f)
     emit filterChanged();
 }
 
+void BookmarksHistoryModel::setDomain(const QString &d)
+{
+    if (m_domain == d)
+        return;
+    m_domain = d;
+    setQuery();
+    emit domainChanged();
+}
+
+void BookmarksHistoryModel::setPageText(bool p)
+{
+    if (m_pageText == p)
+        return;
+    m_pageText = p;
+    setQuery();
+    emit pageTextChanged();
+}
+
 void BookmarksHistoryModel::onDatabaseChanged(const QString &table)
 {
-    if ((table == QLatin1String("bookmarks") && m_bookmarks) || (table == QLatin1String("history") && m_history))
+    if ((table == QLatin1String("bookmarks") && m_bookmarks) || (table == QLatin1String("history") && m_history)
+        || table == QLatin1String("snapshots"))
         setQuery();
 }
 
@@ -71,28 +94,60 @@ void BookmarksHistoryModel::setQuery()
     if (!m_active)
         return;
 
+    TraceScope trace("BookmarksHistoryModel::setQuery", "models");
     QString command;
-    const QString b = QStringLiteral("SELECT rowid AS id, url, title, icon, :now - lastVisited AS lastVisitedDelta, %1 AS bookmarked FROM %2 ");
-    const QLatin1String filter = m_filter.isEmpty() ? QLatin1String() : QLatin1String("WHERE url LIKE '%' || :filter || '%' OR title LIKE '%' || :filter || '%'");
-    const bool includeHistory = m_history && !(m_bookmarks && m_filter.isEmpty());
+    const QString b = QStringLiteral("SELECT %2.rowid AS id, url, title, icon, host, domain, displayPath, "
+                                     ":now - lastVisited AS lastVisitedDelta, "
+                                     "CASE WHEN lastVisited >= :today THEN 0 WHEN lastVisited >= :yesterday THEN 1 ELSE 2 END AS section, "
+                                     "%1 AS bookmarked, "
+                                     "EXISTS (SELECT 1 FROM snapshots WHERE snapshots.url = %2.url) AS saved, %3 AS snippet FROM %2 ");
+    QStringList conditions;
+    if (!m_domain.isEmpty())
+        conditions << QStringLiteral("domain = :domain");
+    if (!m_filter.isEmpty())
+        conditions << QStringLiteral("(url LIKE '%' || :filter || '%' OR title LIKE '%' || :filter || '%')");
+    const QString filter = conditions.isEmpty() ? QString() : QStringLiteral("WHERE ") + conditions.join(QStringLiteral(" AND "));
+    const bool includeHistory = m_history && !(m_bookmarks && m_filter.isEmpty() && m_domain.isEmpty());
+
+    // The matches in the page text are looked up once and joined to the
+    // history entries by url. Entries whose text matches are listed as well.
+    const QString match = m_pageText && includeHistory ? DBManager::pageTextMatch(m_filter) : QString();
+    QString historyJoin;
+    QString historyFilter = filter;
+    if (!match.isEmpty()) {
+        historyJoin = QStringLiteral("LEFT JOIN (SELECT pagetextinfo.url AS matchUrl, snippet(pagetext, 1, '', '', '…', 12) AS snippet "
+                                     "FROM pagetext JOIN pagetextinfo ON pagetextinfo.id = pagetext.rowid WHERE pagetext MATCH :match) "
+                                     "AS matches ON matches.matchUrl = history.url ");
+        // the filter is the last condition
+        QStringList historyConditions = conditions;
+        historyConditions.last() = QStringLiteral("(url LIKE '%' || :filter || '%' OR title LIKE '%' || :filter || '%' OR matches.matchUrl IS NOT NULL)");
+        historyFilter = QStringLiteral("WHERE ") + historyConditions.join(QStringLiteral(" AND "));
+    }
 
     if (m_bookmarks)
-        command = b.arg(1).arg(QLatin1String("bookmarks")) + filter;
+        command = b.arg(1).arg(QLatin1String("bookmarks"), QLatin1String("NULL")) + filter;
 
     if (m_bookmarks && includeHistory)
-        command += QLatin1String("\n UNION \n");
+        command += QLatin1String("\n UNION ALL \n");
 
     if (includeHistory)
-        command += b.arg(0).arg(QLatin1String("history")) + filter;
+        command += b.arg(0).arg(QLatin1String("history"), match.isEmpty() ? QLatin1String("NULL") : QLatin1String("matches.snippet")) + historyJoin
+            + historyFilter;
 
-    command += QLatin1String("\n ORDER BY bookmarked DESC, lastVisitedDelta ASC");
+    // A single table is read in the order of the index on lastVisited, for
+    // both tables bookmarks come first. Entries of the two tables are never
+    // the same row, as bookmarked differs.
+    if (m_bookmarks && includeHistory)
+        command += QLatin1String("\n ORDER BY bookmarked DESC, lastVisited DESC");
+    else
+        command += QLatin1String("\n ORDER BY lastVisited DESC");
 
     if (includeHistory)
         command += QStringLiteral("\n LIMIT %1").arg(QUERY_LIMIT);
 
     const qint64 ref = QDateTime::currentSecsSinceEpoch();
     QSqlQuery query;
-    if (!query.prepare(command)) {
+    if (!DBManager::prepare(query, command)) {
         qWarning() << Q_FUNC_INFO << "Failed to prepare SQL statement";
         qWarning() << query.lastQuery();
         qWarning() << query.lastError();
@@ -102,7 +157,17 @@ void BookmarksHistoryModel::setQuery()
     if (!m_filter.isEmpty())
         query.bindValue(QStringLiteral(":filter"), m_filter);
 
+    if (!m_domain.isEmpty())
+        query.bindValue(QStringLiteral(":domain"), m_domain);
+
+    if (!match.isEmpty())
+        query.bindValue(QStringLiteral(":match"), match);
+
     query.bindValue(QStringLiteral(":now"), ref);
+    // sections as in HistorySections, starting at local midnight
+    const QDate today = QDate::currentDate();
+    query.bindValue(QStringLiteral(":today"), today.startOfDay().toSecsSinceEpoch());
+    query.bindValue(QStringLiteral(":yesterday"), today.addDays(-1).startOfDay().toSecsSinceEpoch());
 
     if (!query.exec()) {
         qWarning() << Q_FUNC_INFO << "Failed to execute SQL statement";
@@ -112,4 +177,14 @@ void BookmarksHistoryModel::setQuery()
     }
 
     SqlQueryModel::setQuery(query);
+    updateFirstUrl();
+}
+
+void BookmarksHistoryModel::updateFirstUrl()
+{
+    const QString url = rowCount() > 0 ? record(0).value(QStringLiteral("url")).toString() : QString();
+    if (m_firstUrl == url)
+        return;
+    m_firstUrl = url;
+    emit firstUrlChanged();
 }
@@ -15,6 +15,8 @@
 /**
  * @class BookmarksHistoryModel
  * @short Model for listing Bookmarks and History items.
+ *
+ * The section role is the HistorySections::Section of an entry.
  */
 class BookmarksHistoryModel : public SqlQueryModel
 {
@@ -30,6 +32,15 @@ class BookmarksHistoryModel : public SqlQueryModel
     // set to string to filter url or title by it. without filter set, only
     // bookmarks are shown
     Q_PROPERTY(QString filter READ filter WRITE setFilter NOTIFY filterChanged)
+    // set to a registrable domain (e.g. "kde.org") to only list entries of
+    // that site. Uses the precomputed domain column and its index.
+    Q_PROPERTY(QString domain READ domain WRITE setDomain NOTIFY domainChanged)
+    // set to true for also matching the filter in the indexed text of the
+    // history pages, see PageTextIndex. The snippet role shows the match.
+    Q_PROPERTY(bool pageText READ pageText WRITE setPageText NOTIFY pageTextChanged)
+    // url of the first entry, the most likely destination while filtering.
+    // Empty if there are no entries.
+    Q_PROPERTY(QString firstUrl READ firstUrl NOTIFY firstUrlChanged)
 
 public:
     BookmarksHistoryModel();
@@ -58,22 +69,46 @@ public:
     }
     void setFilter(const QString &f);
 
+    QString domain() const
+    {
+        return m_domain;
+    }
+    void setDomain(const QString &d);
+
+    bool pageText() const
+    {
+        return m_pageText;
+    }
+    void setPageText(bool p);
+
+    QString firstUrl() const
+    {
+        return m_firstUrl;
+    }
+
 signals:
     void activeChanged();
     void bookmarksChanged();
     void historyChanged();
     void filterChanged();
+    void domainChanged();
+    void pageTextChanged();
+    void firstUrlChanged();
 
 private:
     void onDatabaseChanged(const QString &table);
 
     void setQuery();
+    void updateFirstUrl();
 
 private:
     bool m_active = true;
     bool m_bookmarks = false;
     bool m_history = false;
     QString m_filter;
+    QString m_domain;
+    bool m_pageText = false;
+    QString m_firstUrl;
 };
 
 #endif // BOOKMARKSHISTORYMODEL_H
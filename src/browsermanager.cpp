@@ -14,17 +14,39 @@
 #include <QUrl>
 
 #include "angelfishsettings.h"
+#include "pagetimings.h"
+#include "urlutils.h"
 
 BrowserManager *BrowserManager::s_instance = nullptr;
 
+// tables whose number of rows is exported as <table>.rows metric
+static const QStringList COUNTED_TABLES = {QStringLiteral("history"), QStringLiteral("bookmarks"), QStringLiteral("icons")};
+
 BrowserManager::BrowserManager(QObject *parent)
     : QObject(parent)
     , m_dbmanager(new DBManager(this))
+    , m_userAgentRules(new UserAgentRules(this))
 {
+    // keep the rules up to date before anyone else is notified about the change
+    connect(m_dbmanager, &DBManager::databaseTableChanged, this, [this](const QString &table) {
+        if (table == QLatin1String("useragentrules"))
+            m_userAgentRules->reload();
+    });
     connect(m_dbmanager, &DBManager::databaseTableChanged, this, &BrowserManager::databaseTableChanged);
+
+    // counted when the metrics are read, which is rare
+    for (const QString &table : COUNTED_TABLES) {
+        metrics()->setProvider(table + QStringLiteral(".rows"), [this, table] {
+            return m_dbmanager->rowCount(table);
+        });
+    }
 }
 
-BrowserManager::~BrowserManager() = default;
+BrowserManager::~BrowserManager()
+{
+    for (const QString &table : COUNTED_TABLES)
+        metrics()->setProvider(table + QStringLiteral(".rows"), {});
+}
 
 void BrowserManager::addBookmark(const QVariantMap &bookmarkdata)
 {
@@ -65,6 +87,140 @@ void BrowserManager::updateIcon(const QString &url, const QString &iconSource)
     m_dbmanager->updateIcon(url, iconSource);
 }
 
+void BrowserManager::setUserAgentRule(const QString &pattern, int mode, const QString &userAgent)
+{
+    m_dbmanager->setUserAgentRule(pattern, mode, userAgent);
+}
+
+void BrowserManager::removeUserAgentRule(const QString &pattern)
+{
+    m_dbmanager->removeUserAgentRule(pattern);
+}
+
+QVariantMap BrowserManager::userAgentRuleForUrl(const QString &url) const
+{
+    return m_userAgentRules->ruleForUrl(url);
+}
+
+void BrowserManager::addPageTiming(const QString &url, const QVariantMap &timing)
+{
+    const QUrl parsed(url);
+    if (parsed.scheme() != QLatin1String("http") && parsed.scheme() != QLatin1String("https"))
+        return;
+
+    const QString host = UrlUtils::urlNormalizedHost(url);
+    const QHash<int, int> buckets = PageTimings::buckets(timing);
+    if (host.isEmpty() || buckets.isEmpty())
+        return;
+
+    m_dbmanager->addPageTimings(host, buckets);
+}
+
+UserAgentRules *BrowserManager::userAgentRules() const
+{
+    return m_userAgentRules;
+}
+
+Metrics *BrowserManager::metrics() const
+{
+    return Metrics::instance();
+}
+
+QString BrowserManager::addSnapshot(const QString &url, const QString &hash, const QString &title, qint64 size)
+{
+    return m_dbmanager->addSnapshot(url, hash, title, size);
+}
+
+QString BrowserManager::removeSnapshot(const QString &url)
+{
+    return m_dbmanager->removeSnapshot(url);
+}
+
+QVariantMap BrowserManager::snapshot(const QString &url) const
+{
+    return m_dbmanager->snapshot(url);
+}
+
+void BrowserManager::touchSnapshot(const QString &url)
+{
+    m_dbmanager->touchSnapshot(url);
+}
+
+qint64 BrowserManager::snapshotsSize() const
+{
+    return m_dbmanager->snapshotsSize();
+}
+
+QStringList BrowserManager::trimSnapshots(qint64 maxSize)
+{
+    return m_dbmanager->trimSnapshots(maxSize);
+}
+
+int BrowserManager::addDownload(const QVariantMap &download)
+{
+    return m_dbmanager->addDownload(download);
+}
+
+void BrowserManager::updateDownload(int id, qint64 receivedBytes, qint64 totalBytes, int state)
+{
+    m_dbmanager->updateDownload(id, receivedBytes, totalBytes, state);
+}
+
+void BrowserManager::setDownloadValidator(int id, const QString &validator)
+{
+    m_dbmanager->setDownloadValidator(id, validator);
+}
+
+void BrowserManager::removeDownload(int id)
+{
+    m_dbmanager->removeDownload(id);
+}
+
+QVariantList BrowserManager::downloads() const
+{
+    return m_dbmanager->downloads();
+}
+
+QVector<DBManager::PageTimingCount> BrowserManager::pageTimings() const
+{
+    return m_dbmanager->pageTimings();
+}
+
+QVector<DBManager::HistoryDay> BrowserManager::historyDays() const
+{
+    return m_dbmanager->historyDays();
+}
+
+QVector<DBManager::TopSite> BrowserManager::topSites(int limit) const
+{
+    return m_dbmanager->topSites(limit);
+}
+
+bool BrowserManager::hasPageText() const
+{
+    return m_dbmanager->hasPageText();
+}
+
+void BrowserManager::clearPageText()
+{
+    m_dbmanager->clearPageText();
+}
+
+void BrowserManager::runMaintenance()
+{
+    m_dbmanager->runMaintenance();
+}
+
+QString BrowserManager::databaseFile() const
+{
+    return m_dbmanager->databaseFile();
+}
+
+void BrowserManager::announceChanges(const QString &table)
+{
+    m_dbmanager->announceChanges(table);
+}
+
 QString BrowserManager::initialUrl() const
 {
     return m_initialUrl;
@@ -12,6 +12,8 @@
 #include <QObject>
 
 #include "dbmanager.h"
+#include "metrics.h"
+#include "useragentrules.h"
 
 class QSettings;
 
@@ -53,11 +55,57 @@ public slots:
     void updateLastVisited(const QString &url);
     void updateIcon(const QString &url, const QString &iconSource);
 
+    // per-site user agent rules, see UserAgentRules
+    void setUserAgentRule(const QString &pattern, int mode, const QString &userAgent = QString());
+    void removeUserAgentRule(const QString &pattern);
+    QVariantMap userAgentRuleForUrl(const QString &url) const;
+
+    // records the Navigation and Paint Timing of a load of url, see PageTimings
+    void addPageTiming(const QString &url, const QVariantMap &timing);
+
+public:
+    UserAgentRules *userAgentRules() const;
+    // registry of the metrics exported on D-Bus
+    Metrics *metrics() const;
+
+    // offline snapshots, see SnapshotStore
+    QString addSnapshot(const QString &url, const QString &hash, const QString &title, qint64 size);
+    QString removeSnapshot(const QString &url);
+    QVariantMap snapshot(const QString &url) const;
+    void touchSnapshot(const QString &url);
+    qint64 snapshotsSize() const;
+    QStringList trimSnapshots(qint64 maxSize);
+
+    // persisted downloads, see DownloadManager
+    int addDownload(const QVariantMap &download);
+    void updateDownload(int id, qint64 receivedBytes, qint64 totalBytes, int state);
+    void setDownloadValidator(int id, const QString &validator);
+    void removeDownload(int id);
+    QVariantList downloads() const;
+
+    // recorded page timings, see SitePerformanceModel
+    QVector<DBManager::PageTimingCount> pageTimings() const;
+
+    // aggregates of the history, see HistorySections and TopSitesModel
+    QVector<DBManager::HistoryDay> historyDays() const;
+    QVector<DBManager::TopSite> topSites(int limit) const;
+
+    // indexed text of visited pages, see PageTextIndex
+    bool hasPageText() const;
+    void clearPageText();
+
+    void runMaintenance();
+
+    // see BrowsingDataCleaner
+    QString databaseFile() const;
+    void announceChanges(const QString &table);
+
 private:
     // BrowserManager should only be createdd by calling the instance() function
     BrowserManager(QObject *parent = nullptr);
 
     DBManager *m_dbmanager;
+    UserAgentRules *m_userAgentRules;
 
     QString m_initialUrl;
 
@@ -0,0 +1,170 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "browsingdatacleaner.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QtConcurrent>
+#include <QtWebEngine/QQuickWebEngineProfile>
+#include <QtWebEngineCore/QWebEngineCookieStore>
+
+#include "browsermanager.h"
+#include "dbmanager.h"
+#include "profilemanager.h"
+
+BrowsingDataCleaner::BrowsingDataCleaner(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_worker, &QFutureWatcher<int>::finished, this, [this] {
+        const int removed = m_worker.result();
+        // one notification for the whole range
+        if (removed > 0)
+            BrowserManager::instance()->announceChanges(QStringLiteral("history"));
+        if (removed >= 0 && (m_types & History))
+            BrowserManager::instance()->announceChanges(QStringLiteral("pagetimings"));
+
+        setProgress(1);
+        m_running = false;
+        emit runningChanged();
+        emit finished(removed);
+    });
+}
+
+BrowsingDataCleaner::~BrowsingDataCleaner()
+{
+    m_worker.waitForFinished();
+}
+
+ProfileManager *BrowsingDataCleaner::profileManager() const
+{
+    return m_profileManager;
+}
+
+void BrowsingDataCleaner::setProfileManager(ProfileManager *profileManager)
+{
+    if (m_profileManager == profileManager)
+        return;
+    m_profileManager = profileManager;
+    emit profileManagerChanged();
+}
+
+bool BrowsingDataCleaner::running() const
+{
+    return m_running;
+}
+
+qreal BrowsingDataCleaner::progress() const
+{
+    return m_progress;
+}
+
+void BrowsingDataCleaner::clear(Range range, DataTypes types)
+{
+    if (m_running)
+        return;
+
+    m_running = true;
+    m_types = types;
+    emit runningChanged();
+    setProgress(0);
+
+    clearProfiles(types);
+
+    // storages not opened in this session only keep their data on disk
+    QStringList cookieDirectories;
+    QStringList cacheDirectories;
+    if (m_profileManager) {
+        if (types & Cookies)
+            cookieDirectories = m_profileManager->closedStorageDirectories(QStandardPaths::AppDataLocation);
+        if (types & Cache)
+            cacheDirectories = m_profileManager->closedStorageDirectories(QStandardPaths::CacheLocation);
+    }
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    const qint64 from = rangeStart(range, now);
+    const QString databaseFile = BrowserManager::instance()->databaseFile();
+    // the worker is waited for in the destructor, so this outlives it
+    const auto progress = [this](qreal value) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, value] {
+                setProgress(value);
+            },
+            Qt::QueuedConnection);
+    };
+    // entries are stamped when visited, include those of the current second
+    m_worker.setFuture(QtConcurrent::run([databaseFile, from, now, progress, types, cookieDirectories, cacheDirectories] {
+        clearClosedStorages(cookieDirectories, cacheDirectories);
+        if (!(types & History))
+            return 0;
+        return DBManager::removeHistoryRange(databaseFile, from, now, progress);
+    }));
+}
+
+qint64 BrowsingDataCleaner::rangeStart(Range range, qint64 now)
+{
+    switch (range) {
+    case LastHour:
+        return now - 60 * 60;
+    case LastDay:
+        return now - 24 * 60 * 60;
+    case LastWeek:
+        return now - 7 * 24 * 60 * 60;
+    case LastMonth:
+        return now - 30 * 24 * 60 * 60;
+    case Everything:
+        break;
+    }
+    return 0;
+}
+
+void BrowsingDataCleaner::setProgress(qreal progress)
+{
+    if (m_progress == progress)
+        return;
+    m_progress = progress;
+    emit progressChanged();
+}
+
+void BrowsingDataCleaner::clearProfiles(DataTypes types)
+{
+    if (!(types & (Cookies | Cache)))
+        return;
+
+    if (!m_profileManager) {
+        qWarning() << Q_FUNC_INFO << "No profiles to clear";
+        return;
+    }
+
+    // both are carried out by the web engine in the background
+    const auto profiles = m_profileManager->profiles();
+    for (QQuickWebEngineProfile *profile : profiles) {
+        if (types & Cookies)
+            profile->cookieStore()->deleteAllCookies();
+        if (types & Cache)
+            profile->clearHttpCache();
+    }
+}
+
+void BrowsingDataCleaner::clearClosedStorages(const QStringList &cookieDirectories, const QStringList &cacheDirectories)
+{
+    // the cookie database of a storage, the rest of it is kept
+    for (const QString &directory : cookieDirectories) {
+        const QDir storage(directory);
+        QFile::remove(storage.filePath(QStringLiteral("Cookies")));
+        QFile::remove(storage.filePath(QStringLiteral("Cookies-journal")));
+    }
+
+    for (const QString &directory : cacheDirectories) {
+        if (!QDir(directory).removeRecursively())
+            qWarning() << Q_FUNC_INFO << "Could not remove" << directory;
+    }
+}
@@ -0,0 +1,96 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BROWSINGDATACLEANER_H
+#define BROWSINGDATACLEANER_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPointer>
+
+class ProfileManager;
+
+/**
+ * @class BrowsingDataCleaner
+ * @short Clears the history, cookies and cache of the browser.
+ *
+ * History entries are removed by the time they were last visited, together
+ * with the icons no longer used by any entry. This runs in a worker thread
+ * with a database connection of its own, and the history views are notified
+ * once when it is done.
+ *
+ * The web engine only allows clearing cookies and the HTTP cache as a whole,
+ * so these are cleared for all profiles of the profileManager regardless of
+ * the range. The storages no profile has been created for yet, like the one
+ * of the desktop agent, are cleared on disk by the worker.
+ */
+class BrowsingDataCleaner : public QObject
+{
+    Q_OBJECT
+
+    // profiles whose cookies and cache are cleared
+    Q_PROPERTY(ProfileManager *profileManager READ profileManager WRITE setProfileManager NOTIFY profileManagerChanged)
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+    // from 0 to 1 while running
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+
+public:
+    enum Range {
+        LastHour,
+        LastDay,
+        LastWeek,
+        LastMonth,
+        Everything,
+    };
+    Q_ENUM(Range)
+
+    enum DataType {
+        History = 1,
+        Cookies = 2,
+        Cache = 4,
+    };
+    Q_DECLARE_FLAGS(DataTypes, DataType)
+    Q_FLAG(DataTypes)
+
+    explicit BrowsingDataCleaner(QObject *parent = nullptr);
+    ~BrowsingDataCleaner() override;
+
+    ProfileManager *profileManager() const;
+    void setProfileManager(ProfileManager *profileManager);
+
+    bool running() const;
+    qreal progress() const;
+
+    // does nothing while a previous call is running
+    Q_INVOKABLE void clear(Range range, DataTypes types);
+
+    // start of the range in seconds since the epoch, for a range ending at now
+    static qint64 rangeStart(Range range, qint64 now);
+
+signals:
+    void profileManagerChanged();
+    void runningChanged();
+    void progressChanged();
+    // number of history entries removed, -1 if clearing the history failed
+    void finished(int removedHistory);
+
+private:
+    void setProgress(qreal progress);
+    void clearProfiles(DataTypes types);
+    static void clearClosedStorages(const QStringList &cookieDirectories, const QStringList &cacheDirectories);
+
+    QPointer<ProfileManager> m_profileManager;
+    QFutureWatcher<int> m_worker;
+    DataTypes m_types;
+    bool m_running = false;
+    qreal m_progress = 0;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(BrowsingDataCleaner::DataTypes)
+
+#endif // BROWSINGDATACLEANER_H
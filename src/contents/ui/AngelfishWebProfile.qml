@@ -10,34 +10,25 @@
 import QtWebEngine 1.7
 import QtQuick 2.7
 
+import org.kde.mobile.angelfish 1.0
+
 WebEngineProfile {
     // TODO Qt 5.15 make required
     property Loader questionLoader
 
     onDownloadRequested: (download) => {
-        // if we don't accept the request right away, it will be deleted
-        download.accept()
-        // therefore just stop the download again as quickly as possible,
-        // and ask the user for confirmation
-        download.pause()
+        // pages saved for offline reading, see WebView.saveSnapshot()
+        if (download.type === WebEngineDownloadItem.SavePage) {
+            Snapshots.capture(download)
+            return
+        }
 
+        // the download waits for the confirmation of the user, see DownloadManager
         questionLoader.setSource("DownloadQuestion.qml")
-        questionLoader.item.download = download
+        questionLoader.item.downloadId = Downloads.add(download, offTheRecord)
         questionLoader.item.visible = true
     }
 
-    onDownloadFinished: (download) => {
-        switch (download.state) {
-        case WebEngineDownloadItem.DownloadCompleted:
-            showPassiveNotification(i18n("Download finished"))
-            break;
-        case WebEngineDownloadItem.DownloadInterrupted:
-            showPassiveNotification(i18n("Download failed"))
-            console.log("Download interrupt reason: " + download.interruptReason)
-            break;
-        case WebEngineDownloadItem.DownloadCancelled:
-            console.log("Download cancelled by the user")
-            break;
-        }
-    }
+    // downloads of an earlier session are continued with the cookies
+    Component.onCompleted: Downloads.addProfile(this)
 }
@@ -58,6 +58,10 @@ Kirigami.ScrollablePage {
                 pageStack.pop();
             }
             onRemoved: BrowserManager.removeBookmark(url);
+            onSavedCopyRequested: {
+                currentWebView.url = Snapshots.snapshotUrl(url);
+                pageStack.pop();
+            }
         }
     }
 
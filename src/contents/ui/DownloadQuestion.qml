@@ -10,21 +10,22 @@
 import QtQuick 2.0
 import org.kde.kirigami 2.4 as Kirigami
 
-import QtWebEngine 1.1
+import org.kde.mobile.angelfish 1.0
 
 Kirigami.InlineMessage {
     id: downloadQuestion
     text: i18n("Do you want to download this file?")
     showCloseButton: false
 
-    property WebEngineDownloadItem download
+    // see DownloadManager
+    property int downloadId: -1
 
     actions: [
         Kirigami.Action {
             iconName: "download"
             text: i18n("Download")
             onTriggered: {
-                downloadQuestion.download.resume()
+                Downloads.start(downloadQuestion.downloadId)
                 downloadQuestion.visible = false
             }
         },
@@ -32,7 +33,7 @@ Kirigami.InlineMessage {
             icon.name: "dialog-cancel"
             text: i18n("Cancel")
             onTriggered: {
-                downloadQuestion.download.cancel()
+                Downloads.cancel(downloadQuestion.downloadId)
                 downloadQuestion.visible = false
             }
         }
@@ -0,0 +1,126 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+import QtQuick 2.3
+import QtQuick.Controls 2.2 as Controls
+import QtQuick.Layouts 1.0
+
+import org.kde.kirigami 2.8 as Kirigami
+import org.kde.mobile.angelfish 1.0
+
+Kirigami.ScrollablePage {
+    title: i18n("Downloads")
+    Kirigami.ColumnView.fillWidth: false
+
+    actions.main: Kirigami.Action {
+        icon.name: "edit-clear-history"
+        text: i18n("Clear finished")
+        onTriggered: Downloads.clearFinished()
+    }
+
+    function statusText(state, receivedBytes, totalBytes, speed, remainingTime) {
+        const received = Qt.locale().formattedDataSize(receivedBytes);
+        const total = totalBytes > 0 ? Qt.locale().formattedDataSize(totalBytes) : "";
+        switch (state) {
+        case Downloads.Requested:
+            return i18n("Waiting for confirmation");
+        case Downloads.Queued:
+            return i18n("Queued");
+        case Downloads.Paused:
+            return total ? i18n("Paused, %1 of %2", received, total) : i18n("Paused, %1", received);
+        case Downloads.Completed:
+            return total ? total : received;
+        case Downloads.Failed:
+            return i18n("Failed");
+        }
+
+        const rate = i18n("%1/s", Qt.locale().formattedDataSize(speed));
+        if (remainingTime >= 0)
+            return i18n("%1 of %2, %3, %4 s left", received, total, rate, remainingTime);
+        return total ? i18n("%1 of %2, %3", received, total, rate) : i18n("%1, %2", received, rate);
+    }
+
+    Component {
+        id: delegateComponent
+
+        Kirigami.SwipeListItem {
+            id: downloadDelegate
+
+            onClicked: {
+                if (model.state === Downloads.Completed)
+                    Qt.openUrlExternally("file://" + model.path);
+            }
+
+            ColumnLayout {
+                Controls.Label {
+                    text: model.fileName
+                    elide: Qt.ElideMiddle
+                    maximumLineCount: 1
+                    Layout.fillWidth: true
+                }
+
+                Controls.ProgressBar {
+                    visible: model.state === Downloads.Downloading || model.state === Downloads.Paused
+                    indeterminate: model.totalBytes <= 0
+                    value: model.totalBytes > 0 ? model.receivedBytes / model.totalBytes : 0
+                    Layout.fillWidth: true
+                }
+
+                Controls.Label {
+                    text: statusText(model.state, model.receivedBytes, model.totalBytes, model.speed, model.remainingTime)
+                    opacity: 0.6
+                    elide: Qt.ElideRight
+                    maximumLineCount: 1
+                    Layout.fillWidth: true
+                }
+            }
+
+            actions: [
+                Kirigami.Action {
+                    icon.name: "media-playback-pause"
+                    text: i18n("Pause")
+                    visible: model.state === Downloads.Downloading || model.state === Downloads.Queued
+                    onTriggered: Downloads.pause(model.id)
+                },
+                Kirigami.Action {
+                    icon.name: "media-playback-start"
+                    text: i18n("Resume")
+                    visible: model.state === Downloads.Paused || model.state === Downloads.Failed
+                    onTriggered: Downloads.resume(model.id)
+                },
+                Kirigami.Action {
+                    icon.name: "dialog-cancel"
+                    text: i18n("Cancel")
+                    visible: model.state !== Downloads.Completed && model.state !== Downloads.Failed
+                    onTriggered: Downloads.cancel(model.id)
+                },
+                Kirigami.Action {
+                    icon.name: "list-remove"
+                    text: i18n("Remove from list")
+                    visible: model.state === Downloads.Completed || model.state === Downloads.Failed
+                    onTriggered: Downloads.remove(model.id)
+                }
+            ]
+        }
+    }
+
+    ListView {
+        id: list
+        anchors.fill: parent
+
+        interactive: height < contentHeight
+        clip: true
+
+        model: Downloads
+
+        delegate: Kirigami.DelegateRecycler {
+            width: list.width
+            sourceComponent: delegateComponent
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+import QtQuick 2.3
+import QtQuick.Layouts 1.0
+import QtQuick.Controls 2.0 as Controls
+
+import org.kde.kirigami 2.5 as Kirigami
+import org.kde.mobile.angelfish 1.0
+
+// Frame rate and janky frames of the window, see FrameMonitor
+Rectangle {
+    id: frameOverlay
+
+    width: layout.implicitWidth + Kirigami.Units.smallSpacing * 2
+    height: layout.implicitHeight + Kirigami.Units.smallSpacing * 2
+    radius: Kirigami.Units.smallSpacing
+    color: Qt.rgba(0, 0, 0, 0.6)
+
+    ColumnLayout {
+        id: layout
+        anchors.centerIn: parent
+        spacing: 0
+
+        Controls.Label {
+            color: "white"
+            font: Kirigami.Theme.smallFont
+            text: i18n("%1 fps", Math.round(FrameMonitor.fps))
+        }
+        Controls.Label {
+            color: FrameMonitor.jankCount > 0 ? Kirigami.Theme.negativeTextColor : "white"
+            font: Kirigami.Theme.smallFont
+            text: i18n("%1 of %2 janky", FrameMonitor.jankCount, FrameMonitor.frameCount)
+        }
+        Controls.Label {
+            color: FrameMonitor.worstFrame > FrameMonitor.budget * 1.5 ? Kirigami.Theme.negativeTextColor : "white"
+            font: Kirigami.Theme.smallFont
+            text: i18n("worst %1 ms", FrameMonitor.worstFrame.toFixed(1))
+        }
+    }
+
+    // tap to save a report, hold to start over
+    MouseArea {
+        anchors.fill: parent
+        onClicked: {
+            var path = FrameMonitor.writeReport();
+            if (path)
+                showPassiveNotification(i18n("Frame report saved to %1", path));
+        }
+        onPressAndHold: FrameMonitor.reset()
+    }
+}
@@ -58,6 +58,10 @@ Kirigami.ScrollablePage {
                 pageStack.pop();
             }
             onRemoved: BrowserManager.removeFromHistory(url);
+            onSavedCopyRequested: {
+                currentWebView.url = Snapshots.snapshotUrl(url);
+                pageStack.pop();
+            }
         }
     }
 
@@ -70,6 +74,28 @@ Kirigami.ScrollablePage {
 
         model: BookmarksHistoryModel {
             history: true
+            pageText: PageText.enabled
+        }
+
+        // search results are not grouped
+        section.property: list.model.filter === "" ? "section" : ""
+        section.delegate: Kirigami.ListSectionHeader {
+            width: list.width
+            label: {
+                var entries = [sections.today, sections.yesterday, sections.older][section];
+                switch (Number(section)) {
+                case HistorySections.Today:
+                    return i18np("Today (%1 page)", "Today (%1 pages)", entries);
+                case HistorySections.Yesterday:
+                    return i18np("Yesterday (%1 page)", "Yesterday (%1 pages)", entries);
+                default:
+                    return i18np("Older (%1 page)", "Older (%1 pages)", entries);
+                }
+            }
+        }
+
+        HistorySections {
+            id: sections
         }
 
         delegate: Kirigami.DelegateRecycler {
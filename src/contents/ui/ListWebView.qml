@@ -8,8 +8,9 @@
 
 import QtQuick 2.3
 import QtQuick.Controls 2.0
+import QtQuick.Window 2.7
 import QtQml.Models 2.1
-import QtWebEngine 1.6
+import QtWebEngine 1.10
 
 import org.kde.kirigami 2.7 as Kirigami
 import org.kde.mobile.angelfish 1.0
@@ -25,17 +26,7 @@ Repeater {
     property alias currentIndex: tabsModel.currentTab
     property WebView currentItem
 
-    property alias tabsModel: tabsModel
-
-    property WebEngineProfile profile: AngelfishWebProfile {
-        httpUserAgent: tabs.currentItem.userAgent.userAgent
-        offTheRecord: tabs.privateTabsMode
-        storageName: tabs.privateTabsMode ? "Private" : Settings.profile
-
-        questionLoader: rootPage.questionLoader
-    }
-
-    model: TabsModel {
+    readonly property TabsModel tabsModel: TabsModel {
         id: tabsModel
         isMobileDefault: Kirigami.Settings.isMobile
         privateMode: privateTabsMode
@@ -46,6 +37,20 @@ Repeater {
         signal loadTabsModel()
     }
 
+    // Storage shared by all tabs of this list. Each tab uses the profile
+    // matching its user agent, see ProfileManager.
+    property string storageName: tabs.privateTabsMode ? "Private" : Settings.profile
+
+    // closes all tabs, leaving a single empty one
+    function closeAllTabs() {
+        for (var i = tabsModel.rowCount() - 1; i >= 0; i--)
+            tabsModel.closeTab(i);
+    }
+
+    // no private view is kept while waiting in the background, so their
+    // off-the-record profile can be released
+    model: tabs.privateTabsMode && WarmInstance.waiting ? null : tabsModel
+
     delegate: WebView {
         id: webView
         anchors {
@@ -56,12 +61,17 @@ Repeater {
         userAgent.isMobile: model.isMobile
         width: tabs.width
 
-        profile: tabs.profile
+        profile: profileManager.profile(tabs.storageName, tabs.privateTabsMode, webView.profileUserAgent)
 
         property bool readyForSnapshot: false
         property bool showView: index === tabs.currentIndex
+        // tabs in the background are loaded once the startup is done, and
+        // none is loaded while waiting in the background to be activated
+        property bool deferred: WarmInstance.waiting || (!showView && !Startup.ready)
 
         visible: (showView || readyForSnapshot || loadingActive) && tabs.activeTabs
+        // the item stays visible while its window is hidden
+        readonly property bool shown: visible && Window.window !== null && Window.window.visible
         x: showView && tabs.activeTabs ? 0 : -width
         z: showView && tabs.activeTabs ? 0 : -1
 
@@ -73,7 +83,35 @@ Repeater {
 
         onRequestedUrlChanged: tabsModel.setUrl(index, requestedUrl)
 
-        Component.onCompleted: url = model.pageurl
+        onDeferredChanged: {
+            if (deferred)
+                Qt.callLater(webView.unload)
+            else if (url.toString() === "")
+                url = model.pageurl
+        }
+
+        // the window may be hidden after the instance started waiting
+        onShownChanged: {
+            if (!shown && deferred)
+                Qt.callLater(webView.unload)
+        }
+
+        // Frees the renderer while waiting in the background again. Like a tab
+        // discarded in the task manager, the page is reloaded once it is shown.
+        function unload() {
+            if (deferred && !shown && url.toString() !== "")
+                lifecycleState = WebEngineView.LifecycleState.Discarded
+        }
+
+        Component.onCompleted: {
+            if (showView)
+                tabs.currentItem = webView
+            if (!deferred)
+                url = model.pageurl
+            TabResources.addView(webView, tabs.privateTabsMode)
+        }
+
+        Component.onDestruction: TabResources.removeView(webView)
 
         Connections {
             target: webView.userAgent
@@ -83,9 +121,10 @@ Repeater {
         }
 
         Connections {
-            target: tabs.model
+            target: tabsModel
             function onLoadTabsModel() {
-                url = model.pageurl
+                if (!webView.deferred)
+                    url = model.pageurl
             }
         }
     }
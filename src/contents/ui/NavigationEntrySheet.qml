@@ -30,6 +30,8 @@ Controls.Drawer {
     property int buttonSize: Kirigami.Units.gridUnit * 2
     property int fullHeight: 0.9 * rootPage.height
     property bool openedState: false
+    // the text typed into the entry
+    property alias text: urlInput.text
 
     contentHeight: fullHeight - topPadding - bottomPadding
     contentWidth: parent.width - rightPadding - leftPadding
@@ -89,6 +91,7 @@ Controls.Drawer {
                     } else {
                         currentWebView.url = UrlUtils.urlFromUserInput(Settings.searchBaseUrl + text);
                     }
+                    speculation.commit(currentWebView.url);
                     overlay.close();
                 }
             }
@@ -122,6 +125,7 @@ Controls.Drawer {
                 showRemove: false
                 onClicked: {
                     currentWebView.url = url;
+                    speculation.commit(url);
                     overlay.close();
                 }
                 highlightText: urlFilter.filter
@@ -137,6 +141,13 @@ Controls.Drawer {
         }
     }
 
+    // the first completion is the most likely destination
+    Binding {
+        target: speculation
+        property: "candidate"
+        value: openedState && urlFilter.filter !== "" ? urlFilter.firstUrl : ""
+    }
+
     onOpened: {
         // check if the drawer was just slightly slided
         if (openedState) return;
@@ -0,0 +1,137 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+import QtQuick 2.3
+import QtQuick.Controls 2.4 as Controls
+import QtQuick.Layouts 1.11
+
+import org.kde.kirigami 2.7 as Kirigami
+import org.kde.mobile.angelfish 1.0
+
+Kirigami.ScrollablePage {
+    title: i18n("Clear browsing data")
+
+    topPadding: 0
+    bottomPadding: 0
+    leftPadding: 0
+    rightPadding: 0
+    Kirigami.ColumnView.fillWidth: false
+
+    background: Rectangle {
+        Kirigami.Theme.colorSet: Kirigami.Theme.View
+        color: Kirigami.Theme.backgroundColor
+    }
+
+    Connections {
+        target: BrowsingData
+        function onFinished(removedHistory) {
+            if (removedHistory < 0)
+                showPassiveNotification(i18n("Failed to clear the history"))
+            else
+                showPassiveNotification(i18n("Browsing data cleared"))
+        }
+    }
+
+    ColumnLayout {
+        spacing: 0
+
+        property real itemHeight: Kirigami.Units.gridUnit * 2.5
+
+        RowLayout {
+            Layout.fillWidth: true
+            Layout.leftMargin: Kirigami.Units.gridUnit
+            Layout.rightMargin: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+
+            Controls.Label {
+                text: i18n("Time range")
+                Layout.fillWidth: true
+            }
+            Controls.ComboBox {
+                id: range
+                // in the order of BrowsingData.Range
+                model: [i18n("Last hour"), i18n("Last day"), i18n("Last week"), i18n("Last month"), i18n("Everything")]
+            }
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.CheckDelegate {
+            id: history
+            text: i18n("History")
+            checked: true
+            Layout.fillWidth: true
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.CheckDelegate {
+            id: cookies
+            text: i18n("Cookies of all time")
+            Layout.fillWidth: true
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.CheckDelegate {
+            id: cache
+            text: i18n("Cached files of all time")
+            checked: true
+            Layout.fillWidth: true
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.Button {
+            text: i18n("Clear data")
+            icon.name: "edit-clear-history"
+            enabled: !BrowsingData.running && (history.checked || cookies.checked || cache.checked)
+            Layout.alignment: Qt.AlignHCenter
+            Layout.margins: Kirigami.Units.gridUnit
+            onClicked: {
+                var types = 0;
+                if (history.checked)
+                    types |= BrowsingData.History;
+                if (cookies.checked)
+                    types |= BrowsingData.Cookies;
+                if (cache.checked)
+                    types |= BrowsingData.Cache;
+                BrowsingData.clear(range.currentIndex, types);
+            }
+        }
+
+        Controls.ProgressBar {
+            visible: BrowsingData.running
+            value: BrowsingData.progress
+            Layout.fillWidth: true
+            Layout.leftMargin: Kirigami.Units.gridUnit
+            Layout.rightMargin: Kirigami.Units.gridUnit
+        }
+
+        Item {
+            Layout.fillHeight: true
+        }
+    }
+}
@@ -0,0 +1,158 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+import QtQuick 2.3
+import QtQuick.Controls 2.4 as Controls
+import QtQuick.Layouts 1.11
+
+import org.kde.kirigami 2.7 as Kirigami
+import org.kde.mobile.angelfish 1.0
+
+Kirigami.ScrollablePage {
+    title: i18n("Data saver")
+
+    topPadding: 0
+    bottomPadding: 0
+    leftPadding: 0
+    rightPadding: 0
+    Kirigami.ColumnView.fillWidth: false
+
+    background: Rectangle {
+        Kirigami.Theme.colorSet: Kirigami.Theme.View
+        color: Kirigami.Theme.backgroundColor
+    }
+
+    ColumnLayout {
+        spacing: 0
+
+        property real itemHeight: Kirigami.Units.gridUnit * 2.5
+
+        Controls.Label {
+            text: i18n("Limits the resources a page may load, for use on metered " +
+                       "connections. Resources which have been held back can be " +
+                       "loaded from the menu of the page.")
+            Layout.fillWidth: true
+            padding: Kirigami.Units.gridUnit
+            wrapMode: Text.WordWrap
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.SwitchDelegate {
+            text: i18n("Enable data saver")
+            Layout.fillWidth: true
+            checked: Settings.dataSaverEnabled
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+            onCheckedChanged: Settings.dataSaverEnabled = checked
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.SwitchDelegate {
+            text: i18n("Block audio and video")
+            enabled: Settings.dataSaverEnabled
+            Layout.fillWidth: true
+            checked: Settings.dataSaverBlockMedia
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+            onCheckedChanged: Settings.dataSaverBlockMedia = checked
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.SwitchDelegate {
+            text: i18n("Block web fonts")
+            enabled: Settings.dataSaverEnabled
+            Layout.fillWidth: true
+            checked: Settings.dataSaverBlockFonts
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+            onCheckedChanged: Settings.dataSaverBlockFonts = checked
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.SwitchDelegate {
+            text: i18n("Block scripts of other sites")
+            enabled: Settings.dataSaverEnabled
+            Layout.fillWidth: true
+            checked: Settings.dataSaverBlockThirdPartyScripts
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+            onCheckedChanged: Settings.dataSaverBlockThirdPartyScripts = checked
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        RowLayout {
+            enabled: Settings.dataSaverEnabled
+            Layout.fillWidth: true
+            Layout.leftMargin: Kirigami.Units.gridUnit
+            Layout.rightMargin: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+
+            Controls.Label {
+                text: i18n("Images per page")
+                Layout.fillWidth: true
+            }
+            Controls.SpinBox {
+                from: 0
+                to: 1000
+                value: Settings.dataSaverMaxImages
+                onValueModified: Settings.dataSaverMaxImages = value
+            }
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        RowLayout {
+            enabled: Settings.dataSaverEnabled
+            Layout.fillWidth: true
+            Layout.leftMargin: Kirigami.Units.gridUnit
+            Layout.rightMargin: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+
+            Controls.Label {
+                text: i18n("Requests per page")
+                Layout.fillWidth: true
+            }
+            Controls.SpinBox {
+                from: 10
+                to: 10000
+                stepSize: 10
+                value: Settings.dataSaverMaxRequests
+                onValueModified: Settings.dataSaverMaxRequests = value
+            }
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Item {
+            Layout.fillHeight: true
+        }
+    }
+}
@@ -0,0 +1,135 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+import QtQuick 2.3
+import QtQuick.Controls 2.4 as Controls
+import QtQuick.Dialogs 1.3
+import QtQuick.Layouts 1.11
+
+import org.kde.kirigami 2.7 as Kirigami
+import org.kde.mobile.angelfish 1.0
+
+Kirigami.ScrollablePage {
+    title: i18n("Import and export")
+
+    topPadding: 0
+    bottomPadding: 0
+    leftPadding: 0
+    rightPadding: 0
+    Kirigami.ColumnView.fillWidth: false
+
+    background: Rectangle {
+        Kirigami.Theme.colorSet: Kirigami.Theme.View
+        color: Kirigami.Theme.backgroundColor
+    }
+
+    // in the order of DataTransfer.Format
+    readonly property var formats: [
+        {name: i18n("Bookmarks file (HTML)"), filter: i18n("HTML files (*.html *.htm)"), canExport: true},
+        {name: i18n("JSON Lines"), filter: i18n("JSON Lines files (*.jsonl)"), canExport: true},
+        {name: i18n("Firefox history (places.sqlite)"), filter: "places.sqlite", canExport: false},
+        {name: i18n("Chromium history"), filter: "History", canExport: false}
+    ]
+
+    Connections {
+        target: DataTransfer
+        function onFinished(count, error) {
+            if (error)
+                showPassiveNotification(i18n("Failed: %1", error))
+            else
+                showPassiveNotification(i18np("Transferred one entry", "Transferred %1 entries", count))
+        }
+    }
+
+    FileDialog {
+        id: fileDialog
+        property bool exporting
+        selectExisting: !exporting
+        nameFilters: [formats[format.currentIndex].filter]
+        onAccepted: {
+            if (exporting)
+                DataTransfer.exportFile(fileUrl, format.currentIndex)
+            else
+                DataTransfer.importFile(fileUrl, format.currentIndex)
+        }
+    }
+
+    ColumnLayout {
+        spacing: 0
+
+        property real itemHeight: Kirigami.Units.gridUnit * 2.5
+
+        Controls.Label {
+            text: i18n("Imported entries are added to the history and bookmarks. " +
+                       "Firefox and Chromium have to be closed to read their history.")
+            Layout.fillWidth: true
+            padding: Kirigami.Units.gridUnit
+            wrapMode: Text.WordWrap
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        RowLayout {
+            Layout.fillWidth: true
+            Layout.leftMargin: Kirigami.Units.gridUnit
+            Layout.rightMargin: Kirigami.Units.gridUnit
+            implicitHeight: parent.itemHeight
+
+            Controls.Label {
+                text: i18n("Format")
+                Layout.fillWidth: true
+            }
+            Controls.ComboBox {
+                id: format
+                model: formats.map(function (format) { return format.name })
+            }
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        RowLayout {
+            enabled: !DataTransfer.running
+            Layout.alignment: Qt.AlignHCenter
+            Layout.margins: Kirigami.Units.gridUnit
+
+            Controls.Button {
+                text: i18n("Import…")
+                icon.name: "document-import"
+                onClicked: {
+                    fileDialog.exporting = false
+                    fileDialog.open()
+                }
+            }
+            Controls.Button {
+                text: i18n("Export…")
+                icon.name: "document-export"
+                enabled: formats[format.currentIndex].canExport
+                onClicked: {
+                    fileDialog.exporting = true
+                    fileDialog.open()
+                }
+            }
+        }
+
+        Controls.ProgressBar {
+            visible: DataTransfer.running
+            value: DataTransfer.progress
+            Layout.fillWidth: true
+            Layout.leftMargin: Kirigami.Units.gridUnit
+            Layout.rightMargin: Kirigami.Units.gridUnit
+        }
+
+        Item {
+            Layout.fillHeight: true
+        }
+    }
+}
@@ -60,6 +60,50 @@ Kirigami.ScrollablePage {
             Layout.fillWidth: true
         }
 
+        Controls.SwitchDelegate {
+            text: i18n("Block ads and trackers")
+            Layout.fillWidth: true
+            checked: Settings.adblockEnabled
+            onClicked: Settings.adblockEnabled = checked
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: Kirigami.Units.gridUnit * 2.5
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.SwitchDelegate {
+            text: i18n("Save bookmarked pages for offline reading")
+            Layout.fillWidth: true
+            checked: Settings.snapshotsCaptureBookmarks
+            onClicked: Settings.snapshotsCaptureBookmarks = checked
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: Kirigami.Units.gridUnit * 2.5
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.SwitchDelegate {
+            text: i18n("Search the text of visited pages in the history")
+            Layout.fillWidth: true
+            visible: PageText.available
+            checked: Settings.pageTextIndexEnabled
+            onClicked: Settings.pageTextIndexEnabled = checked
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: Kirigami.Units.gridUnit * 2.5
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+            visible: PageText.available
+        }
+
         Controls.ItemDelegate {
             text: i18n("Search Engine")
             Layout.fillWidth: true
@@ -73,6 +117,19 @@ Kirigami.ScrollablePage {
             Layout.fillWidth: true
         }
 
+        Controls.ItemDelegate {
+            text: i18n("Data saver")
+            Layout.fillWidth: true
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: Kirigami.Units.gridUnit * 2.5
+            onClicked: pageStack.push(Qt.resolvedUrl("SettingsDataSaverPage.qml"))
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
         Controls.ItemDelegate {
             text: i18n("Navigation bar")
             Layout.fillWidth: true
@@ -86,6 +143,59 @@ Kirigami.ScrollablePage {
             Layout.fillWidth: true
         }
 
+        Controls.ItemDelegate {
+            text: i18n("Clear browsing data")
+            Layout.fillWidth: true
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: Kirigami.Units.gridUnit * 2.5
+            onClicked: pageStack.push(Qt.resolvedUrl("SettingsClearDataPage.qml"))
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.ItemDelegate {
+            text: i18n("Import and export")
+            Layout.fillWidth: true
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: Kirigami.Units.gridUnit * 2.5
+            onClicked: pageStack.push(Qt.resolvedUrl("SettingsImportExportPage.qml"))
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.ItemDelegate {
+            text: i18n("Site performance")
+            Layout.fillWidth: true
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: Kirigami.Units.gridUnit * 2.5
+            onClicked: pageStack.push(Qt.resolvedUrl("SettingsSitePerformancePage.qml"))
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
+        Controls.SwitchDelegate {
+            text: i18n("Show frame rate and record janky frames")
+            Layout.fillWidth: true
+            checked: Settings.frameMonitorEnabled
+            onClicked: Settings.frameMonitorEnabled = checked
+            leftPadding: Kirigami.Units.gridUnit
+            rightPadding: Kirigami.Units.gridUnit
+            implicitHeight: Kirigami.Units.gridUnit * 2.5
+        }
+
+        Kirigami.Separator {
+            Layout.fillWidth: true
+        }
+
         Item {
             Layout.fillHeight: true
         }
@@ -0,0 +1,86 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+import QtQuick 2.3
+import QtQuick.Controls 2.2 as Controls
+import QtQuick.Layouts 1.0
+
+import org.kde.kirigami 2.8 as Kirigami
+import org.kde.mobile.angelfish 1.0
+
+Kirigami.ScrollablePage {
+    title: i18n("Site performance")
+    Kirigami.ColumnView.fillWidth: false
+
+    // median and 90th percentile, missing if not recorded
+    function timeText(median, p90) {
+        if (median < 0)
+            return i18n("n/a");
+        return i18n("%1 ms, 90%: %2 ms", median, p90);
+    }
+
+    Component {
+        id: delegateComponent
+
+        Kirigami.BasicListItem {
+            hoverEnabled: false
+            separatorVisible: true
+
+            ColumnLayout {
+                Controls.Label {
+                    text: model.host
+                    elide: Qt.ElideRight
+                    maximumLineCount: 1
+                    Layout.fillWidth: true
+                }
+
+                Controls.Label {
+                    text: i18np("%1 load, %2 transferred", "%1 loads, %2 transferred", model.loads,
+                                model.transferSizeMedian < 0 ? i18n("n/a") : Qt.locale().formattedDataSize(model.transferSizeMedian))
+                    opacity: 0.6
+                    Layout.fillWidth: true
+                }
+
+                GridLayout {
+                    columns: 2
+                    opacity: 0.6
+                    Layout.fillWidth: true
+
+                    Controls.Label { text: i18n("First byte:") }
+                    Controls.Label { text: timeText(model.timeToFirstByteMedian, model.timeToFirstByteP90) }
+                    Controls.Label { text: i18n("Content loaded:") }
+                    Controls.Label { text: timeText(model.domContentLoadedMedian, model.domContentLoadedP90) }
+                    Controls.Label { text: i18n("First paint:") }
+                    Controls.Label { text: timeText(model.firstContentfulPaintMedian, model.firstContentfulPaintP90) }
+                }
+            }
+        }
+    }
+
+    ListView {
+        id: list
+        anchors.fill: parent
+
+        interactive: height < contentHeight
+        clip: true
+
+        model: SitePerformanceModel {}
+
+        delegate: Kirigami.DelegateRecycler {
+            width: list.width
+            sourceComponent: delegateComponent
+        }
+
+        Controls.Label {
+            anchors.centerIn: parent
+            visible: list.count === 0
+            text: i18n("No pages have been loaded yet")
+            opacity: 0.6
+        }
+    }
+}
@@ -0,0 +1,136 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+import QtQuick 2.3
+import QtQuick.Controls 2.2 as Controls
+import QtQuick.Layouts 1.0
+
+import org.kde.kirigami 2.8 as Kirigami
+import org.kde.mobile.angelfish 1.0
+
+Kirigami.ScrollablePage {
+    title: i18n("Task manager")
+    Kirigami.ColumnView.fillWidth: false
+
+    // the processes are only sampled while the page is shown
+    Component.onCompleted: TabResources.active = true
+    Component.onDestruction: TabResources.active = false
+
+    function memoryText(kilobytes) {
+        return kilobytes < 0 ? i18n("n/a") : Qt.locale().formattedDataSize(kilobytes * 1024);
+    }
+
+    function usageText(model) {
+        if (model.pid < 0)
+            return i18n("Process unknown");
+
+        const cpu = model.cpuUsage < 0 ? i18n("%1 s CPU", (model.cpuTime / 1000).toFixed(1))
+                                       : i18n("%1 s CPU (%2%)", (model.cpuTime / 1000).toFixed(1), Math.round(model.cpuUsage));
+        return i18n("PID %1, %2 resident, %3 proportional, %4", model.pid, memoryText(model.rss), memoryText(model.pss), cpu);
+    }
+
+    function stateText(model) {
+        const states = [];
+        if (model.lifecycleState === TabResources.Frozen)
+            states.push(i18n("Frozen"));
+        else if (model.lifecycleState === TabResources.Discarded)
+            states.push(i18n("Discarded"));
+        if (model.privateMode)
+            states.push(i18n("Private"));
+        if (model.processTabs > 1)
+            states.push(i18np("Process shared with %1 other tab", "Process shared with %1 other tabs", model.processTabs - 1));
+        if (model.transferredBytes >= 0)
+            states.push(i18n("%1 transferred", Qt.locale().formattedDataSize(model.transferredBytes)));
+        return states.join(", ");
+    }
+
+    function closeTab(view) {
+        for (let i = 0; i < tabs.count; i++) {
+            if (tabs.itemAt(i) === view) {
+                tabs.tabsModel.closeTab(i);
+                return;
+            }
+        }
+    }
+
+    Component {
+        id: delegateComponent
+
+        Kirigami.SwipeListItem {
+            ColumnLayout {
+                Controls.Label {
+                    text: model.title ? model.title : model.url
+                    elide: Qt.ElideRight
+                    maximumLineCount: 1
+                    Layout.fillWidth: true
+                }
+
+                Controls.Label {
+                    text: usageText(model)
+                    opacity: 0.6
+                    elide: Qt.ElideRight
+                    maximumLineCount: 1
+                    Layout.fillWidth: true
+                }
+
+                Controls.Label {
+                    text: stateText(model)
+                    visible: text !== ""
+                    opacity: 0.6
+                    elide: Qt.ElideRight
+                    maximumLineCount: 1
+                    Layout.fillWidth: true
+                }
+            }
+
+            actions: [
+                Kirigami.Action {
+                    icon.name: "media-playback-pause"
+                    text: i18n("Freeze")
+                    // the current tab can't be frozen
+                    visible: model.lifecycleState === TabResources.Active && model.view !== currentWebView
+                    onTriggered: TabResources.setLifecycleState(index, TabResources.Frozen)
+                },
+                Kirigami.Action {
+                    icon.name: "edit-clear"
+                    text: i18n("Discard")
+                    visible: model.lifecycleState !== TabResources.Discarded && model.view !== currentWebView
+                    onTriggered: TabResources.setLifecycleState(index, TabResources.Discarded)
+                },
+                Kirigami.Action {
+                    icon.name: "media-playback-start"
+                    text: i18n("Activate")
+                    visible: model.lifecycleState !== TabResources.Active
+                    onTriggered: TabResources.setLifecycleState(index, TabResources.Active)
+                },
+                Kirigami.Action {
+                    icon.name: "tab-close"
+                    text: i18n("Close")
+                    // only tabs of the current mode are listed by tabs
+                    visible: model.privateMode === tabs.privateTabsMode
+                    onTriggered: closeTab(model.view)
+                }
+            ]
+        }
+    }
+
+    ListView {
+        id: list
+        anchors.fill: parent
+
+        interactive: height < contentHeight
+        clip: true
+
+        model: TabResources
+
+        delegate: Kirigami.DelegateRecycler {
+            width: list.width
+            sourceComponent: delegateComponent
+        }
+    }
+}
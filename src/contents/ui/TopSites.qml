@@ -0,0 +1,75 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+import QtQuick 2.3
+import QtQuick.Layouts 1.0
+import QtQuick.Controls 2.0 as Controls
+
+import org.kde.kirigami 2.5 as Kirigami
+import org.kde.mobile.angelfish 1.0
+
+// Grid of the most visited sites, see TopSitesModel
+Rectangle {
+    id: topSites
+
+    property int tileSize: Kirigami.Units.gridUnit * 6
+
+    color: Kirigami.Theme.viewBackgroundColor
+    visible: grid.count > 0
+
+    GridView {
+        id: grid
+        anchors.fill: parent
+        anchors.margins: Kirigami.Units.largeSpacing
+
+        cellWidth: width / Math.max(1, Math.floor(width / topSites.tileSize))
+        cellHeight: topSites.tileSize
+        interactive: contentHeight > height
+        clip: true
+
+        model: TopSitesModel {}
+
+        delegate: Item {
+            width: grid.cellWidth
+            height: grid.cellHeight
+
+            Rectangle {
+                anchors.fill: parent
+                color: mouse.pressed ? Kirigami.Theme.highlightColor : "transparent"
+                opacity: 0.2
+            }
+
+            ColumnLayout {
+                anchors.fill: parent
+                anchors.margins: Kirigami.Units.smallSpacing
+
+                Image {
+                    Layout.alignment: Qt.AlignHCenter
+                    Layout.preferredWidth: Kirigami.Units.iconSizes.large
+                    Layout.preferredHeight: Kirigami.Units.iconSizes.large
+                    fillMode: Image.PreserveAspectFit
+                    source: model.icon ? model.icon : ""
+                }
+
+                Controls.Label {
+                    Layout.fillWidth: true
+                    horizontalAlignment: Text.AlignHCenter
+                    elide: Text.ElideRight
+                    maximumLineCount: 1
+                    text: model.host
+                }
+            }
+
+            MouseArea {
+                id: mouse
+                anchors.fill: parent
+                onClicked: currentWebView.url = model.url
+            }
+        }
+    }
+}
@@ -16,12 +16,21 @@ Kirigami.SwipeListItem {
     id: urlDelegate
 
     property bool showRemove: true
+    // a snapshot for offline reading exists, only known for bookmarks and history
+    property bool saved: model && model.saved ? true : false
 
     property string highlightText
     property var regex: new RegExp(highlightText, 'i')
     property string highlightedText: "<b><font color=\"" + Kirigami.Theme.selectionTextColor + "\">$&</font></b>"
 
-    height: Kirigami.Units.gridUnit * 3
+    // Bookmarks and history provide the host and path precomputed by the
+    // database, other models (e.g. navigation history) only the url
+    property string displayUrl: model && model.host ? model.host + (model.displayPath ? model.displayPath : "") : (url ? url : "")
+
+    // text of the page matching the search, only known for history
+    property string snippet: model && model.snippet ? model.snippet : ""
+
+    height: Kirigami.Units.gridUnit * (snippet ? 4 : 3)
 
     Kirigami.Theme.colorSet: Kirigami.Theme.View
 
@@ -30,6 +39,7 @@ Kirigami.SwipeListItem {
     }
 
     signal removed
+    signal savedCopyRequested
 
     RowLayout {
         Kirigami.Theme.inherit: true
@@ -59,7 +69,17 @@ Kirigami.SwipeListItem {
 
             // url
             Controls.Label {
-                text: url ? (highlightText ? url.replace(regex, highlightedText) : url) : ""
+                text: highlightText ? displayUrl.replace(regex, highlightedText) : displayUrl
+                opacity: 0.6
+                elide: Qt.ElideRight
+                maximumLineCount: 1
+                Layout.fillWidth: true
+            }
+
+            Controls.Label {
+                visible: urlDelegate.snippet !== ""
+                text: highlightText ? urlDelegate.snippet.replace(regex, highlightedText) : urlDelegate.snippet
+                font: Kirigami.Theme.smallFont
                 opacity: 0.6
                 elide: Qt.ElideRight
                 maximumLineCount: 1
@@ -69,6 +89,12 @@ Kirigami.SwipeListItem {
     }
 
     actions: [
+        Kirigami.Action {
+            icon.name: "document-open"
+            text: i18n("Open saved copy")
+            visible: urlDelegate.saved
+            onTriggered: urlDelegate.savedCopyRequested();
+        },
         Kirigami.Action {
             icon.name: "list-remove"
             visible: urlDelegate.showRemove
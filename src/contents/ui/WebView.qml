@@ -24,6 +24,11 @@ WebEngineView {
 
     property bool privateMode: false
 
+    // ms since the epoch the current load has been started at
+    property double loadStartTime: 0
+    // by the page loaded last, including its resources
+    property double transferredBytes: -1
+
     property alias userAgent: userAgent
 
     // loadingActive property is set to true when loading is started
@@ -41,25 +46,38 @@ WebEngineView {
     // reloadOnVisible property ensures that the view has been always
     // loaded at least once while it is visible. When the view is loaded
     // while visible is set to false, there, what appears to be Chromium
-    // optimizations that can disturb the loading.
+    // optimizations that can disturb the loading. Only loads that did not
+    // succeed are repeated, so that every page is still loaded only once.
     property bool reloadOnVisible: true
-
-    // Profiles of WebViews are shared among all views of the same type (regular or
-    // private). However, within each group of tabs, we can have some tabs that are
-    // using mobile or desktop user agent. To avoid loading a page with the wrong
-    // user agent, the agent is checked in the beginning of the loading at onLoadingChanged
-    // handler. If the user agent is wrong, loading is stopped and reloadOnMatchingAgents
-    // property is set to true. As soon as the agent is correct, the page is loaded.
-    property bool reloadOnMatchingAgents: false
-
-    // Used to follow whether agents match
-    property bool agentsMatch: profile.httpUserAgent === userAgent.userAgent
+    property int lastLoadStatus: -1
+
+    // The profile of the view always has to use the agent of userAgent. Views
+    // get their profile from the ProfileManager, which provides one profile
+    // per user agent, and have to request it with profileUserAgent. Switching
+    // the agent switches the profile, which reloads the current page once
+    // with the new agent. Only the current page is carried over, the new
+    // profile starts without back and forward history.
+    property string profileUserAgent: userAgent.userAgent
+
+    // Page a rule switched the agent for. It is loaded once the profile of
+    // the agent is used, the reload of the previous page started by the
+    // profile switch is dropped. The reload is requested asynchronously, so
+    // droppedReloadUrl is kept until it has been dropped or the page of the
+    // rule is done loading.
+    property string ruleSwitchUrl: ""
+    property string droppedReloadUrl: ""
 
     // URL that was requested and should be used
     // as a base for user interaction. It reflects
     // last request (successful or failed)
     property url requestedUrl: url
 
+    // number of requests of the current page blocked by the content blocker
+    property int blockedRequests: 0
+
+    // requests of the current page counted by the data saver, see DataSaver.pageStatistics
+    property var dataSaverStatistics: ({})
+
     property int findInPageResultIndex
     property int findInPageResultCount
 
@@ -110,7 +128,47 @@ WebEngineView {
 
     UserAgentGenerator {
         id: userAgent
-        onUserAgentChanged: webEngineView.reload()
+        onUserAgentChanged: Qt.callLater(webEngineView.updateProfileUserAgent)
+    }
+
+    // Per-site user agent rules are applied before the first request of a
+    // page is sent. If the rule asks for a different agent, the navigation
+    // is restarted with the profile of that agent, see updateProfileUserAgent.
+    // Going back and forward keeps the agent, as switching it would drop the
+    // history the navigation is moving in.
+    onNavigationRequested: {
+        if (!request.isMainFrame)
+            return;
+
+        if (droppedReloadUrl !== "" && String(request.url) === droppedReloadUrl) {
+            request.action = WebEngineNavigationRequest.IgnoreRequest;
+            droppedReloadUrl = "";
+            return;
+        }
+
+        if (request.navigationType === WebEngineNavigationRequest.BackForwardNavigation)
+            return;
+
+        if (userAgent.applyRule(BrowserManager.userAgentRuleForUrl(request.url))) {
+            request.action = WebEngineNavigationRequest.IgnoreRequest;
+            ruleSwitchUrl = String(request.url);
+        }
+    }
+
+    Connections {
+        target: Adblock
+        function onBlockedCountChanged(view, count) {
+            if (view === webEngineView)
+                webEngineView.blockedRequests = count;
+        }
+    }
+
+    Connections {
+        target: DataSaver
+        function onPageStatisticsChanged(pageUrl) {
+            if (String(pageUrl) === String(webEngineView.url))
+                webEngineView.dataSaverStatistics = DataSaver.pageStatistics(pageUrl);
+        }
     }
 
     settings {
@@ -125,6 +183,14 @@ WebEngineView {
     }
 
     focus: true
+    onVisibleChanged: {
+        if (visible && reloadOnVisible) {
+            reloadOnVisible = false;
+            if (!loading && lastLoadStatus !== -1 && lastLoadStatus !== WebEngineView.LoadSucceededStatus)
+                reload();
+        }
+    }
+
     onLoadingChanged: {
         //print("Loading: " + loading);
         print("    url: " + loadRequest.url + " " + loadRequest.status)
@@ -139,17 +205,21 @@ WebEngineView {
         */
         var ec = "";
         var es = "";
+        lastLoadStatus = loadRequest.status;
         if (loadRequest.status === WebEngineView.LoadStartedStatus) {
-            if (profile.httpUserAgent !== userAgent.userAgent) {
-                //print("Mismatch of user agents, will load later " + loadRequest.url);
-                reloadOnMatchingAgents = true;
-                stopLoading();
-            } else {
-                loadingActive = true;
-            }
+            Adblock.startPage(webEngineView, loadRequest.url);
+            loadingActive = true;
+            loadStartTime = Date.now();
+        }
+        // a later request of the previous page is made by the user
+        if (loadRequest.status !== WebEngineView.LoadStartedStatus)
+            droppedReloadUrl = "";
+        if (loadRequest.status !== WebEngineView.LoadStartedStatus && loadStartTime > 0) {
+            Metrics.record("page.load_ms", Date.now() - loadStartTime);
+            loadStartTime = 0;
         }
         if (loadRequest.status === WebEngineView.LoadSucceededStatus) {
-            if (!privateMode) {
+            if (!privateMode && !Snapshots.isSnapshot(url)) {
                 const request = {
                     url: currentWebView.url,
                     title: currentWebView.title,
@@ -158,7 +228,13 @@ WebEngineView {
 
                 BrowserManager.addToHistory(request);
                 BrowserManager.updateLastVisited(currentWebView.url);
+
+                if (Snapshots.shouldCapture(url))
+                    saveSnapshot();
+                if (PageText.shouldIndex(url))
+                    indexPageText();
             }
+            measurePage(!privateMode && !Snapshots.isSnapshot(url));
             loadingActive = false;
         }
         if (loadRequest.status === WebEngineView.LoadFailedStatus) {
@@ -172,16 +248,33 @@ WebEngineView {
             // Otherwise, its updated as a part of url property update.
             if (requestedUrl !== loadRequest.url)
                 requestedUrl = loadRequest.url;
+
+            // without connection, show the saved copy instead of an error
+            if (loadRequest.errorDomain === WebEngineView.ConnectionErrorDomain && Snapshots.hasSnapshot(loadRequest.url)) {
+                url = Snapshots.snapshotUrl(loadRequest.url);
+                showPassiveNotification(i18n("Showing the saved copy of the page"));
+                ec = "";
+                es = "";
+            }
         }
         errorCode = ec;
         errorString = es;
+
+        // only the current tab is loaded during startup
+        if (loadRequest.status === WebEngineView.LoadSucceededStatus || loadRequest.status === WebEngineView.LoadFailedStatus)
+            Startup.pageLoaded();
     }
 
     Component.onCompleted: {
+        // from now on, the profile only follows the agent through updateProfileUserAgent
+        profileUserAgent = userAgent.userAgent;
         print("WebView completed.");
         print("Settings: " + webEngineView.settings);
+        Metrics.add("webengine.views", 1);
     }
 
+    Component.onDestruction: Metrics.add("webengine.views", -1)
+
     onIconChanged: {
         if (icon && !privateMode)
             BrowserManager.updateIcon(url, icon)
@@ -202,6 +295,10 @@ WebEngineView {
         if (requestedUrl !== url) {
             requestedUrl = url;
         }
+        Adblock.setPageUrl(webEngineView, url);
+        blockedRequests = Adblock.blockedCount(webEngineView);
+        DataSaver.showPage(webEngineView, url);
+        dataSaverStatistics = DataSaver.pageStatistics(url);
     }
 
     onFullScreenRequested: {
@@ -222,9 +319,7 @@ WebEngineView {
 
     onAuthenticationDialogRequested: {
         request.accepted = true
-        sheetLoader.setSource("AuthSheet.qml")
-        sheetLoader.item.request = request
-        sheetLoader.item.open()
+        sheetLoader.setSource("AuthSheet.qml", {request: request})
     }
 
     onFeaturePermissionRequested: {
@@ -236,9 +331,7 @@ WebEngineView {
 
     onJavaScriptDialogRequested: {
         request.accepted = true
-        sheetLoader.setSource("JavaScriptDialogSheet.qml")
-        sheetLoader.item.request = request
-        sheetLoader.item.open()
+        sheetLoader.setSource("JavaScriptDialogSheet.qml", {request: request})
     }
 
     onFindTextFinished: {
@@ -246,22 +339,6 @@ WebEngineView {
         findInPageResultCount = result.numberOfMatches;
     }
 
-    onVisibleChanged: {
-        if (visible && reloadOnVisible) {
-            // see description of reloadOnVisible above for reasoning
-            reloadOnVisible = false;
-            reload();
-        }
-    }
-
-    onAgentsMatchChanged: {
-        if (agentsMatch && reloadOnMatchingAgents) {
-            // see description of reloadOnMatchingAgents above for reasoning
-            reloadOnMatchingAgents = false;
-            reload();
-        }
-    }
-
     function findInPageBack(text) {
         findText(text, WebEngineView.FindBackward);
     }
@@ -270,6 +347,67 @@ WebEngineView {
         findText(text);
     }
 
+    // Reads the Navigation and Paint Timing of the loaded page. The bytes
+    // transferred are shown by the task manager, the timing is stored per
+    // host for the site performance settings page if recordTiming is set.
+    function measurePage(recordTiming) {
+        const pageUrl = String(url);
+        runJavaScript("(function() {" +
+                      "    var nav = performance.getEntriesByType('navigation')[0];" +
+                      "    if (!nav) return null;" +
+                      "    var paint = performance.getEntriesByName('first-contentful-paint')[0];" +
+                      "    var resources = performance.getEntriesByType('resource');" +
+                      "    return {" +
+                      "        ttfb: nav.responseStart - nav.startTime," +
+                      "        domContentLoaded: nav.domContentLoadedEventEnd - nav.startTime," +
+                      "        firstContentfulPaint: paint ? paint.startTime : -1," +
+                      "        transferSize: nav.transferSize," +
+                      "        transferred: resources.reduce(function(sum, entry) { return sum + entry.transferSize; }, nav.transferSize)" +
+                      "    };" +
+                      "})()", function(timing) {
+            if (!timing)
+                return;
+            transferredBytes = timing.transferred;
+            if (recordTiming)
+                BrowserManager.addPageTiming(pageUrl, timing);
+        });
+    }
+
+    // hands the readable text of the page to the history search, see
+    // PageTextIndex. Only the main content is read if the page marks it.
+    function indexPageText() {
+        const pageUrl = String(url);
+        const pageTitle = title;
+        runJavaScript("(function() {" +
+                      "    var root = document.querySelector('main, article, [role=main]') || document.body;" +
+                      "    return root ? root.innerText.substring(0, 100000) : '';" +
+                      "})()", function(text) {
+            if (text)
+                PageText.addPage(pageUrl, pageTitle, text);
+        });
+    }
+
+    // stores the page for offline reading, see SnapshotStore
+    function saveSnapshot() {
+        triggerWebAction(WebEngineView.SavePage);
+    }
+
+    function updateProfileUserAgent() {
+        const switchUrl = ruleSwitchUrl;
+        ruleSwitchUrl = "";
+
+        if (profileUserAgent !== userAgent.userAgent) {
+            const currentUrl = String(url);
+            // the page is left for the one of the rule instead of being reloaded
+            if (switchUrl !== "" && switchUrl !== currentUrl && currentUrl !== "")
+                droppedReloadUrl = currentUrl;
+            profileUserAgent = userAgent.userAgent;
+        }
+
+        if (switchUrl !== "")
+            url = switchUrl;
+    }
+
     function stopLoading() {
         loadingActive = false;
         stop();
@@ -94,6 +94,22 @@ Kirigami.ApplicationWindow {
                 }
                 text: i18n("History")
             },
+            Kirigami.Action {
+                icon.name: "download"
+                onTriggered: {
+                    popSubPages();
+                    pageStack.push(Qt.resolvedUrl("Downloads.qml"))
+                }
+                text: Downloads.activeCount > 0 ? i18n("Downloads (%1)", Downloads.activeCount) : i18n("Downloads")
+            },
+            Kirigami.Action {
+                icon.name: "utilities-system-monitor"
+                onTriggered: {
+                    popSubPages();
+                    pageStack.push(Qt.resolvedUrl("TaskManager.qml"))
+                }
+                text: i18n("Task manager")
+            },
             Kirigami.Action {
                 icon.name: "configure"
                 text: i18n("Settings")
@@ -105,6 +121,33 @@ Kirigami.ApplicationWindow {
         ]
     }
 
+    // Closing the window while running in the background forgets the
+    // private tabs. The views of the other tabs are unloaded, see ListWebView.
+    Connections {
+        target: WarmInstance
+        function onWaitingChanged() {
+            if (!WarmInstance.waiting || !rootPage.initialized)
+                return;
+
+            rootPage.privateMode = false;
+            // once the private views are gone
+            Qt.callLater(function() {
+                privateTabs.closeAllTabs();
+                profileManager.releaseOffTheRecordProfiles();
+            });
+        }
+    }
+
+    Connections {
+        target: Downloads
+        function onDownloadFinished(fileName, state) {
+            if (state === Downloads.Completed)
+                showPassiveNotification(i18n("Download finished"))
+            else
+                showPassiveNotification(i18n("Download failed"))
+        }
+    }
+
     contextDrawer: Kirigami.ContextDrawer {
         id: contextDrawer
 
@@ -141,7 +184,7 @@ Kirigami.ApplicationWindow {
             id: regularTabs
             objectName: "regularTabsObject"
             anchors.fill: parent
-            activeTabs: rootPage.initialized && !rootPage.privateMode
+            activeTabs: rootPage.initialized && !rootPage.privateMode && !WarmInstance.waiting
         }
 
         ListWebView {
@@ -179,6 +222,18 @@ Kirigami.ApplicationWindow {
             onRefreshRequested: currentWebView.reload()
         }
 
+        // most visited sites in place of a blank page
+        Loader {
+            anchors {
+                top: parent.top
+                left: parent.left
+                right: parent.right
+                bottom: navigation.top
+            }
+            active: !rootPage.privateMode && currentWebView.url.toString() === "about:blank" && !currentWebView.loading
+            sourceComponent: TopSites {}
+        }
+
         Loader {
             id: questionLoader
 
@@ -194,7 +249,7 @@ Kirigami.ApplicationWindow {
             height: Math.round(Kirigami.Units.gridUnit / 6)
             z: navigation.z + 1
             anchors {
-                bottom: findInPage.active ? findInPage.top : navigation.top
+                bottom: findInPage.item && findInPage.item.active ? findInPage.top : navigation.top
                 bottomMargin: -Math.round(height / 2)
                 left: tabs.left
                 right: tabs.right
@@ -215,11 +270,14 @@ Kirigami.ApplicationWindow {
             }
         }
 
+        // Sheets are only created when needed, and opened once loaded
         Loader {
             id: sheetLoader
+            asynchronous: true
+            onLoaded: item.open()
         }
 
-        // Unload the ShareSheet again after it closed
+        // Unload the sheet again after it closed
         Connections {
             target: sheetLoader.item
             function onSheetOpenChanged() {
@@ -234,6 +292,66 @@ Kirigami.ApplicationWindow {
             url: currentWebView.url
         }
 
+        // Profiles for the regular and private tabs, one per user agent
+        ProfileManager {
+            id: profileManager
+            urlRequestInterceptor: Adblock.interceptor
+            profileComponent: Component {
+                AngelfishWebProfile {
+                    questionLoader: rootPage.questionLoader
+                }
+            }
+        }
+
+        Binding {
+            target: BrowsingData
+            property: "profileManager"
+            value: profileManager
+        }
+
+        // Prepares the most likely next page while an url is being entered
+        SpeculationService {
+            id: speculation
+            enabled: Settings.speculationEnabled && !rootPage.privateMode && !DataSaver.enabled
+
+            onPreconnectRequested: {
+                speculationLoader.active = true;
+                speculationLoader.item.loadHtml(html, baseUrl);
+            }
+            onReleased: speculationLoader.active = false
+        }
+
+        // Hidden view carrying out the speculations. It shares the profile of
+        // the current tab, which then reuses its connections. It only exists
+        // while there is a speculation.
+        Loader {
+            id: speculationLoader
+            active: false
+            visible: false
+            width: rootPage.width
+            height: rootPage.height
+
+            sourceComponent: WebEngineView {
+                profile: currentWebView.profile
+                audioMuted: true
+
+                onJavaScriptDialogRequested: {
+                    request.accepted = true;
+                    request.dialogReject();
+                }
+                onAuthenticationDialogRequested: {
+                    request.accepted = true;
+                    request.dialogReject();
+                }
+                onFileDialogRequested: {
+                    request.accepted = true;
+                    request.dialogReject();
+                }
+                onCertificateError: error.rejectCertificate()
+                onFeaturePermissionRequested: grantFeaturePermission(securityOrigin, feature, false)
+            }
+        }
+
         // The menu at the bottom right
         contextualActions: [
             Kirigami.Action {
@@ -246,10 +364,19 @@ Kirigami.ApplicationWindow {
                 icon.name: "document-share"
                 text: i18n("Share page")
                 onTriggered: {
-                    sheetLoader.setSource("ShareSheet.qml")
-                    sheetLoader.item.url = currentWebView.url
-                    sheetLoader.item.title = currentWebView.title
-                    sheetLoader.item.open()
+                    sheetLoader.setSource("ShareSheet.qml", {
+                        url: currentWebView.url,
+                        title: currentWebView.title
+                    })
+                }
+            },
+            Kirigami.Action {
+                icon.name: "document-save"
+                text: i18n("Save for offline reading")
+                visible: !rootPage.privateMode
+                onTriggered: {
+                    currentWebView.saveSnapshot()
+                    showPassiveNotification(i18n("Saving page for offline reading"))
                 }
             },
             Kirigami.Action {
@@ -304,6 +431,8 @@ Kirigami.ApplicationWindow {
                             icon: currentWebView.icon
                         }
                         BrowserManager.addBookmark(request);
+                        if (Snapshots.captureBookmarks && !rootPage.privateMode)
+                            currentWebView.saveSnapshot();
                     } else {
                         BrowserManager.removeBookmark(currentWebView.url);
                     }
@@ -316,6 +445,39 @@ Kirigami.ApplicationWindow {
                 checked: !currentWebView.userAgent.isMobile
                 onTriggered: {
                     currentWebView.userAgent.isMobile = !currentWebView.userAgent.isMobile;
+                    // an explicit choice replaces the rule for the site
+                    if (urlObserver.userAgentRule.pattern)
+                        BrowserManager.setUserAgentRule(urlObserver.userAgentRule.pattern,
+                                                        currentWebView.userAgent.isMobile ? UserAgentRules.Mobile : UserAgentRules.Desktop);
+                }
+            },
+            Kirigami.Action {
+                icon.name: "document-save"
+                text: i18n("Remember site mode")
+                checkable: true
+                checked: urlObserver.userAgentRule.pattern !== undefined
+                onTriggered: {
+                    if (checked) {
+                        BrowserManager.setUserAgentRule(UrlUtils.urlRegistrableDomain(currentWebView.url),
+                                                        currentWebView.userAgent.isMobile ? UserAgentRules.Mobile : UserAgentRules.Desktop);
+                    } else {
+                        BrowserManager.removeUserAgentRule(urlObserver.userAgentRule.pattern);
+                    }
+                }
+            },
+            Kirigami.Action {
+                icon.name: "security-high"
+                text: i18np("%1 request blocked", "%1 requests blocked", currentWebView.blockedRequests)
+                visible: Adblock.enabled && currentWebView.blockedRequests > 0
+                enabled: false
+            },
+            Kirigami.Action {
+                icon.name: "download"
+                text: i18np("Load %1 held back resource", "Load %1 held back resources", currentWebView.dataSaverStatistics.blocked || 0)
+                visible: DataSaver.enabled && currentWebView.dataSaverStatistics.blocked > 0
+                onTriggered: {
+                    DataSaver.allowPage(currentWebView.url);
+                    currentWebView.reload();
                 }
             },
             Kirigami.Action {
@@ -329,19 +491,43 @@ Kirigami.ApplicationWindow {
             }
         ]
 
-        // Find bar
-        FindInPageBar {
+        // Find bar, only loaded while it is used
+        Loader {
             id: findInPage
 
-            Kirigami.Theme.colorSet: rootPage.privateMode ? Kirigami.Theme.Complementary : Kirigami.Theme.Window
+            anchors {
+                bottom: parent.bottom
+                left: parent.left
+                right: parent.right
+            }
 
-            layer.enabled: active
-            layer.effect: DropShadow {
-                verticalOffset: - 1
-                color: Kirigami.Theme.disabledTextColor
-                samples: 10
-                spread: 0.1
-                cached: true // element is static
+            active: false
+            asynchronous: true
+
+            function activate() {
+                if (active && item)
+                    item.activate();
+                active = true;
+            }
+
+            onLoaded: item.activate()
+
+            sourceComponent: FindInPageBar {
+                Kirigami.Theme.colorSet: rootPage.privateMode ? Kirigami.Theme.Complementary : Kirigami.Theme.Window
+
+                layer.enabled: active
+                layer.effect: DropShadow {
+                    verticalOffset: - 1
+                    color: Kirigami.Theme.disabledTextColor
+                    samples: 10
+                    spread: 0.1
+                    cached: true // element is static
+                }
+
+                onActiveChanged: {
+                    if (!active)
+                        findInPage.active = false;
+                }
             }
         }
 
@@ -356,7 +542,7 @@ Kirigami.ApplicationWindow {
             }
 
             navigationShown: visible && rootPage.navigationAutoShow
-            visible: webBrowser.visibility !== Window.FullScreen && !findInPage.active
+            visible: webBrowser.visibility !== Window.FullScreen && !(findInPage.item && findInPage.item.active)
 
             Kirigami.Theme.colorSet: rootPage.privateMode ? Kirigami.Theme.Complementary : Kirigami.Theme.Window
 
@@ -376,8 +562,38 @@ Kirigami.ApplicationWindow {
             id: urlEntry
         }
 
-        HistorySheet {
+        FrameOverlay {
+            anchors {
+                top: parent.top
+                right: parent.right
+                margins: Kirigami.Units.smallSpacing
+            }
+            z: navigation.z + 1
+            visible: Settings.frameMonitorEnabled
+        }
+
+        // History of the current tab, only loaded while it is shown
+        Loader {
             id: historySheet
+
+            property bool backHistory: true
+
+            active: false
+            asynchronous: true
+
+            function open() {
+                if (item)
+                    item.open();
+                active = true;
+            }
+
+            onLoaded: item.open()
+
+            sourceComponent: HistorySheet {
+                parent: rootPage
+                backHistory: historySheet.backHistory
+                onClosed: historySheet.active = false
+            }
         }
 
         // Thin line above navigation or find
@@ -386,10 +602,10 @@ Kirigami.ApplicationWindow {
             color: webBrowser.borderColor
             anchors {
                 left: parent.left
-                bottom: findInPage.active ? findInPage.top : navigation.top
+                bottom: findInPage.item && findInPage.item.active ? findInPage.top : navigation.top
                 right: parent.right
             }
-            visible: navigation.navigationShown || findInPage.active
+            visible: navigation.navigationShown || (findInPage.item && findInPage.item.active)
         }
 
         // dealing with hiding and showing navigation bar
@@ -440,6 +656,61 @@ Kirigami.ApplicationWindow {
         }
     }
 
+    // Scenarios of angelfish --benchmark, see BenchmarkDriver
+    Connections {
+        target: Benchmark
+        enabled: Benchmark.running
+        function onStepRequested(action, args) {
+            switch (action) {
+            case "openTab":
+                tabs.tabsModel.newTab(args.url);
+                break;
+            case "navigate":
+                currentWebView.url = args.url;
+                break;
+            case "switchTab":
+                tabs.currentIndex = args.index;
+                break;
+            case "openUrlEntry":
+                urlEntry.open();
+                break;
+            case "setUrlText":
+                urlEntry.text = args.text;
+                break;
+            case "closeUrlEntry":
+                urlEntry.close();
+                break;
+            case "openHistory":
+                popSubPages();
+                pageStack.push(Qt.resolvedUrl("History.qml"));
+                break;
+            case "closeSubPages":
+                popSubPages();
+                break;
+            }
+        }
+    }
+
+    Connections {
+        target: currentWebView
+        enabled: Benchmark.running
+        function onLoadingChanged(loadRequest) {
+            if (loadRequest.status !== WebEngineView.LoadStartedStatus)
+                Benchmark.pageLoaded(loadRequest.url, loadRequest.status === WebEngineView.LoadSucceededStatus);
+        }
+    }
+
+    Connections {
+        target: urlEntry
+        enabled: Benchmark.running
+        function onOpened() {
+            Benchmark.stepFinished();
+        }
+        function onClosed() {
+            Benchmark.stepFinished();
+        }
+    }
+
     // Store window dimensions
     Component.onCompleted: {
         rootPage.initialized = true
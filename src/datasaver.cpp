@@ -0,0 +1,219 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "datasaver.h"
+#include "urlutils.h"
+
+#include "angelfishsettings.h"
+
+#include <algorithm>
+
+// started pages whose counters are kept until a view shows them
+constexpr int MAX_STARTED_PAGES = 8;
+
+DataSaver *DataSaver::s_instance = nullptr;
+
+namespace {
+DataSaver::Budget budgetFromSettings()
+{
+    const auto *settings = AngelfishSettings::self();
+    DataSaver::Budget budget;
+    budget.blockMedia = settings->dataSaverBlockMedia();
+    budget.blockFonts = settings->dataSaverBlockFonts();
+    budget.blockThirdPartyScripts = settings->dataSaverBlockThirdPartyScripts();
+    budget.maxImages = settings->dataSaverMaxImages();
+    budget.maxRequests = settings->dataSaverMaxRequests();
+    return budget;
+}
+}
+
+DataSaver::DataSaver(QObject *parent)
+    : QObject(parent)
+{
+}
+
+DataSaver *DataSaver::instance()
+{
+    if (s_instance)
+        return s_instance;
+
+    s_instance = new DataSaver();
+    auto *settings = AngelfishSettings::self();
+    s_instance->setEnabled(settings->dataSaverEnabled());
+    s_instance->setBudget(budgetFromSettings());
+
+    QObject::connect(settings, &AngelfishSettings::dataSaverEnabledChanged, s_instance, [settings] {
+        s_instance->setEnabled(settings->dataSaverEnabled());
+    });
+    const auto updateBudget = [] {
+        s_instance->setBudget(budgetFromSettings());
+    };
+    QObject::connect(settings, &AngelfishSettings::dataSaverBlockMediaChanged, s_instance, updateBudget);
+    QObject::connect(settings, &AngelfishSettings::dataSaverBlockFontsChanged, s_instance, updateBudget);
+    QObject::connect(settings, &AngelfishSettings::dataSaverBlockThirdPartyScriptsChanged, s_instance, updateBudget);
+    QObject::connect(settings, &AngelfishSettings::dataSaverMaxImagesChanged, s_instance, updateBudget);
+    QObject::connect(settings, &AngelfishSettings::dataSaverMaxRequestsChanged, s_instance, updateBudget);
+
+    return s_instance;
+}
+
+bool DataSaver::enabled() const
+{
+    return m_enabled;
+}
+
+void DataSaver::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+    m_enabled = enabled;
+    m_pages.clear();
+    m_startedPages.clear();
+    emit enabledChanged();
+}
+
+DataSaver::Budget DataSaver::budget() const
+{
+    return m_budget;
+}
+
+void DataSaver::setBudget(const Budget &budget)
+{
+    m_budget = budget;
+}
+
+void DataSaver::startPage(const QUrl &pageUrl)
+{
+    if (!m_enabled)
+        return;
+
+    PageState state;
+    state.exempt = m_exemptPages.remove(pageUrl);
+    m_pages.insert(pageUrl, state);
+
+    // Redirects and downloads are requested like pages, but never shown.
+    // Only the latest pages that aren't shown yet keep their counters.
+    if (!isShown(pageUrl)) {
+        m_startedPages.removeOne(pageUrl);
+        m_startedPages.append(pageUrl);
+        if (m_startedPages.size() > MAX_STARTED_PAGES)
+            releasePage(m_startedPages.takeFirst());
+    }
+    emit pageStatisticsChanged(pageUrl);
+}
+
+void DataSaver::showPage(QObject *view, const QUrl &pageUrl)
+{
+    if (!view)
+        return;
+
+    auto viewPage = m_viewPages.find(view);
+    if (viewPage == m_viewPages.end()) {
+        viewPage = m_viewPages.insert(view, QUrl());
+        connect(view, &QObject::destroyed, this, [this, view] {
+            releasePage(m_viewPages.take(view));
+        });
+    }
+
+    const QUrl previousUrl = *viewPage;
+    *viewPage = pageUrl;
+    m_startedPages.removeOne(pageUrl);
+    if (previousUrl != pageUrl)
+        releasePage(previousUrl);
+}
+
+void DataSaver::releasePage(const QUrl &pageUrl)
+{
+    if (isShown(pageUrl) || m_startedPages.contains(pageUrl))
+        return;
+    m_pages.remove(pageUrl);
+}
+
+bool DataSaver::isShown(const QUrl &pageUrl) const
+{
+    return std::find(m_viewPages.cbegin(), m_viewPages.cend(), pageUrl) != m_viewPages.cend();
+}
+
+bool DataSaver::allowRequest(const QUrl &pageUrl, const QUrl &url, AdblockFilter::ResourceType type)
+{
+    if (!m_enabled)
+        return true;
+
+    // Pages which started loading before the data saver was enabled are
+    // counted from now on. Requests of pages no view shows can only be
+    // checked against the resource types, their counters would never be
+    // released.
+    auto found = m_pages.find(pageUrl);
+    if (found == m_pages.end() && isShown(pageUrl))
+        found = m_pages.insert(pageUrl, {});
+    PageState untracked;
+    PageState &page = found != m_pages.end() ? *found : untracked;
+    if (page.exempt)
+        return true;
+
+    bool allowed = true;
+    int *blockedCounter = nullptr;
+
+    switch (type) {
+    case AdblockFilter::Media:
+        allowed = !m_budget.blockMedia;
+        blockedCounter = &page.blockedMedia;
+        break;
+    case AdblockFilter::Font:
+        allowed = !m_budget.blockFonts;
+        blockedCounter = &page.blockedFonts;
+        break;
+    case AdblockFilter::Script:
+        if (m_budget.blockThirdPartyScripts)
+            allowed = UrlUtils::urlRegistrableDomain(url.toString()) == UrlUtils::urlRegistrableDomain(pageUrl.toString());
+        blockedCounter = &page.blockedScripts;
+        break;
+    case AdblockFilter::Image:
+        allowed = m_budget.maxImages < 0 || page.images < m_budget.maxImages;
+        blockedCounter = &page.blockedImages;
+        break;
+    default:
+        break;
+    }
+
+    // pages without their stylesheets are hardly usable, so they don't count
+    if (allowed && type != AdblockFilter::Stylesheet)
+        allowed = m_budget.maxRequests < 0 || page.requests < m_budget.maxRequests;
+
+    if (!allowed) {
+        page.blocked++;
+        if (blockedCounter)
+            (*blockedCounter)++;
+        emit pageStatisticsChanged(pageUrl);
+        return false;
+    }
+
+    if (type != AdblockFilter::Stylesheet)
+        page.requests++;
+    if (type == AdblockFilter::Image)
+        page.images++;
+    return true;
+}
+
+QVariantMap DataSaver::pageStatistics(const QUrl &pageUrl) const
+{
+    const PageState page = m_pages.value(pageUrl);
+    return {
+        {QStringLiteral("requests"), page.requests},
+        {QStringLiteral("blocked"), page.blocked},
+        {QStringLiteral("blockedImages"), page.blockedImages},
+        {QStringLiteral("blockedMedia"), page.blockedMedia},
+        {QStringLiteral("blockedFonts"), page.blockedFonts},
+        {QStringLiteral("blockedScripts"), page.blockedScripts},
+    };
+}
+
+void DataSaver::allowPage(const QUrl &pageUrl)
+{
+    m_exemptPages.insert(pageUrl);
+}
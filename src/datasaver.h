@@ -0,0 +1,106 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef DATASAVER_H
+#define DATASAVER_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QUrl>
+#include <QVariantMap>
+#include <QVector>
+
+#include "adblockfilter.h"
+
+/**
+ * @class DataSaver
+ * @short Limits the resources a page may load on metered connections.
+ *
+ * Media, fonts and third-party scripts can be blocked entirely, and the
+ * number of images and of requests in total is limited per page. Blocked
+ * resources can be loaded on demand by allowing the page and reloading it.
+ *
+ * The sizes of the responses are not known when a request is intercepted, so
+ * the budgets count requests and not bytes.
+ */
+class DataSaver : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+
+public:
+    struct Budget {
+        bool blockMedia = true;
+        bool blockFonts = true;
+        bool blockThirdPartyScripts = true;
+        // images per page, -1 for no limit
+        int maxImages = 10;
+        // requests per page, not counting stylesheets. -1 for no limit
+        int maxRequests = 100;
+    };
+
+    explicit DataSaver(QObject *parent = nullptr);
+
+    // instance following the application settings
+    static DataSaver *instance();
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    Budget budget() const;
+    void setBudget(const Budget &budget);
+
+    // to be called when the main frame of a view requests a page
+    void startPage(const QUrl &pageUrl);
+    // the view shows the page now, the counters of a page are kept while a view shows it
+    Q_INVOKABLE void showPage(QObject *view, const QUrl &pageUrl);
+    // counts the request and decides whether it fits into the budget of the page
+    bool allowRequest(const QUrl &pageUrl, const QUrl &url, AdblockFilter::ResourceType type);
+
+    // counters of the page: requests, blocked, blockedImages, blockedMedia,
+    // blockedFonts and blockedScripts
+    Q_INVOKABLE QVariantMap pageStatistics(const QUrl &pageUrl) const;
+
+    // don't limit the next load of the page
+    Q_INVOKABLE void allowPage(const QUrl &pageUrl);
+
+signals:
+    void enabledChanged();
+    // only emitted when a request was blocked, the other counters change too often
+    void pageStatisticsChanged(const QUrl &pageUrl);
+
+private:
+    struct PageState {
+        bool exempt = false;
+        int requests = 0;
+        int images = 0;
+        int blocked = 0;
+        int blockedImages = 0;
+        int blockedMedia = 0;
+        int blockedFonts = 0;
+        int blockedScripts = 0;
+    };
+
+    // drops the counters of the page unless a view shows it or it has just been started
+    void releasePage(const QUrl &pageUrl);
+    bool isShown(const QUrl &pageUrl) const;
+
+    bool m_enabled = false;
+    Budget m_budget;
+    QHash<QUrl, PageState> m_pages;
+    QHash<QObject *, QUrl> m_viewPages;
+    // started pages no view shows yet, the latest last
+    QVector<QUrl> m_startedPages;
+    QSet<QUrl> m_exemptPages;
+
+    static DataSaver *s_instance;
+};
+
+#endif // DATASAVER_H
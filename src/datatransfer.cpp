@@ -0,0 +1,539 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "datatransfer.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QtConcurrent>
+
+#include "browsermanager.h"
+#include "dbmanager.h"
+#include "urlutils.h"
+
+// rows inserted per transaction, the browser can write in between
+constexpr int IMPORT_BATCH_SIZE = 5000;
+// seconds between 1601-01-01, the epoch of Chromium, and 1970-01-01
+constexpr qint64 CHROMIUM_EPOCH_OFFSET = 11644473600;
+
+DataTransfer *DataTransfer::s_instance = nullptr;
+
+namespace {
+struct Record {
+    bool bookmark = false;
+    QString url;
+    QString title;
+    qint64 lastVisited = 0;
+};
+
+// only passes on changes of at least a percent, to not flood the receiver
+class ProgressReporter
+{
+public:
+    explicit ProgressReporter(const DataTransfer::Progress &progress)
+        : m_progress(progress)
+    {
+    }
+
+    void report(qreal value)
+    {
+        const int percent = qBound(0, int(value * 100), 100);
+        if (!m_progress || percent == m_percent)
+            return;
+        m_percent = percent;
+        m_progress(percent / 100.0);
+    }
+
+private:
+    DataTransfer::Progress m_progress;
+    int m_percent = -1;
+};
+
+// Inserts records in batches, keeping the latest visit of known urls
+class RecordWriter
+{
+public:
+    explicit RecordWriter(QSqlDatabase &database)
+        : m_database(database)
+        , m_history(database)
+        , m_bookmarks(database)
+    {
+        const QString insert = QStringLiteral(
+            "INSERT INTO %1 (url, title, lastVisited, host, domain, displayPath%2) "
+            "VALUES (:url, :title, :lastVisited, :host, :domain, :displayPath%3) "
+            "ON CONFLICT(url) DO UPDATE SET lastVisited = MAX(lastVisited, excluded.lastVisited)");
+        // new history entries are marked, so trimming the history keeps them
+        DBManager::prepare(m_history, insert.arg(QStringLiteral("history"), QStringLiteral(", imported"), QStringLiteral(", 1")));
+        DBManager::prepare(m_bookmarks, insert.arg(QStringLiteral("bookmarks"), QString(), QString()));
+    }
+
+    bool add(const Record &record)
+    {
+        if (!m_inTransaction) {
+            if (!m_database.transaction()) {
+                m_error = m_database.lastError().text();
+                return false;
+            }
+            m_inTransaction = true;
+        }
+
+        QSqlQuery &query = record.bookmark ? m_bookmarks : m_history;
+        query.bindValue(QStringLiteral(":url"), record.url);
+        query.bindValue(QStringLiteral(":title"), record.title);
+        query.bindValue(QStringLiteral(":lastVisited"), record.lastVisited);
+        query.bindValue(QStringLiteral(":host"), UrlUtils::urlNormalizedHost(record.url));
+        query.bindValue(QStringLiteral(":domain"), UrlUtils::urlRegistrableDomain(record.url));
+        query.bindValue(QStringLiteral(":displayPath"), UrlUtils::urlDisplayPath(record.url));
+        if (!DBManager::execute(query)) {
+            m_error = query.lastError().text();
+            m_database.rollback();
+            m_inTransaction = false;
+            return false;
+        }
+
+        (record.bookmark ? m_bookmarkCount : m_historyCount)++;
+        if (++m_batch == IMPORT_BATCH_SIZE)
+            return commit();
+        return true;
+    }
+
+    bool commit()
+    {
+        m_batch = 0;
+        if (!m_inTransaction)
+            return true;
+
+        m_inTransaction = false;
+        if (!m_database.commit()) {
+            m_error = m_database.lastError().text();
+            return false;
+        }
+        m_committedHistory = m_historyCount;
+        m_committedBookmarks = m_bookmarkCount;
+        return true;
+    }
+
+    // only counts what has been committed
+    DataTransfer::Result result() const
+    {
+        DataTransfer::Result result;
+        result.count = m_committedHistory + m_committedBookmarks;
+        result.error = m_error;
+        result.historyChanged = m_committedHistory > 0;
+        result.bookmarksChanged = m_committedBookmarks > 0;
+        return result;
+    }
+
+private:
+    QSqlDatabase &m_database;
+    QSqlQuery m_history;
+    QSqlQuery m_bookmarks;
+    bool m_inTransaction = false;
+    int m_batch = 0;
+    int m_historyCount = 0;
+    int m_bookmarkCount = 0;
+    int m_committedHistory = 0;
+    int m_committedBookmarks = 0;
+    QString m_error;
+};
+
+using RecordSink = std::function<bool(const Record &)>;
+
+bool isImportable(const QString &url)
+{
+    // leaves out internal pages of other browsers, like place: or chrome:
+    return url.startsWith(QLatin1String("https:")) || url.startsWith(QLatin1String("http:"))
+        || url.startsWith(QLatin1String("ftp:")) || url.startsWith(QLatin1String("file:"));
+}
+
+QString unescapeHtml(QString text)
+{
+    text.replace(QLatin1String("&lt;"), QLatin1String("<"));
+    text.replace(QLatin1String("&gt;"), QLatin1String(">"));
+    text.replace(QLatin1String("&quot;"), QLatin1String("\""));
+    text.replace(QLatin1String("&#39;"), QLatin1String("'"));
+    text.replace(QLatin1String("&#x27;"), QLatin1String("'"));
+    // last, so that "&amp;lt;" stays "&lt;"
+    text.replace(QLatin1String("&amp;"), QLatin1String("&"));
+    return text;
+}
+
+// Calls read with each line of the file, reporting the progress by position
+QString readLines(const QString &path, ProgressReporter &progress, const std::function<bool(const QByteArray &)> &read)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return file.errorString();
+
+    const qint64 size = qMax(file.size(), qint64(1));
+    while (!file.atEnd()) {
+        if (!read(file.readLine()))
+            return QString();
+        progress.report(qreal(file.pos()) / size);
+    }
+    return QString();
+}
+
+QString readNetscapeBookmarks(const QString &path, ProgressReporter &progress, const RecordSink &sink)
+{
+    // <DT><A HREF="https://kde.org/" ADD_DATE="1600000000" ...>KDE</A>
+    static const QRegularExpression link(QStringLiteral("<A\\s([^>]*)>(.*)</A>"), QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression href(QStringLiteral("\\bHREF=\"([^\"]*)\""), QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression date(QStringLiteral("\\b(?:LAST_VISIT|ADD_DATE)=\"(\\d+)\""), QRegularExpression::CaseInsensitiveOption);
+
+    return readLines(path, progress, [&sink](const QByteArray &data) {
+        const QString line = QString::fromUtf8(data);
+        const auto linkMatch = link.match(line);
+        if (!linkMatch.hasMatch())
+            return true;
+
+        const QString attributes = linkMatch.captured(1);
+        Record record;
+        record.bookmark = true;
+        record.url = unescapeHtml(href.match(attributes).captured(1));
+        record.title = unescapeHtml(linkMatch.captured(2));
+        // the last visit if known, the date of adding otherwise
+        auto dates = date.globalMatch(attributes);
+        while (dates.hasNext())
+            record.lastVisited = qMax(record.lastVisited, dates.next().captured(1).toLongLong());
+
+        return !isImportable(record.url) || sink(record);
+    });
+}
+
+QString readJsonLines(const QString &path, ProgressReporter &progress, const RecordSink &sink)
+{
+    int lineNumber = 0;
+    QString error;
+    const QString readError = readLines(path, progress, [&](const QByteArray &line) {
+        lineNumber++;
+        if (line.trimmed().isEmpty())
+            return true;
+
+        QJsonParseError parseError;
+        const QJsonObject object = QJsonDocument::fromJson(line, &parseError).object();
+        if (parseError.error != QJsonParseError::NoError) {
+            error = QStringLiteral("Line %1: %2").arg(lineNumber).arg(parseError.errorString());
+            return false;
+        }
+
+        Record record;
+        record.bookmark = object.value(QStringLiteral("type")).toString() == QStringLiteral("bookmark");
+        record.url = object.value(QStringLiteral("url")).toString();
+        record.title = object.value(QStringLiteral("title")).toString();
+        record.lastVisited = qint64(object.value(QStringLiteral("lastVisited")).toDouble());
+        return !isImportable(record.url) || sink(record);
+    });
+    return readError.isEmpty() ? error : readError;
+}
+
+// Reads the history of another browser, sql selects url, title and the
+// last visit, which toSeconds converts
+QString readHistoryDatabase(const QString &path,
+                            const QString &countSql,
+                            const QString &sql,
+                            const std::function<qint64(qint64)> &toSeconds,
+                            ProgressReporter &progress,
+                            const RecordSink &sink)
+{
+    if (!QFile::exists(path))
+        return QStringLiteral("%1 does not exist").arg(path);
+
+    QString error;
+    const bool opened = DBManager::withConnection(
+        path,
+        [&](QSqlDatabase &database) {
+            QSqlQuery count(database);
+            DBManager::prepare(count, countSql);
+            if (!DBManager::execute(count) || !count.next()) {
+                error = count.lastError().text();
+                return;
+            }
+            const qint64 total = qMax(count.value(0).toLongLong(), qint64(1));
+            count.finish();
+
+            QSqlQuery query(database);
+            query.setForwardOnly(true);
+            DBManager::prepare(query, sql);
+            if (!DBManager::execute(query)) {
+                error = query.lastError().text();
+                return;
+            }
+
+            qint64 read = 0;
+            while (query.next()) {
+                Record record;
+                record.url = query.value(0).toString();
+                record.title = query.value(1).toString();
+                record.lastVisited = toSeconds(query.value(2).toLongLong());
+                if (isImportable(record.url) && !sink(record))
+                    break;
+                progress.report(qreal(++read) / total);
+            }
+            if (query.lastError().isValid())
+                error = query.lastError().text();
+        },
+        true);
+    return opened ? error : QStringLiteral("Could not open %1").arg(path);
+}
+
+QString readRecords(const QString &path, DataTransfer::Format format, ProgressReporter &progress, const RecordSink &sink)
+{
+    switch (format) {
+    case DataTransfer::NetscapeBookmarks:
+        return readNetscapeBookmarks(path, progress, sink);
+    case DataTransfer::JsonLines:
+        return readJsonLines(path, progress, sink);
+    case DataTransfer::FirefoxHistory:
+        // in microseconds since the epoch
+        return readHistoryDatabase(path,
+                                   QStringLiteral("SELECT COUNT(*) FROM moz_places WHERE last_visit_date IS NOT NULL"),
+                                   QStringLiteral("SELECT url, title, last_visit_date FROM moz_places WHERE last_visit_date IS NOT NULL"),
+                                   [](qint64 time) {
+                                       return time / 1000000;
+                                   },
+                                   progress,
+                                   sink);
+    case DataTransfer::ChromiumHistory:
+        // in microseconds since 1601
+        return readHistoryDatabase(path,
+                                   QStringLiteral("SELECT COUNT(*) FROM urls WHERE hidden = 0"),
+                                   QStringLiteral("SELECT url, title, last_visit_time FROM urls WHERE hidden = 0"),
+                                   [](qint64 time) {
+                                       return time / 1000000 - CHROMIUM_EPOCH_OFFSET;
+                                   },
+                                   progress,
+                                   sink);
+    }
+    return QStringLiteral("Unknown format");
+}
+
+QString writeNetscapeBookmarks(QSqlDatabase &database, QIODevice &file, ProgressReporter &progress, qint64 total, int &count)
+{
+    file.write("<!DOCTYPE NETSCAPE-Bookmark-file-1>\n"
+               "<META HTTP-EQUIV=\"Content-Type\" CONTENT=\"text/html; charset=UTF-8\">\n"
+               "<TITLE>Bookmarks</TITLE>\n"
+               "<H1>Bookmarks</H1>\n"
+               "<DL><p>\n");
+
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    DBManager::prepare(query, QStringLiteral("SELECT url, title, lastVisited FROM bookmarks"));
+    if (!DBManager::execute(query))
+        return query.lastError().text();
+
+    while (query.next()) {
+        const QString line = QStringLiteral("    <DT><A HREF=\"%1\" ADD_DATE=\"%2\">%3</A>\n")
+                                 .arg(query.value(0).toString().toHtmlEscaped(), query.value(2).toString(), query.value(1).toString().toHtmlEscaped());
+        file.write(line.toUtf8());
+        progress.report(qreal(++count) / total);
+    }
+
+    file.write("</DL><p>\n");
+    return QString();
+}
+
+QString writeJsonLines(QSqlDatabase &database, QIODevice &file, ProgressReporter &progress, qint64 total, int &count)
+{
+    const QStringList tables = {QStringLiteral("bookmarks"), QStringLiteral("history")};
+    for (const QString &table : tables) {
+        const QString type = table == QStringLiteral("bookmarks") ? QStringLiteral("bookmark") : QStringLiteral("history");
+
+        QSqlQuery query(database);
+        query.setForwardOnly(true);
+        DBManager::prepare(query, QStringLiteral("SELECT url, title, lastVisited FROM %1").arg(table));
+        if (!DBManager::execute(query))
+            return query.lastError().text();
+
+        while (query.next()) {
+            const QJsonObject object = {
+                {QStringLiteral("type"), type},
+                {QStringLiteral("url"), query.value(0).toString()},
+                {QStringLiteral("title"), query.value(1).toString()},
+                {QStringLiteral("lastVisited"), query.value(2).toLongLong()},
+            };
+            file.write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+            file.write("\n");
+            progress.report(qreal(++count) / total);
+        }
+    }
+    return QString();
+}
+}
+
+DataTransfer::DataTransfer(const QString &databaseFile, QObject *parent)
+    : QObject(parent)
+    , m_databaseFile(databaseFile)
+{
+    connect(&m_worker, &QFutureWatcher<Result>::finished, this, [this] {
+        const Result result = m_worker.result();
+        // one notification per table for the whole file
+        if (result.historyChanged)
+            emit tableChanged(QStringLiteral("history"));
+        if (result.bookmarksChanged)
+            emit tableChanged(QStringLiteral("bookmarks"));
+
+        if (!result.error.isEmpty())
+            qWarning() << Q_FUNC_INFO << result.error;
+
+        setProgress(1);
+        emit runningChanged();
+        emit finished(result.count, result.error);
+    });
+}
+
+DataTransfer::~DataTransfer()
+{
+    m_worker.waitForFinished();
+}
+
+DataTransfer *DataTransfer::instance()
+{
+    if (s_instance)
+        return s_instance;
+
+    BrowserManager *browserManager = BrowserManager::instance();
+    s_instance = new DataTransfer(browserManager->databaseFile());
+    connect(s_instance, &DataTransfer::tableChanged, browserManager, &BrowserManager::announceChanges);
+    return s_instance;
+}
+
+bool DataTransfer::running() const
+{
+    return m_worker.isRunning();
+}
+
+qreal DataTransfer::progress() const
+{
+    return m_progress;
+}
+
+void DataTransfer::importFile(const QUrl &file, Format format)
+{
+    const QString databaseFile = m_databaseFile;
+    const QString path = file.toLocalFile();
+    start([databaseFile, path, format](const Progress &progress) {
+        return importFromFile(databaseFile, path, format, progress);
+    });
+}
+
+void DataTransfer::exportFile(const QUrl &file, Format format)
+{
+    const QString databaseFile = m_databaseFile;
+    const QString path = file.toLocalFile();
+    start([databaseFile, path, format](const Progress &progress) {
+        return exportToFile(databaseFile, path, format, progress);
+    });
+}
+
+DataTransfer::Result DataTransfer::importFromFile(const QString &databaseFile, const QString &path, Format format, const Progress &progress)
+{
+    Result result;
+    const bool opened = DBManager::withConnection(databaseFile, [&](QSqlDatabase &database) {
+        ProgressReporter reporter(progress);
+        RecordWriter writer(database);
+        const QString error = readRecords(path, format, reporter, [&writer](const Record &record) {
+            return writer.add(record);
+        });
+        writer.commit();
+
+        result = writer.result();
+        if (result.error.isEmpty())
+            result.error = error;
+    });
+    if (!opened)
+        return {0, QStringLiteral("Could not open %1").arg(databaseFile)};
+    return result;
+}
+
+DataTransfer::Result DataTransfer::exportToFile(const QString &databaseFile, const QString &path, Format format, const Progress &progress)
+{
+    if (format != NetscapeBookmarks && format != JsonLines)
+        return {0, QStringLiteral("Exporting to this format is not supported")};
+
+    Result result;
+    const bool opened = DBManager::withConnection(
+        databaseFile,
+        [&](QSqlDatabase &database) {
+            const QString countSql = format == NetscapeBookmarks
+                ? QStringLiteral("SELECT COUNT(*) FROM bookmarks")
+                : QStringLiteral("SELECT (SELECT COUNT(*) FROM bookmarks) + (SELECT COUNT(*) FROM history)");
+            QSqlQuery count(database);
+            DBManager::prepare(count, countSql);
+            if (!DBManager::execute(count) || !count.next()) {
+                result.error = count.lastError().text();
+                return;
+            }
+            const qint64 total = qMax(count.value(0).toLongLong(), qint64(1));
+            count.finish();
+
+            // only replaces an existing file once everything has been written
+            QSaveFile file(path);
+            if (!file.open(QIODevice::WriteOnly)) {
+                result.error = file.errorString();
+                return;
+            }
+
+            // a consistent snapshot of both tables
+            database.transaction();
+            ProgressReporter reporter(progress);
+            int written = 0;
+            const QString error = format == NetscapeBookmarks ? writeNetscapeBookmarks(database, file, reporter, total, written)
+                                                              : writeJsonLines(database, file, reporter, total, written);
+            database.rollback();
+
+            if (!error.isEmpty()) {
+                file.cancelWriting();
+                result.error = error;
+            } else if (!file.commit()) {
+                result.error = file.errorString();
+            } else {
+                result.count = written;
+            }
+        },
+        true);
+    if (!opened)
+        return {0, QStringLiteral("Could not open %1").arg(databaseFile)};
+    return result;
+}
+
+void DataTransfer::start(const std::function<Result(const Progress &)> &transfer)
+{
+    if (m_worker.isRunning())
+        return;
+
+    setProgress(0);
+    // the worker is waited for in the destructor, so this outlives it
+    const Progress progress = [this](qreal value) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, value] {
+                setProgress(value);
+            },
+            Qt::QueuedConnection);
+    };
+    m_worker.setFuture(QtConcurrent::run([transfer, progress] {
+        return transfer(progress);
+    }));
+    emit runningChanged();
+}
+
+void DataTransfer::setProgress(qreal progress)
+{
+    if (m_progress == progress)
+        return;
+    m_progress = progress;
+    emit progressChanged();
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef DATATRANSFER_H
+#define DATATRANSFER_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QUrl>
+
+#include <functional>
+
+/**
+ * @class DataTransfer
+ * @short Imports and exports history and bookmarks.
+ *
+ * Files are read and written in a worker thread using a database connection
+ * of its own, one line or row at a time, so the memory needed does not grow
+ * with the size of the file. Imported entries are inserted with a prepared
+ * statement in transactions of a few thousand rows, so that the browser can
+ * still write to the database in between. Entries already known keep the
+ * most recent visit.
+ *
+ * The history databases of Firefox and Chromium can only be read while the
+ * browser owning them is closed.
+ */
+class DataTransfer : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+    // from 0 to 1 while running
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+
+public:
+    enum Format {
+        // bookmarks.html as written by most browsers, bookmarks only
+        NetscapeBookmarks,
+        // one object with type, url, title and lastVisited per line
+        JsonLines,
+        // places.sqlite of a Firefox profile, import only
+        FirefoxHistory,
+        // History database of a Chromium profile, import only
+        ChromiumHistory,
+    };
+    Q_ENUM(Format)
+
+    struct Result {
+        // entries imported or exported
+        int count = 0;
+        // empty on success
+        QString error;
+        bool historyChanged = false;
+        bool bookmarksChanged = false;
+    };
+
+    using Progress = std::function<void(qreal)>;
+
+    explicit DataTransfer(const QString &databaseFile, QObject *parent = nullptr);
+    ~DataTransfer() override;
+
+    // instance using the database of the browser
+    static DataTransfer *instance();
+
+    bool running() const;
+    qreal progress() const;
+
+    // both do nothing while a transfer is running
+    Q_INVOKABLE void importFile(const QUrl &file, Format format);
+    Q_INVOKABLE void exportFile(const QUrl &file, Format format);
+
+    // carry out a transfer in the calling thread
+    static Result importFromFile(const QString &databaseFile, const QString &path, Format format, const Progress &progress = {});
+    static Result exportToFile(const QString &databaseFile, const QString &path, Format format, const Progress &progress = {});
+
+signals:
+    void runningChanged();
+    void progressChanged();
+    void finished(int count, const QString &error);
+    // emitted for history and bookmarks after entries have been imported
+    void tableChanged(const QString &table);
+
+private:
+    void start(const std::function<Result(const Progress &)> &transfer);
+    void setProgress(qreal progress);
+
+    QString m_databaseFile;
+    QFutureWatcher<Result> m_worker;
+    qreal m_progress = 0;
+
+    static DataTransfer *s_instance;
+};
+
+#endif // DATATRANSFER_H
@@ -8,27 +8,74 @@
  ***************************************************************************/
 
 #include "dbmanager.h"
+#include "hostmatcher.h"
 #include "iconimageprovider.h"
+#include "metrics.h"
+#include "tracer.h"
+#include "urlutils.h"
 
+#include <QCoreApplication>
 #include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QRegularExpression>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QStandardPaths>
+#include <QThread>
 #include <QVariant>
 #include <QDir>
 
+#include <atomic>
 #include <exception>
+#include <memory>
 
-constexpr int DB_USER_VERSION = 1;
+constexpr int DB_USER_VERSION = 12;
+// entries visited in this browser kept in the history, imported ones don't count
 constexpr int MAX_BROWSER_HISTORY_SIZE = 3000;
 
+// ms SQLite waits for a lock held by another process
+constexpr int BUSY_TIMEOUT = 2000;
+// statements of worker threads still failing with a busy database afterwards
+// are retried with an increasing delay, starting at BUSY_RETRY_DELAY ms
+constexpr int BUSY_RETRIES = 3;
+constexpr int BUSY_RETRY_DELAY = 50;
+// ms to collect the writes of other processes before announcing them
+constexpr int EXTERNAL_CHANGE_DELAY = 100;
+// seconds page timings are kept after their last update
+constexpr qint64 MAX_PAGE_TIMING_AGE = 90 * 24 * 60 * 60;
+// history entries removed per statement while clearing a time range
+constexpr int CLEAR_BATCH_SIZE = 200;
+
+// icons no longer referenced by any bookmark or history entry. Unlike
+// NOT IN, this still works when some entries have no icon.
+constexpr char DELETE_UNUSED_ICONS[] = "DELETE FROM icons WHERE "
+                                       "NOT EXISTS (SELECT 1 FROM history WHERE history.icon = icons.url) AND "
+                                       "NOT EXISTS (SELECT 1 FROM bookmarks WHERE bookmarks.icon = icons.url)";
+
+// notified of every statement prepared or reused, see setStatementObserver
+static std::function<void(const QString &)> s_statementObserver;
+
+// tables whose changes are announced with databaseTableChanged
+static const QStringList ANNOUNCED_TABLES = {
+    QStringLiteral("bookmarks"),
+    QStringLiteral("history"),
+    QStringLiteral("useragentrules"),
+    QStringLiteral("snapshots"),
+    QStringLiteral("pagetimings"),
+};
+
 DBManager::DBManager(QObject *parent)
     : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
 {
     const QString dbpath = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
     const QString dbname = dbpath + QStringLiteral("/angelfish.sqlite");
+    m_databaseFile = dbname;
 
     if (!QDir().mkpath(dbpath)) {
         qCritical() << "Database directory does not exist and cannot be created: " << dbpath;
@@ -37,18 +84,47 @@ DBManager::DBManager(QObject *parent)
 
     QSqlDatabase database = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"));
     database.setDatabaseName(dbname);
+    database.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=%1").arg(BUSY_TIMEOUT));
     if (!database.open()) {
         qCritical() << "Failed to open database" << dbname;
         throw std::runtime_error("Failed to open database " + dbname.toStdString());
     }
 
+    // Several processes use the database. With a write-ahead log, readers
+    // don't block the writer and the other way round.
+    execute(QStringLiteral("PRAGMA journal_mode = WAL"));
+    execute(QStringLiteral("PRAGMA synchronous = NORMAL"));
+
     if (!migrate()) {
         qCritical() << "Failed to initialize or migrate the schema in" << dbname;
         throw std::runtime_error("Failed to initialize or migrate the schema in " + dbname.toStdString());
     }
 
-    trimHistory();
-    trimIcons();
+    // Writes of other processes change the files of the database. Changes
+    // committed by this connection don't change the data version.
+    m_dataVersion = dataVersion();
+    m_changeTimer.setSingleShot(true);
+    m_changeTimer.setInterval(EXTERNAL_CHANGE_DELAY);
+    connect(&m_changeTimer, &QTimer::timeout, this, &DBManager::checkExternalChanges);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, [this] {
+        watchDatabaseFiles();
+        m_changeTimer.start();
+    });
+    // the log is created again after the last connection closed it
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &DBManager::watchDatabaseFiles);
+    m_watcher->addPath(dbpath);
+    watchDatabaseFiles();
+}
+
+DBManager::~DBManager()
+{
+    if (m_maintenance) {
+        m_maintenance->wait();
+        delete m_maintenance;
+    }
+
+    // the statements have to be gone before the connection
+    m_statements.clear();
 }
 
 int DBManager::version()
@@ -70,30 +146,129 @@ void DBManager::setVersion(int v)
     query.exec();
 }
 
+bool DBManager::prepare(QSqlQuery &query, const QString &sql)
+{
+    if (s_statementObserver)
+        s_statementObserver(sql);
+    return query.prepare(sql);
+}
+
+void DBManager::setStatementObserver(const std::function<void(const QString &)> &observer)
+{
+    s_statementObserver = observer;
+}
+
 bool DBManager::execute(const QString &command)
 {
     QSqlQuery query;
-    if (!query.exec(command)) {
-        qWarning() << Q_FUNC_INFO << "Failed to execute SQL statement";
-        qWarning() << query.lastQuery();
-        qWarning() << query.lastError();
-        return false;
-    }
-    return true;
+    prepare(query, command);
+    return execute(query);
 }
 
 bool DBManager::execute(QSqlQuery &query)
 {
-    if (!query.exec()) {
+    TraceScope trace("SQL", "sql");
+    if (trace.active())
+        trace.setArgument(query.lastQuery());
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int attempt = 0;; attempt++) {
+        if (query.exec()) {
+            Metrics::instance()->add(QStringLiteral("sql.statements"));
+            Metrics::instance()->record(QStringLiteral("sql.latency_us"), timer.nsecsElapsed() / 1000);
+            return true;
+        }
+
+        // SQLITE_BUSY or SQLITE_LOCKED, the lock may be released in a moment.
+        // The GUI thread must not sleep, there the busy timeout has to do.
+        const QString code = query.lastError().nativeErrorCode();
+        const bool guiThread = QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread();
+        if (!guiThread && attempt < BUSY_RETRIES && (code == QLatin1String("5") || code == QLatin1String("6"))) {
+            QThread::msleep(BUSY_RETRY_DELAY << attempt);
+            continue;
+        }
+
         qWarning() << Q_FUNC_INFO << "Failed to execute SQL statement";
         qWarning() << query.lastQuery();
         qWarning() << query.lastError();
+        Metrics::instance()->add(QStringLiteral("sql.errors"));
         return false;
     }
-    return true;
+}
+
+QSqlQuery &DBManager::statement(const QString &sql) const
+{
+    auto it = m_statements.find(sql);
+    if (it != m_statements.end()) {
+        if (s_statementObserver)
+            s_statementObserver(sql);
+        return *it;
+    }
+
+    it = m_statements.insert(sql, QSqlQuery());
+    if (!prepare(*it, sql)) {
+        qWarning() << Q_FUNC_INFO << "Failed to prepare SQL statement";
+        qWarning() << sql;
+        qWarning() << it->lastError();
+        // prepare again next time, the failed query fails to execute
+        m_invalidStatement = *it;
+        m_statements.erase(it);
+        return m_invalidStatement;
+    }
+    return *it;
+}
+
+qint64 DBManager::dataVersion() const
+{
+    QSqlQuery &query = statement(QStringLiteral("PRAGMA data_version"));
+    qint64 version = -1;
+    if (execute(query) && query.next())
+        version = query.value(0).toLongLong();
+    query.finish();
+    return version;
+}
+
+void DBManager::watchDatabaseFiles()
+{
+    const QStringList files = {m_databaseFile, m_databaseFile + QStringLiteral("-wal")};
+    for (const QString &file : files) {
+        if (!m_watcher->files().contains(file) && QFile::exists(file))
+            m_watcher->addPath(file);
+    }
+}
+
+void DBManager::checkExternalChanges()
+{
+    const qint64 version = dataVersion();
+    if (version < 0 || version == m_dataVersion)
+        return;
+
+    m_dataVersion = version;
+    // which tables changed is not known, views requery what they show
+    for (const QString &table : ANNOUNCED_TABLES)
+        emit databaseTableChanged(table);
 }
 
 bool DBManager::migrate()
+{
+    if (version() == DB_USER_VERSION)
+        return true;
+
+    // Another process may be migrating at the same time. The version is
+    // read again after taking the write lock, and a failed step leaves
+    // the schema untouched.
+    if (!execute(QStringLiteral("BEGIN IMMEDIATE")))
+        return false;
+
+    if (!migrateSteps()) {
+        execute(QStringLiteral("ROLLBACK"));
+        return false;
+    }
+    return execute(QStringLiteral("COMMIT"));
+}
+
+bool DBManager::migrateSteps()
 {
     for (int v = version(); v != DB_USER_VERSION; v = version()) {
         if (v < 0 || v > DB_USER_VERSION) {
@@ -105,6 +280,61 @@ bool DBManager::migrate()
             if (!migrateTo1())
                 return false;
         }
+
+        if (v == 1) {
+            if (!migrateTo2())
+                return false;
+        }
+
+        if (v == 2) {
+            if (!migrateTo3())
+                return false;
+        }
+
+        if (v == 3) {
+            if (!migrateTo4())
+                return false;
+        }
+
+        if (v == 4) {
+            if (!migrateTo5())
+                return false;
+        }
+
+        if (v == 5) {
+            if (!migrateTo6())
+                return false;
+        }
+
+        if (v == 6) {
+            if (!migrateTo7())
+                return false;
+        }
+
+        if (v == 7) {
+            if (!migrateTo8())
+                return false;
+        }
+
+        if (v == 8) {
+            if (!migrateTo9())
+                return false;
+        }
+
+        if (v == 9) {
+            if (!migrateTo10())
+                return false;
+        }
+
+        if (v == 10) {
+            if (!migrateTo11())
+                return false;
+        }
+
+        if (v == 11) {
+            if (!migrateTo12())
+                return false;
+        }
     }
     return true;
 }
@@ -126,18 +356,283 @@ bool DBManager::migrateTo1()
     return true;
 }
 
-void DBManager::trimHistory()
+bool DBManager::migrateTo2()
+{
+    // Store normalized host, registrable domain and display path next to the url,
+    // so views can show and group entries without parsing urls
+    const QStringList tables = { QStringLiteral("bookmarks"), QStringLiteral("history") };
+
+    for (const QString &table : tables) {
+        if (!execute(QStringLiteral("ALTER TABLE %1 ADD COLUMN host TEXT").arg(table))
+            || !execute(QStringLiteral("ALTER TABLE %1 ADD COLUMN domain TEXT").arg(table))
+            || !execute(QStringLiteral("ALTER TABLE %1 ADD COLUMN displayPath TEXT").arg(table))
+            || !execute(QStringLiteral("CREATE INDEX idx_%1_host ON %1(host)").arg(table))
+            || !execute(QStringLiteral("CREATE INDEX idx_%1_domain ON %1(domain)").arg(table))) {
+            return false;
+        }
+
+        // fill in the new columns for the existing records
+        QSqlQuery records(QStringLiteral("SELECT rowid, url FROM %1").arg(table));
+        QSqlQuery update;
+        update.prepare(QStringLiteral("UPDATE %1 SET host = :host, domain = :domain, displayPath = :displayPath "
+                                      "WHERE rowid = :rowid")
+                           .arg(table));
+        while (records.next()) {
+            const QString url = records.value(1).toString();
+            update.bindValue(QStringLiteral(":host"), UrlUtils::urlNormalizedHost(url));
+            update.bindValue(QStringLiteral(":domain"), UrlUtils::urlRegistrableDomain(url));
+            update.bindValue(QStringLiteral(":displayPath"), UrlUtils::urlDisplayPath(url));
+            update.bindValue(QStringLiteral(":rowid"), records.value(0));
+            if (!execute(update))
+                return false;
+        }
+    }
+
+    setVersion(2);
+    qDebug() << "Migrated database schema to version 2";
+    return true;
+}
+
+bool DBManager::migrateTo3()
 {
-    execute(QStringLiteral("DELETE FROM history WHERE rowid NOT IN (SELECT rowid FROM history"
-                           " ORDER BY lastVisited DESC LIMIT %1)")
-                .arg(MAX_BROWSER_HISTORY_SIZE));
+    // Per-site user agent rules. Mode is one of UserAgentRules::Mode, userAgent
+    // is only used for custom agents.
+    const QString rules = QStringLiteral("CREATE TABLE useragentrules (pattern TEXT PRIMARY KEY, mode INT, userAgent TEXT)");
+    if (!execute(rules))
+        return false;
+
+    setVersion(3);
+    qDebug() << "Migrated database schema to version 3";
+    return true;
 }
 
-void DBManager::trimIcons()
+bool DBManager::migrateTo4()
 {
-    execute(
-        QStringLiteral("DELETE FROM icons WHERE url NOT IN "
-                       "(SELECT icon FROM history UNION SELECT icon FROM bookmarks)"));
+    // Offline snapshots of pages. The files are stored by the hash of their
+    // content, so urls with identical snapshots share a file.
+    const QString snapshots = QStringLiteral("CREATE TABLE snapshots (url TEXT PRIMARY KEY, hash TEXT NOT NULL, title TEXT, "
+                                             "size INT, created INT, lastAccessed INT)");
+    const QString idx_hash = QStringLiteral("CREATE INDEX idx_snapshots_hash ON snapshots(hash)");
+    const QString idx_lastAccessed = QStringLiteral("CREATE INDEX idx_snapshots_lastAccessed ON snapshots(lastAccessed)");
+    if (!execute(snapshots) || !execute(idx_hash) || !execute(idx_lastAccessed))
+        return false;
+
+    setVersion(4);
+    qDebug() << "Migrated database schema to version 4";
+    return true;
+}
+
+bool DBManager::migrateTo5()
+{
+    // Downloads that are kept across restarts. State is one of
+    // DownloadManager::State.
+    const QString downloads = QStringLiteral("CREATE TABLE downloads (id INTEGER PRIMARY KEY, url TEXT, path TEXT, mimeType TEXT, "
+                                             "receivedBytes INT, totalBytes INT, state INT, created INT)");
+    if (!execute(downloads))
+        return false;
+
+    setVersion(5);
+    qDebug() << "Migrated database schema to version 5";
+    return true;
+}
+
+bool DBManager::migrateTo6()
+{
+    // history is cleared by time range
+    if (!execute(QStringLiteral("CREATE INDEX idx_history_lastVisited ON history(lastVisited)")))
+        return false;
+
+    setVersion(6);
+    qDebug() << "Migrated database schema to version 6";
+    return true;
+}
+
+bool DBManager::migrateTo7()
+{
+    // unused icons are found by looking up the entries using them
+    if (!execute(QStringLiteral("CREATE INDEX idx_history_icon ON history(icon)"))
+        || !execute(QStringLiteral("CREATE INDEX idx_bookmarks_icon ON bookmarks(icon)")))
+        return false;
+
+    setVersion(7);
+    qDebug() << "Migrated database schema to version 7";
+    return true;
+}
+
+bool DBManager::migrateTo8()
+{
+    // histograms of page load timings per host, see SitePerformanceModel
+    const QString timings = QStringLiteral("CREATE TABLE pagetimings (host TEXT NOT NULL, metric INT NOT NULL, bucket INT NOT NULL, "
+                                           "count INT NOT NULL, lastSeen INT NOT NULL, PRIMARY KEY (host, metric, bucket)) WITHOUT ROWID");
+    const QString idx_lastSeen = QStringLiteral("CREATE INDEX idx_pagetimings_lastSeen ON pagetimings(lastSeen)");
+    if (!execute(timings) || !execute(idx_lastSeen))
+        return false;
+
+    setVersion(8);
+    qDebug() << "Migrated database schema to version 8";
+    return true;
+}
+
+bool DBManager::migrateTo9()
+{
+    // Text of visited pages for searching the history, see PageTextIndex.
+    // The text is looked up by the id of its entry in pagetextinfo, and
+    // removed together with the history entry.
+    const QString info = QStringLiteral("CREATE TABLE pagetextinfo (id INTEGER PRIMARY KEY, url TEXT UNIQUE NOT NULL, "
+                                        "size INT NOT NULL, indexed INT NOT NULL)");
+    const QString idx_indexed = QStringLiteral("CREATE INDEX idx_pagetextinfo_indexed ON pagetextinfo(indexed)");
+    const QString text = QStringLiteral("CREATE VIRTUAL TABLE pagetext USING fts5(title, content)");
+    const QString trigger = QStringLiteral("CREATE TRIGGER pagetext_history_delete AFTER DELETE ON history BEGIN "
+                                           "DELETE FROM pagetext WHERE rowid = (SELECT id FROM pagetextinfo WHERE url = old.url); "
+                                           "DELETE FROM pagetextinfo WHERE url = old.url; "
+                                           "END");
+    if (!execute(info) || !execute(idx_indexed))
+        return false;
+
+    // the history works without, SQLite may have been built without FTS5
+    if (!execute(text) || !execute(trigger))
+        qWarning() << "Page text is not indexed, SQLite lacks FTS5";
+
+    setVersion(9);
+    qDebug() << "Migrated database schema to version 9";
+    return true;
+}
+
+bool DBManager::migrateTo10()
+{
+    // Entries per day and visits per host, so grouped history views and the
+    // top sites don't have to read the whole history. Every visit after the
+    // first one updates lastVisited. Entries keep the day they have been
+    // counted on in the local time of then.
+    const QString days = QStringLiteral("CREATE TABLE historydays (day TEXT PRIMARY KEY, entries INT NOT NULL) WITHOUT ROWID");
+    const QString hosts = QStringLiteral("CREATE TABLE historyhosts (host TEXT PRIMARY KEY, url TEXT NOT NULL, entries INT NOT NULL, "
+                                         "visits INT NOT NULL, lastVisited INT NOT NULL) WITHOUT ROWID");
+    const QString idx_visits = QStringLiteral("CREATE INDEX idx_historyhosts_visits ON historyhosts(visits)");
+    const QString fillDays = QStringLiteral("INSERT INTO historydays (day, entries) SELECT date(lastVisited, 'unixepoch', 'localtime') AS day, "
+                                            "COUNT(*) FROM history WHERE lastVisited IS NOT NULL GROUP BY day");
+    // the url is taken from the row with the maximum
+    const QString fillHosts = QStringLiteral("INSERT INTO historyhosts (host, url, entries, visits, lastVisited) "
+                                             "SELECT host, url, COUNT(*), COUNT(*), MAX(lastVisited) FROM history "
+                                             "WHERE host <> '' AND lastVisited IS NOT NULL GROUP BY host");
+
+    const QString insert = QStringLiteral(
+        "CREATE TRIGGER history_aggregates_insert AFTER INSERT ON history BEGIN "
+        "INSERT INTO historydays (day, entries) SELECT date(new.lastVisited, 'unixepoch', 'localtime'), 1 WHERE new.lastVisited IS NOT NULL "
+        "ON CONFLICT (day) DO UPDATE SET entries = entries + 1; "
+        "INSERT INTO historyhosts (host, url, entries, visits, lastVisited) SELECT new.host, new.url, 1, 1, new.lastVisited "
+        "WHERE new.host <> '' AND new.lastVisited IS NOT NULL "
+        "ON CONFLICT (host) DO UPDATE SET url = CASE WHEN excluded.lastVisited >= lastVisited THEN excluded.url ELSE url END, "
+        "entries = entries + 1, visits = visits + 1, lastVisited = MAX(lastVisited, excluded.lastVisited); "
+        "END");
+    // a removed page is replaced by the latest remaining one of its host
+    const QString remove = QStringLiteral(
+        "CREATE TRIGGER history_aggregates_delete AFTER DELETE ON history BEGIN "
+        "UPDATE historydays SET entries = entries - 1 WHERE day = date(old.lastVisited, 'unixepoch', 'localtime'); "
+        "DELETE FROM historydays WHERE day = date(old.lastVisited, 'unixepoch', 'localtime') AND entries <= 0; "
+        "UPDATE historyhosts SET entries = entries - 1, url = CASE WHEN url = old.url THEN "
+        "COALESCE((SELECT url FROM history WHERE host = old.host ORDER BY lastVisited DESC LIMIT 1), url) ELSE url END "
+        "WHERE host = old.host; "
+        "DELETE FROM historyhosts WHERE host = old.host AND entries <= 0; "
+        "END");
+    // only a later visit counts, the entry moves to its day either way
+    const QString visit = QStringLiteral(
+        "CREATE TRIGGER history_aggregates_visit AFTER UPDATE OF lastVisited ON history WHEN new.lastVisited IS NOT old.lastVisited BEGIN "
+        "UPDATE historydays SET entries = entries - 1 WHERE day = date(old.lastVisited, 'unixepoch', 'localtime'); "
+        "DELETE FROM historydays WHERE day = date(old.lastVisited, 'unixepoch', 'localtime') AND entries <= 0; "
+        "INSERT INTO historydays (day, entries) SELECT date(new.lastVisited, 'unixepoch', 'localtime'), 1 WHERE new.lastVisited IS NOT NULL "
+        "ON CONFLICT (day) DO UPDATE SET entries = entries + 1; "
+        "UPDATE historyhosts SET url = new.url, visits = visits + 1, lastVisited = new.lastVisited "
+        "WHERE host = new.host AND new.lastVisited > old.lastVisited; "
+        "END");
+
+    if (!execute(days) || !execute(hosts) || !execute(idx_visits) || !execute(fillDays) || !execute(fillHosts) || !execute(insert)
+        || !execute(remove) || !execute(visit))
+        return false;
+
+    setVersion(10);
+    qDebug() << "Migrated database schema to version 10";
+    return true;
+}
+
+bool DBManager::migrateTo11()
+{
+    // Imported entries are kept when the history is trimmed, so an import
+    // isn't undone by the next start. Only the other entries are indexed for
+    // finding the oldest ones.
+    if (!execute(QStringLiteral("ALTER TABLE history ADD COLUMN imported INT NOT NULL DEFAULT 0"))
+        || !execute(QStringLiteral("CREATE INDEX idx_history_visited ON history(lastVisited) WHERE imported = 0")))
+        return false;
+
+    setVersion(11);
+    qDebug() << "Migrated database schema to version 11";
+    return true;
+}
+
+bool DBManager::migrateTo12()
+{
+    // ETag or Last-Modified of a download, sent as If-Range when it is
+    // continued in a later session
+    if (!execute(QStringLiteral("ALTER TABLE downloads ADD COLUMN validator TEXT")))
+        return false;
+
+    setVersion(12);
+    qDebug() << "Migrated database schema to version 12";
+    return true;
+}
+
+void DBManager::runMaintenance()
+{
+    if (m_maintenance)
+        return;
+
+    // the history can be large after an import
+    const QString databaseFile = m_databaseFile;
+    auto removed = std::make_shared<int>(-1);
+    m_maintenance = QThread::create([databaseFile, removed] {
+        *removed = runMaintenance(databaseFile);
+    });
+    connect(m_maintenance, &QThread::finished, this, [this, removed] {
+        m_maintenance->deleteLater();
+        m_maintenance = nullptr;
+        if (*removed > 0)
+            announceChanges(QStringLiteral("history"));
+    });
+    m_maintenance->start(QThread::LowPriority);
+}
+
+int DBManager::runMaintenance(const QString &databaseFile)
+{
+    TraceScope trace("DBManager::runMaintenance", "sql");
+
+    int removed = -1;
+    withConnection(databaseFile, [&](QSqlDatabase &database) {
+        removed = runMaintenance(database);
+    });
+    return removed;
+}
+
+int DBManager::runMaintenance(QSqlDatabase &database)
+{
+    // compares with the oldest entry kept, so both the lookup and the
+    // removal use the index of the entries that haven't been imported
+    QSqlQuery history(database);
+    prepare(history, QStringLiteral("DELETE FROM history WHERE imported = 0 AND lastVisited < (SELECT lastVisited FROM history"
+                                    " WHERE imported = 0 ORDER BY lastVisited DESC LIMIT 1 OFFSET %1)")
+                         .arg(MAX_BROWSER_HISTORY_SIZE - 1));
+    if (!execute(history))
+        return -1;
+    const int removed = history.numRowsAffected();
+
+    QSqlQuery icons(database);
+    prepare(icons, QString::fromLatin1(DELETE_UNUSED_ICONS));
+    execute(icons);
+
+    QSqlQuery timings(database);
+    prepare(timings, QStringLiteral("DELETE FROM pagetimings WHERE lastSeen < :before"));
+    timings.bindValue(QStringLiteral(":before"), QDateTime::currentSecsSinceEpoch() - MAX_PAGE_TIMING_AGE);
+    execute(timings);
+
+    return removed;
 }
 
 void DBManager::addRecord(const QString &table, const QVariantMap &pagedata)
@@ -150,14 +645,20 @@ void DBManager::addRecord(const QString &table, const QVariantMap &pagedata)
     if (url.isEmpty() || url == QStringLiteral("about:blank"))
         return;
 
-    QSqlQuery query;
-    query.prepare(QStringLiteral("INSERT OR REPLACE INTO %1 (url, title, icon, lastVisited) "
-                                 "VALUES (:url, :title, :icon, :lastVisited)")
-                      .arg(table));
+    // An existing entry is updated rather than replaced, so the triggers
+    // count another visit instead of a new entry.
+    QSqlQuery &query = statement(QStringLiteral("INSERT INTO %1 (url, title, icon, lastVisited, host, domain, displayPath) "
+                                                "VALUES (:url, :title, :icon, :lastVisited, :host, :domain, :displayPath) "
+                                                "ON CONFLICT (url) DO UPDATE SET title = excluded.title, icon = excluded.icon, "
+                                                "lastVisited = excluded.lastVisited")
+                                     .arg(table));
     query.bindValue(QStringLiteral(":url"), url);
     query.bindValue(QStringLiteral(":title"), title);
     query.bindValue(QStringLiteral(":icon"), icon);
     query.bindValue(QStringLiteral(":lastVisited"), lastVisited);
+    query.bindValue(QStringLiteral(":host"), UrlUtils::urlNormalizedHost(url));
+    query.bindValue(QStringLiteral(":domain"), UrlUtils::urlRegistrableDomain(url));
+    query.bindValue(QStringLiteral(":displayPath"), UrlUtils::urlDisplayPath(url));
     execute(query);
 
     emit databaseTableChanged(table);
@@ -168,8 +669,7 @@ void DBManager::removeRecord(const QString &table, const QString &url)
     if (url.isEmpty())
         return;
 
-    QSqlQuery query;
-    query.prepare(QStringLiteral("DELETE FROM %1 WHERE url = :url").arg(table));
+    QSqlQuery &query = statement(QStringLiteral("DELETE FROM %1 WHERE url = :url").arg(table));
     query.bindValue(QStringLiteral(":url"), url);
     execute(query);
 
@@ -178,19 +678,11 @@ void DBManager::removeRecord(const QString &table, const QString &url)
 
 bool DBManager::hasRecord(const QString &table, const QString &url) const
 {
-    QSqlQuery query;
-    query.prepare(QStringLiteral("SELECT 1 FROM %1 WHERE url = :url").arg(table));
+    QSqlQuery &query = statement(QStringLiteral("SELECT 1 FROM %1 WHERE url = :url").arg(table));
     query.bindValue(QStringLiteral(":url"), url);
-    if (!query.exec()) {
-        qWarning() << Q_FUNC_INFO << "Failed to execute SQL statement";
-        qWarning() << query.lastQuery();
-        qWarning() << query.lastError();
-        return false;
-    }
-    while (query.next()) {
-        return true;
-    }
-    return false;
+    const bool found = execute(query) && query.next();
+    query.finish();
+    return found;
 }
 
 void DBManager::updateIconRecord(const QString &table, const QString &url, const QString &iconSource)
@@ -198,8 +690,7 @@ void DBManager::updateIconRecord(const QString &table, const QString &url, const
     if (url.isEmpty())
         return;
 
-    QSqlQuery query;
-    query.prepare(QStringLiteral("UPDATE %1 SET icon = :icon WHERE url = :url").arg(table));
+    QSqlQuery &query = statement(QStringLiteral("UPDATE %1 SET icon = :icon WHERE url = :url").arg(table));
     query.bindValue(QStringLiteral(":url"), url);
     query.bindValue(QStringLiteral(":icon"), iconSource);
     execute(query);
@@ -213,8 +704,7 @@ void DBManager::setLastVisitedRecord(const QString &table, const QString &url)
         return;
 
     qint64 lastVisited = QDateTime::currentSecsSinceEpoch();
-    QSqlQuery query;
-    query.prepare(QStringLiteral("UPDATE %1 SET lastVisited = :lv WHERE url = :url").arg(table));
+    QSqlQuery &query = statement(QStringLiteral("UPDATE %1 SET lastVisited = :lv WHERE url = :url").arg(table));
     query.bindValue(QStringLiteral(":url"), url);
     query.bindValue(QStringLiteral(":lv"), lastVisited);
     execute(query);
@@ -259,3 +749,546 @@ void DBManager::updateIcon(const QString &url, const QString &iconSource)
     updateIconRecord(QStringLiteral("bookmarks"), url, updatedSource);
     updateIconRecord(QStringLiteral("history"), url, updatedSource);
 }
+
+void DBManager::setUserAgentRule(const QString &pattern, int mode, const QString &userAgent)
+{
+    const QString normalized = HostMatcher<int>::normalized(pattern);
+    if (normalized.isEmpty())
+        return;
+
+    QSqlQuery &query = statement(QStringLiteral("INSERT OR REPLACE INTO useragentrules (pattern, mode, userAgent) "
+                                                "VALUES (:pattern, :mode, :userAgent)"));
+    query.bindValue(QStringLiteral(":pattern"), normalized);
+    query.bindValue(QStringLiteral(":mode"), mode);
+    query.bindValue(QStringLiteral(":userAgent"), userAgent);
+    execute(query);
+
+    emit databaseTableChanged(QStringLiteral("useragentrules"));
+}
+
+void DBManager::removeUserAgentRule(const QString &pattern)
+{
+    QSqlQuery &query = statement(QStringLiteral("DELETE FROM useragentrules WHERE pattern = :pattern"));
+    query.bindValue(QStringLiteral(":pattern"), HostMatcher<int>::normalized(pattern));
+    execute(query);
+
+    emit databaseTableChanged(QStringLiteral("useragentrules"));
+}
+
+QString DBManager::addSnapshot(const QString &url, const QString &hash, const QString &title, qint64 size)
+{
+    if (url.isEmpty() || hash.isEmpty())
+        return QString();
+
+    const QString previousHash = snapshot(url).value(QStringLiteral("hash")).toString();
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+
+    QSqlQuery &query = statement(QStringLiteral("INSERT OR REPLACE INTO snapshots (url, hash, title, size, created, lastAccessed) "
+                                                "VALUES (:url, :hash, :title, :size, :created, :lastAccessed)"));
+    query.bindValue(QStringLiteral(":url"), url);
+    query.bindValue(QStringLiteral(":hash"), hash);
+    query.bindValue(QStringLiteral(":title"), title);
+    query.bindValue(QStringLiteral(":size"), size);
+    query.bindValue(QStringLiteral(":created"), now);
+    query.bindValue(QStringLiteral(":lastAccessed"), now);
+    execute(query);
+
+    emit databaseTableChanged(QStringLiteral("snapshots"));
+
+    if (previousHash.isEmpty() || previousHash == hash || isSnapshotHashUsed(previousHash))
+        return QString();
+    return previousHash;
+}
+
+QString DBManager::removeSnapshot(const QString &url)
+{
+    const QString hash = snapshot(url).value(QStringLiteral("hash")).toString();
+    if (hash.isEmpty())
+        return QString();
+
+    removeRecord(QStringLiteral("snapshots"), url);
+
+    if (isSnapshotHashUsed(hash))
+        return QString();
+    return hash;
+}
+
+QVariantMap DBManager::snapshot(const QString &url) const
+{
+    QSqlQuery &query = statement(QStringLiteral("SELECT hash, title, size, created, lastAccessed FROM snapshots WHERE url = :url"));
+    query.bindValue(QStringLiteral(":url"), url);
+    if (!execute(query) || !query.next()) {
+        query.finish();
+        return {};
+    }
+
+    const QVariantMap snapshot = {
+        {QStringLiteral("hash"), query.value(0)},
+        {QStringLiteral("title"), query.value(1)},
+        {QStringLiteral("size"), query.value(2)},
+        {QStringLiteral("created"), query.value(3)},
+        {QStringLiteral("lastAccessed"), query.value(4)},
+    };
+    query.finish();
+    return snapshot;
+}
+
+bool DBManager::isSnapshotHashUsed(const QString &hash) const
+{
+    QSqlQuery &query = statement(QStringLiteral("SELECT 1 FROM snapshots WHERE hash = :hash LIMIT 1"));
+    query.bindValue(QStringLiteral(":hash"), hash);
+    // keep the file if in doubt
+    const bool used = !execute(query) || query.next();
+    query.finish();
+    return used;
+}
+
+void DBManager::touchSnapshot(const QString &url)
+{
+    // only used for the eviction order, so views are not notified
+    QSqlQuery &query = statement(QStringLiteral("UPDATE snapshots SET lastAccessed = :lastAccessed WHERE url = :url"));
+    query.bindValue(QStringLiteral(":url"), url);
+    query.bindValue(QStringLiteral(":lastAccessed"), QDateTime::currentSecsSinceEpoch());
+    execute(query);
+}
+
+void DBManager::addPageTimings(const QString &host, const QHash<int, int> &buckets)
+{
+    if (host.isEmpty() || buckets.isEmpty())
+        return;
+
+    QSqlQuery &query = statement(QStringLiteral("INSERT INTO pagetimings (host, metric, bucket, count, lastSeen) "
+                                                "VALUES (:host, :metric, :bucket, 1, :lastSeen) "
+                                                "ON CONFLICT (host, metric, bucket) DO UPDATE SET count = count + 1, lastSeen = excluded.lastSeen"));
+    const qint64 lastSeen = QDateTime::currentSecsSinceEpoch();
+
+    // one transaction for all metrics of the load
+    execute(QStringLiteral("BEGIN IMMEDIATE"));
+    for (auto it = buckets.cbegin(); it != buckets.cend(); ++it) {
+        query.bindValue(QStringLiteral(":host"), host);
+        query.bindValue(QStringLiteral(":metric"), it.key());
+        query.bindValue(QStringLiteral(":bucket"), it.value());
+        query.bindValue(QStringLiteral(":lastSeen"), lastSeen);
+        if (!execute(query)) {
+            execute(QStringLiteral("ROLLBACK"));
+            return;
+        }
+    }
+    execute(QStringLiteral("COMMIT"));
+
+    emit databaseTableChanged(QStringLiteral("pagetimings"));
+}
+
+QVector<DBManager::PageTimingCount> DBManager::pageTimings() const
+{
+    QSqlQuery &query = statement(QStringLiteral("SELECT host, metric, bucket, count FROM pagetimings ORDER BY host"));
+    if (!execute(query))
+        return {};
+
+    QVector<PageTimingCount> timings;
+    while (query.next())
+        timings.append({query.value(0).toString(), query.value(1).toInt(), query.value(2).toInt(), query.value(3).toLongLong()});
+    query.finish();
+    return timings;
+}
+
+QVector<DBManager::HistoryDay> DBManager::historyDays() const
+{
+    // a row per day with history, so it stays small
+    QSqlQuery &query = statement(QStringLiteral("SELECT day, entries FROM historydays ORDER BY day DESC"));
+    if (!execute(query))
+        return {};
+
+    QVector<HistoryDay> days;
+    while (query.next())
+        days.append({QDate::fromString(query.value(0).toString(), Qt::ISODate), query.value(1).toLongLong()});
+    query.finish();
+    return days;
+}
+
+QVector<DBManager::TopSite> DBManager::topSites(int limit) const
+{
+    QSqlQuery &query = statement(QStringLiteral("SELECT historyhosts.host, historyhosts.url, history.icon, historyhosts.visits "
+                                                "FROM historyhosts LEFT JOIN history ON history.url = historyhosts.url "
+                                                "ORDER BY historyhosts.visits DESC LIMIT :limit"));
+    query.bindValue(QStringLiteral(":limit"), limit);
+    if (!execute(query))
+        return {};
+
+    QVector<TopSite> sites;
+    while (query.next())
+        sites.append({query.value(0).toString(), query.value(1).toString(), query.value(2).toString(), query.value(3).toLongLong()});
+    query.finish();
+    return sites;
+}
+
+bool DBManager::hasPageText() const
+{
+    QSqlQuery &query = statement(QStringLiteral("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'pagetext'"));
+    const bool found = execute(query) && query.next();
+    query.finish();
+    return found;
+}
+
+void DBManager::clearPageText()
+{
+    if (!hasPageText())
+        return;
+
+    execute(QStringLiteral("BEGIN IMMEDIATE"));
+    if (!execute(QStringLiteral("DELETE FROM pagetext")) || !execute(QStringLiteral("DELETE FROM pagetextinfo"))) {
+        execute(QStringLiteral("ROLLBACK"));
+        return;
+    }
+    execute(QStringLiteral("COMMIT"));
+
+    // searches showing matches in the text are run again
+    emit databaseTableChanged(QStringLiteral("history"));
+}
+
+QString DBManager::pageTextMatch(const QString &text)
+{
+    static const QRegularExpression separators(QStringLiteral("[^\\w]+"), QRegularExpression::UseUnicodePropertiesOption);
+
+    // every word is quoted, so none of them is read as FTS5 syntax
+    QStringList words = text.split(separators, Qt::SkipEmptyParts);
+    if (words.isEmpty())
+        return {};
+    for (QString &word : words)
+        word = QLatin1Char('"') + word + QLatin1Char('"');
+    // the last word may not have been typed completely
+    return words.join(QLatin1Char(' ')) + QLatin1Char('*');
+}
+
+qint64 DBManager::rowCount(const QString &table) const
+{
+    QSqlQuery &query = statement(QStringLiteral("SELECT COUNT(*) FROM %1").arg(table));
+    const qint64 count = execute(query) && query.next() ? query.value(0).toLongLong() : -1;
+    query.finish();
+    return count;
+}
+
+qint64 DBManager::snapshotsSize() const
+{
+    QSqlQuery &query = statement(QStringLiteral("SELECT SUM(size) FROM (SELECT DISTINCT hash, size FROM snapshots)"));
+    const qint64 size = execute(query) && query.next() ? query.value(0).toLongLong() : 0;
+    query.finish();
+    return size;
+}
+
+QStringList DBManager::trimSnapshots(qint64 maxSize)
+{
+    qint64 size = snapshotsSize();
+    if (size <= maxSize)
+        return {};
+
+    // a file is only freed once all urls using it are gone
+    QSqlQuery query;
+    prepare(query, QStringLiteral("SELECT url, hash, size, (SELECT COUNT(*) FROM snapshots s WHERE s.hash = snapshots.hash) "
+                                  "FROM snapshots ORDER BY lastAccessed ASC"));
+    if (!execute(query))
+        return {};
+    QStringList urls;
+    QStringList hashes;
+    QHash<QString, int> references;
+    while (size > maxSize && query.next()) {
+        const QString hash = query.value(1).toString();
+        auto it = references.find(hash);
+        if (it == references.end())
+            it = references.insert(hash, query.value(3).toInt());
+
+        urls.append(query.value(0).toString());
+        if (--(*it) == 0) {
+            size -= query.value(2).toLongLong();
+            hashes.append(hash);
+        }
+    }
+
+    query.finish();
+
+    execute(QStringLiteral("BEGIN IMMEDIATE"));
+    QSqlQuery &remove = statement(QStringLiteral("DELETE FROM snapshots WHERE url = :url"));
+    for (const QString &url : qAsConst(urls)) {
+        remove.bindValue(QStringLiteral(":url"), url);
+        if (!execute(remove)) {
+            execute(QStringLiteral("ROLLBACK"));
+            return {};
+        }
+    }
+    execute(QStringLiteral("COMMIT"));
+
+    emit databaseTableChanged(QStringLiteral("snapshots"));
+    return hashes;
+}
+
+int DBManager::addDownload(const QVariantMap &download)
+{
+    QSqlQuery &query = statement(QStringLiteral("INSERT INTO downloads (url, path, mimeType, receivedBytes, totalBytes, state, validator, created) "
+                                                "VALUES (:url, :path, :mimeType, :receivedBytes, :totalBytes, :state, :validator, :created)"));
+    query.bindValue(QStringLiteral(":url"), download.value(QStringLiteral("url")).toString());
+    query.bindValue(QStringLiteral(":path"), download.value(QStringLiteral("path")).toString());
+    query.bindValue(QStringLiteral(":mimeType"), download.value(QStringLiteral("mimeType")).toString());
+    query.bindValue(QStringLiteral(":receivedBytes"), download.value(QStringLiteral("receivedBytes")).toLongLong());
+    query.bindValue(QStringLiteral(":totalBytes"), download.value(QStringLiteral("totalBytes")).toLongLong());
+    query.bindValue(QStringLiteral(":state"), download.value(QStringLiteral("state")).toInt());
+    query.bindValue(QStringLiteral(":validator"), download.value(QStringLiteral("validator")).toString());
+    query.bindValue(QStringLiteral(":created"), QDateTime::currentSecsSinceEpoch());
+    if (!execute(query))
+        return -1;
+
+    return query.lastInsertId().toInt();
+}
+
+void DBManager::updateDownload(int id, qint64 receivedBytes, qint64 totalBytes, int state)
+{
+    QSqlQuery &query = statement(QStringLiteral("UPDATE downloads SET receivedBytes = :receivedBytes, totalBytes = :totalBytes, state = :state "
+                                                "WHERE id = :id"));
+    query.bindValue(QStringLiteral(":id"), id);
+    query.bindValue(QStringLiteral(":receivedBytes"), receivedBytes);
+    query.bindValue(QStringLiteral(":totalBytes"), totalBytes);
+    query.bindValue(QStringLiteral(":state"), state);
+    execute(query);
+}
+
+void DBManager::setDownloadValidator(int id, const QString &validator)
+{
+    QSqlQuery &query = statement(QStringLiteral("UPDATE downloads SET validator = :validator WHERE id = :id"));
+    query.bindValue(QStringLiteral(":id"), id);
+    query.bindValue(QStringLiteral(":validator"), validator);
+    execute(query);
+}
+
+void DBManager::removeDownload(int id)
+{
+    QSqlQuery &query = statement(QStringLiteral("DELETE FROM downloads WHERE id = :id"));
+    query.bindValue(QStringLiteral(":id"), id);
+    execute(query);
+}
+
+QVariantList DBManager::downloads() const
+{
+    QSqlQuery &query = statement(QStringLiteral("SELECT id, url, path, mimeType, receivedBytes, totalBytes, state, validator FROM downloads ORDER BY id"));
+    if (!execute(query))
+        return {};
+
+    QVariantList downloads;
+    while (query.next()) {
+        downloads.append(QVariantMap {
+            {QStringLiteral("id"), query.value(0)},
+            {QStringLiteral("url"), query.value(1)},
+            {QStringLiteral("path"), query.value(2)},
+            {QStringLiteral("mimeType"), query.value(3)},
+            {QStringLiteral("receivedBytes"), query.value(4)},
+            {QStringLiteral("totalBytes"), query.value(5)},
+            {QStringLiteral("state"), query.value(6)},
+            {QStringLiteral("validator"), query.value(7)},
+        });
+    }
+    query.finish();
+    return downloads;
+}
+
+QString DBManager::databaseFile() const
+{
+    return m_databaseFile;
+}
+
+void DBManager::announceChanges(const QString &table)
+{
+    // the writes have been made by this process, don't announce them twice
+    m_dataVersion = dataVersion();
+    m_changeTimer.stop();
+    emit databaseTableChanged(table);
+}
+
+bool DBManager::withConnection(const QString &databaseFile, const std::function<void(QSqlDatabase &)> &function, bool readOnly)
+{
+    // connections can only be used by the thread which created them, and a
+    // thread may open another one while using the first, like an import does
+    static std::atomic<int> connections{0};
+    const QString connection = QStringLiteral("angelfish-worker-%1-%2").arg(quintptr(QThread::currentThreadId())).arg(connections++);
+    bool opened = false;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connection);
+        database.setDatabaseName(databaseFile);
+        QString options = QStringLiteral("QSQLITE_BUSY_TIMEOUT=%1").arg(BUSY_TIMEOUT);
+        if (readOnly)
+            options += QStringLiteral(";QSQLITE_OPEN_READONLY");
+        database.setConnectOptions(options);
+        opened = database.open();
+        if (opened)
+            function(database);
+        else
+            qWarning() << Q_FUNC_INFO << "Failed to open database" << databaseFile << database.lastError();
+    }
+    QSqlDatabase::removeDatabase(connection);
+    return opened;
+}
+
+int DBManager::removeHistoryRange(const QString &databaseFile, qint64 from, qint64 to, const std::function<void(qreal)> &progress)
+{
+    TraceScope trace("DBManager::removeHistoryRange", "sql");
+
+    int removed = -1;
+    withConnection(databaseFile, [&](QSqlDatabase &database) {
+        removed = removeHistoryRange(database, from, to, progress);
+    });
+    return removed;
+}
+
+int DBManager::removeHistoryRange(QSqlDatabase &database, qint64 from, qint64 to, const std::function<void(qreal)> &progress)
+{
+    const auto run = [&database](const QString &sql) {
+        QSqlQuery query(database);
+        prepare(query, sql);
+        return execute(query);
+    };
+
+    QSqlQuery count(database);
+    prepare(count, QStringLiteral("SELECT COUNT(*) FROM history WHERE lastVisited BETWEEN :from AND :to"));
+    count.bindValue(QStringLiteral(":from"), from);
+    count.bindValue(QStringLiteral(":to"), to);
+    if (!execute(count) || !count.next())
+        return -1;
+    const int total = count.value(0).toInt();
+    count.finish();
+
+    // Removed in batches to report the progress. Everything is committed at
+    // once, so other connections never see half of the range removed.
+    if (!run(QStringLiteral("BEGIN IMMEDIATE")))
+        return -1;
+
+    QSqlQuery remove(database);
+    prepare(remove, QStringLiteral("DELETE FROM history WHERE rowid IN "
+                                   "(SELECT rowid FROM history WHERE lastVisited BETWEEN :from AND :to LIMIT %1)")
+                        .arg(CLEAR_BATCH_SIZE));
+    int removed = 0;
+    for (;;) {
+        remove.bindValue(QStringLiteral(":from"), from);
+        remove.bindValue(QStringLiteral(":to"), to);
+        if (!execute(remove)) {
+            run(QStringLiteral("ROLLBACK"));
+            return -1;
+        }
+
+        const int batch = remove.numRowsAffected();
+        if (batch <= 0)
+            break;
+        removed += batch;
+        if (progress)
+            progress(qreal(removed) / qMax(total, removed));
+    }
+
+    // timings can't be split by time, all hosts updated in the range go
+    QSqlQuery timings(database);
+    prepare(timings, QStringLiteral("DELETE FROM pagetimings WHERE lastSeen BETWEEN :from AND :to"));
+    timings.bindValue(QStringLiteral(":from"), from);
+    timings.bindValue(QStringLiteral(":to"), to);
+    if (!execute(timings)) {
+        run(QStringLiteral("ROLLBACK"));
+        return -1;
+    }
+
+    if (!run(QString::fromLatin1(DELETE_UNUSED_ICONS)) || !run(QStringLiteral("COMMIT"))) {
+        run(QStringLiteral("ROLLBACK"));
+        return -1;
+    }
+    return removed;
+}
+
+bool DBManager::addPageText(const QString &databaseFile, const QString &url, const QString &title, const QString &text, qint64 maxSize)
+{
+    TraceScope trace("DBManager::addPageText", "sql");
+
+    bool added = false;
+    withConnection(databaseFile, [&](QSqlDatabase &database) {
+        added = addPageText(database, url, title, text, maxSize);
+    });
+    return added;
+}
+
+bool DBManager::addPageText(QSqlDatabase &database, const QString &url, const QString &title, const QString &text, qint64 maxSize)
+{
+    const auto run = [&database](const QString &sql, const QVariantMap &values = {}) {
+        QSqlQuery query(database);
+        prepare(query, sql);
+        for (auto it = values.cbegin(); it != values.cend(); ++it)
+            query.bindValue(it.key(), it.value());
+        return execute(query);
+    };
+    const auto fail = [&run] {
+        run(QStringLiteral("ROLLBACK"));
+        return false;
+    };
+
+    // The entry is looked up in the transaction, so it can't be removed from
+    // the history before its text has been added. Other connections writing
+    // meanwhile wait, the transaction only holds a single page.
+    if (!run(QStringLiteral("BEGIN IMMEDIATE")))
+        return false;
+
+    QSqlQuery visited(database);
+    prepare(visited, QStringLiteral("SELECT 1 FROM history WHERE url = :url"));
+    visited.bindValue(QStringLiteral(":url"), url);
+    if (!execute(visited))
+        return fail();
+    if (!visited.next()) {
+        // private tabs and removed entries are never indexed
+        visited.finish();
+        run(QStringLiteral("ROLLBACK"));
+        return false;
+    }
+    visited.finish();
+
+    // the text of an earlier visit is replaced
+    const QVariantMap page = {{QStringLiteral(":url"), url}};
+    if (!run(QStringLiteral("DELETE FROM pagetext WHERE rowid = (SELECT id FROM pagetextinfo WHERE url = :url)"), page)
+        || !run(QStringLiteral("DELETE FROM pagetextinfo WHERE url = :url"), page))
+        return fail();
+
+    QSqlQuery info(database);
+    prepare(info, QStringLiteral("INSERT INTO pagetextinfo (url, size, indexed) VALUES (:url, :size, :indexed)"));
+    info.bindValue(QStringLiteral(":url"), url);
+    info.bindValue(QStringLiteral(":size"), text.toUtf8().size() + title.toUtf8().size());
+    info.bindValue(QStringLiteral(":indexed"), QDateTime::currentSecsSinceEpoch());
+    if (!execute(info))
+        return fail();
+    const qint64 id = info.lastInsertId().toLongLong();
+
+    if (!run(QStringLiteral("INSERT INTO pagetext (rowid, title, content) VALUES (:id, :title, :content)"),
+             {{QStringLiteral(":id"), id}, {QStringLiteral(":title"), title}, {QStringLiteral(":content"), text}}))
+        return fail();
+
+    // the oldest texts are removed until the rest fits, the table has an
+    // entry per page in the history at most
+    QSqlQuery size(database);
+    prepare(size, QStringLiteral("SELECT SUM(size) FROM pagetextinfo"));
+    if (!execute(size) || !size.next())
+        return fail();
+    qint64 total = size.value(0).toLongLong();
+    size.finish();
+
+    if (total > maxSize) {
+        QSqlQuery oldest(database);
+        prepare(oldest, QStringLiteral("SELECT id, size FROM pagetextinfo ORDER BY indexed, id"));
+        if (!execute(oldest))
+            return fail();
+        QVector<qint64> ids;
+        while (total > maxSize && oldest.next()) {
+            ids.append(oldest.value(0).toLongLong());
+            total -= oldest.value(1).toLongLong();
+        }
+        oldest.finish();
+
+        for (qint64 removed : qAsConst(ids)) {
+            const QVariantMap entry = {{QStringLiteral(":id"), removed}};
+            if (!run(QStringLiteral("DELETE FROM pagetext WHERE rowid = :id"), entry)
+                || !run(QStringLiteral("DELETE FROM pagetextinfo WHERE id = :id"), entry))
+                return fail();
+        }
+    }
+
+    if (!run(QStringLiteral("COMMIT")))
+        return fail();
+    return true;
+}
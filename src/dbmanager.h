@@ -10,19 +10,35 @@
 #ifndef DBMANAGER_H
 #define DBMANAGER_H
 
+#include <QDate>
+#include <QHash>
 #include <QObject>
 #include <QSqlQuery>
 #include <QString>
+#include <QTimer>
+#include <QVariantMap>
+#include <QVector>
+
+#include <functional>
+
+class QFileSystemWatcher;
+class QSqlDatabase;
+class QThread;
 
 /**
  * @class DBManager
  * @short Class for database initialization and applying changes in its records
+ *
+ * The database may be used by several processes at once. It is kept in WAL
+ * mode, statements waiting for a lock are retried for a while, and changes
+ * written by other processes are announced with databaseTableChanged too.
  */
 class DBManager : public QObject
 {
     Q_OBJECT
 public:
     explicit DBManager(QObject *parent = nullptr);
+    ~DBManager() override;
 
 signals:
     // emitted with the name of the table that has been changed
@@ -39,6 +55,106 @@ public:
     void updateIcon(const QString &url, const QString &iconSource);
     void updateLastVisited(const QString &url);
 
+    void setUserAgentRule(const QString &pattern, int mode, const QString &userAgent);
+    void removeUserAgentRule(const QString &pattern);
+
+    // offline snapshots, see SnapshotStore. Methods changing the table return
+    // the hash of a snapshot file that is no longer used by any url.
+    QString addSnapshot(const QString &url, const QString &hash, const QString &title, qint64 size);
+    QString removeSnapshot(const QString &url);
+    QVariantMap snapshot(const QString &url) const;
+    void touchSnapshot(const QString &url);
+    // size of all snapshot files
+    qint64 snapshotsSize() const;
+    // removes the least recently used snapshots until the files fit into maxSize
+    QStringList trimSnapshots(qint64 maxSize);
+
+    // persisted state of the downloads, see DownloadManager. The manager keeps
+    // its own copy, so changes are not announced.
+    int addDownload(const QVariantMap &download);
+    void updateDownload(int id, qint64 receivedBytes, qint64 totalBytes, int state);
+    void setDownloadValidator(int id, const QString &validator);
+    void removeDownload(int id);
+    QVariantList downloads() const;
+
+    // page load timings, see SitePerformanceModel
+    struct PageTimingCount {
+        QString host;
+        int metric;
+        int bucket;
+        qint64 count;
+    };
+    // counts one load of host in the bucket given for each metric
+    void addPageTimings(const QString &host, const QHash<int, int> &buckets);
+    // ordered by host
+    QVector<PageTimingCount> pageTimings() const;
+
+    // Aggregates of the history kept up to date by triggers, see
+    // HistorySections and TopSitesModel
+    struct HistoryDay {
+        QDate day;
+        qint64 entries;
+    };
+    struct TopSite {
+        QString host;
+        // the page of the host visited last
+        QString url;
+        QString icon;
+        qint64 visits;
+    };
+    // entries last visited on each day, in local time, the latest day first
+    QVector<HistoryDay> historyDays() const;
+    // hosts by the number of visits
+    QVector<TopSite> topSites(int limit) const;
+
+    // Indexed text of visited pages, see PageTextIndex. Not available if
+    // SQLite has been built without FTS5.
+    bool hasPageText() const;
+    void clearPageText();
+    // FTS5 query matching the words of text, the last one as prefix. Empty
+    // if there are no words.
+    static QString pageTextMatch(const QString &text);
+
+    // number of entries in table, -1 on errors
+    qint64 rowCount(const QString &table) const;
+
+    // trims history and icons in a worker thread, run once the startup is done
+    void runMaintenance();
+    // Trims the history entries that haven't been imported, the icons and
+    // the page timings. Opens a connection of its own like removeHistoryRange.
+    // Returns the number of removed history entries, or -1 on errors.
+    static int runMaintenance(const QString &databaseFile);
+
+    QString databaseFile() const;
+    // announces a table changed through another connection of this process
+    void announceChanges(const QString &table);
+
+    // Removes the history entries visited between from and to, in seconds
+    // since the epoch, the timings of hosts loaded in between and the icons
+    // no longer used. Opens a connection of its own, so it can be run in any
+    // thread. Returns the number of removed entries, or -1 if the database
+    // could not be changed.
+    static int removeHistoryRange(const QString &databaseFile, qint64 from, qint64 to,
+                                  const std::function<void(qreal)> &progress = {});
+
+    // Indexes text as content of url, which has to be in the history. The
+    // texts indexed the longest ago are removed while all are larger than
+    // maxSize bytes. Opens a connection of its own like removeHistoryRange.
+    static bool addPageText(const QString &databaseFile, const QString &url, const QString &title, const QString &text, qint64 maxSize);
+
+    // Prepares sql for query. Every statement of the browser is prepared
+    // through here, so that the tests can check how SQLite runs them.
+    static bool prepare(QSqlQuery &query, const QString &sql);
+    // called with the sql of every statement prepared or reused from the
+    // statement cache, in the thread running it
+    static void setStatementObserver(const std::function<void(const QString &)> &observer);
+
+    // Runs function with a connection of its own to databaseFile, so that it
+    // can be used in any thread. False if the database could not be opened.
+    static bool withConnection(const QString &databaseFile, const std::function<void(QSqlDatabase &)> &function, bool readOnly = false);
+    // executes a prepared query, worker threads retry while the database is busy
+    static bool execute(QSqlQuery &query);
+
 private:
     // version of database schema
     int version();
@@ -46,16 +162,36 @@ private:
 
     // migration from earlier versions
     bool migrate();
+    bool migrateSteps();
     bool migrateTo1();
+    bool migrateTo2();
+    bool migrateTo3();
+    bool migrateTo4();
+    bool migrateTo5();
+    bool migrateTo6();
+    bool migrateTo7();
+    bool migrateTo8();
+    bool migrateTo9();
+    bool migrateTo10();
+    bool migrateTo11();
+    bool migrateTo12();
 
-    // limit the size of history table
-    void trimHistory();
-    // drop unused icons
-    void trimIcons();
+    static int runMaintenance(QSqlDatabase &database);
 
-    // execute SQL statement
-    bool execute(const QString &command);
-    bool execute(QSqlQuery &query);
+    // execute SQL statement, worker threads retry while the database is busy
+    static bool execute(const QString &command);
+
+    // prepared statement for sql, reused by later calls. Queries that return
+    // rows have to be finished once they are read.
+    QSqlQuery &statement(const QString &sql) const;
+
+    // changes whenever another connection commits to the database
+    qint64 dataVersion() const;
+    void watchDatabaseFiles();
+    void checkExternalChanges();
+
+    static int removeHistoryRange(QSqlDatabase &database, qint64 from, qint64 to, const std::function<void(qreal)> &progress);
+    static bool addPageText(QSqlDatabase &database, const QString &url, const QString &title, const QString &text, qint64 maxSize);
 
     // methods for manipulation of bookmarks or history tables
     void addRecord(const QString &table, const QVariantMap &pagedata);
@@ -63,6 +199,17 @@ private:
     void updateIconRecord(const QString &table, const QString &url, const QString &iconSource);
     void setLastVisitedRecord(const QString &table, const QString &url);
     bool hasRecord(const QString &table, const QString &url) const;
+    bool isSnapshotHashUsed(const QString &hash) const;
+
+    mutable QHash<QString, QSqlQuery> m_statements;
+    // returned by statement if preparing failed
+    mutable QSqlQuery m_invalidStatement;
+    QString m_databaseFile;
+    QFileSystemWatcher *m_watcher;
+    QTimer m_changeTimer;
+    qint64 m_dataVersion = -1;
+    // runs the maintenance, see runMaintenance
+    QThread *m_maintenance = nullptr;
 };
 
 #endif // DBMANAGER_H
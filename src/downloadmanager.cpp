@@ -0,0 +1,642 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "downloadmanager.h"
+#include "browsermanager.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkCookie>
+#include <QNetworkCookieJar>
+#include <QNetworkReply>
+#include <QtWebEngine/QQuickWebEngineDownloadItem>
+#include <QtWebEngine/QQuickWebEngineProfile>
+#include <QtWebEngineCore/QWebEngineCookieStore>
+
+#include "angelfishsettings.h"
+
+// minimum time between two samples of the throughput, in ms
+constexpr qint64 SPEED_SAMPLE_INTERVAL = 500;
+// weight of the latest sample in the smoothed throughput
+constexpr double SPEED_SMOOTHING = 0.3;
+// minimum time between storing the progress of a download, in ms
+constexpr qint64 PERSIST_INTERVAL = 2000;
+// ms the downloads of an earlier session wait for the cookies of a profile,
+// the cookie store doesn't tell when it has loaded all of them
+constexpr int COOKIE_LOAD_TIME = 500;
+
+namespace {
+// identifies the file of the reply in If-Range, only strong ETags can be used
+QString validator(const QNetworkReply *reply)
+{
+    const QByteArray etag = reply->rawHeader(QByteArrayLiteral("ETag"));
+    if (!etag.isEmpty() && !etag.startsWith("W/"))
+        return QString::fromLatin1(etag);
+    return QString::fromLatin1(reply->rawHeader(QByteArrayLiteral("Last-Modified")));
+}
+
+// whether the whole file sent by the server is still the one of the download
+bool sameFile(const QNetworkReply *reply, const QString &mimeType, qint64 totalBytes)
+{
+    const QVariant length = reply->header(QNetworkRequest::ContentLengthHeader);
+    if (totalBytes > 0 && length.isValid() && length.toLongLong() != totalBytes)
+        return false;
+
+    // "text/html; charset=utf-8"
+    const QString type = reply->header(QNetworkRequest::ContentTypeHeader).toString().section(QLatin1Char(';'), 0, 0).trimmed();
+    return mimeType.isEmpty() || type.isEmpty() || type.compare(mimeType, Qt::CaseInsensitive) == 0;
+}
+}
+
+DownloadManager *DownloadManager::s_instance = nullptr;
+
+DownloadManager::DownloadManager(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_network(new QNetworkAccessManager(this))
+{
+    m_network->setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
+    m_network->setCookieJar(new QNetworkCookieJar(m_network));
+    m_clock.start();
+
+    m_cookieTimer.setSingleShot(true);
+    m_cookieTimer.setInterval(COOKIE_LOAD_TIME);
+    connect(&m_cookieTimer, &QTimer::timeout, this, &DownloadManager::schedule);
+
+    const QVariantList downloads = BrowserManager::instance()->downloads();
+    for (const QVariant &value : downloads) {
+        const QVariantMap map = value.toMap();
+        Download download;
+        download.id = map.value(QStringLiteral("id")).toInt();
+        download.url = map.value(QStringLiteral("url")).toUrl();
+        download.path = map.value(QStringLiteral("path")).toString();
+        download.mimeType = map.value(QStringLiteral("mimeType")).toString();
+        download.receivedBytes = map.value(QStringLiteral("receivedBytes")).toLongLong();
+        download.totalBytes = map.value(QStringLiteral("totalBytes")).toLongLong();
+        download.state = State(map.value(QStringLiteral("state")).toInt());
+        download.validator = map.value(QStringLiteral("validator")).toString();
+
+        switch (download.state) {
+        case Requested:
+            // never confirmed
+            BrowserManager::instance()->removeDownload(download.id);
+            continue;
+        case Downloading:
+            // continue what has been interrupted by quitting
+            download.state = Queued;
+            break;
+        default:
+            break;
+        }
+        m_downloads.append(download);
+    }
+
+    // give the owner the chance to change the limit first
+    QMetaObject::invokeMethod(this, &DownloadManager::schedule, Qt::QueuedConnection);
+}
+
+DownloadManager::~DownloadManager()
+{
+    for (const Download &download : qAsConst(m_downloads))
+        persist(download);
+}
+
+DownloadManager *DownloadManager::instance()
+{
+    if (s_instance)
+        return s_instance;
+
+    s_instance = new DownloadManager();
+    auto *settings = AngelfishSettings::self();
+    s_instance->setMaximumActive(settings->downloadsMaximumActive());
+    QObject::connect(settings, &AngelfishSettings::downloadsMaximumActiveChanged, s_instance, [settings] {
+        s_instance->setMaximumActive(settings->downloadsMaximumActive());
+    });
+
+    return s_instance;
+}
+
+QHash<int, QByteArray> DownloadManager::roleNames() const
+{
+    return {
+        {IdRole, QByteArrayLiteral("id")},
+        {UrlRole, QByteArrayLiteral("url")},
+        {PathRole, QByteArrayLiteral("path")},
+        {FileNameRole, QByteArrayLiteral("fileName")},
+        {MimeTypeRole, QByteArrayLiteral("mimeType")},
+        {ReceivedBytesRole, QByteArrayLiteral("receivedBytes")},
+        {TotalBytesRole, QByteArrayLiteral("totalBytes")},
+        {StateRole, QByteArrayLiteral("state")},
+        {SpeedRole, QByteArrayLiteral("speed")},
+        {RemainingTimeRole, QByteArrayLiteral("remainingTime")},
+    };
+}
+
+QVariant DownloadManager::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_downloads.size())
+        return {};
+
+    const Download &download = m_downloads.at(index.row());
+    switch (role) {
+    case IdRole:
+        return download.id;
+    case UrlRole:
+        return download.url;
+    case PathRole:
+        return download.path;
+    case FileNameRole:
+        return QFileInfo(download.path).fileName();
+    case MimeTypeRole:
+        return download.mimeType;
+    case ReceivedBytesRole:
+        return download.receivedBytes;
+    case TotalBytesRole:
+        return download.totalBytes;
+    case StateRole:
+        return download.state;
+    case SpeedRole:
+        return download.state == Downloading ? download.speed : 0;
+    case RemainingTimeRole:
+        if (download.state != Downloading || download.totalBytes <= 0 || download.speed <= 0)
+            return -1;
+        return qint64((download.totalBytes - download.receivedBytes) / download.speed);
+    }
+    return {};
+}
+
+int DownloadManager::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_downloads.size();
+}
+
+int DownloadManager::maximumActive() const
+{
+    return m_maximumActive;
+}
+
+void DownloadManager::setMaximumActive(int maximum)
+{
+    if (m_maximumActive == maximum)
+        return;
+    m_maximumActive = maximum;
+    schedule();
+    emit maximumActiveChanged();
+}
+
+int DownloadManager::activeCount() const
+{
+    return m_activeCount;
+}
+
+int DownloadManager::add(QObject *object, bool offTheRecord)
+{
+    auto *item = qobject_cast<QQuickWebEngineDownloadItem *>(object);
+    if (!item) {
+        qWarning() << Q_FUNC_INFO << "Not a download" << object;
+        return -1;
+    }
+
+    // if we don't accept the request right away, it will be deleted,
+    // so stop it again until the user confirmed it
+    item->accept();
+    item->pause();
+
+    Download download;
+    download.url = item->url();
+    download.path = item->downloadDirectory() + QLatin1Char('/') + item->downloadFileName();
+    download.mimeType = item->mimeType();
+    download.totalBytes = item->totalBytes();
+    download.item = item;
+    download.id = BrowserManager::instance()->addDownload({
+        {QStringLiteral("url"), download.url},
+        {QStringLiteral("path"), download.path},
+        {QStringLiteral("mimeType"), download.mimeType},
+        {QStringLiteral("totalBytes"), download.totalBytes},
+        {QStringLiteral("state"), download.state},
+    });
+    if (download.id < 0) {
+        item->cancel();
+        return -1;
+    }
+
+    const int id = download.id;
+    connect(item, &QQuickWebEngineDownloadItem::receivedBytesChanged, this, [this, id, item] {
+        updateProgress(id, item->receivedBytes(), item->totalBytes());
+    });
+    connect(item, &QQuickWebEngineDownloadItem::totalBytesChanged, this, [this, id, item] {
+        updateProgress(id, item->receivedBytes(), item->totalBytes());
+    });
+    connect(item, &QQuickWebEngineDownloadItem::stateChanged, this, [this, id] {
+        onItemStateChanged(id);
+    });
+
+    beginInsertRows({}, m_downloads.size(), m_downloads.size());
+    m_downloads.append(download);
+    endInsertRows();
+
+    // nothing about private downloads is requested outside of the web engine
+    if (!offTheRecord)
+        requestValidator(id);
+    return id;
+}
+
+void DownloadManager::addProfile(QObject *object)
+{
+    auto *profile = qobject_cast<QQuickWebEngineProfile *>(object);
+    if (!profile) {
+        qWarning() << Q_FUNC_INFO << "Not a profile" << object;
+        return;
+    }
+    if (profile->isOffTheRecord())
+        return;
+
+    QNetworkCookieJar *jar = m_network->cookieJar();
+    QWebEngineCookieStore *store = profile->cookieStore();
+    connect(store, &QWebEngineCookieStore::cookieAdded, jar, [jar](const QNetworkCookie &cookie) {
+        jar->insertCookie(cookie);
+    });
+    connect(store, &QWebEngineCookieStore::cookieRemoved, jar, [jar](const QNetworkCookie &cookie) {
+        jar->deleteCookie(cookie);
+    });
+    store->loadAllCookies();
+    m_cookieTimer.start();
+}
+
+void DownloadManager::start(int id)
+{
+    const int row = rowOf(id);
+    if (row < 0 || m_downloads.at(row).state != Requested)
+        return;
+
+    setState(id, Queued);
+    schedule();
+}
+
+void DownloadManager::pause(int id)
+{
+    const int row = rowOf(id);
+    if (row < 0)
+        return;
+
+    Download &download = m_downloads[row];
+    if (download.state != Downloading && download.state != Queued)
+        return;
+
+    if (download.item)
+        download.item->pause();
+    setState(id, Paused);
+    if (download.reply)
+        download.reply->abort();
+    schedule();
+}
+
+void DownloadManager::resume(int id)
+{
+    const int row = rowOf(id);
+    if (row < 0)
+        return;
+
+    const State state = m_downloads.at(row).state;
+    if (state != Paused && state != Failed)
+        return;
+
+    setState(id, Queued);
+    schedule();
+}
+
+void DownloadManager::cancel(int id)
+{
+    const int row = rowOf(id);
+    if (row < 0)
+        return;
+
+    // take it out first, so the state changes caused by stopping it are ignored
+    beginRemoveRows({}, row, row);
+    const Download download = m_downloads.takeAt(row);
+    endRemoveRows();
+    BrowserManager::instance()->removeDownload(id);
+
+    if (download.item) {
+        download.item->cancel();
+    } else {
+        if (download.reply) {
+            download.reply->abort();
+            download.reply->deleteLater();
+        }
+        if (download.file)
+            download.file->close();
+        if (download.state != Completed)
+            QFile::remove(download.path);
+    }
+
+    if (download.state == Downloading) {
+        m_activeCount--;
+        emit activeCountChanged();
+        schedule();
+    }
+}
+
+void DownloadManager::remove(int id)
+{
+    const int row = rowOf(id);
+    if (row < 0)
+        return;
+
+    const State state = m_downloads.at(row).state;
+    if (state != Completed && state != Failed) {
+        cancel(id);
+        return;
+    }
+
+    beginRemoveRows({}, row, row);
+    m_downloads.remove(row);
+    endRemoveRows();
+    BrowserManager::instance()->removeDownload(id);
+}
+
+void DownloadManager::clearFinished()
+{
+    for (int row = m_downloads.size() - 1; row >= 0; row--) {
+        if (m_downloads.at(row).state == Completed)
+            remove(m_downloads.at(row).id);
+    }
+}
+
+int DownloadManager::rowOf(int id) const
+{
+    for (int row = 0; row < m_downloads.size(); row++) {
+        if (m_downloads.at(row).id == id)
+            return row;
+    }
+    return -1;
+}
+
+void DownloadManager::schedule()
+{
+    // the oldest queued downloads go first
+    for (int row = 0; row < m_downloads.size() && m_activeCount < m_maximumActive; row++) {
+        Download &download = m_downloads[row];
+        if (download.state != Queued)
+            continue;
+        // wait for the cookies
+        if (!download.item && m_cookieTimer.isActive())
+            continue;
+
+        download.sampleTime = m_clock.elapsed();
+        download.sampleBytes = download.receivedBytes;
+        download.speed = 0;
+        setState(download.id, Downloading);
+
+        if (download.item)
+            download.item->resume();
+        else
+            transfer(download);
+    }
+}
+
+void DownloadManager::requestValidator(int id)
+{
+    const int row = rowOf(id);
+    if (row < 0)
+        return;
+
+    QNetworkReply *reply = m_network->head(QNetworkRequest(m_downloads.at(row).url));
+    connect(reply, &QNetworkReply::finished, this, [this, id, reply] {
+        reply->deleteLater();
+        const int row = rowOf(id);
+        if (row < 0 || reply->error() != QNetworkReply::NoError)
+            return;
+
+        Download &download = m_downloads[row];
+        if (download.validator.isEmpty())
+            setValidator(download, validator(reply));
+    });
+}
+
+void DownloadManager::setValidator(Download &download, const QString &validator)
+{
+    if (download.validator == validator)
+        return;
+    download.validator = validator;
+    BrowserManager::instance()->setDownloadValidator(download.id, validator);
+}
+
+void DownloadManager::transfer(Download &download)
+{
+    // continue after what is already on disk, if the server can tell whether
+    // it is still the same file
+    const qint64 offset = download.validator.isEmpty() ? 0 : QFileInfo(download.path).size();
+    QNetworkRequest request(download.url);
+    if (offset > 0) {
+        request.setRawHeader(QByteArrayLiteral("Range"), QByteArrayLiteral("bytes=") + QByteArray::number(offset) + '-');
+        request.setRawHeader(QByteArrayLiteral("If-Range"), download.validator.toLatin1());
+    }
+
+    download.file.reset();
+    download.receivedBytes = offset;
+    download.reply = m_network->get(request);
+
+    const int id = download.id;
+    connect(download.reply, &QNetworkReply::readyRead, this, [this, id] {
+        onTransferData(id);
+    });
+    connect(download.reply, &QNetworkReply::finished, this, [this, id] {
+        onTransferFinished(id);
+    });
+}
+
+void DownloadManager::onTransferData(int id)
+{
+    const int row = rowOf(id);
+    if (row < 0)
+        return;
+
+    Download &download = m_downloads[row];
+    QNetworkReply *reply = download.reply;
+    if (!reply)
+        return;
+
+    if (!download.file) {
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        const qint64 offset = download.receivedBytes;
+        QIODevice::OpenMode mode = QIODevice::WriteOnly;
+        qint64 totalBytes = -1;
+
+        if (status == 206) {
+            // "bytes 100-999/1000"
+            const QByteArray range = reply->rawHeader(QByteArrayLiteral("Content-Range"));
+            if (!range.startsWith(QByteArrayLiteral("bytes ") + QByteArray::number(offset) + '-')) {
+                qWarning() << Q_FUNC_INFO << "Unexpected range" << range << "for" << download.url;
+                reply->abort();
+                return;
+            }
+            totalBytes = range.mid(range.indexOf('/') + 1).toLongLong();
+            mode |= QIODevice::Append;
+        } else if (status == 416) {
+            // the file was complete already, see onTransferFinished
+            reply->readAll();
+            return;
+        } else if (status == 200 && sameFile(reply, download.mimeType, download.totalBytes)) {
+            // the server sends the whole file, as it doesn't support ranges
+            // or the file has changed
+            download.receivedBytes = 0;
+            totalBytes = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+            mode |= QIODevice::Truncate;
+        } else {
+            qWarning() << Q_FUNC_INFO << "Unexpected response" << status << reply->header(QNetworkRequest::ContentTypeHeader).toString() << "for"
+                       << download.url;
+            reply->abort();
+            return;
+        }
+
+        download.file = std::make_shared<QFile>(download.path);
+        if (!download.file->open(mode)) {
+            qWarning() << Q_FUNC_INFO << "Failed to open" << download.path;
+            reply->abort();
+            return;
+        }
+        download.totalBytes = totalBytes > 0 ? totalBytes : -1;
+        download.sampleBytes = download.receivedBytes;
+        setValidator(download, validator(reply));
+    }
+
+    const QByteArray data = reply->readAll();
+    if (download.file->write(data) != data.size()) {
+        qWarning() << Q_FUNC_INFO << "Failed to write to" << download.path;
+        reply->abort();
+        return;
+    }
+    updateProgress(id, download.receivedBytes + data.size(), download.totalBytes);
+}
+
+void DownloadManager::onTransferFinished(int id)
+{
+    const int row = rowOf(id);
+    if (row < 0)
+        return;
+
+    Download &download = m_downloads[row];
+    QNetworkReply *reply = download.reply;
+    if (!reply)
+        return;
+
+    if (reply->error() == QNetworkReply::NoError && reply->bytesAvailable() > 0)
+        onTransferData(id);
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const QNetworkReply::NetworkError error = reply->error();
+    reply->deleteLater();
+    download.reply.clear();
+    if (download.file) {
+        download.file->close();
+        download.file.reset();
+    }
+
+    // paused or cancelled
+    if (download.state != Downloading)
+        return;
+
+    // the file was complete already
+    const bool complete = status == 416 && download.totalBytes > 0 && download.receivedBytes >= download.totalBytes;
+    if ((error == QNetworkReply::NoError && (download.totalBytes < 0 || download.receivedBytes >= download.totalBytes)) || complete) {
+        setState(id, Completed);
+    } else {
+        qWarning() << Q_FUNC_INFO << "Download of" << download.url << "failed:" << error << status;
+        setState(id, Failed);
+    }
+    schedule();
+}
+
+void DownloadManager::onItemStateChanged(int id)
+{
+    const int row = rowOf(id);
+    if (row < 0)
+        return;
+
+    Download &download = m_downloads[row];
+    if (!download.item)
+        return;
+
+    switch (download.item->state()) {
+    case QQuickWebEngineDownloadItem::DownloadCompleted:
+        updateProgress(id, download.item->receivedBytes(), download.item->totalBytes());
+        setState(id, Completed);
+        break;
+    case QQuickWebEngineDownloadItem::DownloadInterrupted:
+        qWarning() << Q_FUNC_INFO << "Download of" << download.url << "interrupted:" << download.item->interruptReasonString();
+        setState(id, Failed);
+        break;
+    case QQuickWebEngineDownloadItem::DownloadCancelled:
+        // cancelled by the engine, e.g. when the page was closed
+        cancel(id);
+        return;
+    default:
+        return;
+    }
+    schedule();
+}
+
+void DownloadManager::updateProgress(int id, qint64 receivedBytes, qint64 totalBytes)
+{
+    const int row = rowOf(id);
+    if (row < 0)
+        return;
+
+    Download &download = m_downloads[row];
+    const qint64 now = m_clock.elapsed();
+    const qint64 elapsed = now - download.sampleTime;
+    if (elapsed >= SPEED_SAMPLE_INTERVAL) {
+        const double speed = (receivedBytes - download.sampleBytes) * 1000.0 / elapsed;
+        download.speed = download.speed > 0 ? SPEED_SMOOTHING * speed + (1 - SPEED_SMOOTHING) * download.speed : speed;
+        download.sampleTime = now;
+        download.sampleBytes = receivedBytes;
+    }
+
+    download.receivedBytes = receivedBytes;
+    download.totalBytes = totalBytes;
+    if (now - download.persistTime >= PERSIST_INTERVAL) {
+        persist(download);
+        download.persistTime = now;
+    }
+
+    const QModelIndex index = this->index(row);
+    emit dataChanged(index, index, {ReceivedBytesRole, TotalBytesRole, SpeedRole, RemainingTimeRole});
+}
+
+void DownloadManager::setState(int id, State state)
+{
+    const int row = rowOf(id);
+    if (row < 0)
+        return;
+
+    Download &download = m_downloads[row];
+    if (download.state == state)
+        return;
+
+    const bool wasActive = download.state == Downloading;
+    download.state = state;
+    persist(download);
+
+    const QModelIndex index = this->index(row);
+    emit dataChanged(index, index, {StateRole, SpeedRole, RemainingTimeRole});
+
+    if (wasActive != (state == Downloading)) {
+        m_activeCount += wasActive ? -1 : 1;
+        emit activeCountChanged();
+    }
+
+    if (state == Completed || state == Failed)
+        emit downloadFinished(QFileInfo(download.path).fileName(), state);
+}
+
+void DownloadManager::persist(const Download &download)
+{
+    BrowserManager::instance()->updateDownload(download.id, download.receivedBytes, download.totalBytes, download.state);
+}
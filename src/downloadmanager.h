@@ -0,0 +1,165 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef DOWNLOADMANAGER_H
+#define DOWNLOADMANAGER_H
+
+#include <QAbstractListModel>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+
+#include <memory>
+
+class QFile;
+class QNetworkAccessManager;
+class QNetworkReply;
+class QQuickWebEngineDownloadItem;
+
+/**
+ * @class DownloadManager
+ * @short Owns the downloads of all profiles and lists them for the downloads page.
+ *
+ * Downloads are queued once the user confirmed them, and only a limited
+ * number of them is transferred at the same time. Their state is stored in
+ * the database, so they can be continued after a restart: as the web engine
+ * can't resume downloads of an earlier session, these are requested again
+ * with a range starting at the size of the partial file, together with the
+ * cookies of the profiles added.
+ *
+ * The range is only requested if the partial file can be identified by its
+ * ETag or Last-Modified date, which is sent as If-Range. The web engine
+ * doesn't expose the response headers, so they are requested separately
+ * when a download is added. If the server sends the whole file instead, it
+ * is downloaded again as long as its type and size are still those of the
+ * download, otherwise, e.g. for a login page, the download fails and the
+ * partial file is left alone.
+ */
+class DownloadManager : public QAbstractListModel
+{
+    Q_OBJECT
+
+    // maximum number of downloads transferred at the same time
+    Q_PROPERTY(int maximumActive READ maximumActive WRITE setMaximumActive NOTIFY maximumActiveChanged)
+    Q_PROPERTY(int activeCount READ activeCount NOTIFY activeCountChanged)
+
+public:
+    // stored in the database, only append
+    enum State {
+        Requested, // waiting for confirmation by the user
+        Queued,
+        Downloading,
+        Paused,
+        Completed,
+        Failed,
+    };
+    Q_ENUM(State)
+
+    enum Role {
+        IdRole = Qt::UserRole + 1,
+        UrlRole,
+        PathRole,
+        FileNameRole,
+        MimeTypeRole,
+        ReceivedBytesRole,
+        TotalBytesRole,
+        StateRole,
+        // bytes per second
+        SpeedRole,
+        // estimated seconds until completion, -1 if unknown
+        RemainingTimeRole,
+    };
+
+    explicit DownloadManager(QObject *parent = nullptr);
+    ~DownloadManager() override;
+
+    // instance following the application settings
+    static DownloadManager *instance();
+
+    QHash<int, QByteArray> roleNames() const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    int maximumActive() const;
+    void setMaximumActive(int maximum);
+
+    int activeCount() const;
+
+    // takes over a download requested by a profile (a QQuickWebEngineDownloadItem),
+    // which waits for confirmation. Returns its id.
+    Q_INVOKABLE int add(QObject *download, bool offTheRecord = false);
+
+    // the cookies of the profile (a QQuickWebEngineProfile) are sent when
+    // continuing downloads, unless it is off the record
+    Q_INVOKABLE void addProfile(QObject *profile);
+
+    Q_INVOKABLE void start(int id);
+    Q_INVOKABLE void pause(int id);
+    Q_INVOKABLE void resume(int id);
+    // stops the download and removes it together with the partial file
+    Q_INVOKABLE void cancel(int id);
+    // removes a finished download from the list, the file is kept
+    Q_INVOKABLE void remove(int id);
+    Q_INVOKABLE void clearFinished();
+
+signals:
+    void maximumActiveChanged();
+    void activeCountChanged();
+    void downloadFinished(const QString &fileName, DownloadManager::State state);
+
+private:
+    struct Download {
+        int id = -1;
+        QUrl url;
+        QString path;
+        QString mimeType;
+        qint64 receivedBytes = 0;
+        qint64 totalBytes = -1;
+        State state = Requested;
+        // ETag or Last-Modified of the file, empty if unknown
+        QString validator;
+
+        // set while the web engine handles the download
+        QPointer<QQuickWebEngineDownloadItem> item;
+        // set while a download of an earlier session is transferred
+        QPointer<QNetworkReply> reply;
+        std::shared_ptr<QFile> file;
+
+        // throughput, smoothed over the samples
+        double speed = 0;
+        qint64 sampleTime = 0;
+        qint64 sampleBytes = 0;
+        qint64 persistTime = 0;
+    };
+
+    int rowOf(int id) const;
+    void schedule();
+    // looks up the validator of a download of the web engine
+    void requestValidator(int id);
+    void setValidator(Download &download, const QString &validator);
+    void transfer(Download &download);
+    void onTransferData(int id);
+    void onTransferFinished(int id);
+    void onItemStateChanged(int id);
+    void updateProgress(int id, qint64 receivedBytes, qint64 totalBytes);
+    void setState(int id, State state);
+    void persist(const Download &download);
+
+    QVector<Download> m_downloads;
+    int m_maximumActive = 2;
+    int m_activeCount = 0;
+    QNetworkAccessManager *m_network;
+    QElapsedTimer m_clock;
+    // running while the cookies of a profile are being loaded
+    QTimer m_cookieTimer;
+
+    static DownloadManager *s_instance;
+};
+
+#endif // DOWNLOADMANAGER_H
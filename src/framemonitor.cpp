@@ -0,0 +1,386 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "framemonitor.h"
+#include "metrics.h"
+
+#include <QAbstractEventDispatcher>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QQuickWindow>
+#include <QScreen>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cmath>
+
+// ms between two updates of the statistics
+constexpr int UPDATE_INTERVAL = 500;
+// frames longer than this many refresh intervals are janky
+constexpr qreal JANK_FACTOR = 1.5;
+// traced operations kept in memory while the monitor is enabled
+constexpr int HISTORY_SIZE = 8192;
+// intervals the percentiles are computed from, a minute at 60 Hz
+constexpr int INTERVAL_COUNT = 3600;
+constexpr int MAX_JANKY_FRAMES = 100;
+
+FrameMonitor *FrameMonitor::s_instance = nullptr;
+
+FrameMonitor::FrameMonitor(QObject *parent)
+    : QObject(parent)
+    , m_budget(1000.0 / 60)
+{
+    m_updateTimer.setInterval(UPDATE_INTERVAL);
+    connect(&m_updateTimer, &QTimer::timeout, this, &FrameMonitor::update);
+}
+
+FrameMonitor::~FrameMonitor()
+{
+    setEnabled(false);
+}
+
+FrameMonitor *FrameMonitor::instance()
+{
+    if (!s_instance)
+        s_instance = new FrameMonitor();
+
+    return s_instance;
+}
+
+bool FrameMonitor::enabled() const
+{
+    return m_enabled;
+}
+
+void FrameMonitor::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+
+    m_enabled = enabled;
+    if (m_enabled) {
+        Tracer::instance()->setHistorySize(HISTORY_SIZE);
+        {
+            // the interval to the frame before doesn't count
+            QMutexLocker locker(&m_mutex);
+            m_lastFrame = -1;
+        }
+        connectWindow();
+        m_lastUpdate = Tracer::now();
+        m_updateTimer.start();
+    } else {
+        if (m_window) {
+            disconnect(m_window, &QQuickWindow::frameSwapped, this, nullptr);
+            disconnect(QAbstractEventDispatcher::instance(m_window->thread()), nullptr, this, nullptr);
+        }
+        m_updateTimer.stop();
+        resolvePending();
+        Tracer::instance()->setHistorySize(0);
+    }
+    emit enabledChanged();
+}
+
+void FrameMonitor::watchWindow(QQuickWindow *window)
+{
+    if (m_window) {
+        disconnect(m_window, nullptr, this, nullptr);
+        disconnect(QAbstractEventDispatcher::instance(m_window->thread()), nullptr, this, nullptr);
+    }
+
+    m_window = window;
+    if (!m_window)
+        return;
+
+    connect(m_window, &QQuickWindow::screenChanged, this, &FrameMonitor::updateBudget);
+    updateBudget();
+    if (m_enabled)
+        connectWindow();
+}
+
+void FrameMonitor::addFrame(qint64 timestamp)
+{
+    QMutexLocker locker(&m_mutex);
+    // after being idle, the frame starts when the GUI thread woke up
+    const qint64 previous = m_lastFrame < 0 ? -1 : std::max(m_lastFrame, m_lastWakeUp);
+    m_lastFrame = timestamp;
+
+    const qint64 interval = timestamp - previous;
+    if (previous < 0 || interval <= 0)
+        return;
+
+    m_frameCount++;
+    m_worstFrame = std::max(m_worstFrame, interval);
+    if (m_intervals.size() < INTERVAL_COUNT)
+        m_intervals.append(interval);
+    else
+        m_intervals[m_nextInterval] = interval;
+    m_nextInterval = (m_nextInterval + 1) % INTERVAL_COUNT;
+
+    const bool janky = interval > m_budget * 1000 * JANK_FACTOR;
+    if (janky) {
+        m_jankCount++;
+        m_pending.append({previous, interval, {}});
+    }
+    locker.unlock();
+
+    Metrics::instance()->add(QStringLiteral("frames.total"));
+    if (janky)
+        Metrics::instance()->add(QStringLiteral("frames.janky"));
+    Metrics::instance()->record(QStringLiteral("frames.interval_ms"), interval / 1000);
+}
+
+void FrameMonitor::addWakeUp(qint64 timestamp)
+{
+    QMutexLocker locker(&m_mutex);
+    m_lastWakeUp = timestamp;
+}
+
+qreal FrameMonitor::fps() const
+{
+    return m_fps;
+}
+
+int FrameMonitor::frameCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frameCount;
+}
+
+int FrameMonitor::jankCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_jankCount;
+}
+
+qreal FrameMonitor::worstFrame() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_worstFrame / 1000.0;
+}
+
+qreal FrameMonitor::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budget;
+}
+
+void FrameMonitor::setBudget(qreal budget)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (qFuzzyCompare(m_budget, budget) || budget <= 0)
+            return;
+        m_budget = budget;
+    }
+    emit statisticsChanged();
+}
+
+QVector<FrameMonitor::JankyFrame> FrameMonitor::jankyFrames()
+{
+    resolvePending();
+
+    QMutexLocker locker(&m_mutex);
+    return m_jankyFrames;
+}
+
+QJsonObject FrameMonitor::report()
+{
+    const QVector<JankyFrame> frames = jankyFrames();
+    const qint64 guiThread = Tracer::currentThread();
+
+    QMutexLocker locker(&m_mutex);
+    QVector<qint64> intervals = m_intervals;
+    const int frameCount = m_frameCount;
+    const int jankCount = m_jankCount;
+    const qreal budget = m_budget;
+    locker.unlock();
+
+    std::sort(intervals.begin(), intervals.end());
+    const auto percentile = [&intervals](qreal fraction) {
+        if (intervals.isEmpty())
+            return -1.0;
+        const int rank = std::max(1, int(std::ceil(fraction * intervals.size())));
+        return intervals.at(rank - 1) / 1000.0;
+    };
+
+    struct Attribution {
+        QString name;
+        QString category;
+        int frames = 0;
+        qint64 overlap = 0;
+        bool guiThread = false;
+    };
+    QHash<QString, Attribution> attributions;
+
+    QJsonArray jankyFrames;
+    for (const JankyFrame &frame : frames) {
+        const qint64 end = frame.start + frame.interval;
+        QJsonArray operations;
+        for (const Tracer::Event &event : frame.operations) {
+            const qint64 overlap = std::min(end, event.start + event.duration) - std::max(frame.start, event.start);
+            QJsonObject operation{
+                {QStringLiteral("name"), QString::fromLatin1(event.name)},
+                {QStringLiteral("category"), QString::fromLatin1(event.category)},
+                {QStringLiteral("thread"), event.thread},
+                {QStringLiteral("guiThread"), event.thread == guiThread},
+                {QStringLiteral("duration_ms"), event.duration / 1000.0},
+                {QStringLiteral("overlap_ms"), overlap / 1000.0},
+            };
+            if (!event.argument.isEmpty())
+                operation.insert(QStringLiteral("detail"), event.argument);
+            operations.append(operation);
+
+            const QString key = QString::fromLatin1(event.category) + QLatin1Char('/') + QString::fromLatin1(event.name);
+            Attribution &attribution = attributions[key];
+            attribution.name = QString::fromLatin1(event.name);
+            attribution.category = QString::fromLatin1(event.category);
+            attribution.frames++;
+            attribution.overlap += overlap;
+            attribution.guiThread |= event.thread == guiThread;
+        }
+
+        jankyFrames.append(QJsonObject{
+            {QStringLiteral("start_us"), frame.start},
+            {QStringLiteral("interval_ms"), frame.interval / 1000.0},
+            {QStringLiteral("operations"), operations},
+        });
+    }
+
+    // the code paths that overlapped the janky frames the longest come first
+    QVector<Attribution> sorted = attributions.values().toVector();
+    std::sort(sorted.begin(), sorted.end(), [](const Attribution &a, const Attribution &b) {
+        return a.overlap > b.overlap;
+    });
+    QJsonArray attribution;
+    for (const Attribution &operation : qAsConst(sorted)) {
+        attribution.append(QJsonObject{
+            {QStringLiteral("name"), operation.name},
+            {QStringLiteral("category"), operation.category},
+            {QStringLiteral("frames"), operation.frames},
+            {QStringLiteral("overlap_ms"), operation.overlap / 1000.0},
+            {QStringLiteral("guiThread"), operation.guiThread},
+        });
+    }
+
+    return {
+        {QStringLiteral("frames"), frameCount},
+        {QStringLiteral("janky"), jankCount},
+        {QStringLiteral("budget_ms"), budget},
+        {QStringLiteral("interval_ms"),
+         QJsonObject{
+             {QStringLiteral("median"), percentile(0.5)},
+             {QStringLiteral("p90"), percentile(0.9)},
+             {QStringLiteral("p99"), percentile(0.99)},
+             {QStringLiteral("max"), intervals.isEmpty() ? -1.0 : intervals.last() / 1000.0},
+         }},
+        {QStringLiteral("jankyFrames"), jankyFrames},
+        {QStringLiteral("attribution"), attribution},
+    };
+}
+
+QString FrameMonitor::writeReport()
+{
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(directory);
+
+    const QString path = directory + QStringLiteral("/frames-%1.json").arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-hhmmss")));
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << Q_FUNC_INFO << "Failed to write frame report" << path << file.errorString();
+        return {};
+    }
+    file.write(QJsonDocument(report()).toJson());
+    return path;
+}
+
+void FrameMonitor::reset()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastFrame = -1;
+        m_frameCount = 0;
+        m_jankCount = 0;
+        m_worstFrame = 0;
+        m_intervals.clear();
+        m_nextInterval = 0;
+        m_jankyFrames.clear();
+        m_pending.clear();
+    }
+    m_fps = 0;
+    m_lastFrameCount = 0;
+    m_lastUpdate = Tracer::now();
+    emit statisticsChanged();
+}
+
+void FrameMonitor::update()
+{
+    resolvePending();
+
+    const qint64 now = Tracer::now();
+    const int frames = frameCount();
+    if (now > m_lastUpdate)
+        m_fps = (frames - m_lastFrameCount) * 1000000.0 / (now - m_lastUpdate);
+    m_lastFrameCount = frames;
+    m_lastUpdate = now;
+    emit statisticsChanged();
+}
+
+void FrameMonitor::resolvePending()
+{
+    QVector<JankyFrame> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        pending.swap(m_pending);
+    }
+    if (pending.isEmpty())
+        return;
+
+    for (JankyFrame &frame : pending)
+        frame.operations = Tracer::instance()->events(frame.start, frame.start + frame.interval);
+
+    QMutexLocker locker(&m_mutex);
+    m_jankyFrames += pending;
+    if (m_jankyFrames.size() > MAX_JANKY_FRAMES)
+        m_jankyFrames.remove(0, m_jankyFrames.size() - MAX_JANKY_FRAMES);
+}
+
+void FrameMonitor::updateBudget()
+{
+    if (m_window && m_window->screen() && m_window->screen()->refreshRate() > 0)
+        setBudget(1000 / m_window->screen()->refreshRate());
+}
+
+void FrameMonitor::connectWindow()
+{
+    if (!m_window)
+        return;
+
+    // the frame is swapped in the render thread, that is when it is measured
+    connect(
+        m_window,
+        &QQuickWindow::frameSwapped,
+        this,
+        [this] {
+            addFrame(Tracer::now());
+        },
+        Qt::DirectConnection);
+    // a GUI thread that isn't blocked waits for events between two frames
+    connect(
+        QAbstractEventDispatcher::instance(m_window->thread()),
+        &QAbstractEventDispatcher::awake,
+        this,
+        [this] {
+            addWakeUp(Tracer::now());
+        },
+        Qt::DirectConnection);
+}
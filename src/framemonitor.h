@@ -0,0 +1,133 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FRAMEMONITOR_H
+#define FRAMEMONITOR_H
+
+#include <QJsonObject>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+#include "tracer.h"
+
+class QQuickWindow;
+
+/**
+ * @class FrameMonitor
+ * @short Finds frames that missed their budget and what ran meanwhile.
+ *
+ * While enabled, the interval between two swapped frames of the window is
+ * measured in the render thread, so the time the GUI thread spent between
+ * them, e.g. in a handler writing to the database, is part of the frame. A
+ * frame is janky if it took longer than one and a half times the refresh
+ * interval of the screen. The traced operations overlapping a janky frame,
+ * like SQL statements, writing the tabs or decoding icons, are taken from
+ * the in-memory history of the Tracer, which is kept while the monitor is
+ * enabled.
+ *
+ * The window only renders when something has changed. If the GUI thread
+ * has waited for events since the last frame, the window has been idle, and
+ * the next frame is measured from the moment the GUI thread woke up.
+ *
+ * Counts and intervals are also exported as frames.* metrics.
+ */
+class FrameMonitor : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    // frames per second, over the last update
+    Q_PROPERTY(qreal fps READ fps NOTIFY statisticsChanged)
+    Q_PROPERTY(int frameCount READ frameCount NOTIFY statisticsChanged)
+    Q_PROPERTY(int jankCount READ jankCount NOTIFY statisticsChanged)
+    // longest frame interval in ms since the last reset
+    Q_PROPERTY(qreal worstFrame READ worstFrame NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal budget READ budget NOTIFY statisticsChanged)
+
+public:
+    struct JankyFrame {
+        qint64 start = 0; // µs, see Tracer::now()
+        qint64 interval = 0; // µs
+        QVector<Tracer::Event> operations;
+    };
+
+    explicit FrameMonitor(QObject *parent = nullptr);
+    ~FrameMonitor() override;
+
+    static FrameMonitor *instance();
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    void watchWindow(QQuickWindow *window);
+
+    // called with the time the frame has been swapped, from any thread
+    void addFrame(qint64 timestamp);
+    // called with the time the GUI thread stopped waiting for events
+    void addWakeUp(qint64 timestamp);
+
+    qreal fps() const;
+    int frameCount() const;
+    int jankCount() const;
+    qreal worstFrame() const;
+
+    // refresh interval of the screen in ms
+    qreal budget() const;
+    void setBudget(qreal budget);
+
+    // the latest janky frames, oldest first
+    QVector<JankyFrame> jankyFrames();
+
+    // to be called in the GUI thread, which the operations are compared to
+    QJsonObject report();
+    // writes the report into the data directory, returns its path
+    Q_INVOKABLE QString writeReport();
+    Q_INVOKABLE void reset();
+
+signals:
+    void enabledChanged();
+    void statisticsChanged();
+
+private:
+    void update();
+    // looks up the operations overlapping the new janky frames, which is
+    // done at the next update, once the operations have finished
+    void resolvePending();
+    void updateBudget();
+    void connectWindow();
+
+    bool m_enabled = false;
+    QPointer<QQuickWindow> m_window;
+    QTimer m_updateTimer;
+    qreal m_fps = 0;
+    int m_lastFrameCount = 0;
+    qint64 m_lastUpdate = 0;
+
+    // written in the render thread
+    mutable QMutex m_mutex;
+    qreal m_budget;
+    qint64 m_lastFrame = -1;
+    // written in the GUI thread
+    qint64 m_lastWakeUp = -1;
+    int m_frameCount = 0;
+    int m_jankCount = 0;
+    qint64 m_worstFrame = 0;
+    // ring buffer of the latest intervals in µs
+    QVector<qint64> m_intervals;
+    int m_nextInterval = 0;
+    QVector<JankyFrame> m_jankyFrames;
+    // janky frames whose operations haven't been looked up yet
+    QVector<JankyFrame> m_pending;
+
+    static FrameMonitor *s_instance;
+};
+
+#endif // FRAMEMONITOR_H
@@ -0,0 +1,67 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "historysections.h"
+#include "browsermanager.h"
+
+#include <QDateTime>
+
+#include <algorithm>
+
+HistorySections::HistorySections(QObject *parent)
+    : QObject(parent)
+{
+    connect(BrowserManager::instance(), &BrowserManager::databaseTableChanged, this, [this](const QString &table) {
+        if (table == QLatin1String("history"))
+            reload();
+    });
+
+    // today's entries become yesterday's
+    m_midnightTimer.setSingleShot(true);
+    connect(&m_midnightTimer, &QTimer::timeout, this, &HistorySections::reload);
+    reload();
+}
+
+qint64 HistorySections::today() const
+{
+    return m_entries[Today];
+}
+
+qint64 HistorySections::yesterday() const
+{
+    return m_entries[Yesterday];
+}
+
+qint64 HistorySections::older() const
+{
+    return m_entries[Older];
+}
+
+void HistorySections::reload()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    const QDate today = now.date();
+
+    qint64 entries[Older + 1] = {};
+    const auto days = BrowserManager::instance()->historyDays();
+    for (const auto &day : days) {
+        if (day.day == today)
+            entries[Today] += day.entries;
+        else if (day.day == today.addDays(-1))
+            entries[Yesterday] += day.entries;
+        else
+            entries[Older] += day.entries;
+    }
+
+    m_midnightTimer.start(now.msecsTo(today.addDays(1).startOfDay()) + 1000);
+
+    if (std::equal(std::begin(entries), std::end(entries), std::begin(m_entries)))
+        return;
+    std::copy(std::begin(entries), std::end(entries), std::begin(m_entries));
+    emit entriesChanged();
+}
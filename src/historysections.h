@@ -0,0 +1,56 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef HISTORYSECTIONS_H
+#define HISTORYSECTIONS_H
+
+#include <QObject>
+#include <QTimer>
+
+/**
+ * @class HistorySections
+ * @short Number of history entries in the sections of the history page.
+ *
+ * The entries are grouped by the day they have been visited last, the
+ * section of an entry is the section role of BookmarksHistoryModel. The
+ * numbers are read from the entries per day the database keeps up to date,
+ * which has a row per day with history, and are updated at midnight.
+ */
+class HistorySections : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(qint64 today READ today NOTIFY entriesChanged)
+    Q_PROPERTY(qint64 yesterday READ yesterday NOTIFY entriesChanged)
+    Q_PROPERTY(qint64 older READ older NOTIFY entriesChanged)
+
+public:
+    enum Section {
+        Today,
+        Yesterday,
+        Older,
+    };
+    Q_ENUM(Section)
+
+    explicit HistorySections(QObject *parent = nullptr);
+
+    qint64 today() const;
+    qint64 yesterday() const;
+    qint64 older() const;
+
+    Q_INVOKABLE void reload();
+
+signals:
+    void entriesChanged();
+
+private:
+    qint64 m_entries[Older + 1] = {};
+    QTimer m_midnightTimer;
+};
+
+#endif // HISTORYSECTIONS_H
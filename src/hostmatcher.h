@@ -0,0 +1,87 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef HOSTMATCHER_H
+#define HOSTMATCHER_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @class HostMatcher
+ * @short Maps host and domain patterns to values.
+ *
+ * A pattern like "example.org" matches the host itself and all of its
+ * subdomains. A leading "*." is accepted and ignored. Patterns are stored in
+ * a hash, and a lookup walks the suffixes of the host from the most specific
+ * one, so the cost of a lookup depends on the number of labels in the host
+ * and not on the number of patterns.
+ */
+template<typename T>
+class HostMatcher
+{
+public:
+    void insert(const QString &pattern, const T &value)
+    {
+        m_patterns.insert(normalized(pattern), value);
+    }
+
+    bool remove(const QString &pattern)
+    {
+        return m_patterns.remove(normalized(pattern)) > 0;
+    }
+
+    void clear()
+    {
+        m_patterns.clear();
+    }
+
+    int count() const
+    {
+        return m_patterns.count();
+    }
+
+    QStringList patterns() const
+    {
+        return m_patterns.keys();
+    }
+
+    // value of the most specific pattern matching the host, nullptr if none does
+    const T *find(const QString &host) const
+    {
+        if (m_patterns.isEmpty() || host.isEmpty())
+            return nullptr;
+
+        const QString h = host.toLower();
+        int from = 0;
+        while (from >= 0) {
+            const auto it = m_patterns.constFind(from == 0 ? h : h.mid(from));
+            if (it != m_patterns.cend())
+                return &it.value();
+
+            const int dot = h.indexOf(QLatin1Char('.'), from);
+            from = dot < 0 ? -1 : dot + 1;
+        }
+        return nullptr;
+    }
+
+    // pattern under which the value is stored for the given input
+    static QString normalized(const QString &pattern)
+    {
+        QString p = pattern.trimmed().toLower();
+        if (p.startsWith(QLatin1String("*.")))
+            p.remove(0, 2);
+        return p;
+    }
+
+private:
+    QHash<QString, T> m_patterns;
+};
+
+#endif // HOSTMATCHER_H
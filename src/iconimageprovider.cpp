@@ -8,6 +8,9 @@
  ***************************************************************************/
 
 #include "iconimageprovider.h"
+#include "dbmanager.h"
+#include "metrics.h"
+#include "tracer.h"
 
 #include <QBuffer>
 #include <QByteArray>
@@ -37,6 +40,7 @@ QString IconImageProvider::providerId()
 
 QString IconImageProvider::storeImage(const QString &iconSource)
 {
+    TraceScope trace("IconImageProvider::storeImage", "icons");
     const QLatin1String prefix_favicon = QLatin1String("image://favicon/");
     if (!iconSource.startsWith(prefix_favicon)) {
         // don't know what to do with it, return as it is
@@ -49,7 +53,7 @@ QString IconImageProvider::storeImage(const QString &iconSource)
 
     // check if we have that image already
     QSqlQuery query_check;
-    query_check.prepare(QStringLiteral("SELECT 1 FROM icons WHERE url = :url LIMIT 1"));
+    DBManager::prepare(query_check, QStringLiteral("SELECT 1 FROM icons WHERE url = :url LIMIT 1"));
     query_check.bindValue(QStringLiteral(":url"), url);
     if (!query_check.exec()) {
         qWarning() << Q_FUNC_INFO << "Failed to execute SQL statement";
@@ -61,9 +65,11 @@ QString IconImageProvider::storeImage(const QString &iconSource)
     if (query_check.next()) {
         // there is corresponding record in the database already
         // no need to store it again
+        Metrics::instance()->add(QStringLiteral("icons.store_hits"));
         return url;
     }
     query_check.finish();
+    Metrics::instance()->add(QStringLiteral("icons.store_misses"));
 
     // Store new icon
     QQuickImageProvider *provider = dynamic_cast<QQuickImageProvider *>(s_engine->imageProvider(QStringLiteral("favicon")));
@@ -101,7 +107,7 @@ QString IconImageProvider::storeImage(const QString &iconSource)
     }
 
     QSqlQuery query_write;
-    query_write.prepare(QStringLiteral("INSERT INTO icons(url, icon) VALUES (:url, :icon)"));
+    DBManager::prepare(query_write, QStringLiteral("INSERT INTO icons(url, icon) VALUES (:url, :icon)"));
     query_write.bindValue(QStringLiteral(":url"), url);
     query_write.bindValue(QStringLiteral(":icon"), data);
     if (!query_write.exec()) {
@@ -116,9 +122,16 @@ QString IconImageProvider::storeImage(const QString &iconSource)
 
 QImage IconImageProvider::requestImage(const QString &id, QSize *size, const QSize & /*requestedSize*/)
 {
+    TraceScope trace("IconImageProvider::requestImage", "icons");
+    // urls starting with the id, as a range which the index on url is used for
+    const QString from = QStringLiteral("image://%1/%2").arg(providerId(), id);
+    QString to = from;
+    to[to.size() - 1] = QChar(to.at(to.size() - 1).unicode() + 1);
+
     QSqlQuery query;
-    query.prepare(QStringLiteral("SELECT icon FROM icons WHERE url LIKE :url LIMIT 1"));
-    query.bindValue(QStringLiteral(":url"), QStringLiteral("image://%1/%2%").arg(providerId(), id));
+    DBManager::prepare(query, QStringLiteral("SELECT icon FROM icons WHERE url >= :from AND url < :to LIMIT 1"));
+    query.bindValue(QStringLiteral(":from"), from);
+    query.bindValue(QStringLiteral(":to"), to);
     if (!query.exec()) {
         qWarning() << Q_FUNC_INFO << "Failed to execute SQL statement";
         qWarning() << query.lastQuery();
@@ -127,6 +140,7 @@ QImage IconImageProvider::requestImage(const QString &id, QSize *size, const QSi
     }
 
     if (query.next()) {
+        Metrics::instance()->add(QStringLiteral("icons.request_hits"));
         QImage image = QImage::fromData(query.value(0).toByteArray());
         if (size) {
             size->setHeight(image.height());
@@ -135,6 +149,7 @@ QImage IconImageProvider::requestImage(const QString &id, QSize *size, const QSi
         return image;
     }
 
+    Metrics::instance()->add(QStringLiteral("icons.request_misses"));
     qWarning() << "Failed to find icon for" << id;
     return {};
 }
@@ -7,7 +7,9 @@
 #include <QApplication>
 #include <QCommandLineOption>
 #include <QCommandLineParser>
+#include <QDBusConnection>
 #include <QQmlApplicationEngine>
+#include <QStandardPaths>
 #include <QUrl>
 #include <QtQml>
 #include <QtWebEngine>
@@ -19,13 +21,34 @@
 
 #include <signal.h>
 
+#include "adblockmanager.h"
+#include "benchmarkdriver.h"
 #include "bookmarkshistorymodel.h"
+#include "browsingdatacleaner.h"
+#include "datasaver.h"
+#include "datatransfer.h"
+#include "downloadmanager.h"
+#include "framemonitor.h"
 #include "browsermanager.h"
+#include "historysections.h"
 #include "iconimageprovider.h"
+#include "metrics.h"
+#include "pagetextindex.h"
+#include "profilemanager.h"
+#include "requestinterceptor.h"
+#include "siteperformancemodel.h"
+#include "snapshotstore.h"
+#include "speculationservice.h"
+#include "startupmonitor.h"
+#include "tabresourcemonitor.h"
 #include "tabsmodel.h"
+#include "topsitesmodel.h"
+#include "tracer.h"
 #include "urlobserver.h"
 #include "urlutils.h"
 #include "useragent.h"
+#include "useragentrules.h"
+#include "warminstance.h"
 #include "desktopfilegenerator.h"
 #include "angelfishsettings.h"
 
@@ -34,6 +57,17 @@ Q_DECL_EXPORT int main(int argc, char *argv[])
     QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QGuiApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
 
+    // Benchmarks run without a display and in a profile of their own, which
+    // has to be set up before the application is created
+    const bool benchmark = std::any_of(argv, argv + argc, [](const char *argument) {
+        return qstrcmp(argument, "--benchmark") == 0;
+    });
+    if (benchmark) {
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
     // Setup QtWebEngine
     qputenv("QTWEBENGINE_DIALOG_SET", "QtQuickControls2");
 #if QT_VERSION > QT_VERSION_CHECK(5, 14, 0)
@@ -52,15 +86,56 @@ Q_DECL_EXPORT int main(int argc, char *argv[])
     // Command line parser
     QCommandLineParser parser;
     parser.addPositionalArgument(QStringLiteral("url"), i18n("URL to open"), QStringLiteral("[url]"));
+    const QCommandLineOption startupTraceOption(QStringLiteral("startup-trace"), i18n("Print the duration of the startup phases"));
+    parser.addOption(startupTraceOption);
+    const QCommandLineOption backgroundOption(QStringLiteral("background"), i18n("Start hidden, so the browser opens faster when launched later"));
+    parser.addOption(backgroundOption);
+    const QCommandLineOption traceOption(QStringLiteral("trace"), i18n("Write trace events for chrome://tracing to the file"), i18n("file"));
+    parser.addOption(traceOption);
+    const QCommandLineOption benchmarkOption(QStringLiteral("benchmark"), i18n("Run the scripted scenarios of the file offscreen and print the results"), i18n("file"));
+    parser.addOption(benchmarkOption);
     parser.addHelpOption();
     parser.process(app);
 
+    auto *benchmarkDriver = BenchmarkDriver::instance();
+    if (benchmark) {
+        if (!benchmarkDriver->load(parser.value(benchmarkOption))) {
+            qWarning() << "Invalid benchmark script:" << benchmarkDriver->errorString();
+            return 1;
+        }
+        if (!benchmarkDriver->server()->start())
+            return 1;
+
+        // start every run with the same, empty profile
+        QDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).removeRecursively();
+        BrowserManager::instance()->setInitialUrl(benchmarkDriver->server()->url(QStringLiteral("/")).toString());
+    }
+
+    auto *startupMonitor = StartupMonitor::instance();
+    startupMonitor->setTraceEnabled(parser.isSet(startupTraceOption));
+
+    auto *warmInstance = WarmInstance::instance();
+    warmInstance->setEnabled(parser.isSet(backgroundOption));
+
     // QML loading
     QQmlApplicationEngine engine;
 
     // Open links in the already running window when e.g clicked on in another application.
-    KDBusService service(KDBusService::Unique, &app);
+    // Benchmarks don't interfere with the running browser.
+    KDBusService service(benchmark ? KDBusService::Multiple : KDBusService::Unique, &app);
+
+    // only in the instance that keeps running, so the trace of a running
+    // browser isn't replaced by launching it again
+    const QString tracePath = parser.isSet(traceOption) ? parser.value(traceOption) : qEnvironmentVariable("ANGELFISH_TRACE");
+    if (!tracePath.isEmpty())
+        Tracer::instance()->start(tracePath);
+
+    // polled by monitoring on the name of the service
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/Metrics"), BrowserManager::instance()->metrics(), QDBusConnection::ExportScriptableSlots);
     QObject::connect(&service, &KDBusService::activateRequested, &app, [&parser, &engine](const QStringList &arguments) {
+        // show the hidden window of an instance started in the background
+        WarmInstance::instance()->activate();
+
         parser.parse(arguments);
 
         if (!parser.positionalArguments().isEmpty()) {
@@ -104,6 +179,12 @@ Q_DECL_EXPORT int main(int argc, char *argv[])
     qmlRegisterType<UrlObserver>("org.kde.mobile.angelfish", 1, 0, "UrlObserver");
     qmlRegisterType<UserAgent>("org.kde.mobile.angelfish", 1, 0, "UserAgentGenerator");
     qmlRegisterType<TabsModel>("org.kde.mobile.angelfish", 1, 0, "TabsModel");
+    qmlRegisterType<ProfileManager>("org.kde.mobile.angelfish", 1, 0, "ProfileManager");
+    qmlRegisterType<SpeculationService>("org.kde.mobile.angelfish", 1, 0, "SpeculationService");
+    qmlRegisterType<SitePerformanceModel>("org.kde.mobile.angelfish", 1, 0, "SitePerformanceModel");
+    qmlRegisterType<HistorySections>("org.kde.mobile.angelfish", 1, 0, "HistorySections");
+    qmlRegisterType<TopSitesModel>("org.kde.mobile.angelfish", 1, 0, "TopSitesModel");
+    qmlRegisterUncreatableType<UserAgentRules>("org.kde.mobile.angelfish", 1, 0, "UserAgentRules", QStringLiteral("Only provides the rule modes"));
 
     // URL utils
     qmlRegisterSingletonType<UrlUtils>("org.kde.mobile.angelfish", 1, 0, "UrlUtils", [](QQmlEngine *, QJSEngine *) -> QObject * {
@@ -120,10 +201,44 @@ Q_DECL_EXPORT int main(int argc, char *argv[])
         return static_cast<QObject *>(new DesktopFileGenerator(engine));
     });
 
+    // Content blocker
+    qmlRegisterSingletonType<AdblockManager>("org.kde.mobile.angelfish", 1, 0, "Adblock", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(AdblockManager::instance());
+    });
+
+    // Data saver, applied by the same interceptor as the content blocker
+    static_cast<RequestInterceptor *>(AdblockManager::instance()->interceptor())->setDataSaver(DataSaver::instance());
+    qmlRegisterSingletonType<DataSaver>("org.kde.mobile.angelfish", 1, 0, "DataSaver", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(DataSaver::instance());
+    });
+    qmlRegisterSingletonType<SnapshotStore>("org.kde.mobile.angelfish", 1, 0, "Snapshots", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(SnapshotStore::instance());
+    });
+    qmlRegisterSingletonType<PageTextIndex>("org.kde.mobile.angelfish", 1, 0, "PageText", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(PageTextIndex::instance());
+    });
+    qmlRegisterSingletonType<DownloadManager>("org.kde.mobile.angelfish", 1, 0, "Downloads", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(DownloadManager::instance());
+    });
+    qmlRegisterSingletonType<DataTransfer>("org.kde.mobile.angelfish", 1, 0, "DataTransfer", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return static_cast<QObject *>(DataTransfer::instance());
+    });
+    qmlRegisterSingletonType<BrowsingDataCleaner>("org.kde.mobile.angelfish", 1, 0, "BrowsingData", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        return new BrowsingDataCleaner();
+    });
+
+    qmlRegisterSingletonInstance<BenchmarkDriver>("org.kde.mobile.angelfish", 1, 0, "Benchmark", benchmarkDriver);
+    qmlRegisterSingletonInstance<FrameMonitor>("org.kde.mobile.angelfish", 1, 0, "FrameMonitor", FrameMonitor::instance());
+    qmlRegisterSingletonInstance<TabResourceMonitor>("org.kde.mobile.angelfish", 1, 0, "TabResources", TabResourceMonitor::instance());
+    qmlRegisterSingletonInstance<Metrics>("org.kde.mobile.angelfish", 1, 0, "Metrics", BrowserManager::instance()->metrics());
+    qmlRegisterSingletonInstance<StartupMonitor>("org.kde.mobile.angelfish", 1, 0, "Startup", startupMonitor);
+    qmlRegisterSingletonInstance<WarmInstance>("org.kde.mobile.angelfish", 1, 0, "WarmInstance", warmInstance);
+
     qmlRegisterSingletonInstance<AngelfishSettings>("org.kde.mobile.angelfish", 1, 0, "Settings", AngelfishSettings::self());
 
     QObject::connect(QApplication::instance(), &QCoreApplication::aboutToQuit, QApplication::instance(), [] {
         AngelfishSettings::self()->save();
+        Tracer::instance()->stop();
     });
 
     // Setup Unix signal handlers
@@ -148,8 +263,16 @@ Q_DECL_EXPORT int main(int argc, char *argv[])
         sigaction(sig, &sa, nullptr);
     }
 
-    // Load QML
-    engine.load(QUrl(QStringLiteral("qrc:///webbrowser.qml")));
+    // Load QML, the window stays hidden until activated when started in the background
+    if (warmInstance->enabled()) {
+        engine.setInitialProperties({{QStringLiteral("visible"), false}});
+        QGuiApplication::setQuitOnLastWindowClosed(false);
+    }
+    {
+        TraceScope trace("Load QML", "startup");
+        engine.load(QUrl(QStringLiteral("qrc:///webbrowser.qml")));
+    }
+    startupMonitor->mark(StartupMonitor::QmlLoaded);
 
     const auto *window = qobject_cast<QQuickWindow *>(engine.rootObjects().first());
     QObject::connect(window, &QQuickWindow::widthChanged, AngelfishSettings::self(), [window] {
@@ -170,5 +293,26 @@ Q_DECL_EXPORT int main(int argc, char *argv[])
         return -1;
     }
 
+    // Only what is needed for the current tab is done before the first frame
+    startupMonitor->watchWindow(qobject_cast<QQuickWindow *>(engine.rootObjects().constFirst()));
+    warmInstance->setWindow(qobject_cast<QQuickWindow *>(engine.rootObjects().constFirst()));
+    FrameMonitor::instance()->watchWindow(qobject_cast<QQuickWindow *>(engine.rootObjects().constFirst()));
+    FrameMonitor::instance()->setEnabled(AngelfishSettings::frameMonitorEnabled());
+    QObject::connect(AngelfishSettings::self(), &AngelfishSettings::frameMonitorEnabledChanged, FrameMonitor::instance(), [] {
+        FrameMonitor::instance()->setEnabled(AngelfishSettings::frameMonitorEnabled());
+    });
+    startupMonitor->deferToIdle(BrowserManager::instance(), [] {
+        BrowserManager::instance()->runMaintenance();
+    });
+
+    if (benchmark) {
+        QObject::connect(benchmarkDriver, &BenchmarkDriver::finished, &app, [](int exitCode) {
+            QCoreApplication::exit(exitCode);
+        });
+        startupMonitor->deferToIdle(benchmarkDriver, [benchmarkDriver, &engine] {
+            benchmarkDriver->start(qobject_cast<QQuickWindow *>(engine.rootObjects().constFirst()));
+        });
+    }
+
     return app.exec();
 }
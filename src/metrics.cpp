@@ -0,0 +1,130 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "metrics.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+Metrics::Metrics(QObject *parent)
+    : QObject(parent)
+{
+}
+
+Metrics *Metrics::instance()
+{
+    // recorded from several threads, so it is created thread-safely
+    static Metrics metrics;
+    return &metrics;
+}
+
+const QVector<qint64> &Metrics::bucketBounds()
+{
+    static const QVector<qint64> bounds = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000};
+    return bounds;
+}
+
+void Metrics::add(const QString &name, qint64 value)
+{
+    QMutexLocker locker(&m_mutex);
+    m_values[name] += value;
+}
+
+void Metrics::set(const QString &name, qint64 value)
+{
+    QMutexLocker locker(&m_mutex);
+    m_values[name] = value;
+}
+
+void Metrics::setProvider(const QString &name, const std::function<qint64()> &provider)
+{
+    QMutexLocker locker(&m_mutex);
+    if (provider)
+        m_providers[name] = provider;
+    else
+        m_providers.remove(name);
+}
+
+qint64 Metrics::value(const QString &name) const
+{
+    QMutexLocker locker(&m_mutex);
+    const auto provider = m_providers.value(name);
+    if (provider) {
+        // the provider may record metrics itself
+        locker.unlock();
+        return provider();
+    }
+    return m_values.value(name);
+}
+
+void Metrics::record(const QString &name, qint64 sample)
+{
+    const QVector<qint64> &bounds = bucketBounds();
+    const int bucket = std::lower_bound(bounds.cbegin(), bounds.cend(), sample) - bounds.cbegin();
+
+    QMutexLocker locker(&m_mutex);
+    Histogram &histogram = m_histograms[name];
+    if (histogram.buckets.isEmpty()) {
+        histogram.buckets.fill(0, bounds.size() + 1);
+        histogram.min = sample;
+        histogram.max = sample;
+    }
+    histogram.count++;
+    histogram.sum += sample;
+    histogram.min = std::min(histogram.min, sample);
+    histogram.max = std::max(histogram.max, sample);
+    histogram.buckets[bucket]++;
+}
+
+void Metrics::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_values.clear();
+    m_histograms.clear();
+}
+
+QVariantMap Metrics::values() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVariantMap values;
+    for (auto it = m_values.cbegin(); it != m_values.cend(); ++it)
+        values.insert(it.key(), it.value());
+    const auto providers = m_providers;
+    locker.unlock();
+
+    for (auto it = providers.cbegin(); it != providers.cend(); ++it)
+        values.insert(it.key(), it.value()());
+    return values;
+}
+
+QVariantMap Metrics::histograms() const
+{
+    QVariantList bounds;
+    for (qint64 bound : bucketBounds())
+        bounds.append(bound);
+
+    QMutexLocker locker(&m_mutex);
+    QVariantMap histograms;
+    for (auto it = m_histograms.cbegin(); it != m_histograms.cend(); ++it) {
+        QVariantList buckets;
+        for (qint64 count : it->buckets)
+            buckets.append(count);
+
+        histograms.insert(it.key(),
+                          QVariantMap{
+                              {QStringLiteral("count"), it->count},
+                              {QStringLiteral("sum"), it->sum},
+                              {QStringLiteral("min"), it->min},
+                              {QStringLiteral("max"), it->max},
+                              {QStringLiteral("bounds"), bounds},
+                              {QStringLiteral("buckets"), buckets},
+                          });
+    }
+    return histograms;
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QVariantMap>
+#include <QVector>
+
+#include <functional>
+
+/**
+ * @class Metrics
+ * @short Counters and histograms describing the running browser.
+ *
+ * Values are counters and gauges, identified by a name like
+ * "sql.statements". Histograms collect samples, like the latency of the SQL
+ * statements, into buckets with exponentially growing bounds. Units are part
+ * of the name. Everything can be recorded from any thread.
+ *
+ * The registry is exported on the session bus as /Metrics under the name of
+ * the application, so it can be polled by monitoring:
+ *
+ *   qdbus org.kde.mobile.angelfish /Metrics values
+ */
+class Metrics : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.mobile.angelfish.Metrics")
+
+public:
+    static Metrics *instance();
+
+    // upper bounds of the buckets of the histograms, larger samples are
+    // counted in an additional bucket
+    static const QVector<qint64> &bucketBounds();
+
+    // adds to a counter or gauge
+    Q_INVOKABLE void add(const QString &name, qint64 value = 1);
+    void set(const QString &name, qint64 value);
+    // value computed whenever the values are read, in the thread reading them
+    void setProvider(const QString &name, const std::function<qint64()> &provider);
+    qint64 value(const QString &name) const;
+
+    // adds a sample to a histogram
+    Q_INVOKABLE void record(const QString &name, qint64 sample);
+
+    // forgets everything recorded, the providers are kept
+    void reset();
+
+public Q_SLOTS:
+    // name to value of every counter and gauge
+    Q_SCRIPTABLE QVariantMap values() const;
+    // name to a map of count, sum, min, max, bounds and buckets
+    Q_SCRIPTABLE QVariantMap histograms() const;
+
+private:
+    struct Histogram {
+        qint64 count = 0;
+        qint64 sum = 0;
+        qint64 min = 0;
+        qint64 max = 0;
+        QVector<qint64> buckets;
+    };
+
+    explicit Metrics(QObject *parent = nullptr);
+
+    mutable QMutex m_mutex;
+    QHash<QString, qint64> m_values;
+    QHash<QString, Histogram> m_histograms;
+    QHash<QString, std::function<qint64()>> m_providers;
+};
+
+#endif // METRICS_H
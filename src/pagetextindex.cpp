@@ -0,0 +1,153 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "pagetextindex.h"
+#include "browsermanager.h"
+#include "dbmanager.h"
+#include "metrics.h"
+
+#include <QtConcurrent>
+
+#include "angelfishsettings.h"
+
+// characters of a page that are indexed, the rest is cut off
+constexpr int MAX_PAGE_TEXT = 100000;
+// pages waiting to be indexed, the oldest ones are dropped
+constexpr int MAX_QUEUED_PAGES = 10;
+// the worker pauses this many times as long as indexing the page took
+constexpr int PAUSE_FACTOR = 4;
+// ms the worker pauses at least
+constexpr int MIN_PAUSE = 200;
+
+PageTextIndex *PageTextIndex::s_instance = nullptr;
+
+PageTextIndex::PageTextIndex(QObject *parent)
+    : QObject(parent)
+    , m_available(BrowserManager::instance()->hasPageText())
+    , m_maximumSize(50 * 1024 * 1024)
+{
+    m_pool.setMaxThreadCount(1);
+
+    m_pause.setSingleShot(true);
+    connect(&m_pause, &QTimer::timeout, this, &PageTextIndex::indexNext);
+
+    connect(&m_worker, &QFutureWatcher<bool>::finished, this, [this] {
+        const qint64 elapsed = m_workTimer.elapsed();
+        const bool indexed = m_worker.result();
+        if (indexed) {
+            Metrics::instance()->add(QStringLiteral("pagetext.pages"));
+            Metrics::instance()->record(QStringLiteral("pagetext.index_ms"), elapsed);
+        }
+
+        m_pause.start(qMax<qint64>(MIN_PAUSE, elapsed * PAUSE_FACTOR));
+        emit pageIndexed(m_current, indexed);
+    });
+}
+
+PageTextIndex::~PageTextIndex()
+{
+    m_worker.waitForFinished();
+}
+
+PageTextIndex *PageTextIndex::instance()
+{
+    if (s_instance)
+        return s_instance;
+
+    s_instance = new PageTextIndex();
+    auto *settings = AngelfishSettings::self();
+    s_instance->setMaximumSize(qint64(settings->pageTextIndexMaxSize()) * 1024 * 1024);
+    s_instance->setEnabled(settings->pageTextIndexEnabled());
+
+    QObject::connect(settings, &AngelfishSettings::pageTextIndexMaxSizeChanged, s_instance, [settings] {
+        s_instance->setMaximumSize(qint64(settings->pageTextIndexMaxSize()) * 1024 * 1024);
+    });
+    QObject::connect(settings, &AngelfishSettings::pageTextIndexEnabledChanged, s_instance, [settings] {
+        s_instance->setEnabled(settings->pageTextIndexEnabled());
+    });
+
+    return s_instance;
+}
+
+bool PageTextIndex::enabled() const
+{
+    return m_enabled;
+}
+
+void PageTextIndex::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+
+    m_enabled = enabled;
+    if (!m_enabled) {
+        m_queue.clear();
+        // a page still being written is removed as well
+        m_worker.waitForFinished();
+        if (m_available)
+            BrowserManager::instance()->clearPageText();
+    }
+    emit enabledChanged();
+}
+
+bool PageTextIndex::available() const
+{
+    return m_available;
+}
+
+qint64 PageTextIndex::maximumSize() const
+{
+    return m_maximumSize;
+}
+
+void PageTextIndex::setMaximumSize(qint64 maximumSize)
+{
+    if (m_maximumSize == maximumSize)
+        return;
+    m_maximumSize = maximumSize;
+    emit maximumSizeChanged();
+}
+
+bool PageTextIndex::shouldIndex(const QUrl &url) const
+{
+    return m_enabled && m_available && (url.scheme() == QLatin1String("https") || url.scheme() == QLatin1String("http"));
+}
+
+void PageTextIndex::addPage(const QString &url, const QString &title, const QString &text)
+{
+    if (!shouldIndex(QUrl(url)) || text.trimmed().isEmpty())
+        return;
+
+    // only the latest text of a page is indexed
+    for (int i = m_queue.size() - 1; i >= 0; i--) {
+        if (m_queue.at(i).url == url)
+            m_queue.remove(i);
+    }
+    m_queue.append({url, title, text.left(MAX_PAGE_TEXT)});
+    if (m_queue.size() > MAX_QUEUED_PAGES)
+        m_queue.removeFirst();
+
+    if (!m_worker.isRunning() && !m_pause.isActive())
+        indexNext();
+}
+
+void PageTextIndex::indexNext()
+{
+    if (m_queue.isEmpty() || !m_enabled)
+        return;
+
+    const Page page = m_queue.takeFirst();
+    const QString databaseFile = BrowserManager::instance()->databaseFile();
+    const qint64 maximumSize = m_maximumSize;
+
+    m_current = page.url;
+    m_workTimer.start();
+    m_worker.setFuture(QtConcurrent::run(&m_pool, [databaseFile, page, maximumSize] {
+        return DBManager::addPageText(databaseFile, page.url, page.title, page.text, maximumSize);
+    }));
+}
@@ -0,0 +1,95 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PAGETEXTINDEX_H
+#define PAGETEXTINDEX_H
+
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUrl>
+#include <QVector>
+
+/**
+ * @class PageTextIndex
+ * @short Indexes the readable text of visited pages for the history search.
+ *
+ * Once a page has been loaded outside of private mode, its web view extracts
+ * the text and hands it in here. The texts are written into an FTS5 table by
+ * a worker thread, one page at a time. After each page the worker pauses
+ * for several times as long as indexing took, so a burst of page loads
+ * doesn't keep a core and the disk busy. Pages waiting for too long are
+ * dropped.
+ *
+ * The text of a page is removed with its history entry. Beyond maximumSize,
+ * the texts indexed the longest ago are removed. Disabling the index clears
+ * it.
+ */
+class PageTextIndex : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    // false if SQLite has been built without FTS5
+    Q_PROPERTY(bool available READ available CONSTANT)
+    // in bytes
+    Q_PROPERTY(qint64 maximumSize READ maximumSize WRITE setMaximumSize NOTIFY maximumSizeChanged)
+
+public:
+    explicit PageTextIndex(QObject *parent = nullptr);
+    ~PageTextIndex() override;
+
+    // instance following the application settings
+    static PageTextIndex *instance();
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    bool available() const;
+
+    qint64 maximumSize() const;
+    void setMaximumSize(qint64 maximumSize);
+
+    // whether the text of a page loaded from url is indexed
+    Q_INVOKABLE bool shouldIndex(const QUrl &url) const;
+    // queues the text of url, which has to be in the history
+    Q_INVOKABLE void addPage(const QString &url, const QString &title, const QString &text);
+
+signals:
+    void enabledChanged();
+    void maximumSizeChanged();
+    // indexed is false if the page could not be or was not to be indexed
+    void pageIndexed(const QString &url, bool indexed);
+
+private:
+    struct Page {
+        QString url;
+        QString title;
+        QString text;
+    };
+
+    void indexNext();
+
+    bool m_enabled = false;
+    bool m_available;
+    qint64 m_maximumSize;
+    QVector<Page> m_queue;
+    QString m_current;
+
+    // a single thread, so the pages are written one after another
+    QThreadPool m_pool;
+    QFutureWatcher<bool> m_worker;
+    QElapsedTimer m_workTimer;
+    QTimer m_pause;
+
+    static PageTextIndex *s_instance;
+};
+
+#endif // PAGETEXTINDEX_H
@@ -0,0 +1,64 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "pagetimings.h"
+
+#include <QStringList>
+
+#include <cmath>
+
+constexpr int BUCKETS_PER_DOUBLING = 4;
+
+// keys of the metrics in the timing reported by the script
+static const QStringList METRIC_KEYS = {
+    QStringLiteral("ttfb"),
+    QStringLiteral("domContentLoaded"),
+    QStringLiteral("firstContentfulPaint"),
+    QStringLiteral("transferSize"),
+};
+
+QHash<int, int> PageTimings::buckets(const QVariantMap &timing)
+{
+    QHash<int, int> buckets;
+    for (int metric = 0; metric < MetricCount; metric++) {
+        bool ok = false;
+        const double value = timing.value(METRIC_KEYS.at(metric)).toDouble(&ok);
+        if (ok && value >= 0)
+            buckets.insert(metric, bucket(qint64(value)));
+    }
+    return buckets;
+}
+
+int PageTimings::bucket(qint64 value)
+{
+    return int(std::floor(std::log2(double(qMax(qint64(0), value)) + 1) * BUCKETS_PER_DOUBLING));
+}
+
+qint64 PageTimings::bucketValue(int bucket)
+{
+    return qint64(std::round(std::exp2((bucket + 0.5) / BUCKETS_PER_DOUBLING) - 1));
+}
+
+qint64 PageTimings::percentile(const QMap<int, qint64> &buckets, qreal fraction)
+{
+    qint64 total = 0;
+    for (qint64 count : buckets)
+        total += count;
+    if (total == 0)
+        return -1;
+
+    // the bucket holding the count at the rank of the percentile
+    const qint64 rank = qMax(qint64(1), qint64(std::ceil(fraction * total)));
+    qint64 counted = 0;
+    for (auto it = buckets.cbegin(); it != buckets.cend(); ++it) {
+        counted += it.value();
+        if (counted >= rank)
+            return bucketValue(it.key());
+    }
+    return bucketValue(buckets.lastKey());
+}
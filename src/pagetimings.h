@@ -0,0 +1,49 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PAGETIMINGS_H
+#define PAGETIMINGS_H
+
+#include <QHash>
+#include <QMap>
+#include <QVariantMap>
+
+/**
+ * @class PageTimings
+ * @short Histograms of the Navigation and Paint Timing of page loads.
+ *
+ * Each load adds one to a bucket per metric, stored per host in the
+ * database. Buckets grow exponentially, four per doubling of the value, so
+ * a handful of rows per host is enough for percentiles accurate to about
+ * 10%, no matter how often the host has been loaded.
+ */
+class PageTimings
+{
+public:
+    enum Metric {
+        TimeToFirstByte, // ms
+        DomContentLoaded, // ms
+        FirstContentfulPaint, // ms
+        TransferSize, // bytes
+        MetricCount,
+    };
+
+    // bucket per metric of the timing reported by the script in WebView.qml,
+    // metrics missing or negative in timing are left out
+    static QHash<int, int> buckets(const QVariantMap &timing);
+
+    static int bucket(qint64 value);
+    // middle of the values in bucket
+    static qint64 bucketValue(int bucket);
+
+    // value below which fraction of the counts in the buckets lie, -1 if
+    // there are no counts
+    static qint64 percentile(const QMap<int, qint64> &buckets, qreal fraction);
+};
+
+#endif // PAGETIMINGS_H
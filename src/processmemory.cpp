@@ -0,0 +1,43 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "processmemory.h"
+
+#include <QFile>
+
+qint64 ProcessMemory::resident(qint64 pid)
+{
+    return readKilobytes(directory(pid) + QStringLiteral("status"), QByteArrayLiteral("VmRSS:"));
+}
+
+qint64 ProcessMemory::proportional(qint64 pid)
+{
+    // the sum over all mappings
+    return readKilobytes(directory(pid) + QStringLiteral("smaps_rollup"), QByteArrayLiteral("Pss:"));
+}
+
+qint64 ProcessMemory::readKilobytes(const QString &path, const QByteArray &key)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.startsWith(key))
+            return line.mid(key.size()).simplified().split(' ').constFirst().toLongLong();
+    }
+    return -1;
+}
+
+QString ProcessMemory::directory(qint64 pid)
+{
+    if (pid == 0)
+        return QStringLiteral("/proc/self/");
+    return QStringLiteral("/proc/%1/").arg(pid);
+}
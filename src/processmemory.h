@@ -0,0 +1,37 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PROCESSMEMORY_H
+#define PROCESSMEMORY_H
+
+#include <QString>
+
+/**
+ * @class ProcessMemory
+ * @short Reads the memory use of processes from /proc.
+ *
+ * Values are in KiB as the kernel reports them and -1 if they are unknown,
+ * e.g. without procfs or for a process that has exited. The web engine
+ * renders in processes of its own, the browser process doesn't include them.
+ */
+class ProcessMemory
+{
+public:
+    // resident memory of the process, of this one if pid is 0
+    static qint64 resident(qint64 pid = 0);
+    // proportional set size of the process, only in Linux 4.14 and newer
+    static qint64 proportional(qint64 pid = 0);
+
+    // value of a "Key:   123 kB" line of the file
+    static qint64 readKilobytes(const QString &path, const QByteArray &key);
+
+private:
+    static QString directory(qint64 pid);
+};
+
+#endif // PROCESSMEMORY_H
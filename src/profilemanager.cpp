@@ -0,0 +1,222 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "profilemanager.h"
+#include "useragent.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QNetworkCookie>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QtWebEngineCore/QWebEngineCookieStore>
+#include <QtWebEngineCore/QWebEngineUrlRequestInterceptor>
+#include <QtWebEngine/QQuickWebEngineProfile>
+
+namespace {
+QString profileKey(const QString &storageName, bool offTheRecord, const QString &userAgent)
+{
+    return QStringLiteral("%1\n%2\n%3").arg(storageName, offTheRecord ? QStringLiteral("1") : QStringLiteral("0"), userAgent);
+}
+
+QString desktopUserAgent()
+{
+    UserAgent agent;
+    agent.setIsMobile(false);
+    return agent.userAgent();
+}
+}
+
+ProfileManager::ProfileManager(QObject *parent)
+    : QObject(parent)
+    , m_mobileUserAgent(UserAgent().userAgent())
+{
+}
+
+QQmlComponent *ProfileManager::profileComponent() const
+{
+    return m_profileComponent;
+}
+
+void ProfileManager::setProfileComponent(QQmlComponent *component)
+{
+    if (m_profileComponent == component)
+        return;
+    m_profileComponent = component;
+    emit profileComponentChanged();
+}
+
+QWebEngineUrlRequestInterceptor *ProfileManager::urlRequestInterceptor() const
+{
+    return m_urlRequestInterceptor;
+}
+
+void ProfileManager::setUrlRequestInterceptor(QWebEngineUrlRequestInterceptor *interceptor)
+{
+    if (m_urlRequestInterceptor == interceptor)
+        return;
+    m_urlRequestInterceptor = interceptor;
+
+    for (auto *profile : qAsConst(m_profiles))
+        profile->setUrlRequestInterceptor(interceptor);
+
+    emit urlRequestInterceptorChanged();
+}
+
+QVector<QQuickWebEngineProfile *> ProfileManager::profiles() const
+{
+    return m_profiles.values().toVector();
+}
+
+QStringList ProfileManager::closedStorageDirectories(QStandardPaths::StandardLocation location) const
+{
+    QSet<QString> openStorages;
+    for (auto *profile : qAsConst(m_profiles)) {
+        if (!profile->isOffTheRecord())
+            openStorages.insert(profile->storageName());
+    }
+
+    // where the web engine places the storages of named profiles
+    const QDir root(QStandardPaths::writableLocation(location) + QStringLiteral("/QtWebEngine"));
+    QStringList directories;
+    const auto names = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &name : names) {
+        if (!openStorages.contains(name))
+            directories.append(root.absoluteFilePath(name));
+    }
+    return directories;
+}
+
+QQuickWebEngineProfile *ProfileManager::profile(const QString &storageName, bool offTheRecord, const QString &userAgent)
+{
+    const QString key = profileKey(storageName, offTheRecord, userAgent);
+    if (auto *existing = m_profiles.value(key))
+        return existing;
+
+    auto *profile = createProfile(storageName, offTheRecord, userAgent);
+    m_profiles.insert(key, profile);
+
+    const QString groupKey = profileKey(storageName, offTheRecord, QString());
+    auto &group = m_storageGroups[groupKey];
+    if (!offTheRecord)
+        shareCookies(profile, groupKey, group);
+    group.append(profile);
+
+    emit profileCreated(profile);
+    return profile;
+}
+
+void ProfileManager::releaseOffTheRecordProfiles()
+{
+    for (auto it = m_storageGroups.begin(); it != m_storageGroups.end();) {
+        if (it.value().isEmpty() || !it.value().constFirst()->isOffTheRecord()) {
+            ++it;
+            continue;
+        }
+
+        for (auto *profile : qAsConst(it.value())) {
+            m_profiles.remove(m_profiles.key(profile));
+            // after the views that have been destroyed in the same turn of the event loop
+            profile->deleteLater();
+        }
+        it = m_storageGroups.erase(it);
+    }
+}
+
+QQuickWebEngineProfile *ProfileManager::createProfile(const QString &storageName, bool offTheRecord, const QString &userAgent)
+{
+    const QString diskName = offTheRecord ? storageName : diskStorageName(storageName, userAgent);
+
+    QQuickWebEngineProfile *profile = nullptr;
+    bool fromComponent = false;
+    if (m_profileComponent) {
+        // set the properties before the component is completed, so that
+        // the profile is never used with the wrong storage or agent
+        QObject *object = m_profileComponent->beginCreate(m_profileComponent->creationContext());
+        profile = qobject_cast<QQuickWebEngineProfile *>(object);
+        if (!profile) {
+            qWarning() << Q_FUNC_INFO << "Profile component does not create a WebEngineProfile" << m_profileComponent->errors();
+            delete object;
+        } else {
+            fromComponent = true;
+        }
+    }
+
+    if (!profile)
+        profile = new QQuickWebEngineProfile();
+
+    profile->setStorageName(diskName);
+    profile->setOffTheRecord(offTheRecord);
+    profile->setHttpUserAgent(userAgent);
+    profile->setUrlRequestInterceptor(m_urlRequestInterceptor);
+
+    if (fromComponent)
+        m_profileComponent->completeCreate();
+
+    profile->setParent(this);
+    QQmlEngine::setObjectOwnership(profile, QQmlEngine::CppOwnership);
+
+    return profile;
+}
+
+QString ProfileManager::diskStorageName(const QString &storageName, const QString &userAgent) const
+{
+    if (userAgent == m_mobileUserAgent)
+        return storageName;
+
+    // keep the name stable across WebEngine updates, which change the version
+    // numbers contained in the generated agents
+    static const QString desktop = desktopUserAgent();
+    if (userAgent == desktop)
+        return storageName + QStringLiteral("-desktop");
+
+    const QByteArray hash = QCryptographicHash::hash(userAgent.toUtf8(), QCryptographicHash::Sha1).toHex().left(8);
+    return storageName + QLatin1Char('-') + QString::fromLatin1(hash);
+}
+
+void ProfileManager::shareCookies(QQuickWebEngineProfile *profile, const QString &group, const QVector<QQuickWebEngineProfile *> &siblings)
+{
+    QWebEngineCookieStore *store = profile->cookieStore();
+    m_cookieStoreGroups.insert(store, group);
+
+    connect(store, &QWebEngineCookieStore::cookieAdded, this, [this, store](const QNetworkCookie &cookie) {
+        mirrorCookie(store, cookie, true);
+    });
+    connect(store, &QWebEngineCookieStore::cookieRemoved, this, [this, store](const QNetworkCookie &cookie) {
+        mirrorCookie(store, cookie, false);
+    });
+
+    if (!siblings.isEmpty()) {
+        // copy the cookies the other profiles already have into the new one
+        siblings.constFirst()->cookieStore()->loadAllCookies();
+    }
+}
+
+void ProfileManager::mirrorCookie(QWebEngineCookieStore *source, const QNetworkCookie &cookie, bool added)
+{
+    const QByteArray raw = cookie.toRawForm();
+
+    // ignore the notification about a cookie we have copied ourselves
+    auto &mirrored = m_mirroredCookies[source];
+    if (mirrored.remove(raw))
+        return;
+
+    const QString group = m_cookieStoreGroups.value(source);
+    for (auto it = m_cookieStoreGroups.cbegin(); it != m_cookieStoreGroups.cend(); ++it) {
+        QWebEngineCookieStore *target = it.key();
+        if (target == source || it.value() != group)
+            continue;
+
+        m_mirroredCookies[target].insert(raw);
+        if (added)
+            target->setCookie(cookie);
+        else
+            target->deleteCookie(cookie);
+    }
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PROFILEMANAGER_H
+#define PROFILEMANAGER_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QStandardPaths>
+#include <QVector>
+
+class QNetworkCookie;
+class QQmlComponent;
+class QQuickWebEngineProfile;
+class QWebEngineCookieStore;
+class QWebEngineUrlRequestInterceptor;
+
+/**
+ * @class ProfileManager
+ * @short Provides one WebEngine profile per (storage, user agent) pair.
+ *
+ * Each view requests the profile matching its user agent instead of sharing
+ * one profile whose agent is rewritten whenever the current tab changes. As a
+ * result, every page is loaded exactly once with the correct agent.
+ *
+ * Chromium does not allow two profiles to open the same on-disk storage, so
+ * only the mobile agent uses the requested storage name directly. Other agents
+ * get a storage of their own, and cookies are mirrored between all profiles of
+ * the same storage so that logins survive switching to the desktop site.
+ * Off-the-record profiles keep nothing on disk and share the name as is.
+ */
+class ProfileManager : public QObject
+{
+    Q_OBJECT
+
+    // Component used for creating the profiles, usually an AngelfishWebProfile.
+    // Plain WebEngineProfiles are created if it is not set.
+    Q_PROPERTY(QQmlComponent *profileComponent READ profileComponent WRITE setProfileComponent NOTIFY profileComponentChanged)
+    // Interceptor installed on all profiles
+    Q_PROPERTY(QWebEngineUrlRequestInterceptor *urlRequestInterceptor READ urlRequestInterceptor WRITE setUrlRequestInterceptor NOTIFY
+                   urlRequestInterceptorChanged)
+
+public:
+    explicit ProfileManager(QObject *parent = nullptr);
+
+    QQmlComponent *profileComponent() const;
+    void setProfileComponent(QQmlComponent *component);
+
+    QWebEngineUrlRequestInterceptor *urlRequestInterceptor() const;
+    void setUrlRequestInterceptor(QWebEngineUrlRequestInterceptor *interceptor);
+
+    // returns the profile for the storage and user agent, creating it if needed
+    Q_INVOKABLE QQuickWebEngineProfile *profile(const QString &storageName, bool offTheRecord, const QString &userAgent);
+
+    // Deletes the off-the-record profiles together with everything they keep
+    // in memory. The views using them must have been destroyed before.
+    Q_INVOKABLE void releaseOffTheRecordProfiles();
+
+    // all profiles created so far
+    QVector<QQuickWebEngineProfile *> profiles() const;
+
+    // Directories of the storages on disk that no profile has been created for
+    // so far, like those of the agents not used in this session, below the
+    // AppDataLocation or CacheLocation. The web engine does not use them until
+    // such a profile is created. Off-the-record profiles keep nothing on disk.
+    QStringList closedStorageDirectories(QStandardPaths::StandardLocation location) const;
+
+signals:
+    void profileComponentChanged();
+    void urlRequestInterceptorChanged();
+    void profileCreated(QQuickWebEngineProfile *profile);
+
+private:
+    QQuickWebEngineProfile *createProfile(const QString &storageName, bool offTheRecord, const QString &userAgent);
+    QString diskStorageName(const QString &storageName, const QString &userAgent) const;
+
+    // mirror cookies between the profiles sharing a storage
+    void shareCookies(QQuickWebEngineProfile *profile, const QString &group, const QVector<QQuickWebEngineProfile *> &siblings);
+    void mirrorCookie(QWebEngineCookieStore *source, const QNetworkCookie &cookie, bool added);
+
+    QPointer<QQmlComponent> m_profileComponent;
+    QPointer<QWebEngineUrlRequestInterceptor> m_urlRequestInterceptor;
+    const QString m_mobileUserAgent;
+
+    // profiles by storage name, off-the-record flag and agent
+    QHash<QString, QQuickWebEngineProfile *> m_profiles;
+    // profiles grouped by the storage they have been requested for
+    QHash<QString, QVector<QQuickWebEngineProfile *>> m_storageGroups;
+    // cookies that have been copied into a store and should not be copied back
+    QHash<QWebEngineCookieStore *, QSet<QByteArray>> m_mirroredCookies;
+    QHash<QWebEngineCookieStore *, QString> m_cookieStoreGroups;
+};
+
+#endif // PROFILEMANAGER_H
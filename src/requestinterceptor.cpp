@@ -0,0 +1,90 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "requestinterceptor.h"
+#include "datasaver.h"
+
+RequestInterceptor::RequestInterceptor(QObject *parent)
+    : QWebEngineUrlRequestInterceptor(parent)
+{
+}
+
+void RequestInterceptor::interceptRequest(QWebEngineUrlRequestInfo &info)
+{
+    const auto type = info.resourceType();
+    if (type == QWebEngineUrlRequestInfo::ResourceTypeMainFrame) {
+        if (m_dataSaver)
+            m_dataSaver->startPage(info.requestUrl());
+        return;
+    }
+
+    const AdblockFilter::ResourceType adblockType = adblockResourceType(type);
+
+    if (m_adblockEnabled && m_adblockFilter) {
+        const AdblockFilter::Request request(info.requestUrl(), info.firstPartyUrl(), adblockType);
+        if (m_adblockFilter->shouldBlock(request)) {
+            info.block(true);
+            emit requestBlocked(info.firstPartyUrl(), info.requestUrl());
+            return;
+        }
+    }
+
+    if (m_dataSaver && !m_dataSaver->allowRequest(info.firstPartyUrl(), info.requestUrl(), adblockType))
+        info.block(true);
+}
+
+void RequestInterceptor::setAdblockFilter(std::shared_ptr<const AdblockFilter> filter)
+{
+    m_adblockFilter = std::move(filter);
+}
+
+void RequestInterceptor::setAdblockEnabled(bool enabled)
+{
+    m_adblockEnabled = enabled;
+}
+
+void RequestInterceptor::setDataSaver(DataSaver *dataSaver)
+{
+    m_dataSaver = dataSaver;
+}
+
+AdblockFilter::ResourceType RequestInterceptor::adblockResourceType(QWebEngineUrlRequestInfo::ResourceType type)
+{
+    switch (type) {
+    case QWebEngineUrlRequestInfo::ResourceTypeMainFrame:
+    case QWebEngineUrlRequestInfo::ResourceTypeNavigationPreloadMainFrame:
+        return AdblockFilter::Document;
+    case QWebEngineUrlRequestInfo::ResourceTypeSubFrame:
+    case QWebEngineUrlRequestInfo::ResourceTypeNavigationPreloadSubFrame:
+        return AdblockFilter::SubDocument;
+    case QWebEngineUrlRequestInfo::ResourceTypeStylesheet:
+        return AdblockFilter::Stylesheet;
+    case QWebEngineUrlRequestInfo::ResourceTypeScript:
+    case QWebEngineUrlRequestInfo::ResourceTypeWorker:
+    case QWebEngineUrlRequestInfo::ResourceTypeSharedWorker:
+    case QWebEngineUrlRequestInfo::ResourceTypeServiceWorker:
+        return AdblockFilter::Script;
+    case QWebEngineUrlRequestInfo::ResourceTypeImage:
+    case QWebEngineUrlRequestInfo::ResourceTypeFavicon:
+        return AdblockFilter::Image;
+    case QWebEngineUrlRequestInfo::ResourceTypeFontResource:
+        return AdblockFilter::Font;
+    case QWebEngineUrlRequestInfo::ResourceTypeObject:
+    case QWebEngineUrlRequestInfo::ResourceTypePluginResource:
+        return AdblockFilter::Object;
+    case QWebEngineUrlRequestInfo::ResourceTypeMedia:
+        return AdblockFilter::Media;
+    case QWebEngineUrlRequestInfo::ResourceTypeXhr:
+        return AdblockFilter::XmlHttpRequest;
+    case QWebEngineUrlRequestInfo::ResourceTypePing:
+    case QWebEngineUrlRequestInfo::ResourceTypeCspReport:
+        return AdblockFilter::Ping;
+    default:
+        return AdblockFilter::Other;
+    }
+}
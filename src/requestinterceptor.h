@@ -0,0 +1,58 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef REQUESTINTERCEPTOR_H
+#define REQUESTINTERCEPTOR_H
+
+#include <QtWebEngineCore/QWebEngineUrlRequestInterceptor>
+
+#include <memory>
+
+#include "adblockfilter.h"
+
+class DataSaver;
+
+/**
+ * @class RequestInterceptor
+ * @short Interceptor installed on all profiles of the ProfileManager.
+ *
+ * Requests are checked by the content blocker first, and then against the
+ * budget of the DataSaver.
+ *
+ * Since Qt 5.13, interceptors set on a profile are called on the UI thread,
+ * so the filter has to answer in microseconds. The filter itself is compiled
+ * on a worker thread and swapped in once it is ready.
+ */
+class RequestInterceptor : public QWebEngineUrlRequestInterceptor
+{
+    Q_OBJECT
+
+public:
+    explicit RequestInterceptor(QObject *parent = nullptr);
+
+    void interceptRequest(QWebEngineUrlRequestInfo &info) override;
+
+    void setAdblockFilter(std::shared_ptr<const AdblockFilter> filter);
+    void setAdblockEnabled(bool enabled);
+
+    // applied to the requests the content blocker lets through
+    void setDataSaver(DataSaver *dataSaver);
+
+    static AdblockFilter::ResourceType adblockResourceType(QWebEngineUrlRequestInfo::ResourceType type);
+
+signals:
+    // a request made by the page has been blocked
+    void requestBlocked(const QUrl &firstPartyUrl, const QUrl &url);
+
+private:
+    std::shared_ptr<const AdblockFilter> m_adblockFilter;
+    bool m_adblockEnabled = true;
+    DataSaver *m_dataSaver = nullptr;
+};
+
+#endif // REQUESTINTERCEPTOR_H
@@ -0,0 +1,116 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "siteperformancemodel.h"
+#include "browsermanager.h"
+
+#include <algorithm>
+#include <numeric>
+
+SitePerformanceModel::SitePerformanceModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    connect(BrowserManager::instance(), &BrowserManager::databaseTableChanged, this, [this](const QString &table) {
+        if (table == QLatin1String("pagetimings"))
+            reload();
+    });
+    reload();
+}
+
+QHash<int, QByteArray> SitePerformanceModel::roleNames() const
+{
+    return {
+        {HostRole, QByteArrayLiteral("host")},
+        {LoadsRole, QByteArrayLiteral("loads")},
+        {TimeToFirstByteMedianRole, QByteArrayLiteral("timeToFirstByteMedian")},
+        {TimeToFirstByteP90Role, QByteArrayLiteral("timeToFirstByteP90")},
+        {DomContentLoadedMedianRole, QByteArrayLiteral("domContentLoadedMedian")},
+        {DomContentLoadedP90Role, QByteArrayLiteral("domContentLoadedP90")},
+        {FirstContentfulPaintMedianRole, QByteArrayLiteral("firstContentfulPaintMedian")},
+        {FirstContentfulPaintP90Role, QByteArrayLiteral("firstContentfulPaintP90")},
+        {TransferSizeMedianRole, QByteArrayLiteral("transferSizeMedian")},
+    };
+}
+
+QVariant SitePerformanceModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_sites.count())
+        return {};
+
+    const Site &site = m_sites.at(index.row());
+    switch (role) {
+    case HostRole:
+        return site.host;
+    case LoadsRole:
+        return site.loads;
+    case TimeToFirstByteMedianRole:
+        return site.medians[PageTimings::TimeToFirstByte];
+    case TimeToFirstByteP90Role:
+        return site.p90s[PageTimings::TimeToFirstByte];
+    case DomContentLoadedMedianRole:
+        return site.medians[PageTimings::DomContentLoaded];
+    case DomContentLoadedP90Role:
+        return site.p90s[PageTimings::DomContentLoaded];
+    case FirstContentfulPaintMedianRole:
+        return site.medians[PageTimings::FirstContentfulPaint];
+    case FirstContentfulPaintP90Role:
+        return site.p90s[PageTimings::FirstContentfulPaint];
+    case TransferSizeMedianRole:
+        return site.medians[PageTimings::TransferSize];
+    }
+
+    return {};
+}
+
+int SitePerformanceModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_sites.count();
+}
+
+void SitePerformanceModel::reload()
+{
+    QVector<Site> sites;
+    QVector<QMap<int, qint64>> buckets(PageTimings::MetricCount);
+
+    const auto finishSite = [&sites, &buckets] {
+        Site &site = sites.last();
+        for (int metric = 0; metric < PageTimings::MetricCount; metric++) {
+            // every load records the time to the first byte
+            site.loads = std::max(site.loads, std::accumulate(buckets[metric].cbegin(), buckets[metric].cend(), qint64(0)));
+            site.medians[metric] = PageTimings::percentile(buckets[metric], 0.5);
+            site.p90s[metric] = PageTimings::percentile(buckets[metric], 0.9);
+            buckets[metric].clear();
+        }
+    };
+
+    // ordered by host
+    const auto timings = BrowserManager::instance()->pageTimings();
+    for (const auto &timing : timings) {
+        if (sites.isEmpty() || sites.last().host != timing.host) {
+            if (!sites.isEmpty())
+                finishSite();
+            sites.append(Site());
+            sites.last().host = timing.host;
+        }
+        if (timing.metric >= 0 && timing.metric < PageTimings::MetricCount)
+            buckets[timing.metric][timing.bucket] += timing.count;
+    }
+    if (!sites.isEmpty())
+        finishSite();
+
+    std::stable_sort(sites.begin(), sites.end(), [](const Site &a, const Site &b) {
+        return a.loads > b.loads;
+    });
+
+    const int oldCount = m_sites.count();
+    beginResetModel();
+    m_sites = sites;
+    endResetModel();
+    if (oldCount != m_sites.count())
+        emit countChanged();
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SITEPERFORMANCEMODEL_H
+#define SITEPERFORMANCEMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+
+#include "pagetimings.h"
+
+/**
+ * @class SitePerformanceModel
+ * @short Percentiles of the page load timings per host.
+ *
+ * Lists the hosts by the number of recorded loads. Times are in ms and the
+ * transfer size in bytes, -1 if a metric has not been recorded for a host.
+ */
+class SitePerformanceModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Role {
+        HostRole = Qt::UserRole + 1,
+        LoadsRole,
+        TimeToFirstByteMedianRole,
+        TimeToFirstByteP90Role,
+        DomContentLoadedMedianRole,
+        DomContentLoadedP90Role,
+        FirstContentfulPaintMedianRole,
+        FirstContentfulPaintP90Role,
+        TransferSizeMedianRole,
+    };
+
+    explicit SitePerformanceModel(QObject *parent = nullptr);
+
+    QHash<int, QByteArray> roleNames() const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    Q_INVOKABLE void reload();
+
+signals:
+    void countChanged();
+
+private:
+    struct Site {
+        QString host;
+        qint64 loads = 0;
+        // median and 90th percentile per metric
+        qint64 medians[PageTimings::MetricCount];
+        qint64 p90s[PageTimings::MetricCount];
+    };
+
+    QVector<Site> m_sites;
+};
+
+#endif // SITEPERFORMANCEMODEL_H
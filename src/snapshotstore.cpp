@@ -0,0 +1,286 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "snapshotstore.h"
+#include "browsermanager.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <QtWebEngine/QQuickWebEngineDownloadItem>
+
+#include "angelfishsettings.h"
+
+// snapshots of bookmarks are captured again after this time, in seconds
+constexpr qint64 SNAPSHOT_MAX_AGE = 24 * 60 * 60;
+
+SnapshotStore *SnapshotStore::s_instance = nullptr;
+
+namespace {
+struct StoredFile {
+    // empty if the file could not be stored
+    QString hash;
+    qint64 size = 0;
+};
+
+QString snapshotPath(const QString &directory, const QString &hash)
+{
+    return directory + QLatin1Char('/') + hash + QStringLiteral(".mht");
+}
+
+// hashes the file and moves it into the directory, unless the same content
+// is stored there already
+StoredFile storeFile(const QString &fileName, const QString &directory)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << Q_FUNC_INFO << "Failed to open the snapshot" << fileName;
+        return {};
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(&file);
+    StoredFile stored;
+    stored.size = file.size();
+    file.close();
+
+    const QString hex = QString::fromLatin1(hash.result().toHex());
+    const QString path = snapshotPath(directory, hex);
+    // identical content is already stored
+    if (QFile::exists(path)) {
+        file.remove();
+    } else if (!file.rename(path)) {
+        // as well if another capture has just stored the same content
+        const bool exists = QFile::exists(path);
+        file.remove();
+        if (!exists) {
+            qWarning() << Q_FUNC_INFO << "Failed to move the snapshot to" << path;
+            return {};
+        }
+    }
+
+    stored.hash = hex;
+    return stored;
+}
+}
+
+SnapshotStore::SnapshotStore(const QString &directory, QObject *parent)
+    : QObject(parent)
+    , m_directory(directory)
+{
+    QDir dir(m_directory);
+    if (!dir.mkpath(QStringLiteral(".")))
+        qWarning() << Q_FUNC_INFO << "Failed to create the snapshot directory" << m_directory;
+
+    // left behind by captures that have been interrupted
+    const QStringList partial = dir.entryList({QStringLiteral("*.partial")}, QDir::Files);
+    for (const QString &fileName : partial)
+        dir.remove(fileName);
+}
+
+SnapshotStore *SnapshotStore::instance()
+{
+    if (s_instance)
+        return s_instance;
+
+    s_instance = new SnapshotStore(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QStringLiteral("/snapshots"));
+    auto *settings = AngelfishSettings::self();
+    s_instance->setMaximumSize(qint64(settings->snapshotsMaxSize()) * 1024 * 1024);
+    s_instance->setCaptureBookmarks(settings->snapshotsCaptureBookmarks());
+
+    QObject::connect(settings, &AngelfishSettings::snapshotsMaxSizeChanged, s_instance, [settings] {
+        s_instance->setMaximumSize(qint64(settings->snapshotsMaxSize()) * 1024 * 1024);
+    });
+    QObject::connect(settings, &AngelfishSettings::snapshotsCaptureBookmarksChanged, s_instance, [settings] {
+        s_instance->setCaptureBookmarks(settings->snapshotsCaptureBookmarks());
+    });
+
+    return s_instance;
+}
+
+QString SnapshotStore::directory() const
+{
+    return m_directory;
+}
+
+qint64 SnapshotStore::size() const
+{
+    return BrowserManager::instance()->snapshotsSize();
+}
+
+qint64 SnapshotStore::maximumSize() const
+{
+    return m_maximumSize;
+}
+
+void SnapshotStore::setMaximumSize(qint64 maximumSize)
+{
+    if (m_maximumSize == maximumSize)
+        return;
+    m_maximumSize = maximumSize;
+    trim();
+    emit maximumSizeChanged();
+}
+
+bool SnapshotStore::captureBookmarks() const
+{
+    return m_captureBookmarks;
+}
+
+void SnapshotStore::setCaptureBookmarks(bool capture)
+{
+    if (m_captureBookmarks == capture)
+        return;
+    m_captureBookmarks = capture;
+    emit captureBookmarksChanged();
+}
+
+void SnapshotStore::capture(QObject *object)
+{
+    auto *download = qobject_cast<QQuickWebEngineDownloadItem *>(object);
+    if (!download || download->type() != QQuickWebEngineDownloadItem::SavePage) {
+        qWarning() << Q_FUNC_INFO << "Not a save page download" << object;
+        return;
+    }
+
+    QString url = download->url().toString();
+    QString title;
+    if (auto *view = download->property("view").value<QObject *>()) {
+        url = view->property("url").toUrl().toString();
+        title = view->property("title").toString();
+    }
+
+    if (url.isEmpty() || m_capturing.contains(url) || isSnapshot(QUrl(url))) {
+        download->cancel();
+        return;
+    }
+    m_capturing.append(url);
+
+    const QString fileName = QStringLiteral("capture-%1.partial").arg(m_captureCount++);
+    download->setDownloadDirectory(m_directory);
+    download->setDownloadFileName(fileName);
+    download->setSavePageFormat(QQuickWebEngineDownloadItem::MimeHtmlSaveFormat);
+    download->accept();
+
+    connect(download, &QQuickWebEngineDownloadItem::stateChanged, this, [this, download, url, title, fileName] {
+        switch (download->state()) {
+        case QQuickWebEngineDownloadItem::DownloadCompleted:
+            // still being captured until it has been added
+            addSnapshot(url, title, m_directory + QLatin1Char('/') + fileName);
+            return;
+        case QQuickWebEngineDownloadItem::DownloadCancelled:
+        case QQuickWebEngineDownloadItem::DownloadInterrupted:
+            QFile::remove(m_directory + QLatin1Char('/') + fileName);
+            break;
+        default:
+            return;
+        }
+        m_capturing.removeOne(url);
+    });
+}
+
+void SnapshotStore::addSnapshot(const QString &url, const QString &title, const QString &fileName)
+{
+    auto *watcher = new QFutureWatcher<StoredFile>(this);
+    connect(watcher, &QFutureWatcher<StoredFile>::finished, this, [this, watcher, url, title] {
+        watcher->deleteLater();
+        m_capturing.removeOne(url);
+
+        // a file with the same content may have been evicted meanwhile
+        const StoredFile stored = watcher->result();
+        if (stored.hash.isEmpty() || !QFile::exists(filePath(stored.hash))) {
+            emit snapshotFailed(url);
+            return;
+        }
+
+        const QString unused = BrowserManager::instance()->addSnapshot(url, stored.hash, title, stored.size);
+        if (!unused.isEmpty())
+            removeFile(unused);
+
+        trim();
+        emit sizeChanged();
+        emit snapshotAdded(url);
+    });
+    watcher->setFuture(QtConcurrent::run(storeFile, fileName, m_directory));
+}
+
+void SnapshotStore::removeSnapshot(const QString &url)
+{
+    const QString unused = BrowserManager::instance()->removeSnapshot(url);
+    if (!unused.isEmpty())
+        removeFile(unused);
+    emit sizeChanged();
+}
+
+bool SnapshotStore::hasSnapshot(const QString &url) const
+{
+    return !BrowserManager::instance()->snapshot(url).isEmpty();
+}
+
+QUrl SnapshotStore::snapshotUrl(const QString &url)
+{
+    const QString hash = BrowserManager::instance()->snapshot(url).value(QStringLiteral("hash")).toString();
+    if (hash.isEmpty())
+        return QUrl();
+
+    const QString path = filePath(hash);
+    if (!QFile::exists(path)) {
+        qWarning() << Q_FUNC_INFO << "Snapshot file is missing" << path;
+        removeSnapshot(url);
+        return QUrl();
+    }
+
+    BrowserManager::instance()->touchSnapshot(url);
+    return QUrl::fromLocalFile(path);
+}
+
+bool SnapshotStore::isSnapshot(const QUrl &url) const
+{
+    return url.isLocalFile() && url.toLocalFile().startsWith(m_directory + QLatin1Char('/'));
+}
+
+bool SnapshotStore::shouldCapture(const QString &url) const
+{
+    if (!m_captureBookmarks || m_maximumSize <= 0 || m_capturing.contains(url))
+        return false;
+
+    const QString scheme = QUrl(url).scheme();
+    if (scheme != QLatin1String("http") && scheme != QLatin1String("https"))
+        return false;
+
+    if (!BrowserManager::instance()->isBookmarked(url))
+        return false;
+
+    const QVariantMap snapshot = BrowserManager::instance()->snapshot(url);
+    return snapshot.isEmpty() || QDateTime::currentSecsSinceEpoch() - snapshot.value(QStringLiteral("created")).toLongLong() > SNAPSHOT_MAX_AGE;
+}
+
+QString SnapshotStore::filePath(const QString &hash) const
+{
+    return snapshotPath(m_directory, hash);
+}
+
+void SnapshotStore::removeFile(const QString &hash)
+{
+    if (!QFile::remove(filePath(hash)))
+        qWarning() << Q_FUNC_INFO << "Failed to remove the snapshot" << filePath(hash);
+}
+
+void SnapshotStore::trim()
+{
+    const QStringList unused = BrowserManager::instance()->trimSnapshots(m_maximumSize);
+    for (const QString &hash : unused)
+        removeFile(hash);
+    if (!unused.isEmpty())
+        emit sizeChanged();
+}
@@ -0,0 +1,95 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SNAPSHOTSTORE_H
+#define SNAPSHOTSTORE_H
+
+#include <QObject>
+#include <QUrl>
+
+/**
+ * @class SnapshotStore
+ * @short Keeps MHTML snapshots of pages for reading them offline.
+ *
+ * Snapshots are saved by the web engine and stored in a directory named by
+ * the SHA-256 hash of their content, while the snapshots table of the
+ * database maps urls to files. Hashing and moving the files is done in a
+ * worker thread, the database is updated once that is done. When the files exceed the maximum size, the
+ * least recently opened snapshots are evicted.
+ *
+ * Bookmarked pages are captured in the background whenever they have been
+ * loaded and their snapshot is missing or outdated.
+ */
+class SnapshotStore : public QObject
+{
+    Q_OBJECT
+
+    // size of all snapshots in bytes
+    Q_PROPERTY(qint64 size READ size NOTIFY sizeChanged)
+    // in bytes, older snapshots are evicted once the store grows larger
+    Q_PROPERTY(qint64 maximumSize READ maximumSize WRITE setMaximumSize NOTIFY maximumSizeChanged)
+    // capture bookmarked pages when they are loaded
+    Q_PROPERTY(bool captureBookmarks READ captureBookmarks WRITE setCaptureBookmarks NOTIFY captureBookmarksChanged)
+
+public:
+    explicit SnapshotStore(const QString &directory, QObject *parent = nullptr);
+
+    // instance following the application settings
+    static SnapshotStore *instance();
+
+    QString directory() const;
+
+    qint64 size() const;
+
+    qint64 maximumSize() const;
+    void setMaximumSize(qint64 maximumSize);
+
+    bool captureBookmarks() const;
+    void setCaptureBookmarks(bool capture);
+
+    // takes over a save page download (a QQuickWebEngineDownloadItem) and
+    // stores its result when it is done
+    Q_INVOKABLE void capture(QObject *download);
+
+    // Moves the file into the store and records it as snapshot of url. Emits
+    // snapshotAdded or snapshotFailed when done.
+    void addSnapshot(const QString &url, const QString &title, const QString &fileName);
+    Q_INVOKABLE void removeSnapshot(const QString &url);
+
+    Q_INVOKABLE bool hasSnapshot(const QString &url) const;
+    // local url of the snapshot of url, empty if there is none. Counts as use
+    // of the snapshot for the eviction order.
+    Q_INVOKABLE QUrl snapshotUrl(const QString &url);
+    // whether url points into the store
+    Q_INVOKABLE bool isSnapshot(const QUrl &url) const;
+    // whether a loaded page should be captured in the background
+    Q_INVOKABLE bool shouldCapture(const QString &url) const;
+
+signals:
+    void sizeChanged();
+    void maximumSizeChanged();
+    void captureBookmarksChanged();
+    void snapshotAdded(const QString &url);
+    void snapshotFailed(const QString &url);
+
+private:
+    QString filePath(const QString &hash) const;
+    void removeFile(const QString &hash);
+    void trim();
+
+    QString m_directory;
+    qint64 m_maximumSize = 200 * 1024 * 1024;
+    bool m_captureBookmarks = true;
+    // urls being captured, to not save a page twice at the same time
+    QStringList m_capturing;
+    int m_captureCount = 0;
+
+    static SnapshotStore *s_instance;
+};
+
+#endif // SNAPSHOTSTORE_H
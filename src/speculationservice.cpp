@@ -0,0 +1,178 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "speculationservice.h"
+
+// a speculation that is not committed within this time is released
+constexpr int UNUSED_TIMEOUT = 30000;
+// keeps a used speculation around, so its pending requests can end up in the cache
+constexpr int COMMIT_RELEASE_DELAY = 10000;
+
+SpeculationService::SpeculationService(QObject *parent)
+    : QObject(parent)
+{
+    m_stableTimer.setSingleShot(true);
+    m_stableTimer.setInterval(300);
+    connect(&m_stableTimer, &QTimer::timeout, this, &SpeculationService::speculate);
+
+    m_releaseTimer.setSingleShot(true);
+    connect(&m_releaseTimer, &QTimer::timeout, this, &SpeculationService::release);
+}
+
+bool SpeculationService::enabled() const
+{
+    return m_enabled;
+}
+
+void SpeculationService::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+    m_enabled = enabled;
+    if (!m_enabled) {
+        m_stableTimer.stop();
+        release();
+    } else if (!m_candidate.isEmpty()) {
+        m_stableTimer.start();
+    }
+    emit enabledChanged();
+}
+
+QUrl SpeculationService::candidate() const
+{
+    return m_candidate;
+}
+
+void SpeculationService::setCandidate(const QUrl &candidate)
+{
+    if (m_candidate == candidate)
+        return;
+    m_candidate = candidate;
+    if (m_enabled && !m_candidate.isEmpty())
+        m_stableTimer.start();
+    else
+        m_stableTimer.stop();
+    emit candidateChanged();
+}
+
+int SpeculationService::stableDelay() const
+{
+    return m_stableTimer.interval();
+}
+
+void SpeculationService::setStableDelay(int delay)
+{
+    if (m_stableTimer.interval() == delay)
+        return;
+    m_stableTimer.setInterval(delay);
+    emit stableDelayChanged();
+}
+
+SpeculationService::Mode SpeculationService::mode() const
+{
+    return m_mode;
+}
+
+QUrl SpeculationService::url() const
+{
+    return m_url;
+}
+
+QVariantMap SpeculationService::statistics() const
+{
+    return {
+        {QStringLiteral("preconnects"), m_preconnects},
+        {QStringLiteral("preconnectHits"), m_preconnectHits},
+        {QStringLiteral("misses"), m_misses},
+        {QStringLiteral("unspeculatedCommits"), m_unspeculatedCommits},
+    };
+}
+
+void SpeculationService::commit(const QUrl &url)
+{
+    m_stableTimer.stop();
+
+    if (!m_pending) {
+        m_unspeculatedCommits++;
+        emit statisticsChanged();
+        return;
+    }
+
+    m_pending = false;
+    if (origin(m_url) == origin(url)) {
+        m_preconnectHits++;
+    } else {
+        m_misses++;
+        emit statisticsChanged();
+        release();
+        return;
+    }
+
+    emit statisticsChanged();
+    m_releaseTimer.start(COMMIT_RELEASE_DELAY);
+}
+
+void SpeculationService::speculate()
+{
+    if (!m_enabled)
+        return;
+
+    const QString scheme = m_candidate.scheme();
+    if (scheme != QLatin1String("http") && scheme != QLatin1String("https"))
+        return;
+
+    const QUrl url = origin(m_candidate);
+    if (m_pending && url == m_url) {
+        m_releaseTimer.start(UNUSED_TIMEOUT);
+        return;
+    }
+
+    release();
+
+    m_mode = Preconnect;
+    m_url = url;
+    m_pending = true;
+    m_preconnects++;
+    const QString encodedOrigin = QString::fromUtf8(m_url.toEncoded());
+    emit preconnectRequested(QStringLiteral("<!DOCTYPE html><html><head>"
+                                            "<link rel=\"dns-prefetch\" href=\"%1\">"
+                                            "<link rel=\"preconnect\" href=\"%1\">"
+                                            "</head></html>")
+                                 .arg(encodedOrigin),
+                             m_url);
+    m_releaseTimer.start(UNUSED_TIMEOUT);
+    emit modeChanged();
+    emit statisticsChanged();
+}
+
+void SpeculationService::release()
+{
+    m_releaseTimer.stop();
+    if (m_mode == Idle)
+        return;
+
+    if (m_pending) {
+        m_misses++;
+        m_pending = false;
+        emit statisticsChanged();
+    }
+
+    m_mode = Idle;
+    m_url.clear();
+    emit released();
+    emit modeChanged();
+}
+
+QUrl SpeculationService::origin(const QUrl &url)
+{
+    QUrl origin;
+    origin.setScheme(url.scheme());
+    origin.setHost(url.host());
+    origin.setPort(url.port());
+    return origin;
+}
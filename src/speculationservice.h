@@ -0,0 +1,110 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SPECULATIONSERVICE_H
+#define SPECULATIONSERVICE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QUrl>
+#include <QVariantMap>
+
+/**
+ * @class SpeculationService
+ * @short Prepares the connection to the most likely next page while typing.
+ *
+ * Once the candidate, usually the first completion of the navigation entry,
+ * has not changed for stableDelay milliseconds, the service asks for a
+ * speculation: a page with resource hints that warms DNS, TCP and TLS for the
+ * origin of the candidate. The speculation is carried out by a hidden view
+ * which shares the profile of the tabs, so the tab loading the page
+ * afterwards reuses its connections.
+ *
+ * Pages are not prerendered, as a view can't be handed over to a tab, and
+ * the tab would load the page a second time anyway.
+ *
+ * Speculations are released when they have not been used for a while, and
+ * counted as hit or miss so the heuristic can be tuned.
+ */
+class SpeculationService : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    // the url the user is expected to navigate to
+    Q_PROPERTY(QUrl candidate READ candidate WRITE setCandidate NOTIFY candidateChanged)
+    // time in ms the candidate has to stay unchanged before speculating
+    Q_PROPERTY(int stableDelay READ stableDelay WRITE setStableDelay NOTIFY stableDelayChanged)
+    Q_PROPERTY(Mode mode READ mode NOTIFY modeChanged)
+    // the preconnected origin
+    Q_PROPERTY(QUrl url READ url NOTIFY modeChanged)
+    // preconnects, preconnectHits, misses and unspeculatedCommits
+    Q_PROPERTY(QVariantMap statistics READ statistics NOTIFY statisticsChanged)
+
+public:
+    enum Mode {
+        Idle,
+        Preconnect,
+    };
+    Q_ENUM(Mode)
+
+    explicit SpeculationService(QObject *parent = nullptr);
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    QUrl candidate() const;
+    void setCandidate(const QUrl &candidate);
+
+    int stableDelay() const;
+    void setStableDelay(int delay);
+
+    Mode mode() const;
+    QUrl url() const;
+
+    QVariantMap statistics() const;
+
+    // to be called with the url that is actually loaded
+    Q_INVOKABLE void commit(const QUrl &url);
+
+signals:
+    void enabledChanged();
+    void candidateChanged();
+    void stableDelayChanged();
+    void modeChanged();
+    void statisticsChanged();
+
+    // load the html with the origin as base url
+    void preconnectRequested(const QString &html, const QUrl &baseUrl);
+    // the hidden view can be emptied
+    void released();
+
+private:
+    void speculate();
+    void release();
+
+    static QUrl origin(const QUrl &url);
+
+    bool m_enabled = false;
+    QUrl m_candidate;
+
+    Mode m_mode = Idle;
+    QUrl m_url;
+    // whether the current speculation has not been counted as hit or miss yet
+    bool m_pending = false;
+
+    QTimer m_stableTimer;
+    QTimer m_releaseTimer;
+
+    int m_preconnects = 0;
+    int m_preconnectHits = 0;
+    int m_misses = 0;
+    int m_unspeculatedCommits = 0;
+};
+
+#endif // SPECULATIONSERVICE_H
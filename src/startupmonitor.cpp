@@ -0,0 +1,200 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "startupmonitor.h"
+#include "metrics.h"
+#include "tracer.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QMetaEnum>
+#include <QQuickWindow>
+
+#include <memory>
+
+#include <unistd.h>
+
+// ms after the QML has been loaded the startup is considered idle, even if
+// the current page has not been painted yet
+constexpr int IDLE_TIMEOUT = 5000;
+
+// gauges the phases are exported as, in ms since the process has been started
+static const char *const PHASE_METRICS[] = {
+    nullptr,
+    "startup.qml_loaded_ms",
+    "startup.first_frame_ms",
+    "startup.first_paint_ms",
+    "startup.idle_ms",
+};
+
+StartupMonitor *StartupMonitor::s_instance = nullptr;
+
+StartupMonitor::StartupMonitor(QObject *parent)
+    : QObject(parent)
+    , m_processAge(processAge())
+    , m_phases(Idle + 1, -1)
+{
+    m_timer.start();
+    m_phases[ProcessStart] = 0;
+
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(IDLE_TIMEOUT);
+    connect(&m_idleTimer, &QTimer::timeout, this, [this] {
+        mark(Idle);
+    });
+}
+
+StartupMonitor *StartupMonitor::instance()
+{
+    if (!s_instance)
+        s_instance = new StartupMonitor();
+
+    return s_instance;
+}
+
+bool StartupMonitor::ready() const
+{
+    return m_phases[Idle] >= 0;
+}
+
+qint64 StartupMonitor::elapsed(Phase phase) const
+{
+    return m_phases[phase];
+}
+
+void StartupMonitor::mark(Phase phase)
+{
+    if (m_phases[phase] >= 0)
+        return;
+
+    m_phases[phase] = m_processAge + m_timer.elapsed();
+    if (PHASE_METRICS[phase])
+        Metrics::instance()->set(QLatin1String(PHASE_METRICS[phase]), m_phases[phase]);
+    if (Tracer::enabled()) {
+        Tracer::instance()->instant(QMetaEnum::fromType<Phase>().valueToKey(phase), "startup");
+        // the phases are in ms since the process has been started
+        if (phase == Idle)
+            Tracer::instance()->complete("Startup", "startup", Tracer::now() - m_phases[Idle] * 1000, m_phases[Idle] * 1000);
+    }
+    emit phaseReached(phase);
+
+    switch (phase) {
+    case QmlLoaded:
+        m_idleTimer.start();
+        break;
+    case FirstPaint:
+        // leave the event loop to the first frames before doing deferred work
+        QTimer::singleShot(0, this, [this] {
+            mark(Idle);
+        });
+        break;
+    case Idle:
+        m_idleTimer.stop();
+        if (m_traceEnabled)
+            qInfo().noquote() << report();
+        emit readyChanged();
+        break;
+    default:
+        break;
+    }
+}
+
+void StartupMonitor::watchWindow(QQuickWindow *window)
+{
+    if (m_window)
+        disconnect(m_window, nullptr, this, nullptr);
+
+    m_window = window;
+    if (!m_window)
+        return;
+
+    connect(m_window, &QQuickWindow::frameSwapped, this, [this] {
+        mark(FirstFrame);
+        if (m_pageLoaded)
+            mark(FirstPaint);
+        if (m_phases[FirstPaint] >= 0)
+            disconnect(m_window, &QQuickWindow::frameSwapped, this, nullptr);
+    });
+}
+
+void StartupMonitor::pageLoaded()
+{
+    if (m_pageLoaded)
+        return;
+
+    m_pageLoaded = true;
+    if (m_window)
+        m_window->update();
+    else
+        mark(FirstPaint);
+}
+
+void StartupMonitor::deferToIdle(QObject *context, const std::function<void()> &function)
+{
+    if (ready()) {
+        function();
+        return;
+    }
+
+    auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = connect(this, &StartupMonitor::readyChanged, context, [connection, function] {
+        QObject::disconnect(*connection);
+        function();
+    });
+}
+
+int StartupMonitor::idleTimeout() const
+{
+    return m_idleTimer.interval();
+}
+
+void StartupMonitor::setIdleTimeout(int timeout)
+{
+    m_idleTimer.setInterval(timeout);
+}
+
+bool StartupMonitor::traceEnabled() const
+{
+    return m_traceEnabled;
+}
+
+void StartupMonitor::setTraceEnabled(bool enabled)
+{
+    m_traceEnabled = enabled;
+}
+
+QString StartupMonitor::report() const
+{
+    const QMetaEnum phases = QMetaEnum::fromType<Phase>();
+    QString report = QStringLiteral("Startup phases (ms since process start):");
+    for (int phase = ProcessStart; phase <= Idle; phase++) {
+        const QString time = m_phases[phase] >= 0 ? QString::number(m_phases[phase]) : QStringLiteral("-");
+        report += QStringLiteral("\n  %1 %2").arg(QLatin1String(phases.valueToKey(phase)), -12).arg(time, 6);
+    }
+    return report;
+}
+
+qint64 StartupMonitor::processAge()
+{
+    // The start time of the process is the 22nd field, in clock ticks since boot.
+    // The second field is the executable name, which can contain spaces.
+    QFile stat(QStringLiteral("/proc/self/stat"));
+    QFile uptime(QStringLiteral("/proc/uptime"));
+    if (!stat.open(QIODevice::ReadOnly) || !uptime.open(QIODevice::ReadOnly))
+        return 0;
+
+    const QByteArray statLine = stat.readAll();
+    const QList<QByteArray> fields = statLine.mid(statLine.lastIndexOf(')') + 2).split(' ');
+    const qint64 ticksPerSecond = sysconf(_SC_CLK_TCK);
+    if (fields.size() < 20 || ticksPerSecond <= 0)
+        return 0;
+
+    const qint64 startTime = fields.at(19).toLongLong() * 1000 / ticksPerSecond;
+    const qint64 now = qint64(uptime.readAll().split(' ').constFirst().toDouble() * 1000);
+    return qMax(qint64(0), now - startTime);
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef STARTUPMONITOR_H
+#define STARTUPMONITOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+#include <functional>
+
+class QQuickWindow;
+
+/**
+ * @class StartupMonitor
+ * @short Records the phases of the startup and tells when it is over.
+ *
+ * The application only loads what is needed to show the current tab. Work
+ * that can wait, like database maintenance and loading the other tabs, is
+ * deferred until the startup is idle: once the current page has been
+ * painted, or idleTimeout milliseconds after the QML has been loaded if the
+ * page takes longer.
+ *
+ * All times are in milliseconds since the process has been started.
+ */
+class StartupMonitor : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool ready READ ready NOTIFY readyChanged)
+
+public:
+    enum Phase {
+        ProcessStart,
+        QmlLoaded,
+        FirstFrame,
+        FirstPaint, // of the current page
+        Idle,
+    };
+    Q_ENUM(Phase)
+
+    explicit StartupMonitor(QObject *parent = nullptr);
+
+    static StartupMonitor *instance();
+
+    // true once the startup is idle
+    bool ready() const;
+
+    // time the phase has been reached, -1 if it hasn't been reached yet
+    qint64 elapsed(Phase phase) const;
+
+    void mark(Phase phase);
+
+    // marks the first frame, and the first paint once the page is loaded
+    void watchWindow(QQuickWindow *window);
+
+    // the current page has been loaded, it is painted with the next frame
+    Q_INVOKABLE void pageLoaded();
+
+    // runs the function once the startup is idle, right away if it already is
+    void deferToIdle(QObject *context, const std::function<void()> &function);
+
+    int idleTimeout() const;
+    void setIdleTimeout(int timeout);
+
+    // prints the phases once the startup is idle
+    bool traceEnabled() const;
+    void setTraceEnabled(bool enabled);
+
+    QString report() const;
+
+signals:
+    void readyChanged();
+    void phaseReached(StartupMonitor::Phase phase);
+
+private:
+    // how long the process has been running before the monitor was created
+    static qint64 processAge();
+
+    QElapsedTimer m_timer;
+    qint64 m_processAge;
+    QVector<qint64> m_phases;
+    QPointer<QQuickWindow> m_window;
+    bool m_pageLoaded = false;
+    bool m_traceEnabled = false;
+    QTimer m_idleTimer;
+
+    static StartupMonitor *s_instance;
+};
+
+#endif // STARTUPMONITOR_H
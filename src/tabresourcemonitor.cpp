@@ -0,0 +1,355 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tabresourcemonitor.h"
+#include "metrics.h"
+#include "processmemory.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QMetaProperty>
+#include <QUrl>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+#include <unistd.h>
+
+// ms between two samples of the processes
+constexpr int SAMPLE_INTERVAL = 2000;
+
+// properties of the views shown by the model
+static const QList<QByteArray> WATCHED_PROPERTIES = {
+    QByteArrayLiteral("title"),
+    QByteArrayLiteral("url"),
+    QByteArrayLiteral("lifecycleState"),
+    QByteArrayLiteral("renderProcessPid"),
+    QByteArrayLiteral("transferredBytes"),
+};
+
+TabResourceMonitor *TabResourceMonitor::s_instance = nullptr;
+
+namespace {
+// user and system time in ms
+qint64 readCpuTime(qint64 pid)
+{
+    QFile file(QStringLiteral("/proc/%1/stat").arg(pid));
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+
+    // the name in parentheses may contain spaces, the fields after it start
+    // with the state, which is the third one
+    const QByteArray stat = file.readAll();
+    const QList<QByteArray> fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 13)
+        return -1;
+
+    const qint64 ticks = fields.at(11).toLongLong() + fields.at(12).toLongLong();
+    return ticks * 1000 / sysconf(_SC_CLK_TCK);
+}
+}
+
+TabResourceMonitor::TabResourceMonitor(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    m_sampleTimer.setInterval(SAMPLE_INTERVAL);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &TabResourceMonitor::sample);
+
+    connect(&m_sampler, &QFutureWatcher<QHash<qint64, ProcessSample>>::finished, this, [this] {
+        const QHash<qint64, ProcessSample> samples = m_sampler.result();
+        const qint64 elapsed = m_sampleAge.isValid() ? m_sampleAge.restart() : 0;
+        m_sampleAge.start();
+
+        m_cpuUsage.clear();
+        for (auto it = samples.cbegin(); it != samples.cend(); ++it) {
+            const qint64 previous = m_samples.value(it.key()).cpuTime;
+            if (elapsed > 0 && previous >= 0 && it->cpuTime >= previous)
+                m_cpuUsage.insert(it.key(), qreal(it->cpuTime - previous) * 100 / elapsed);
+        }
+        m_samples = samples;
+
+        qint64 rss = 0;
+        qint64 pss = 0;
+        for (const ProcessSample &sample : samples) {
+            rss += qMax(qint64(0), sample.rss);
+            pss += qMax(qint64(0), sample.pss);
+        }
+        {
+            QMutexLocker locker(&m_metricsMutex);
+            m_rendererRss = rss;
+            m_rendererPss = pss;
+        }
+
+        if (!m_tabs.isEmpty())
+            emit dataChanged(index(0), index(m_tabs.count() - 1));
+    });
+
+    Metrics::instance()->setProvider(QStringLiteral("tabs.renderers"), [this] {
+        QMutexLocker locker(&m_metricsMutex);
+        return qint64(m_pids.size());
+    });
+    // the totals of the last sample, reading them takes the next one in the
+    // background, so polling doesn't need the model to be active
+    Metrics::instance()->setProvider(QStringLiteral("tabs.renderer_rss_kb"), [this] {
+        QMetaObject::invokeMethod(this, &TabResourceMonitor::sample, Qt::QueuedConnection);
+        QMutexLocker locker(&m_metricsMutex);
+        return m_rendererRss;
+    });
+    Metrics::instance()->setProvider(QStringLiteral("tabs.renderer_pss_kb"), [this] {
+        QMetaObject::invokeMethod(this, &TabResourceMonitor::sample, Qt::QueuedConnection);
+        QMutexLocker locker(&m_metricsMutex);
+        return m_rendererPss;
+    });
+    Metrics::instance()->setProvider(QStringLiteral("tabs.frozen"), [this] {
+        QMutexLocker locker(&m_metricsMutex);
+        return qint64(m_frozen);
+    });
+    Metrics::instance()->setProvider(QStringLiteral("tabs.discarded"), [this] {
+        QMutexLocker locker(&m_metricsMutex);
+        return qint64(m_discarded);
+    });
+}
+
+TabResourceMonitor::~TabResourceMonitor()
+{
+    for (const QString &name : {QStringLiteral("tabs.renderers"), QStringLiteral("tabs.renderer_rss_kb"), QStringLiteral("tabs.renderer_pss_kb"),
+                                QStringLiteral("tabs.frozen"), QStringLiteral("tabs.discarded")})
+        Metrics::instance()->setProvider(name, {});
+    m_sampler.waitForFinished();
+}
+
+TabResourceMonitor *TabResourceMonitor::instance()
+{
+    if (!s_instance)
+        s_instance = new TabResourceMonitor();
+
+    return s_instance;
+}
+
+QHash<int, QByteArray> TabResourceMonitor::roleNames() const
+{
+    return {
+        {ViewRole, QByteArrayLiteral("view")},
+        {TitleRole, QByteArrayLiteral("title")},
+        {UrlRole, QByteArrayLiteral("url")},
+        {PrivateModeRole, QByteArrayLiteral("privateMode")},
+        {LifecycleStateRole, QByteArrayLiteral("lifecycleState")},
+        {PidRole, QByteArrayLiteral("pid")},
+        {ProcessTabsRole, QByteArrayLiteral("processTabs")},
+        {RssRole, QByteArrayLiteral("rss")},
+        {PssRole, QByteArrayLiteral("pss")},
+        {CpuTimeRole, QByteArrayLiteral("cpuTime")},
+        {CpuUsageRole, QByteArrayLiteral("cpuUsage")},
+        {TransferredBytesRole, QByteArrayLiteral("transferredBytes")},
+    };
+}
+
+QVariant TabResourceMonitor::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_tabs.count())
+        return {};
+
+    const Tab &tab = m_tabs.at(index.row());
+    const QObject *view = tab.view;
+    if (!view)
+        return {};
+
+    const qint64 processId = pid(view);
+    switch (role) {
+    case ViewRole:
+        return QVariant::fromValue(tab.view.data());
+    case TitleRole:
+        return view->property("title");
+    case UrlRole:
+        return view->property("url");
+    case PrivateModeRole:
+        return tab.privateMode;
+    case LifecycleStateRole:
+        return view->property("lifecycleState").toInt();
+    case PidRole:
+        return processId;
+    case ProcessTabsRole:
+        if (processId < 0)
+            return 1;
+        return int(std::count_if(m_tabs.cbegin(), m_tabs.cend(), [processId](const Tab &other) {
+            return other.view && pid(other.view) == processId;
+        }));
+    case RssRole:
+        return m_samples.value(processId).rss;
+    case PssRole:
+        return m_samples.value(processId).pss;
+    case CpuTimeRole:
+        return m_samples.value(processId).cpuTime;
+    case CpuUsageRole:
+        return m_cpuUsage.value(processId, -1);
+    case TransferredBytesRole: {
+        const QVariant bytes = view->property("transferredBytes");
+        return bytes.isValid() ? bytes.toLongLong() : qint64(-1);
+    }
+    }
+
+    return {};
+}
+
+int TabResourceMonitor::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_tabs.count();
+}
+
+bool TabResourceMonitor::active() const
+{
+    return m_active;
+}
+
+void TabResourceMonitor::setActive(bool active)
+{
+    if (m_active == active)
+        return;
+
+    m_active = active;
+    if (m_active) {
+        m_sampleAge.invalidate();
+        sample();
+        m_sampleTimer.start();
+    } else {
+        m_sampleTimer.stop();
+    }
+    emit activeChanged();
+}
+
+void TabResourceMonitor::addView(QObject *view, bool privateMode)
+{
+    if (!view)
+        return;
+    for (const Tab &tab : qAsConst(m_tabs)) {
+        if (tab.view == view)
+            return;
+    }
+
+    beginInsertRows({}, m_tabs.count(), m_tabs.count());
+    m_tabs.append({view, privateMode});
+    endInsertRows();
+
+    const QMetaObject *metaObject = view->metaObject();
+    const QMetaMethod changed = staticMetaObject.method(staticMetaObject.indexOfSlot("onViewChanged()"));
+    for (const QByteArray &name : WATCHED_PROPERTIES) {
+        const QMetaProperty property = metaObject->property(metaObject->indexOfProperty(name.constData()));
+        if (property.hasNotifySignal())
+            connect(view, property.notifySignal(), this, changed);
+    }
+    // the pointer is already reset while the view is destroyed
+    connect(view, &QObject::destroyed, this, [this] {
+        removeView(nullptr);
+    });
+
+    updateMetrics();
+    emit countChanged();
+}
+
+void TabResourceMonitor::removeView(QObject *view)
+{
+    for (int row = m_tabs.count() - 1; row >= 0; row--) {
+        if (m_tabs.at(row).view != view)
+            continue;
+
+        if (view)
+            disconnect(view, nullptr, this, nullptr);
+        beginRemoveRows({}, row, row);
+        m_tabs.remove(row);
+        endRemoveRows();
+        emit countChanged();
+    }
+    updateMetrics();
+}
+
+void TabResourceMonitor::setLifecycleState(int row, LifecycleState state)
+{
+    if (row < 0 || row >= m_tabs.count() || !m_tabs.at(row).view)
+        return;
+
+    QObject *view = m_tabs.at(row).view;
+    if (state != Active && view->property("visible").toBool()) {
+        qWarning() << Q_FUNC_INFO << "Only tabs in the background can be frozen or discarded";
+        return;
+    }
+    if (!view->setProperty("lifecycleState", int(state)))
+        qWarning() << Q_FUNC_INFO << "The web engine doesn't support lifecycle states";
+}
+
+TabResourceMonitor::ProcessSample TabResourceMonitor::sampleProcess(qint64 pid)
+{
+    ProcessSample sample;
+    if (pid <= 0)
+        return sample;
+
+    sample.rss = ProcessMemory::resident(pid);
+    sample.pss = ProcessMemory::proportional(pid);
+    sample.cpuTime = readCpuTime(pid);
+    return sample;
+}
+
+void TabResourceMonitor::onViewChanged()
+{
+    for (int row = 0; row < m_tabs.count(); row++) {
+        if (m_tabs.at(row).view == sender())
+            emit dataChanged(index(row), index(row));
+    }
+    updateMetrics();
+}
+
+qint64 TabResourceMonitor::pid(const QObject *view)
+{
+    // renderProcessPid is only available since QtWebEngine 5.15
+    const qint64 pid = view->property("renderProcessPid").toLongLong();
+    return pid > 0 ? pid : -1;
+}
+
+void TabResourceMonitor::sample()
+{
+    // the previous sample is still being taken
+    if (m_sampler.isRunning())
+        return;
+
+    QVector<qint64> pids;
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        pids = m_pids;
+    }
+    m_sampler.setFuture(QtConcurrent::run([pids] {
+        QHash<qint64, ProcessSample> samples;
+        for (qint64 pid : pids)
+            samples.insert(pid, sampleProcess(pid));
+        return samples;
+    }));
+}
+
+void TabResourceMonitor::updateMetrics()
+{
+    QVector<qint64> pids;
+    int frozen = 0;
+    int discarded = 0;
+    for (const Tab &tab : qAsConst(m_tabs)) {
+        if (!tab.view)
+            continue;
+
+        const qint64 processId = pid(tab.view);
+        if (processId > 0 && !pids.contains(processId))
+            pids.append(processId);
+
+        const int state = tab.view->property("lifecycleState").toInt();
+        if (state == Frozen)
+            frozen++;
+        else if (state == Discarded)
+            discarded++;
+    }
+
+    QMutexLocker locker(&m_metricsMutex);
+    m_pids = pids;
+    m_frozen = frozen;
+    m_discarded = discarded;
+}
@@ -0,0 +1,137 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TABRESOURCEMONITOR_H
+#define TABRESOURCEMONITOR_H
+
+#include <QAbstractListModel>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * @class TabResourceMonitor
+ * @short Memory and CPU time used by the renderer process of each tab.
+ *
+ * The web views of the tabs add themselves, see ListWebView.qml. While the
+ * model is active, the processes are sampled from /proc every few seconds
+ * in a worker thread. Tabs can share a renderer process, in that case they
+ * show the same numbers.
+ *
+ * The renderer process is only known with QtWebEngine 5.15 and newer,
+ * before the values are -1.
+ *
+ * The totals over all renderers and the number of frozen and discarded tabs
+ * are also exported as tabs.* metrics. The memory totals are those of the
+ * last sample, reading them requests a new one.
+ */
+class TabResourceMonitor : public QAbstractListModel
+{
+    Q_OBJECT
+
+    // while active, the processes are sampled
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Role {
+        ViewRole = Qt::UserRole + 1,
+        TitleRole,
+        UrlRole,
+        PrivateModeRole,
+        LifecycleStateRole,
+        PidRole,
+        // number of tabs sharing the renderer process
+        ProcessTabsRole,
+        RssRole, // kB
+        PssRole, // kB
+        CpuTimeRole, // ms
+        CpuUsageRole, // percent of a core since the last sample
+        TransferredBytesRole,
+    };
+
+    // as WebEngineView.LifecycleState
+    enum LifecycleState {
+        Active,
+        Frozen,
+        Discarded,
+    };
+    Q_ENUM(LifecycleState)
+
+    struct ProcessSample {
+        qint64 rss = -1;
+        qint64 pss = -1;
+        qint64 cpuTime = -1;
+    };
+
+    explicit TabResourceMonitor(QObject *parent = nullptr);
+    ~TabResourceMonitor() override;
+
+    static TabResourceMonitor *instance();
+
+    QHash<int, QByteArray> roleNames() const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    bool active() const;
+    void setActive(bool active);
+
+    // called by the web views of the tabs
+    Q_INVOKABLE void addView(QObject *view, bool privateMode);
+    Q_INVOKABLE void removeView(QObject *view);
+
+    // only views in the background can be frozen or discarded
+    Q_INVOKABLE void setLifecycleState(int row, LifecycleState state);
+
+    // reads /proc, so it is best run in a worker thread
+    static ProcessSample sampleProcess(qint64 pid);
+
+signals:
+    void activeChanged();
+    void countChanged();
+
+private Q_SLOTS:
+    void onViewChanged();
+
+private:
+    struct Tab {
+        QPointer<QObject> view;
+        bool privateMode = false;
+    };
+
+    static qint64 pid(const QObject *view);
+
+    void sample();
+    void updateMetrics();
+
+    QVector<Tab> m_tabs;
+    bool m_active = false;
+    QTimer m_sampleTimer;
+    QFutureWatcher<QHash<qint64, ProcessSample>> m_sampler;
+    QHash<qint64, ProcessSample> m_samples;
+    // percent of a core
+    QHash<qint64, qreal> m_cpuUsage;
+    QElapsedTimer m_sampleAge;
+
+    // read by the metrics providers in any thread
+    mutable QMutex m_metricsMutex;
+    QVector<qint64> m_pids;
+    int m_frozen = 0;
+    int m_discarded = 0;
+    // totals of the last sample in kB
+    qint64 m_rendererRss = 0;
+    qint64 m_rendererPss = 0;
+
+    static TabResourceMonitor *s_instance;
+};
+
+#endif // TABRESOURCEMONITOR_H
@@ -15,14 +15,20 @@
 #include <QUrl>
 
 #include "browsermanager.h"
+#include "angelfishlogging.h"
 #include "angelfishsettings.h"
+#include "metrics.h"
+#include "tracer.h"
 
 TabsModel::TabsModel(QObject *parent)
     : QAbstractListModel(parent)
 {
     connect(this, &TabsModel::currentTabChanged, [this] {
-        qDebug() << "Current tab changed to" << m_currentTab;
+        qCDebug(ANGELFISH_TABS) << "Current tab changed to" << m_currentTab;
     });
+    connect(this, &QAbstractItemModel::rowsInserted, this, &TabsModel::countTabs);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, &TabsModel::countTabs);
+    connect(this, &QAbstractItemModel::modelReset, this, &TabsModel::countTabs);
 
     // The fallback tab must not be saved, it would overwrite our actual data.
     m_tabsReadOnly = true;
@@ -30,6 +36,17 @@ TabsModel::TabsModel(QObject *parent)
     createEmptyTab();
 }
 
+TabsModel::~TabsModel()
+{
+    Metrics::instance()->add(QStringLiteral("tabs.open"), -m_countedTabs);
+}
+
+void TabsModel::countTabs()
+{
+    Metrics::instance()->add(QStringLiteral("tabs.open"), m_tabs.count() - m_countedTabs);
+    m_countedTabs = m_tabs.count();
+}
+
 QHash<int, QByteArray> TabsModel::roleNames() const
 {
     return {{RoleNames::UrlRole, QByteArrayLiteral("pageurl")}, {RoleNames::IsMobileRole, QByteArrayLiteral("isMobile")}};
@@ -131,6 +148,7 @@ QVector<TabState> TabsModel::tabs() const
  */
 bool TabsModel::loadTabs()
 {
+    TraceScope trace("TabsModel::loadTabs", "tabs");
     if (!m_privateMode) {
         beginResetModel();
         const QString input = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) + QStringLiteral("/angelfish/tabs.json");
@@ -141,7 +159,7 @@ bool TabsModel::loadTabs()
         }
 
         if (!inputFile.open(QIODevice::ReadOnly)) {
-            qDebug() << "Failed to load tabs from disk";
+            qCWarning(ANGELFISH_TABS) << "Failed to load tabs from disk";
         }
 
         const auto tabsStorage = QJsonDocument::fromJson(inputFile.readAll()).object();
@@ -151,7 +169,7 @@ bool TabsModel::loadTabs()
             m_tabs.append(TabState::fromJson(tab.toObject()));
         }
 
-        qDebug() << "loaded from file:" << m_tabs.count() << input;
+        qCDebug(ANGELFISH_TABS) << "loaded from file:" << m_tabs.count() << input;
 
         m_currentTab = tabsStorage.value(QLatin1String("currentTab")).toInt();
 
@@ -174,17 +192,18 @@ bool TabsModel::loadTabs()
  */
 bool TabsModel::saveTabs() const
 {
+    TraceScope trace("TabsModel::saveTabs", "tabs");
     // only save if not in private mode
     if (!m_privateMode && !m_tabsReadOnly) {
         QString outputDir = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) + QStringLiteral("/angelfish/");
 
         QFile outputFile(outputDir + QStringLiteral("tabs.json"));
         if (!QDir(outputDir).mkpath(QStringLiteral("."))) {
-            qDebug() << "Destdir doesn't exist and I can't create it: " << outputDir;
+            qCWarning(ANGELFISH_TABS) << "Destdir doesn't exist and I can't create it: " << outputDir;
             return false;
         }
         if (!outputFile.open(QIODevice::WriteOnly)) {
-            qDebug() << "Failed to write tabs to disk";
+            qCWarning(ANGELFISH_TABS) << "Failed to write tabs to disk";
         }
 
         auto document = QJsonDocument();
@@ -193,15 +212,17 @@ bool TabsModel::saveTabs() const
         for (const auto &tab : m_tabs) {
             tabsArray.append(tab.toJson());
         }
-        qDebug() << "Wrote to file" << outputFile.fileName() << "(" << tabsArray.count() << "urls"
-                 << ")";
+        qCDebug(ANGELFISH_TABS) << "Wrote to file" << outputFile.fileName() << "(" << tabsArray.count() << "urls"
+                                << ")";
 
         tabsStorage.insert(QLatin1String("tabs"), tabsArray);
         tabsStorage.insert(QLatin1String("currentTab"), m_currentTab);
 
         document.setObject(tabsStorage);
 
-        outputFile.write(document.toJson());
+        const qint64 written = outputFile.write(document.toJson());
+        if (written > 0)
+            Metrics::instance()->add(QStringLiteral("tabs.bytes_written"), written);
         return true;
     }
     return false;
@@ -307,7 +328,7 @@ void TabsModel::closeTab(int index)
 
 void TabsModel::setIsMobile(int index, bool isMobile)
 {
-    qDebug() << "Setting isMobile:" << index << isMobile << "tabs open" << m_tabs.count();
+    qCDebug(ANGELFISH_TABS) << "Setting isMobile:" << index << isMobile << "tabs open" << m_tabs.count();
     if (index < 0 && index >= m_tabs.count())
         return; // index out of bounds
 
@@ -320,7 +341,7 @@ void TabsModel::setIsMobile(int index, bool isMobile)
 
 void TabsModel::setUrl(int index, const QString &url)
 {
-    qDebug() << "Setting URL:" << index << url << "tabs open" << m_tabs.count();
+    qCDebug(ANGELFISH_TABS) << "Setting URL:" << index << url << "tabs open" << m_tabs.count();
     if (index < 0 && index >= m_tabs.count())
         return; // index out of bounds
 
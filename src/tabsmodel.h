@@ -44,6 +44,7 @@ class TabsModel : public QAbstractListModel
 
 public:
     explicit TabsModel(QObject *parent = nullptr);
+    ~TabsModel() override;
 
     QHash<int, QByteArray> roleNames() const override;
     QVariant data(const QModelIndex &index, int role) const override;
@@ -76,11 +77,16 @@ protected:
     bool saveTabs() const;
 
 private:
+    // keeps the tabs.open metric up to date
+    void countTabs();
+
     int m_currentTab = 0;
     QVector<TabState> m_tabs {};
     bool m_privateMode = false;
     bool m_tabsReadOnly = false;
     bool m_isMobileDefault = false;
+    // tabs counted in the tabs.open metric
+    int m_countedTabs = 0;
 
 signals:
     void currentTabChanged();
@@ -0,0 +1,82 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "topsitesmodel.h"
+#include "browsermanager.h"
+#include "tracer.h"
+
+TopSitesModel::TopSitesModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    connect(BrowserManager::instance(), &BrowserManager::databaseTableChanged, this, [this](const QString &table) {
+        if (table == QLatin1String("history"))
+            reload();
+    });
+    reload();
+}
+
+QHash<int, QByteArray> TopSitesModel::roleNames() const
+{
+    return {
+        {HostRole, QByteArrayLiteral("host")},
+        {UrlRole, QByteArrayLiteral("url")},
+        {IconRole, QByteArrayLiteral("icon")},
+        {VisitsRole, QByteArrayLiteral("visits")},
+    };
+}
+
+QVariant TopSitesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_sites.count())
+        return {};
+
+    const DBManager::TopSite &site = m_sites.at(index.row());
+    switch (role) {
+    case HostRole:
+        return site.host;
+    case UrlRole:
+        return site.url;
+    case IconRole:
+        return site.icon;
+    case VisitsRole:
+        return site.visits;
+    }
+
+    return {};
+}
+
+int TopSitesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_sites.count();
+}
+
+int TopSitesModel::limit() const
+{
+    return m_limit;
+}
+
+void TopSitesModel::setLimit(int limit)
+{
+    if (m_limit == limit)
+        return;
+    m_limit = limit;
+    reload();
+    emit limitChanged();
+}
+
+void TopSitesModel::reload()
+{
+    TraceScope trace("TopSitesModel::reload", "models");
+
+    const int oldCount = m_sites.count();
+    beginResetModel();
+    m_sites = BrowserManager::instance()->topSites(m_limit);
+    endResetModel();
+    if (oldCount != m_sites.count())
+        emit countChanged();
+}
@@ -0,0 +1,60 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TOPSITESMODEL_H
+#define TOPSITESMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+
+#include "dbmanager.h"
+
+/**
+ * @class TopSitesModel
+ * @short The most visited hosts, for the grid shown in new tabs.
+ *
+ * Read from the visits per host the database keeps up to date, so it only
+ * looks at the listed hosts however long the history is. The url of a host
+ * is the page of it visited last.
+ */
+class TopSitesModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int limit READ limit WRITE setLimit NOTIFY limitChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Role {
+        HostRole = Qt::UserRole + 1,
+        UrlRole,
+        IconRole,
+        VisitsRole,
+    };
+
+    explicit TopSitesModel(QObject *parent = nullptr);
+
+    QHash<int, QByteArray> roleNames() const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    int limit() const;
+    void setLimit(int limit);
+
+    Q_INVOKABLE void reload();
+
+signals:
+    void limitChanged();
+    void countChanged();
+
+private:
+    int m_limit = 8;
+    QVector<DBManager::TopSite> m_sites;
+};
+
+#endif // TOPSITESMODEL_H
@@ -0,0 +1,212 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutexLocker>
+
+#include <chrono>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// bytes of events collected before they are written
+constexpr int FLUSH_SIZE = 64 * 1024;
+// us after which collected events are written anyway
+constexpr qint64 FLUSH_INTERVAL = 1000 * 1000;
+
+std::atomic<bool> Tracer::s_enabled(false);
+
+namespace {
+QByteArray quoted(const QString &string)
+{
+    // the array brackets are cut off
+    const QByteArray array = QJsonDocument(QJsonArray{string}).toJson(QJsonDocument::Compact);
+    return array.mid(1, array.size() - 2);
+}
+}
+
+Tracer *Tracer::instance()
+{
+    static Tracer tracer;
+    return &tracer;
+}
+
+qint64 Tracer::now()
+{
+    // steady_clock is CLOCK_MONOTONIC on Linux
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+qint64 Tracer::currentThread()
+{
+    // the ids Chromium writes into its traces as well
+    return qint64(syscall(SYS_gettid));
+}
+
+bool Tracer::start(const QString &path)
+{
+    stop();
+
+    QMutexLocker locker(&m_mutex);
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << Q_FUNC_INFO << "Failed to open trace file" << path << m_file.errorString();
+        return false;
+    }
+
+    const QByteArray process = quoted(QCoreApplication::applicationName());
+    m_buffer = QByteArrayLiteral("[\n");
+    m_buffer += QStringLiteral("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%1,\"tid\":%2,\"args\":{\"name\":%3}},\n")
+                    .arg(getpid())
+                    .arg(currentThread())
+                    .arg(QString::fromUtf8(process))
+                    .toUtf8();
+    m_buffer += QStringLiteral("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%1,\"tid\":%2,\"args\":{\"name\":\"main\"}}")
+                    .arg(getpid())
+                    .arg(currentThread())
+                    .toUtf8();
+    flush();
+
+    updateEnabled();
+    return true;
+}
+
+void Tracer::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen())
+        return;
+
+    m_buffer += "\n]\n";
+    flush();
+    m_file.close();
+    updateEnabled();
+}
+
+QString Tracer::path() const
+{
+    return m_file.fileName();
+}
+
+void Tracer::complete(const char *name, const char *category, qint64 start, qint64 duration, const QString &argument)
+{
+    const qint64 thread = currentThread();
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_historySize > 0) {
+            if (m_history.size() < m_historySize)
+                m_history.append({name, category, start, duration, thread, argument});
+            else
+                m_history[m_historyNext] = {name, category, start, duration, thread, argument};
+            m_historyNext = (m_historyNext + 1) % m_historySize;
+        }
+        if (!m_file.isOpen())
+            return;
+    }
+
+    QByteArray event;
+    event.reserve(160);
+    event += ",\n{\"name\":\"";
+    event += name;
+    event += "\",\"cat\":\"";
+    event += category;
+    event += "\",\"ph\":\"X\",\"ts\":";
+    event += QByteArray::number(start);
+    event += ",\"dur\":";
+    event += QByteArray::number(duration);
+    event += ",\"pid\":";
+    event += QByteArray::number(getpid());
+    event += ",\"tid\":";
+    event += QByteArray::number(thread);
+    if (!argument.isEmpty()) {
+        event += ",\"args\":{\"detail\":";
+        event += quoted(argument);
+        event += '}';
+    }
+    event += '}';
+    append(event);
+}
+
+void Tracer::instant(const char *name, const char *category, qint64 timestamp)
+{
+    QByteArray event;
+    event += ",\n{\"name\":\"";
+    event += name;
+    event += "\",\"cat\":\"";
+    event += category;
+    event += "\",\"ph\":\"i\",\"s\":\"p\",\"ts\":";
+    event += QByteArray::number(timestamp);
+    event += ",\"pid\":";
+    event += QByteArray::number(getpid());
+    event += ",\"tid\":";
+    event += QByteArray::number(currentThread());
+    event += '}';
+    append(event);
+}
+
+void Tracer::setHistorySize(int events)
+{
+    QMutexLocker locker(&m_mutex);
+    m_historySize = qMax(0, events);
+    m_history.clear();
+    m_history.reserve(m_historySize);
+    m_historyNext = 0;
+    updateEnabled();
+}
+
+int Tracer::historySize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_historySize;
+}
+
+QVector<Tracer::Event> Tracer::events(qint64 from, qint64 to) const
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<Event> events;
+    // once the ring is full, the oldest event is the one overwritten next
+    const int first = m_history.size() < m_historySize ? 0 : m_historyNext;
+    for (int i = 0; i < m_history.size(); i++) {
+        const Event &event = m_history.at((first + i) % m_history.size());
+        if (event.start < to && event.start + event.duration > from)
+            events.append(event);
+    }
+    return events;
+}
+
+void Tracer::append(const QByteArray &event)
+{
+    QMutexLocker locker(&m_mutex);
+    // the trace may have been stopped while the event was recorded
+    if (!m_file.isOpen())
+        return;
+
+    m_buffer += event;
+    if (m_buffer.size() >= FLUSH_SIZE || now() - m_lastFlush >= FLUSH_INTERVAL)
+        flush();
+}
+
+void Tracer::updateEnabled()
+{
+    s_enabled = m_file.isOpen() || m_historySize > 0;
+}
+
+void Tracer::flush()
+{
+    if (m_file.write(m_buffer) != m_buffer.size())
+        qWarning() << Q_FUNC_INFO << "Failed to write trace file" << m_file.fileName() << m_file.errorString();
+    m_file.flush();
+    m_buffer.clear();
+    m_lastFlush = now();
+}
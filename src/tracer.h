@@ -0,0 +1,143 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+/**
+ * @class Tracer
+ * @short Writes trace events in the JSON format of Chrome's trace viewer.
+ *
+ * Started with --trace <file> or the environment variable ANGELFISH_TRACE.
+ * Timestamps are microseconds of the monotonic clock, the clock Chromium
+ * uses for its own trace events, so a trace can be viewed next to one of
+ * QtWebEngine. Events are collected in memory and written once 64 KiB have
+ * been collected or a second has passed since the last write. The file can
+ * be loaded even if the browser didn't stop the trace, it only lacks the
+ * events collected since the last write then.
+ *
+ * Besides the file, the latest complete events can be kept in memory, so
+ * they can be looked up while the browser runs, see FrameMonitor.
+ *
+ * While no trace is running, a TraceScope costs a load of a flag.
+ */
+class Tracer
+{
+public:
+    struct Event {
+        const char *name = nullptr;
+        const char *category = nullptr;
+        qint64 start = 0;
+        qint64 duration = 0;
+        qint64 thread = 0;
+        QString argument;
+    };
+
+    static Tracer *instance();
+
+    static bool enabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    // microseconds of the monotonic clock
+    static qint64 now();
+    // id of the calling thread in the events
+    static qint64 currentThread();
+
+    // starts writing to path, replacing the file
+    bool start(const QString &path);
+    // writes the remaining events and closes the file
+    void stop();
+    QString path() const;
+
+    // Events can be added from any thread. Names and categories have to be
+    // string literals, the argument is stored as "detail".
+    void complete(const char *name, const char *category, qint64 start, qint64 duration, const QString &argument = {});
+    void instant(const char *name, const char *category, qint64 timestamp = now());
+
+    // number of complete events kept in memory, 0 to keep none
+    void setHistorySize(int events);
+    int historySize() const;
+    // the kept events overlapping the interval, oldest first
+    QVector<Event> events(qint64 from, qint64 to) const;
+
+private:
+    Tracer() = default;
+
+    void append(const QByteArray &event);
+    // expects m_mutex to be locked
+    void flush();
+    // as well
+    void updateEnabled();
+
+    QFile m_file;
+    mutable QMutex m_mutex;
+    QByteArray m_buffer;
+    // time of the last write
+    qint64 m_lastFlush = 0;
+
+    // ring buffer, m_historyNext is the slot written next
+    QVector<Event> m_history;
+    int m_historySize = 0;
+    int m_historyNext = 0;
+
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * @class TraceScope
+ * @short Records the time from its construction to its destruction.
+ */
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name, const char *category = "angelfish")
+        : m_name(Tracer::enabled() ? name : nullptr)
+        , m_category(category)
+    {
+        if (m_name)
+            m_start = Tracer::now();
+    }
+
+    ~TraceScope()
+    {
+        if (m_name)
+            Tracer::instance()->complete(m_name, m_category, m_start, Tracer::now() - m_start, m_argument);
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+    // whether the scope is recorded, check before computing an argument
+    bool active() const
+    {
+        return m_name;
+    }
+
+    void setArgument(const QString &argument)
+    {
+        m_argument = argument;
+    }
+
+private:
+    const char *m_name;
+    const char *m_category;
+    qint64 m_start = 0;
+    QString m_argument;
+};
+
+#endif // TRACER_H
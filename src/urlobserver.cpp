@@ -24,6 +24,7 @@ void UrlObserver::setUrl(const QString &url)
 {
     m_url = url;
     updateBookmarked();
+    updateUserAgentRule();
     emit urlChanged(url);
 }
 
@@ -32,11 +33,17 @@ bool UrlObserver::bookmarked() const
     return m_bookmarked;
 }
 
+QVariantMap UrlObserver::userAgentRule() const
+{
+    return m_userAgentRule;
+}
+
 void UrlObserver::onDatabaseTableChanged(const QString &table)
 {
-    if (table != QStringLiteral("bookmarks"))
-        return;
-    updateBookmarked();
+    if (table == QStringLiteral("bookmarks"))
+        updateBookmarked();
+    else if (table == QStringLiteral("useragentrules"))
+        updateUserAgentRule();
 }
 
 void UrlObserver::updateBookmarked()
@@ -47,3 +54,12 @@ void UrlObserver::updateBookmarked()
         emit bookmarkedChanged(m_bookmarked);
     }
 }
+
+void UrlObserver::updateUserAgentRule()
+{
+    const QVariantMap rule = BrowserManager::instance()->userAgentRuleForUrl(m_url);
+    if (rule != m_userAgentRule) {
+        m_userAgentRule = rule;
+        emit userAgentRuleChanged();
+    }
+}
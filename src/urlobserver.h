@@ -11,11 +11,14 @@
 
 #include <QObject>
 #include <QString>
+#include <QVariantMap>
 
 class UrlObserver : public QObject
 {
     Q_PROPERTY(QString url READ url WRITE setUrl NOTIFY urlChanged)
     Q_PROPERTY(bool bookmarked READ bookmarked NOTIFY bookmarkedChanged)
+    // user agent rule matching the url, empty if there is none
+    Q_PROPERTY(QVariantMap userAgentRule READ userAgentRule NOTIFY userAgentRuleChanged)
 
     Q_OBJECT
 public:
@@ -26,17 +29,22 @@ public:
 
     bool bookmarked() const;
 
+    QVariantMap userAgentRule() const;
+
 signals:
     void urlChanged(QString url);
     void bookmarkedChanged(bool bookmarked);
+    void userAgentRuleChanged();
 
 private:
     void onDatabaseTableChanged(const QString &table);
     void updateBookmarked();
+    void updateUserAgentRule();
 
 private:
     QString m_url;
     bool m_bookmarked = false;
+    QVariantMap m_userAgentRule;
 };
 
 #endif // URLOBSERVER_H
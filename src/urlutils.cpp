@@ -33,10 +33,9 @@ QString UrlUtils::urlScheme(const QString &url)
     return QUrl::fromUserInput(url).scheme();
 }
 
-QString UrlUtils::urlHostPort(const QString &url)
+QString UrlUtils::stripCommonPrefixes(const QString &host)
 {
-    const QUrl u(url);
-    QString r = u.host();
+    QString r = host;
     const QStringList common = { QLatin1String("www."),
                            QLatin1String("m."),
                            QLatin1String("mobile.") };
@@ -46,6 +45,13 @@ QString UrlUtils::urlHostPort(const QString &url)
             break; // strip prefix only once
         }
     }
+    return r;
+}
+
+QString UrlUtils::urlHostPort(const QString &url)
+{
+    const QUrl u(url);
+    QString r = stripCommonPrefixes(u.host());
 
     const int p = u.port(-1);
 
@@ -69,3 +75,34 @@ QString UrlUtils::htmlFormattedUrl(const QString &url)
             .arg(parsedUrl.host())
             .arg(path == QStringLiteral("/") ? QString() : path);
 }
+
+QString UrlUtils::urlNormalizedHost(const QString &url)
+{
+    return stripCommonPrefixes(QUrl(url).host().toLower());
+}
+
+QString UrlUtils::urlRegistrableDomain(const QString &url)
+{
+    const QUrl u(url);
+    const QString host = u.host().toLower();
+    // The public suffix list of Qt is only reachable through this call,
+    // which has been deprecated in Qt 5.15 without a replacement
+    QT_WARNING_PUSH
+    QT_WARNING_DISABLE_DEPRECATED
+    const QString tld = u.topLevelDomain().toLower();
+    QT_WARNING_POP
+
+    // IP addresses, localhost and unknown suffixes are kept as they are
+    if (tld.isEmpty() || host.length() <= tld.length())
+        return host;
+
+    // keep one label in front of the public suffix
+    const int dot = host.lastIndexOf(QLatin1Char('.'), -tld.length() - 1);
+    return host.mid(dot + 1);
+}
+
+QString UrlUtils::urlDisplayPath(const QString &url)
+{
+    const QString path = QUrl(url).path();
+    return path == QStringLiteral("/") ? QString() : path;
+}
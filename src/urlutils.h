@@ -29,6 +29,19 @@ public:
     Q_INVOKABLE static QString urlHostPort(const QString &url);
     Q_INVOKABLE static QString urlHost(const QString &url);
     Q_INVOKABLE static QString htmlFormattedUrl(const QString &url);
+
+    // Components stored next to each history and bookmarks entry, so that
+    // views don't need to parse the url again when displaying it.
+    // Lower case host without common prefixes like "www." or "m."
+    static QString urlNormalizedHost(const QString &url);
+    // Registrable part of the host according to the public suffix list,
+    // e.g. "bbc.co.uk" for "https://news.bbc.co.uk"
+    Q_INVOKABLE static QString urlRegistrableDomain(const QString &url);
+    // Path of the url as shown next to the host, empty for "/"
+    static QString urlDisplayPath(const QString &url);
+
+private:
+    static QString stripCommonPrefixes(const QString &host);
 };
 
 #endif // URLUTILS_H
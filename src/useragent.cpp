@@ -8,32 +8,64 @@
  ***************************************************************************/
 
 #include "useragent.h"
+#include "useragentrules.h"
 
 #include <QtWebEngine/QQuickWebEngineProfile>
 #include <QtWebEngine/QtWebEngineVersion>
 
+namespace {
+struct AgentVersions {
+    QString chrome;
+    QString appleWebKit;
+    QString webEngine;
+    QString safari;
+};
+
+QString extractValueFromAgent(const QString &agent, QLatin1String key)
+{
+    const int index = agent.indexOf(key) + key.size() + 1;
+    const int endIndex = agent.indexOf(QLatin1Char(' '), index);
+    return agent.mid(index, endIndex < 0 ? -1 : endIndex - index);
+}
+
+// The versions only depend on the WebEngine in use, so the default agent is
+// parsed once per process instead of once per tab
+const AgentVersions &agentVersions()
+{
+    static const AgentVersions versions = [] {
+        const QString defaultUserAgent = QQuickWebEngineProfile::defaultProfile()->httpUserAgent();
+        return AgentVersions{
+            extractValueFromAgent(defaultUserAgent, QLatin1String("Chrome")),
+            extractValueFromAgent(defaultUserAgent, QLatin1String("AppleWebKit")),
+            extractValueFromAgent(defaultUserAgent, QLatin1String("QtWebEngine")),
+            extractValueFromAgent(defaultUserAgent, QLatin1String("Safari")),
+        };
+    }();
+    return versions;
+}
+}
+
 UserAgent::UserAgent(QObject *parent)
     : QObject(parent)
-    , m_defaultProfile(QQuickWebEngineProfile::defaultProfile())
-    , m_chromeVersion(extractValueFromAgent("Chrome"))
-    , m_appleWebKitVersion(extractValueFromAgent("AppleWebKit"))
-    , m_webEngineVersion(extractValueFromAgent("QtWebEngine"))
-    , m_safariVersion(extractValueFromAgent("Safari"))
     , m_isMobile(true)
 {
 }
 
 QString UserAgent::userAgent() const
 {
+    if (!m_customUserAgent.isEmpty())
+        return m_customUserAgent;
+
+    const AgentVersions &versions = agentVersions();
     return QStringLiteral(
                "Mozilla/5.0 (%1) AppleWebKit/%2 (KHTML, like Gecko) QtWebEngine/%3 "
                "Chrome/%4 %5 Safari/%6")
         .arg(m_isMobile ? QStringLiteral("Linux; Plasma Mobile, like Android 9.0") : QStringLiteral("X11; Linux x86_64"),
-             m_appleWebKitVersion,
-             m_webEngineVersion,
-             m_chromeVersion,
+             versions.appleWebKit,
+             versions.webEngine,
+             versions.chrome,
              m_isMobile ? u"Mobile" : u"Desktop",
-             m_safariVersion);
+             versions.safari);
 }
 
 bool UserAgent::isMobile() const
@@ -51,10 +83,50 @@ void UserAgent::setIsMobile(bool value)
     }
 }
 
-QString UserAgent::extractValueFromAgent(const std::string &key)
+QString UserAgent::customUserAgent() const
+{
+    return m_customUserAgent;
+}
+
+void UserAgent::setCustomUserAgent(const QString &userAgent)
 {
-    const std::string defaultUserAgent = m_defaultProfile->httpUserAgent().toStdString();
-    const unsigned long index = defaultUserAgent.find(key) + key.length() + 1;
-    const unsigned long endIndex = defaultUserAgent.find(' ', index);
-    return QString::fromStdString(defaultUserAgent.substr(index, endIndex - index));
+    if (m_customUserAgent != userAgent) {
+        m_customUserAgent = userAgent;
+
+        emit customUserAgentChanged();
+        emit userAgentChanged();
+    }
+}
+
+bool UserAgent::applyRule(const QVariantMap &rule)
+{
+    const QString before = userAgent();
+
+    if (rule.isEmpty()) {
+        if (m_ruleActive) {
+            m_ruleActive = false;
+            setCustomUserAgent(QString());
+            setIsMobile(m_tabIsMobile);
+        }
+        return userAgent() != before;
+    }
+
+    if (!m_ruleActive) {
+        m_ruleActive = true;
+        m_tabIsMobile = m_isMobile;
+    }
+
+    const auto mode = static_cast<UserAgentRules::Mode>(rule.value(QStringLiteral("mode")).toInt());
+    switch (mode) {
+    case UserAgentRules::Mobile:
+    case UserAgentRules::Desktop:
+        setCustomUserAgent(QString());
+        setIsMobile(mode == UserAgentRules::Mobile);
+        break;
+    case UserAgentRules::Custom:
+        setCustomUserAgent(rule.value(QStringLiteral("userAgent")).toString());
+        break;
+    }
+
+    return userAgent() != before;
 }
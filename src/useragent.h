@@ -11,12 +11,14 @@
 #define USERAGENT_H
 
 #include <QObject>
-class QQuickWebEngineProfile;
+#include <QVariantMap>
 
 class UserAgent : public QObject
 {
     Q_PROPERTY(QString userAgent READ userAgent NOTIFY userAgentChanged)
     Q_PROPERTY(bool isMobile READ isMobile WRITE setIsMobile NOTIFY isMobileChanged)
+    // if set, used instead of the generated mobile or desktop agent
+    Q_PROPERTY(QString customUserAgent READ customUserAgent WRITE setCustomUserAgent NOTIFY customUserAgentChanged)
 
     Q_OBJECT
 
@@ -28,20 +30,26 @@ public:
     bool isMobile() const;
     void setIsMobile(bool value);
 
+    QString customUserAgent() const;
+    void setCustomUserAgent(const QString &userAgent);
+
+    // Applies a rule as returned by BrowserManager::userAgentRuleForUrl. With an
+    // empty rule, the agent used before the first rule was applied is restored.
+    // Returns whether the user agent changed.
+    Q_INVOKABLE bool applyRule(const QVariantMap &rule);
+
 signals:
     void isMobileChanged();
     void userAgentChanged();
+    void customUserAgentChanged();
 
 private:
-    QString extractValueFromAgent(const std::string &key);
-
-    const QQuickWebEngineProfile *m_defaultProfile;
-    const QString m_chromeVersion;
-    const QString m_appleWebKitVersion;
-    const QString m_webEngineVersion;
-    const QString m_safariVersion;
-
     bool m_isMobile;
+    QString m_customUserAgent;
+
+    // agent chosen for the tab, restored when leaving a site with a rule
+    bool m_ruleActive = false;
+    bool m_tabIsMobile = true;
 };
 
 #endif // USERAGENT_H
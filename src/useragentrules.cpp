@@ -0,0 +1,61 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "useragentrules.h"
+#include "dbmanager.h"
+
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QUrl>
+
+UserAgentRules::UserAgentRules(QObject *parent)
+    : QObject(parent)
+{
+    reload();
+}
+
+const UserAgentRules::Rule *UserAgentRules::match(const QString &host) const
+{
+    return m_matcher.find(host);
+}
+
+QVariantMap UserAgentRules::ruleForUrl(const QString &url) const
+{
+    const Rule *rule = match(QUrl(url).host());
+    if (!rule)
+        return {};
+
+    return {
+        {QStringLiteral("pattern"), rule->pattern},
+        {QStringLiteral("mode"), rule->mode},
+        {QStringLiteral("userAgent"), rule->userAgent},
+    };
+}
+
+void UserAgentRules::reload()
+{
+    m_matcher.clear();
+
+    QSqlQuery query;
+    DBManager::prepare(query, QStringLiteral("SELECT pattern, mode, userAgent FROM useragentrules"));
+    if (!query.exec()) {
+        qWarning() << Q_FUNC_INFO << "Failed to execute SQL statement";
+        qWarning() << query.lastQuery();
+        qWarning() << query.lastError();
+        return;
+    }
+
+    while (query.next()) {
+        Rule rule;
+        rule.pattern = query.value(0).toString();
+        rule.mode = static_cast<Mode>(query.value(1).toInt());
+        rule.userAgent = query.value(2).toString();
+        m_matcher.insert(rule.pattern, rule);
+    }
+}
@@ -0,0 +1,55 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef USERAGENTRULES_H
+#define USERAGENTRULES_H
+
+#include <QObject>
+#include <QVariantMap>
+
+#include "hostmatcher.h"
+
+/**
+ * @class UserAgentRules
+ * @short In-memory copy of the per-site user agent rules stored in the database.
+ *
+ * Rules map a host or domain pattern to the agent that should be used for it.
+ * They are looked up before a page is requested, so the lookup has to be cheap
+ * even with thousands of rules.
+ */
+class UserAgentRules : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode { Mobile, Desktop, Custom };
+    Q_ENUM(Mode)
+
+    struct Rule {
+        QString pattern;
+        Mode mode = Mobile;
+        QString userAgent;
+    };
+
+    explicit UserAgentRules(QObject *parent = nullptr);
+
+    // rule with the most specific pattern matching the host, nullptr if there is none
+    const Rule *match(const QString &host) const;
+
+    // same as match, as a map with pattern, mode and userAgent. Empty if there
+    // is no rule for the url.
+    QVariantMap ruleForUrl(const QString &url) const;
+
+    // re-read the rules from the database
+    void reload();
+
+private:
+    HostMatcher<Rule> m_matcher;
+};
+
+#endif // USERAGENTRULES_H
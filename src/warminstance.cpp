@@ -0,0 +1,211 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "warminstance.h"
+
+#include <QDebug>
+#include <QQmlEngine>
+#include <QQuickWindow>
+
+#include <KWindowSystem>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "angelfishsettings.h"
+#include "processmemory.h"
+#include "startupmonitor.h"
+
+// ms between the memory checks while hidden
+constexpr int CHECK_INTERVAL = 30000;
+
+WarmInstance *WarmInstance::s_instance = nullptr;
+
+WarmInstance::WarmInstance(QObject *parent)
+    : QObject(parent)
+    , m_memoryLimit(AngelfishSettings::defaultBackgroundMemoryLimitValue())
+    , m_memoryProbe([] {
+        const qint64 kibibytes = ProcessMemory::resident();
+        return kibibytes < 0 ? kibibytes : kibibytes / 1024;
+    })
+{
+    m_checkTimer.setInterval(CHECK_INTERVAL);
+    connect(&m_checkTimer, &QTimer::timeout, this, &WarmInstance::checkMemory);
+}
+
+WarmInstance *WarmInstance::instance()
+{
+    if (s_instance)
+        return s_instance;
+
+    s_instance = new WarmInstance();
+    auto *settings = AngelfishSettings::self();
+    s_instance->setMemoryLimit(settings->backgroundMemoryLimit());
+    QObject::connect(settings, &AngelfishSettings::backgroundMemoryLimitChanged, s_instance, [settings] {
+        s_instance->setMemoryLimit(settings->backgroundMemoryLimit());
+    });
+    return s_instance;
+}
+
+bool WarmInstance::enabled() const
+{
+    return m_enabled;
+}
+
+void WarmInstance::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+
+    m_enabled = enabled;
+    if (m_waiting != enabled) {
+        m_waiting = enabled;
+        emit waitingChanged();
+    }
+    updateChecks();
+}
+
+bool WarmInstance::waiting() const
+{
+    return m_waiting;
+}
+
+void WarmInstance::setWindow(QQuickWindow *window)
+{
+    if (m_window)
+        disconnect(m_window, nullptr, this, nullptr);
+
+    m_window = window;
+    if (m_window) {
+        connect(m_window, &QWindow::visibleChanged, this, &WarmInstance::onVisibleChanged);
+        connect(m_window, &QQuickWindow::frameSwapped, this, [this] {
+            if (m_activation.isValid())
+                finishActivation();
+        });
+    }
+    updateChecks();
+}
+
+void WarmInstance::activate()
+{
+    if (!m_enabled)
+        return;
+
+    if (hidden()) {
+        m_activation.start();
+        if (m_window) {
+            m_window->show();
+            KWindowSystem::raiseWindow(m_window->winId());
+        } else {
+            finishActivation();
+        }
+    }
+
+    if (m_waiting) {
+        m_waiting = false;
+        emit waitingChanged();
+    }
+}
+
+qint64 WarmInstance::lastActivationLatency() const
+{
+    return m_lastActivationLatency;
+}
+
+int WarmInstance::memoryLimit() const
+{
+    return m_memoryLimit;
+}
+
+void WarmInstance::setMemoryLimit(int mebibytes)
+{
+    m_memoryLimit = mebibytes;
+}
+
+int WarmInstance::checkInterval() const
+{
+    return m_checkTimer.interval();
+}
+
+void WarmInstance::setCheckInterval(int interval)
+{
+    m_checkTimer.setInterval(interval);
+}
+
+void WarmInstance::setMemoryProbe(const std::function<qint64()> &probe)
+{
+    m_memoryProbe = probe;
+}
+
+bool WarmInstance::hidden() const
+{
+    return !m_window || !m_window->isVisible();
+}
+
+void WarmInstance::onVisibleChanged()
+{
+    // the window has been closed, wait for the next activation
+    if (m_enabled && hidden() && !m_waiting) {
+        m_waiting = true;
+        emit waitingChanged();
+    }
+    updateChecks();
+}
+
+void WarmInstance::updateChecks()
+{
+    if (m_enabled && hidden()) {
+        if (!m_checkTimer.isActive()) {
+            m_trimmedMemory = -1;
+            m_checkTimer.start();
+        }
+    } else {
+        m_checkTimer.stop();
+    }
+}
+
+void WarmInstance::checkMemory()
+{
+    const qint64 memory = m_memoryProbe();
+    if (memory < 0 || memory <= m_memoryLimit)
+        return;
+
+    // dropping the caches again only helps if something has been allocated since
+    if (m_trimmedMemory >= 0 && memory <= m_trimmedMemory)
+        return;
+
+    dropCaches();
+    m_trimmedMemory = m_memoryProbe();
+}
+
+void WarmInstance::dropCaches()
+{
+    if (m_window) {
+        m_window->releaseResources();
+        if (QQmlEngine *engine = qmlEngine(m_window)) {
+            engine->collectGarbage();
+            engine->trimComponentCache();
+        }
+    }
+
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+
+    emit cachesDropped();
+}
+
+void WarmInstance::finishActivation()
+{
+    m_lastActivationLatency = m_activation.elapsed();
+    m_activation.invalidate();
+    if (StartupMonitor::instance()->traceEnabled())
+        qInfo().noquote() << QStringLiteral("Warm activation: %1 ms").arg(m_lastActivationLatency);
+    emit activated(m_lastActivationLatency);
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *                                                                         *
+ *   SPDX-FileCopyrightText: 2020 Angelfish developers                     *
+ *                                                                         *
+ *   SPDX-License-Identifier: GPL-2.0-or-later                             *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef WARMINSTANCE_H
+#define WARMINSTANCE_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include <functional>
+
+class QQuickWindow;
+
+/**
+ * @class WarmInstance
+ * @short Keeps a hidden browser running, so it can be shown without a cold start.
+ *
+ * When started in the background, the window and the web engine are created
+ * but stay hidden, and no tab is loaded until the instance is activated by
+ * launching the browser again. Closing the window hides it again instead of
+ * quitting, and the instance is waiting again: the private tabs are closed
+ * and the views of the other tabs are unloaded, see webbrowser.qml.
+ *
+ * While hidden, the memory used by the process is checked regularly. If it
+ * exceeds memoryLimit MiB, the instance drops the caches of the scene graph,
+ * the QML engine and the allocator.
+ */
+class WarmInstance : public QObject
+{
+    Q_OBJECT
+
+    // hidden in the background and not activated yet, tabs are not loaded
+    Q_PROPERTY(bool waiting READ waiting NOTIFY waitingChanged)
+
+public:
+    explicit WarmInstance(QObject *parent = nullptr);
+
+    // instance following the application settings
+    static WarmInstance *instance();
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    bool waiting() const;
+
+    void setWindow(QQuickWindow *window);
+
+    // shows the window, the time until its next frame is the activation latency
+    void activate();
+
+    // ms from the last activation to the first frame, -1 if there was none
+    qint64 lastActivationLatency() const;
+
+    // in MiB
+    int memoryLimit() const;
+    void setMemoryLimit(int mebibytes);
+
+    // ms between the memory checks while hidden
+    int checkInterval() const;
+    void setCheckInterval(int interval);
+
+    // replaces the resident memory of the process in MiB, for testing
+    void setMemoryProbe(const std::function<qint64()> &probe);
+
+signals:
+    void waitingChanged();
+    void activated(qint64 latency);
+    void cachesDropped();
+
+private:
+    bool hidden() const;
+    void onVisibleChanged();
+    void updateChecks();
+    void checkMemory();
+    void dropCaches();
+    void finishActivation();
+
+    bool m_enabled = false;
+    bool m_waiting = false;
+    QPointer<QQuickWindow> m_window;
+    QElapsedTimer m_activation;
+    qint64 m_lastActivationLatency = -1;
+    int m_memoryLimit;
+    QTimer m_checkTimer;
+    // memory after the caches have been dropped while hidden, -1 if they weren't
+    qint64 m_trimmedMemory = -1;
+    std::function<qint64()> m_memoryProbe;
+
+    static WarmInstance *s_instance;
+};
+
+#endif // WARMINSTANCE_H